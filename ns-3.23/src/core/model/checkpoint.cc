@@ -0,0 +1,573 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "checkpoint.h"
+#include "object.h"
+#include "config.h"
+#include "pointer.h"
+#include "object-ptr-container.h"
+#include "string.h"
+#include "simulator.h"
+#include "default-simulator-impl.h"
+#include "rng-seed-manager.h"
+#include "fatal-error.h"
+#include "log.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
+#include <utility>
+
+/**
+ * \file
+ * \ingroup checkpoint
+ * Implementation of the checkpoint classes.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Checkpoint");
+
+CheckpointWriter::CheckpointWriter ()
+  : m_events (0)
+{
+}
+
+void
+CheckpointWriter::Append (const void *data, uint32_t size)
+{
+  const uint8_t *bytes = static_cast<const uint8_t *> (data);
+  m_data.insert (m_data.end (), bytes, bytes + size);
+}
+
+void
+CheckpointWriter::WriteU8 (uint8_t v)
+{
+  Append (&v, sizeof (v));
+}
+
+void
+CheckpointWriter::WriteU32 (uint32_t v)
+{
+  Append (&v, sizeof (v));
+}
+
+void
+CheckpointWriter::WriteU64 (uint64_t v)
+{
+  Append (&v, sizeof (v));
+}
+
+void
+CheckpointWriter::WriteDouble (double v)
+{
+  Append (&v, sizeof (v));
+}
+
+void
+CheckpointWriter::WriteString (std::string v)
+{
+  WriteU32 (v.size ());
+  Append (v.data (), v.size ());
+}
+
+void
+CheckpointWriter::WriteTime (Time v)
+{
+  WriteU64 (static_cast<uint64_t> (v.GetTimeStep ()));
+}
+
+void
+CheckpointWriter::WriteBytes (const uint8_t *data, uint32_t size)
+{
+  Append (data, size);
+}
+
+void
+CheckpointWriter::WriteEvent (const EventId &event)
+{
+  bool pending = event.IsRunning ();
+  WriteU8 (pending);
+  if (pending)
+    {
+      WriteTime (Simulator::GetDelayLeft (event));
+      m_events++;
+    }
+}
+
+const std::vector<uint8_t> &
+CheckpointWriter::GetData (void) const
+{
+  return m_data;
+}
+
+uint32_t
+CheckpointWriter::GetEventCount (void) const
+{
+  return m_events;
+}
+
+CheckpointReader::CheckpointReader (const uint8_t *data, uint32_t size)
+  : m_data (data),
+    m_size (size),
+    m_offset (0)
+{
+}
+
+void
+CheckpointReader::Consume (void *data, uint32_t size)
+{
+  if (size > m_size - m_offset)
+    {
+      NS_FATAL_ERROR ("Checkpoint truncated: " << size << " bytes needed, "
+                      << m_size - m_offset << " left");
+    }
+  std::memcpy (data, m_data + m_offset, size);
+  m_offset += size;
+}
+
+uint8_t
+CheckpointReader::ReadU8 (void)
+{
+  uint8_t v;
+  Consume (&v, sizeof (v));
+  return v;
+}
+
+uint32_t
+CheckpointReader::ReadU32 (void)
+{
+  uint32_t v;
+  Consume (&v, sizeof (v));
+  return v;
+}
+
+uint64_t
+CheckpointReader::ReadU64 (void)
+{
+  uint64_t v;
+  Consume (&v, sizeof (v));
+  return v;
+}
+
+double
+CheckpointReader::ReadDouble (void)
+{
+  double v;
+  Consume (&v, sizeof (v));
+  return v;
+}
+
+std::string
+CheckpointReader::ReadString (void)
+{
+  uint32_t size = ReadU32 ();
+  std::string v (size, '\0');
+  if (size > 0)
+    {
+      Consume (&v[0], size);
+    }
+  return v;
+}
+
+Time
+CheckpointReader::ReadTime (void)
+{
+  return TimeStep (ReadU64 ());
+}
+
+void
+CheckpointReader::ReadBytes (uint8_t *data, uint32_t size)
+{
+  Consume (data, size);
+}
+
+bool
+CheckpointReader::ReadEvent (Time &delay)
+{
+  bool pending = ReadU8 ();
+  delay = pending ? ReadTime () : Time (0);
+  return pending;
+}
+
+uint32_t
+CheckpointReader::GetRemaining (void) const
+{
+  return m_size - m_offset;
+}
+
+Checkpointable::~Checkpointable ()
+{
+}
+
+namespace {
+
+/** First bytes of a checkpoint file. */
+const char CHECKPOINT_MAGIC[8] = { 'n', 's', '3', 'c', 'k', 'p', 't', '\0' };
+/** Version of the checkpoint format. */
+const uint32_t CHECKPOINT_VERSION = 2;
+
+/** The objects of a simulation, by Config path. */
+typedef std::vector<std::pair<std::string, Ptr<Object> > > ObjectList;
+
+/**
+ * Add an object and the objects it points to, depth first.
+ * \param [in] path The path of the object.
+ * \param [in] object The object.
+ * \param [in,out] visited The objects already found.
+ * \param [in,out] objects The objects found.
+ */
+void
+Collect (std::string path, Ptr<Object> object, std::set<Object *> &visited, ObjectList &objects)
+{
+  if (object == 0 || !visited.insert (PeekPointer (object)).second)
+    {
+      return;
+    }
+  if (!path.empty ())
+    {
+      objects.push_back (std::make_pair (path, object));
+    }
+  for (TypeId tid = object->GetInstanceTypeId (); tid.HasParent (); tid = tid.GetParent ())
+    {
+      for (uint32_t i = 0; i < tid.GetAttributeN (); ++i)
+        {
+          struct TypeId::AttributeInformation info = tid.GetAttribute (i);
+          if (!(info.flags & TypeId::ATTR_GET) || !info.accessor->HasGetter ())
+            {
+              continue;
+            }
+          if (dynamic_cast<const PointerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              PointerValue ptr;
+              object->GetAttribute (info.name, ptr);
+              Collect (path + "/" + info.name, ptr.Get<Object> (), visited, objects);
+            }
+          else if (dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              ObjectPtrContainerValue container;
+              object->GetAttribute (info.name, container);
+              for (ObjectPtrContainerValue::Iterator j = container.Begin (); j != container.End (); ++j)
+                {
+                  std::ostringstream oss;
+                  oss << path << "/" << info.name << "/" << j->first;
+                  Collect (oss.str (), j->second, visited, objects);
+                }
+            }
+        }
+    }
+  Object::AggregateIterator aggregates = object->GetAggregateIterator ();
+  while (aggregates.HasNext ())
+    {
+      Ptr<Object> aggregate = const_cast<Object *> (PeekPointer (aggregates.Next ()));
+      Collect (path + "/$" + aggregate->GetInstanceTypeId ().GetName (), aggregate, visited, objects);
+    }
+}
+
+/**
+ * \returns All the objects reachable from the root namespace objects.
+ */
+ObjectList
+CollectAll (void)
+{
+  std::set<Object *> visited;
+  ObjectList objects;
+  for (uint32_t i = 0; i < Config::GetRootNamespaceObjectN (); i++)
+    {
+      Collect ("", Config::GetRootNamespaceObject (i), visited, objects);
+    }
+  return objects;
+}
+
+/**
+ * \param [in] object An object.
+ * \returns The attributes of an object which can be both read and
+ *   written, as (name, value) pairs.
+ */
+std::vector<std::pair<std::string, std::string> >
+GetAttributes (Ptr<Object> object)
+{
+  std::vector<std::pair<std::string, std::string> > attributes;
+  for (TypeId tid = object->GetInstanceTypeId (); tid.HasParent (); tid = tid.GetParent ())
+    {
+      for (uint32_t i = 0; i < tid.GetAttributeN (); ++i)
+        {
+          struct TypeId::AttributeInformation info = tid.GetAttribute (i);
+          if (dynamic_cast<const PointerChecker *> (PeekPointer (info.checker)) != 0
+              || dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              continue;
+            }
+          if ((info.flags & TypeId::ATTR_GET) && info.accessor->HasGetter ()
+              && (info.flags & TypeId::ATTR_SET) && info.accessor->HasSetter ())
+            {
+              StringValue value;
+              if (object->GetAttributeFailSafe (info.name, value))
+                {
+                  attributes.push_back (std::make_pair (info.name, value.Get ()));
+                }
+            }
+        }
+    }
+  return attributes;
+}
+
+/**
+ * Read a checkpoint file and check its header.
+ * \param [in] filename The file written by Checkpoint::Save.
+ * \returns The content of the file.
+ */
+std::vector<uint8_t>
+Load (std::string filename)
+{
+  std::ifstream is (filename.c_str (), std::ios::binary);
+  if (!is.is_open ())
+    {
+      NS_FATAL_ERROR ("Cannot open checkpoint file " << filename);
+    }
+  std::vector<uint8_t> data ((std::istreambuf_iterator<char> (is)), std::istreambuf_iterator<char> ());
+  CheckpointReader reader (data.empty () ? 0 : &data[0], data.size ());
+
+  char magic[sizeof (CHECKPOINT_MAGIC)];
+  reader.ReadBytes (reinterpret_cast<uint8_t *> (magic), sizeof (magic));
+  if (std::memcmp (magic, CHECKPOINT_MAGIC, sizeof (magic)) != 0)
+    {
+      NS_FATAL_ERROR (filename << " is not a checkpoint");
+    }
+  uint32_t version = reader.ReadU32 ();
+  if (version != CHECKPOINT_VERSION)
+    {
+      NS_FATAL_ERROR ("Unsupported checkpoint version " << version);
+    }
+  return data;
+}
+
+/**
+ * \param [in] data The content of a checkpoint file.
+ * \returns The number of lost events, written last by Checkpoint::Save.
+ */
+uint32_t
+ReadLostEvents (const std::vector<uint8_t> &data)
+{
+  uint32_t lostEvents;
+  NS_ASSERT (data.size () >= sizeof (CHECKPOINT_MAGIC) + 2 * sizeof (lostEvents));
+  std::memcpy (&lostEvents, &data[data.size () - sizeof (lostEvents)], sizeof (lostEvents));
+  return lostEvents;
+}
+
+} // anonymous namespace
+
+void
+Checkpoint::Save (std::string filename)
+{
+  NS_LOG_FUNCTION (filename);
+  CheckpointWriter writer;
+  writer.WriteBytes (reinterpret_cast<const uint8_t *> (CHECKPOINT_MAGIC), sizeof (CHECKPOINT_MAGIC));
+  writer.WriteU32 (CHECKPOINT_VERSION);
+  writer.WriteU32 (Time::GetResolution ());
+  writer.WriteTime (Simulator::Now ());
+  writer.WriteU32 (RngSeedManager::GetSeed ());
+  writer.WriteU64 (RngSeedManager::GetRun ());
+  // there is no way to read the next stream index without taking it.
+  uint64_t nextStream = RngSeedManager::GetNextStreamIndex ();
+  RngSeedManager::SetNextStreamIndex (nextStream);
+  writer.WriteU64 (nextStream);
+
+  ObjectList objects = CollectAll ();
+  writer.WriteU32 (objects.size ());
+  uint32_t savedEvents = 0;
+  for (ObjectList::const_iterator i = objects.begin (); i != objects.end (); ++i)
+    {
+      Ptr<Object> object = i->second;
+      writer.WriteString (i->first);
+      writer.WriteString (object->GetInstanceTypeId ().GetName ());
+      std::vector<std::pair<std::string, std::string> > attributes = GetAttributes (object);
+      writer.WriteU32 (attributes.size ());
+      for (uint32_t j = 0; j < attributes.size (); j++)
+        {
+          writer.WriteString (attributes[j].first);
+          writer.WriteString (attributes[j].second);
+        }
+      CheckpointWriter state;
+      const Checkpointable *checkpointable = dynamic_cast<const Checkpointable *> (PeekPointer (object));
+      if (checkpointable != 0)
+        {
+          checkpointable->SaveCheckpoint (state);
+        }
+      savedEvents += state.GetEventCount ();
+      writer.WriteU32 (state.GetData ().size ());
+      if (!state.GetData ().empty ())
+        {
+          writer.WriteBytes (&state.GetData ()[0], state.GetData ().size ());
+        }
+    }
+  // the events which no object saved cannot be scheduled again.
+  uint32_t lostEvents = 0;
+  Ptr<DefaultSimulatorImpl> impl = DynamicCast<DefaultSimulatorImpl> (Simulator::GetImplementation ());
+  if (impl != 0)
+    {
+      uint32_t pendingEvents = impl->CountPendingEvents ();
+      lostEvents = pendingEvents > savedEvents ? pendingEvents - savedEvents : 0;
+    }
+  if (lostEvents > 0)
+    {
+      NS_LOG_WARN (lostEvents << " pending events not saved by any object");
+    }
+  writer.WriteU32 (lostEvents);
+
+  std::ofstream os (filename.c_str (), std::ios::binary);
+  if (!os.is_open ())
+    {
+      NS_FATAL_ERROR ("Cannot open checkpoint file " << filename);
+    }
+  const std::vector<uint8_t> &data = writer.GetData ();
+  os.write (reinterpret_cast<const char *> (&data[0]), data.size ());
+  if (!os)
+    {
+      NS_FATAL_ERROR ("Cannot write checkpoint file " << filename);
+    }
+  NS_LOG_INFO ("Saved " << objects.size () << " objects at " << Simulator::Now ().GetSeconds () << "s");
+}
+
+uint32_t
+Checkpoint::GetLostEvents (std::string filename)
+{
+  NS_LOG_FUNCTION (filename);
+  return ReadLostEvents (Load (filename));
+}
+
+uint32_t
+Checkpoint::Restore (std::string filename, bool acceptLostEvents)
+{
+  NS_LOG_FUNCTION (filename << acceptLostEvents);
+  std::vector<uint8_t> data = Load (filename);
+  // refuse before changing anything.
+  uint32_t lostEvents = ReadLostEvents (data);
+  if (lostEvents > 0 && !acceptLostEvents)
+    {
+      NS_FATAL_ERROR (lostEvents << " events pending at the checkpoint " << filename
+                                 << " were not saved by any object; restore it with"
+                                 " acceptLostEvents set to resume without them");
+    }
+  CheckpointReader reader (&data[0], data.size ());
+  // the header was checked by Load.
+  uint8_t magic[sizeof (CHECKPOINT_MAGIC)];
+  reader.ReadBytes (magic, sizeof (magic));
+  reader.ReadU32 ();
+  uint32_t resolution = reader.ReadU32 ();
+  if (resolution != static_cast<uint32_t> (Time::GetResolution ()))
+    {
+      NS_FATAL_ERROR ("Checkpoint saved with another time resolution");
+    }
+  Time now = reader.ReadTime ();
+  RngSeedManager::SetSeed (reader.ReadU32 ());
+  RngSeedManager::SetRun (reader.ReadU64 ());
+  RngSeedManager::SetNextStreamIndex (reader.ReadU64 ());
+
+  Ptr<DefaultSimulatorImpl> impl = DynamicCast<DefaultSimulatorImpl> (Simulator::GetImplementation ());
+  if (impl == 0)
+    {
+      NS_FATAL_ERROR ("Checkpoint::Restore requires DefaultSimulatorImpl");
+    }
+
+  // run the initialization which was done at time zero before the
+  // checkpoint, then forget the events it scheduled.
+  ObjectList objects = CollectAll ();
+  for (ObjectList::const_iterator i = objects.begin (); i != objects.end (); ++i)
+    {
+      i->second->Initialize ();
+    }
+  uint32_t discarded = impl->Reset (now);
+  NS_LOG_INFO ("Discarded " << discarded << " events scheduled before the restore");
+  // initialization may have created objects.
+  objects = CollectAll ();
+  std::map<std::string, Ptr<Object> > byPath (objects.begin (), objects.end ());
+
+  uint32_t n = reader.ReadU32 ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      std::string path = reader.ReadString ();
+      std::string type = reader.ReadString ();
+      std::map<std::string, Ptr<Object> >::const_iterator found = byPath.find (path);
+      Ptr<Object> object = 0;
+      if (found == byPath.end ())
+        {
+          NS_LOG_WARN ("Object " << path << " not found");
+        }
+      else if (found->second->GetInstanceTypeId ().GetName () != type)
+        {
+          NS_LOG_WARN ("Object " << path << " is a " << found->second->GetInstanceTypeId ().GetName ()
+                                 << ", not a " << type);
+        }
+      else
+        {
+          object = found->second;
+          byPath.erase (path);
+        }
+      uint32_t nAttributes = reader.ReadU32 ();
+      for (uint32_t j = 0; j < nAttributes; j++)
+        {
+          std::string name = reader.ReadString ();
+          std::string value = reader.ReadString ();
+          if (object == 0)
+            {
+              continue;
+            }
+          StringValue current;
+          if (object->GetAttributeFailSafe (name, current) && current.Get () == value)
+            {
+              continue;
+            }
+          if (!object->SetAttributeFailSafe (name, StringValue (value)))
+            {
+              NS_LOG_WARN ("Cannot restore " << path << "/" << name << "=" << value);
+            }
+        }
+      uint32_t size = reader.ReadU32 ();
+      std::vector<uint8_t> state (size);
+      if (size > 0)
+        {
+          reader.ReadBytes (&state[0], size);
+        }
+      Checkpointable *checkpointable = dynamic_cast<Checkpointable *> (PeekPointer (object));
+      if (checkpointable != 0)
+        {
+          CheckpointReader stateReader (state.empty () ? 0 : &state[0], size);
+          checkpointable->RestoreCheckpoint (stateReader);
+          if (stateReader.GetRemaining () != 0)
+            {
+              NS_FATAL_ERROR ("State of " << path << " not fully restored");
+            }
+        }
+    }
+  for (std::map<std::string, Ptr<Object> >::const_iterator i = byPath.begin (); i != byPath.end (); ++i)
+    {
+      NS_LOG_WARN ("Object " << i->first << " not in the checkpoint");
+    }
+  // the number of lost events, read first.
+  reader.ReadU32 ();
+  if (lostEvents > 0)
+    {
+      NS_LOG_WARN (lostEvents << " events pending at the checkpoint were not saved by any object and are lost");
+    }
+  NS_LOG_INFO ("Restored " << n << " objects at " << now.GetSeconds () << "s");
+  return lostEvents;
+}
+
+} // namespace ns3
@@ -0,0 +1,255 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "nstime.h"
+#include "event-id.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup checkpoint
+ * Declaration of the checkpoint classes.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup core
+ * \defgroup checkpoint Checkpoint and restore
+ *
+ * Save the state of a simulation to a file, and resume it later from
+ * this file, for example to share the warm-up of a parameter sweep.
+ */
+
+/**
+ * \ingroup checkpoint
+ * \brief Build the binary state of an object.
+ *
+ * Values are written in native byte order: a checkpoint can only be
+ * restored on the platform which saved it.
+ */
+class CheckpointWriter
+{
+public:
+  CheckpointWriter ();
+
+  /** \param [in] v The value to write. */
+  void WriteU8 (uint8_t v);
+  /** \param [in] v The value to write. */
+  void WriteU32 (uint32_t v);
+  /** \param [in] v The value to write. */
+  void WriteU64 (uint64_t v);
+  /** \param [in] v The value to write. */
+  void WriteDouble (double v);
+  /** \param [in] v The value to write. */
+  void WriteString (std::string v);
+  /** \param [in] v The value to write. */
+  void WriteTime (Time v);
+  /**
+   * \param [in] data The bytes to write.
+   * \param [in] size The number of bytes.
+   */
+  void WriteBytes (const uint8_t *data, uint32_t size);
+  /**
+   * Write whether an event is pending and, if it is, how long until
+   * it expires. See CheckpointReader::ReadEvent.
+   * \param [in] event The event.
+   */
+  void WriteEvent (const EventId &event);
+
+  /** \returns The bytes written so far. */
+  const std::vector<uint8_t> &GetData (void) const;
+  /** \returns The number of pending events written by WriteEvent. */
+  uint32_t GetEventCount (void) const;
+
+private:
+  /**
+   * \param [in] data The bytes to append.
+   * \param [in] size The number of bytes.
+   */
+  void Append (const void *data, uint32_t size);
+
+  std::vector<uint8_t> m_data;  //!< The bytes written.
+  uint32_t m_events;            //!< The number of pending events written.
+};
+
+/**
+ * \ingroup checkpoint
+ * \brief Read the binary state written by a CheckpointWriter.
+ *
+ * Reading past the end of the data is a fatal error.
+ */
+class CheckpointReader
+{
+public:
+  /**
+   * \param [in] data The bytes to read.
+   * \param [in] size The number of bytes.
+   */
+  CheckpointReader (const uint8_t *data, uint32_t size);
+
+  /** \returns The value read. */
+  uint8_t ReadU8 (void);
+  /** \returns The value read. */
+  uint32_t ReadU32 (void);
+  /** \returns The value read. */
+  uint64_t ReadU64 (void);
+  /** \returns The value read. */
+  double ReadDouble (void);
+  /** \returns The value read. */
+  std::string ReadString (void);
+  /** \returns The value read. */
+  Time ReadTime (void);
+  /**
+   * \param [out] data The buffer to fill.
+   * \param [in] size The number of bytes to read.
+   */
+  void ReadBytes (uint8_t *data, uint32_t size);
+  /**
+   * Read an event written by CheckpointWriter::WriteEvent.
+   * \param [out] delay How long until the event expires.
+   * \returns true if the event was pending: the caller should then
+   *   schedule it again after delay.
+   */
+  bool ReadEvent (Time &delay);
+
+  /** \returns The number of bytes not read yet. */
+  uint32_t GetRemaining (void) const;
+
+private:
+  /**
+   * \param [out] data The buffer to fill.
+   * \param [in] size The number of bytes to read.
+   */
+  void Consume (void *data, uint32_t size);
+
+  const uint8_t *m_data;  //!< The bytes to read.
+  uint32_t m_size;        //!< The number of bytes.
+  uint32_t m_offset;      //!< The number of bytes read.
+};
+
+/**
+ * \ingroup checkpoint
+ * \brief Interface of the objects which have a state beyond their
+ * attributes.
+ *
+ * Objects derive from this class, in addition to Object, to save the
+ * part of their state which their attributes do not hold: counters,
+ * buffered packets, random number generator positions and pending
+ * events. Events cannot be saved as they are: each object saves the
+ * remaining time of its own events with CheckpointWriter::WriteEvent
+ * and schedules them again when it is restored.
+ */
+class Checkpointable
+{
+public:
+  virtual ~Checkpointable ();
+  /**
+   * Save the state of this object.
+   * \param [in] writer Where to save it.
+   */
+  virtual void SaveCheckpoint (CheckpointWriter &writer) const = 0;
+  /**
+   * Restore the state saved by SaveCheckpoint. The simulation clock
+   * is already at the time of the checkpoint.
+   * \param [in] reader Where to read it.
+   */
+  virtual void RestoreCheckpoint (CheckpointReader &reader) = 0;
+};
+
+/**
+ * \ingroup checkpoint
+ * \brief Save and restore the state of a simulation.
+ *
+ * A checkpoint holds the simulation time, the random number generator
+ * seed, run and next automatic stream index, and the state of all
+ * the objects reachable from the root namespace objects of Config
+ * (NodeList, ChannelList...) through pointer and object container
+ * attributes and aggregation, each identified by its Config path.
+ * The state of an object is the value of its attributes which can be
+ * both read and written, plus whatever it saves itself if it is
+ * Checkpointable.
+ *
+ * The objects are not created by Restore: the program must first
+ * build the same topology, with the same configuration, as the one
+ * which saved the checkpoint. Restore then initializes all the
+ * objects, discards all the pending events, moves the clock to the
+ * time of the checkpoint and restores the state of each object.
+ *
+ * Only the events saved by a Checkpointable object with
+ * CheckpointWriter::WriteEvent are scheduled again: those of the drop
+ * tail queues and the start and stop events of the applications. The
+ * events of the net devices, channels and protocols (such as the
+ * timers of TCP sockets) and the traffic events of the applications
+ * are not saved, so a checkpoint is only complete when it is saved
+ * while none of these is pending, for example before any traffic
+ * starts. The events scheduled by the
+ * program itself, such as Simulator::Stop, are not saved either and
+ * must be scheduled again after Restore. Save counts the pending
+ * events which no object saved, and Restore is a fatal error when
+ * there are any, unless it is explicitly asked to resume without them.
+ *
+ * \code
+ *   // first run: build the topology, then
+ *   Simulator::Schedule (Seconds (600), &Checkpoint::Save, "warmup.ckpt");
+ *   Simulator::Run ();
+ *   // later runs: build the same topology, then
+ *   Checkpoint::Restore ("warmup.ckpt");
+ *   Simulator::Stop (Seconds (1200));
+ *   Simulator::Run ();
+ * \endcode
+ *
+ * Restore requires DefaultSimulatorImpl.
+ */
+class Checkpoint
+{
+public:
+  /**
+   * Save the state of the simulation.
+   * \param [in] filename The file to write.
+   */
+  static void Save (std::string filename);
+  /**
+   * \param [in] filename The file written by Save.
+   * \returns The number of events which were pending when the
+   *   checkpoint was saved but which no object saved.
+   */
+  static uint32_t GetLostEvents (std::string filename);
+  /**
+   * Restore the state of the simulation, before Simulator::Run.
+   *
+   * If some events pending at the checkpoint were not saved by any
+   * object (see GetLostEvents), the simulation cannot be resumed as it
+   * was: this is a fatal error, detected before anything is restored,
+   * unless acceptLostEvents is set.
+   *
+   * \param [in] filename The file written by Save.
+   * \param [in] acceptLostEvents Resume even if events were lost; they
+   *   are not scheduled again.
+   * \returns The number of events lost.
+   */
+  static uint32_t Restore (std::string filename, bool acceptLostEvents = false);
+};
+
+} // namespace ns3
+
+#endif /* CHECKPOINT_H */
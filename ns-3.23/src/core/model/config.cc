@@ -26,6 +26,9 @@
 #include "pointer.h"
 #include "log.h"
 
+#include <algorithm>
+#include <map>
+#include <set>
 #include <sstream>
 
 /**
@@ -94,33 +97,83 @@ void
 MatchContainer::Set (std::string name, const AttributeValue &value)
 {
   NS_LOG_FUNCTION (this << name << &value);
+  // The matched objects usually share their type: look the attribute up
+  // and check the value once for each run of objects of the same type.
+  TypeId tid;
+  struct TypeId::AttributeInformation info;
+  Ptr<AttributeValue> v;
   for (Iterator tmp = Begin (); tmp != End (); ++tmp)
     {
       Ptr<Object> object = *tmp;
-      object->SetAttribute (name, value);
+      if (v == 0 || object->GetInstanceTypeId () != tid)
+        {
+          tid = object->GetInstanceTypeId ();
+          if (!tid.LookupAttributeByName (name, &info))
+            {
+              NS_FATAL_ERROR ("Attribute name="<<name<<" does not exist for this object: tid="<<tid.GetName ());
+            }
+          if (!(info.flags & TypeId::ATTR_SET) ||
+              !info.accessor->HasSetter ())
+            {
+              NS_FATAL_ERROR ("Attribute name="<<name<<" is not settable for this object: tid="<<tid.GetName ());
+            }
+          v = info.checker->CreateValidValue (value);
+          if (v == 0)
+            {
+              NS_FATAL_ERROR ("Attribute name="<<name<<" could not be set for this object: tid="<<tid.GetName ());
+            }
+        }
+      if (!info.accessor->Set (PeekPointer (object), *v))
+        {
+          NS_FATAL_ERROR ("Attribute name="<<name<<" could not be set for this object: tid="<<tid.GetName ());
+        }
     }
 }
+Ptr<const TraceSourceAccessor>
+MatchContainer::LookupTraceSource (uint32_t i, std::string name, TypeId *tid,
+                                   Ptr<const TraceSourceAccessor> accessor) const
+{
+  NS_LOG_FUNCTION (this << i << name << tid << accessor);
+  // The matched objects usually share their type: look the trace source
+  // up once for each run of objects of the same type.
+  TypeId objectTid = m_objects[i]->GetInstanceTypeId ();
+  if (i == 0 || objectTid != *tid)
+    {
+      *tid = objectTid;
+      accessor = objectTid.LookupTraceSourceByName (name);
+    }
+  return accessor;
+}
 void 
 MatchContainer::Connect (std::string name, const CallbackBase &cb)
 {
   NS_LOG_FUNCTION (this << name << &cb);
   NS_ASSERT (m_objects.size () == m_contexts.size ());
+  TypeId tid;
+  Ptr<const TraceSourceAccessor> accessor;
   for (uint32_t i = 0; i < m_objects.size (); ++i)
     {
-      Ptr<Object> object = m_objects[i];
-      std::string ctx = m_contexts[i] + name;
-      object->TraceConnect (name, ctx, cb);
+      accessor = LookupTraceSource (i, name, &tid, accessor);
+      if (accessor != 0)
+        {
+          std::string ctx = m_contexts[i] + name;
+          accessor->Connect (PeekPointer (m_objects[i]), ctx, cb);
+        }
     }
 }
 void 
 MatchContainer::ConnectWithoutContext (std::string name, const CallbackBase &cb)
 {
   NS_LOG_FUNCTION (this << name << &cb);
-
-  for (Iterator tmp = Begin (); tmp != End (); ++tmp)
+  TypeId tid;
+  Ptr<const TraceSourceAccessor> accessor;
+  for (uint32_t i = 0; i < m_objects.size (); ++i)
     {
-      Ptr<Object> object = *tmp;
-      object->TraceConnectWithoutContext (name, cb);
+      accessor = LookupTraceSource (i, name, &tid, accessor);
+      if (accessor != 0)
+        {
+          accessor->ConnectWithoutContext (PeekPointer (m_objects[i]), cb);
+        }
     }
 }
 void 
@@ -128,105 +181,174 @@ MatchContainer::Disconnect (std::string name, const CallbackBase &cb)
 {
   NS_LOG_FUNCTION (this << name << &cb);
   NS_ASSERT (m_objects.size () == m_contexts.size ());
+  TypeId tid;
+  Ptr<const TraceSourceAccessor> accessor;
   for (uint32_t i = 0; i < m_objects.size (); ++i)
     {
-      Ptr<Object> object = m_objects[i];
-      std::string ctx = m_contexts[i] + name;
-      object->TraceDisconnect (name, ctx, cb);
+      accessor = LookupTraceSource (i, name, &tid, accessor);
+      if (accessor != 0)
+        {
+          std::string ctx = m_contexts[i] + name;
+          accessor->Disconnect (PeekPointer (m_objects[i]), ctx, cb);
+        }
     }
 }
 void 
 MatchContainer::DisconnectWithoutContext (std::string name, const CallbackBase &cb)
 {
   NS_LOG_FUNCTION (this << name << &cb);
-  for (Iterator tmp = Begin (); tmp != End (); ++tmp)
+  TypeId tid;
+  Ptr<const TraceSourceAccessor> accessor;
+  for (uint32_t i = 0; i < m_objects.size (); ++i)
     {
-      Ptr<Object> object = *tmp;
-      object->TraceDisconnectWithoutContext (name, cb);
+      accessor = LookupTraceSource (i, name, &tid, accessor);
+      if (accessor != 0)
+        {
+          accessor->DisconnectWithoutContext (PeekPointer (m_objects[i]), cb);
+        }
     }
 }
 
 } // namespace Config
 
+/**
+ * \ingroup config
+ * The container indexes matched by a path segment: "*", an index, a
+ * range of indexes "[min-max]", or several of them separated by '|'.
+ * The segment is parsed once, when the matcher is created.
+ */
 class ArrayMatcher
 {
 public:
+  /**
+   * \param element the path segment.
+   */
   ArrayMatcher (std::string element);
+  /**
+   * \param i an index in a container.
+   * \returns true if the segment matches this index.
+   */
   bool Matches (uint32_t i) const;
+  /**
+   * Get the indexes matched by the segment, if there are few of them.
+   *
+   * \param [in] n the number of items of a container.
+   * \param [out] indexes the matched indexes smaller than n, sorted.
+   * \returns false if the segment is "*" or matches more than n indexes.
+   */
+  bool GetIndexes (uint32_t n, std::vector<uint32_t> *indexes) const;
 private:
+  /**
+   * Add the indexes matched by a segment, or by part of it.
+   * \param element the segment.
+   */
+  void Parse (std::string element);
   bool StringToUint32 (std::string str, uint32_t *value) const;
-  std::string m_element;
+  /** Ranges of indexes, inclusive. */
+  typedef std::vector<std::pair<uint32_t, uint32_t> > Ranges;
+  std::string m_element; //!< The segment.
+  bool m_all;            //!< Whether the segment matches all indexes.
+  Ranges m_ranges;       //!< The indexes matched by the segment.
 };
 
 
 ArrayMatcher::ArrayMatcher (std::string element)
-  : m_element (element)
+  : m_element (element),
+    m_all (false)
 {
   NS_LOG_FUNCTION (this << element);
+  Parse (element);
 }
-bool
-ArrayMatcher::Matches (uint32_t i) const
+void
+ArrayMatcher::Parse (std::string element)
 {
-  NS_LOG_FUNCTION (this << i);
-  if (m_element == "*")
+  NS_LOG_FUNCTION (this << element);
+  if (element == "*")
     {
-      NS_LOG_DEBUG ("Array "<<i<<" matches *");
-      return true;
+      m_all = true;
+      return;
     }
   std::string::size_type tmp;
-  tmp = m_element.find ("|");
+  tmp = element.find ("|");
   if (tmp != std::string::npos)
     {
-      std::string left = m_element.substr (0, tmp-0);
-      std::string right = m_element.substr (tmp+1, m_element.size () - (tmp + 1));
-      ArrayMatcher matcher = ArrayMatcher (left);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<left);
-          return true;
-        }
-      matcher = ArrayMatcher (right);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<right);
-          return true;
-        }
-      NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
-      return false;
+      Parse (element.substr (0, tmp-0));
+      Parse (element.substr (tmp+1, element.size () - (tmp + 1)));
+      return;
     }
-  std::string::size_type leftBracket = m_element.find ("[");
-  std::string::size_type rightBracket = m_element.find ("]");
-  std::string::size_type dash = m_element.find ("-");
-  if (leftBracket == 0 && rightBracket == m_element.size () - 1 &&
+  std::string::size_type leftBracket = element.find ("[");
+  std::string::size_type rightBracket = element.find ("]");
+  std::string::size_type dash = element.find ("-");
+  if (leftBracket == 0 && rightBracket == element.size () - 1 &&
       dash > leftBracket && dash < rightBracket)
     {
-      std::string lowerBound = m_element.substr (leftBracket + 1, dash - (leftBracket + 1));
-      std::string upperBound = m_element.substr (dash + 1, rightBracket - (dash + 1));
+      std::string lowerBound = element.substr (leftBracket + 1, dash - (leftBracket + 1));
+      std::string upperBound = element.substr (dash + 1, rightBracket - (dash + 1));
       uint32_t min;
       uint32_t max;
       if (StringToUint32 (lowerBound, &min) && 
           StringToUint32 (upperBound, &max) &&
-          i >= min && i <= max)
+          min <= max)
         {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
-          return true;
-        }
-      else
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" does not "<<m_element);
-          return false;
+          m_ranges.push_back (std::make_pair (min, max));
         }
+      return;
     }
   uint32_t value;
-  if (StringToUint32 (m_element, &value) &&
-      i == value)
+  if (StringToUint32 (element, &value))
     {
-      NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
+      m_ranges.push_back (std::make_pair (value, value));
+    }
+}
+bool
+ArrayMatcher::Matches (uint32_t i) const
+{
+  NS_LOG_FUNCTION (this << i);
+  if (m_all)
+    {
+      NS_LOG_DEBUG ("Array "<<i<<" matches *");
       return true;
     }
+  for (Ranges::const_iterator j = m_ranges.begin (); j != m_ranges.end (); ++j)
+    {
+      if (i >= j->first && i <= j->second)
+        {
+          NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
+          return true;
+        }
+    }
   NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
   return false;
 }
+bool
+ArrayMatcher::GetIndexes (uint32_t n, std::vector<uint32_t> *indexes) const
+{
+  NS_LOG_FUNCTION (this << n << indexes);
+  if (m_all)
+    {
+      return false;
+    }
+  indexes->clear ();
+  for (Ranges::const_iterator j = m_ranges.begin (); j != m_ranges.end (); ++j)
+    {
+      if (j->first >= n)
+        {
+          continue;
+        }
+      uint32_t last = std::min (j->second, n - 1);
+      if (indexes->size () + (last - j->first) >= n)
+        {
+          return false;
+        }
+      for (uint32_t k = j->first; k <= last; k++)
+        {
+          indexes->push_back (k);
+        }
+    }
+  std::sort (indexes->begin (), indexes->end ());
+  indexes->erase (std::unique (indexes->begin (), indexes->end ()), indexes->end ());
+  return true;
+}
 
 bool
 ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
@@ -239,60 +361,206 @@ ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
 }
 
 
+/**
+ * \ingroup config
+ * A path split into its segments, so that it is parsed only once.
+ */
+struct CompiledPath
+{
+  std::vector<std::string> items;     //!< The segments of the path.
+  std::vector<ArrayMatcher> matchers; //!< The segments, as container indexes.
+};
+
+/**
+ * \ingroup config
+ * The pointer and container attributes which can be designated by a
+ * path segment, for each TypeId, and the containers which are declared
+ * with Config::RegisterCachedContainer.
+ */
+class PathAttributeTable
+{
+public:
+  /** A pointer or container attribute. */
+  struct Entry
+  {
+    std::string name;                               //!< The attribute name.
+    uint32_t flags;                                 //!< The attribute flags.
+    Ptr<const AttributeAccessor> accessor;          //!< The attribute accessor.
+    const ObjectPtrContainerAccessor *container;    //!< The container accessor, zero for a pointer.
+    bool cached;                                    //!< Whether the container is declared.
+  };
+  /** The attributes designated by a segment. */
+  typedef std::vector<Entry> Entries;
+
+  /**
+   * \param tid the TypeId of an object.
+   * \param item a path segment.
+   * \returns the attributes of the object which item designates, in the
+   *          order in which they are resolved.
+   */
+  const Entries & Lookup (TypeId tid, const std::string &item);
+  /**
+   * \param tid the TypeId which defines a container attribute.
+   * \param name the name of the container attribute.
+   */
+  void RegisterCachedContainer (TypeId tid, std::string name);
+  /**
+   * \param name the name of an attribute.
+   * \returns true if a container of this name was declared.
+   */
+  bool IsCachedContainerName (const std::string &name) const;
+private:
+  /** An attribute of a TypeId, identified by its uid. */
+  typedef std::pair<uint16_t, std::string> Key;
+  std::map<Key, Entries> m_entries;       //!< The attributes designated by a segment, by TypeId.
+  std::set<Key> m_cachedContainers;       //!< The declared containers.
+  std::set<std::string> m_cachedNames;    //!< The names of the declared containers.
+};
+
+const PathAttributeTable::Entries &
+PathAttributeTable::Lookup (TypeId tid, const std::string &item)
+{
+  NS_LOG_FUNCTION (this << tid << item);
+  Key key = std::make_pair (tid.GetUid (), item);
+  std::map<Key, Entries>::const_iterator i = m_entries.find (key);
+  if (i != m_entries.end ())
+    {
+      return i->second;
+    }
+  Entries &entries = m_entries[key];
+  TypeId nextTid = tid;
+  do
+    {
+      tid = nextTid;
+      for (uint32_t j = 0; j < tid.GetAttributeN (); j++)
+        {
+          struct TypeId::AttributeInformation info = tid.GetAttribute (j);
+          if (info.name != item && item != "*")
+            {
+              continue;
+            }
+          Entry entry;
+          entry.name = info.name;
+          entry.flags = info.flags;
+          entry.accessor = info.accessor;
+          entry.container = 0;
+          entry.cached = false;
+          if (dynamic_cast<const PointerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              entries.push_back (entry);
+            }
+          if (dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              entry.container = dynamic_cast<const ObjectPtrContainerAccessor *> (PeekPointer (info.accessor));
+              NS_ASSERT_MSG (entry.container != 0, "Attribute " << info.name << " of " << tid.GetName ()
+                             << " has a container checker but no container accessor");
+              entry.cached = m_cachedContainers.count (std::make_pair (tid.GetUid (), info.name)) != 0;
+              entries.push_back (entry);
+            }
+          // this could be anything else and we don't know what to do with it.
+          // So, we just ignore it.
+        }
+      nextTid = tid.GetParent ();
+    } while (nextTid != tid);
+  return entries;
+}
+void
+PathAttributeTable::RegisterCachedContainer (TypeId tid, std::string name)
+{
+  NS_LOG_FUNCTION (this << tid << name);
+  if (m_cachedContainers.insert (std::make_pair (tid.GetUid (), name)).second)
+    {
+      m_cachedNames.insert (name);
+      m_entries.clear ();
+    }
+}
+bool
+PathAttributeTable::IsCachedContainerName (const std::string &name) const
+{
+  return m_cachedNames.count (name) != 0;
+}
+
+
 class Resolver
 {
 public:
-  Resolver (std::string path);
+  /**
+   * \param path the path to resolve.
+   * \param end the number of segments of the path to resolve.
+   */
+  Resolver (const CompiledPath &path, uint32_t end);
   virtual ~Resolver ();
 
   void Resolve (Ptr<Object> root);
+  /**
+   * Resolve the end of the path, from an object matched by its beginning.
+   * \param start the first segment to resolve.
+   * \param root the object matched by the segments before start.
+   * \param context the segments which matched root.
+   */
+  void Resolve (uint32_t start, Ptr<Object> root, const std::vector<std::string> &context);
+  /**
+   * \returns true if only names, aggregated objects and declared containers
+   *          were traversed, so that the matched objects can be cached.
+   */
+  bool IsCacheable (void) const;
+protected:
+  /** \returns the segments which matched the current object. */
+  const std::vector<std::string> & GetWorkStack (void) const;
 private:
-  void Canonicalize (void);
-  void DoResolve (std::string path, Ptr<Object> root);
-  void DoArrayResolve (std::string path, const ObjectPtrContainerValue &vector);
+  void DoResolve (uint32_t i, Ptr<Object> root);
+  void DoArrayResolve (uint32_t i, Ptr<Object> root, const ObjectPtrContainerAccessor *accessor);
+  void DoArrayResolveOne (uint32_t i, uint32_t index, Ptr<Object> object);
   void DoResolveOne (Ptr<Object> object);
   std::string GetResolvedPath (void) const;
   virtual void DoOne (Ptr<Object> object, std::string path) = 0;
   std::vector<std::string> m_workStack;
-  std::string m_path;
+  const CompiledPath &m_path;
+  uint32_t m_end;
+  bool m_cacheable;
 };
 
-Resolver::Resolver (std::string path)
-  : m_path (path)
+Resolver::Resolver (const CompiledPath &path, uint32_t end)
+  : m_path (path),
+    m_end (end),
+    m_cacheable (true)
 {
-  NS_LOG_FUNCTION (this << path);
-  Canonicalize ();
+  NS_LOG_FUNCTION (this << &path << end);
 }
 Resolver::~Resolver ()
 {
   NS_LOG_FUNCTION (this);
 }
+
+void 
+Resolver::Resolve (Ptr<Object> root)
+{
+  NS_LOG_FUNCTION (this << root);
+
+  DoResolve (0, root);
+}
+
 void
-Resolver::Canonicalize (void)
+Resolver::Resolve (uint32_t start, Ptr<Object> root, const std::vector<std::string> &context)
 {
-  NS_LOG_FUNCTION (this);
+  NS_LOG_FUNCTION (this << start << root << &context);
 
-  // ensure that we start and end with a '/'
-  std::string::size_type tmp = m_path.find ("/");
-  if (tmp != 0)
-    {
-      // no slash at start
-      m_path = "/" + m_path;
-    }
-  tmp = m_path.find_last_of ("/");
-  if (tmp != (m_path.size () - 1))
-    {
-      // no slash at end
-      m_path = m_path + "/";
-    }
+  m_workStack = context;
+  DoResolve (start, root);
+  m_workStack.clear ();
 }
 
-void 
-Resolver::Resolve (Ptr<Object> root)
+bool
+Resolver::IsCacheable (void) const
 {
-  NS_LOG_FUNCTION (this << root);
+  NS_LOG_FUNCTION (this);
+  return m_cacheable;
+}
 
-  DoResolve (m_path, root);
+const std::vector<std::string> &
+Resolver::GetWorkStack (void) const
+{
+  return m_workStack;
 }
 
 std::string
@@ -318,13 +586,11 @@ Resolver::DoResolveOne (Ptr<Object> object)
 }
 
 void
-Resolver::DoResolve (std::string path, Ptr<Object> root)
+Resolver::DoResolve (uint32_t i, Ptr<Object> root)
 {
-  NS_LOG_FUNCTION (this << path << root);
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
+  NS_LOG_FUNCTION (this << i << root);
 
-  if (next == std::string::npos)
+  if (i == m_end)
     {
       //
       // If root is zero, we're beginning to see if we can use the object name 
@@ -340,8 +606,7 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
         }
       return;
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
+  const std::string &item = m_path.items[i];
 
   //
   // If root is zero, we're beginning to see if we can use the object name 
@@ -352,11 +617,10 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
   //
   if (root == 0)
     {
-      std::string::size_type offset = path.find ("/Names");
-      if (offset == 0)
+      if (item.compare (0, 5, "Names") == 0)
         {
           m_workStack.push_back (item);
-          DoResolve (pathLeft, root);
+          DoResolve (i + 1, root);
           m_workStack.pop_back ();
           return;
         }
@@ -373,7 +637,7 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
     {
       NS_LOG_DEBUG ("Name system resolved item = " << item << " to " << namedObject);
       m_workStack.push_back (item);
-      DoResolve (pathLeft, namedObject);
+      DoResolve (i + 1, namedObject);
       m_workStack.pop_back ();
       return;
     }
@@ -403,109 +667,140 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
           return;
         }
       m_workStack.push_back (item);
-      DoResolve (pathLeft, object);
+      DoResolve (i + 1, object);
       m_workStack.pop_back ();
     }
   else 
     {
       // this is a normal attribute.
-      TypeId tid;
-      TypeId nextTid = root->GetInstanceTypeId ();
-      bool foundMatch = false;
-      
-      do
+      const PathAttributeTable::Entries &entries =
+        Singleton<PathAttributeTable>::Get ()->Lookup (root->GetInstanceTypeId (), item);
+      if (entries.empty ())
+        {
+          NS_LOG_DEBUG ("Requested item="<<item<<" does not exist on path="<<GetResolvedPath ());
+          return;
+        }
+      for (PathAttributeTable::Entries::const_iterator j = entries.begin (); j != entries.end (); ++j)
         {
-          tid = nextTid;
-          
-          for (uint32_t i = 0; i < tid.GetAttributeN(); i++)
+          if (j->container == 0)
             {
-              struct TypeId::AttributeInformation info;
-              info = tid.GetAttribute(i);
-              if (info.name != item && item != "*")
+              NS_LOG_DEBUG ("GetAttribute(ptr)="<<j->name<<" on path="<<GetResolvedPath ());
+              PointerValue ptr;
+              if (!(j->flags & TypeId::ATTR_GET) ||
+                  !j->accessor->Get (PeekPointer (root), ptr))
                 {
-                  continue;
+                  // report the error as usual.
+                  root->GetAttribute (j->name, ptr);
                 }
-              // attempt to cast to a pointer checker.
-              const PointerChecker *ptr = dynamic_cast<const PointerChecker *> (PeekPointer (info.checker));
-              if (ptr != 0)
+              Ptr<Object> object = ptr.Get<Object> ();
+              if (object == 0)
                 {
-                  NS_LOG_DEBUG ("GetAttribute(ptr)="<<info.name<<" on path="<<GetResolvedPath ());
-                  PointerValue ptr;
-                  root->GetAttribute (info.name, ptr);
-                  Ptr<Object> object = ptr.Get<Object> ();
-                  if (object == 0)
-                    {
-                      NS_LOG_ERROR ("Requested object name=\""<<item<<
-                                    "\" exists on path=\""<<GetResolvedPath ()<<"\""
-                                    " but is null.");
-                      continue;
-                    }
-                  foundMatch = true;
-                  m_workStack.push_back (info.name);
-                  DoResolve (pathLeft, object);
-                  m_workStack.pop_back ();
+                  NS_LOG_ERROR ("Requested object name=\""<<item<<
+                                "\" exists on path=\""<<GetResolvedPath ()<<"\""
+                                " but is null.");
+                  continue;
                 }
-              // attempt to cast to an object vector.
-              const ObjectPtrContainerChecker *vectorChecker = 
-                dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker));
-              if (vectorChecker != 0)
+              // pointers may be changed without notice.
+              m_cacheable = false;
+              m_workStack.push_back (j->name);
+              DoResolve (i + 1, object);
+              m_workStack.pop_back ();
+            }
+          else
+            {
+              NS_LOG_DEBUG ("GetAttribute(vector)="<<j->name<<" on path="<<GetResolvedPath ());
+              if (!j->cached)
                 {
-                  NS_LOG_DEBUG ("GetAttribute(vector)="<<info.name<<" on path="<<GetResolvedPath () << pathLeft);
-                  foundMatch = true;
-                  ObjectPtrContainerValue vector;
-                  root->GetAttribute (info.name, vector);
-                  m_workStack.push_back (info.name);
-                  DoArrayResolve (pathLeft, vector);
-                  m_workStack.pop_back ();
+                  m_cacheable = false;
                 }
-              // this could be anything else and we don't know what to do with it.
-              // So, we just ignore it.
+              m_workStack.push_back (j->name);
+              DoArrayResolve (i + 1, root, j->container);
+              m_workStack.pop_back ();
             }
-
-          nextTid = tid.GetParent ();
-        } while (nextTid != tid);
-      
-      if (!foundMatch)
-        {
-          NS_LOG_DEBUG ("Requested item="<<item<<" does not exist on path="<<GetResolvedPath ());
-          return;
         }
     }
 }
 
 void 
-Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &container)
+Resolver::DoArrayResolve (uint32_t i, Ptr<Object> root, const ObjectPtrContainerAccessor *accessor)
 {
-  NS_LOG_FUNCTION(this << path << &container);
-  NS_ASSERT (path != "");
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
-  if (next == std::string::npos)
+  NS_LOG_FUNCTION (this << i << root << accessor);
+  if (i == m_end)
     {
       return;
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
-
-  ArrayMatcher matcher = ArrayMatcher (item);
-  ObjectPtrContainerValue::Iterator it;
-  for (it = container.Begin (); it != container.End (); ++it)
+  uint32_t n;
+  if (!accessor->GetItemN (PeekPointer (root), &n))
     {
-      if (matcher.Matches ((*it).first))
+      return;
+    }
+  const ArrayMatcher &matcher = m_path.matchers[i];
+  uint32_t position = 0;
+  std::vector<uint32_t> indexes;
+  if (matcher.GetIndexes (n, &indexes))
+    {
+      // Most containers are indexed by position: fetch the matching items
+      // directly, as long as their indexes are their positions.
+      std::vector<uint32_t>::const_iterator k;
+      for (k = indexes.begin (); k != indexes.end (); ++k)
         {
-          std::ostringstream oss;
-          oss << (*it).first;
-          m_workStack.push_back (oss.str ());
-          DoResolve (pathLeft, (*it).second);
-          m_workStack.pop_back ();
+          uint32_t index;
+          Ptr<Object> object = accessor->GetItem (PeekPointer (root), *k, &index);
+          if (index != *k)
+            {
+              break;
+            }
+          DoArrayResolveOne (i, index, object);
+          position = *k + 1;
+        }
+      if (k == indexes.end ())
+        {
+          if (position >= n)
+            {
+              return;
+            }
+          // The indexes are sorted and unique: if the last item is indexed
+          // by its position, so are all the others, and none of those left
+          // can match.
+          uint32_t index;
+          accessor->GetItem (PeekPointer (root), n - 1, &index);
+          if (index == n - 1)
+            {
+              return;
+            }
         }
     }
+  // Since the indexes are sorted and unique, the items already
+  // resolved are exactly those before position.
+  for (; position < n; position++)
+    {
+      uint32_t index;
+      Ptr<Object> object = accessor->GetItem (PeekPointer (root), position, &index);
+      if (matcher.Matches (index))
+        {
+          DoArrayResolveOne (i, index, object);
+        }
+    }
+}
+
+void
+Resolver::DoArrayResolveOne (uint32_t i, uint32_t index, Ptr<Object> object)
+{
+  NS_LOG_FUNCTION (this << i << index << object);
+  std::ostringstream oss;
+  oss << index;
+  m_workStack.push_back (oss.str ());
+  DoResolve (i + 1, object);
+  m_workStack.pop_back ();
 }
 
 
 class ConfigImpl 
 {
 public:
+  ConfigImpl ();
+  ~ConfigImpl ();
+
   void Set (std::string path, const AttributeValue &value);
   void ConnectWithoutContext (std::string path, const CallbackBase &cb);
   void Connect (std::string path, const CallbackBase &cb);
@@ -519,12 +814,71 @@ public:
   uint32_t GetRootNamespaceObjectN (void) const;
   Ptr<Object> GetRootNamespaceObject (uint32_t i) const;
 
+  /** Forget the objects matched by the beginning of paths. */
+  void InvalidateCache (void);
+  /** \returns the instance, or zero if it does not exist. */
+  static ConfigImpl * Peek (void);
+
 private:
+  /** An object matched by the beginning of a path. */
+  struct PrefixMatch
+  {
+    Ptr<Object> object;               //!< The matched object.
+    std::vector<std::string> context; //!< The segments which matched it.
+  };
+  /** The objects matched by the beginning of a path. */
+  typedef std::vector<PrefixMatch> PrefixMatches;
+
   void ParsePath (std::string path, std::string *root, std::string *leaf) const;
+  /**
+   * \param path a path.
+   * \returns the path, split into segments.
+   */
+  const CompiledPath & Compile (std::string path);
+  /**
+   * \param path a path.
+   * \returns the number of segments at the beginning of the path which
+   *          designate only aggregated objects and declared containers.
+   */
+  uint32_t GetCachedPrefix (const CompiledPath &path) const;
+  /**
+   * \param path a path.
+   * \param prefix the number of segments to resolve.
+   * \returns the objects matched by the first segments of the path.
+   */
+  const PrefixMatches & LookupPrefixMatches (const CompiledPath &path, uint32_t prefix);
+
   typedef std::vector<Ptr<Object> > Roots;
   Roots m_roots;
+  std::map<std::string, CompiledPath> m_paths;       //!< The paths already parsed.
+  std::map<std::string, PrefixMatches> m_prefixes;   //!< The cached matches, by path prefix.
+  PrefixMatches m_uncached;                          //!< The matches which could not be cached.
+
+  /** The largest number of parsed paths and of cached prefixes. */
+  static const uint32_t MAX_CACHED_PATHS = 4096;
+  static ConfigImpl *g_instance; //!< The instance, while it exists.
 };
 
+ConfigImpl *ConfigImpl::g_instance = 0;
+
+ConfigImpl::ConfigImpl ()
+{
+  NS_LOG_FUNCTION (this);
+  g_instance = this;
+}
+
+ConfigImpl::~ConfigImpl ()
+{
+  NS_LOG_FUNCTION (this);
+  g_instance = 0;
+}
+
+ConfigImpl *
+ConfigImpl::Peek (void)
+{
+  return g_instance;
+}
+
 void 
 ConfigImpl::ParsePath (std::string path, std::string *root, std::string *leaf) const
 {
@@ -537,6 +891,121 @@ ConfigImpl::ParsePath (std::string path, std::string *root, std::string *leaf) c
   NS_LOG_FUNCTION (path << *root << *leaf);
 }
 
+const CompiledPath &
+ConfigImpl::Compile (std::string path)
+{
+  NS_LOG_FUNCTION (this << path);
+  std::map<std::string, CompiledPath>::const_iterator i = m_paths.find (path);
+  if (i != m_paths.end ())
+    {
+      return i->second;
+    }
+  if (m_paths.size () >= MAX_CACHED_PATHS)
+    {
+      m_paths.clear ();
+    }
+  CompiledPath &compiled = m_paths[path];
+
+  // ensure that we start and end with a '/'
+  std::string::size_type tmp = path.find ("/");
+  if (tmp != 0)
+    {
+      // no slash at start
+      path = "/" + path;
+    }
+  tmp = path.find_last_of ("/");
+  if (tmp != (path.size () - 1))
+    {
+      // no slash at end
+      path = path + "/";
+    }
+  std::string::size_type start = 1;
+  while (start < path.size ())
+    {
+      std::string::size_type next = path.find ("/", start);
+      std::string item = path.substr (start, next - start);
+      compiled.items.push_back (item);
+      compiled.matchers.push_back (ArrayMatcher (item));
+      start = next + 1;
+    }
+  return compiled;
+}
+
+uint32_t
+ConfigImpl::GetCachedPrefix (const CompiledPath &path) const
+{
+  NS_LOG_FUNCTION (this << &path);
+  const PathAttributeTable *table = Singleton<PathAttributeTable>::Get ();
+  uint32_t i = 0;
+  while (i < path.items.size ())
+    {
+      const std::string &item = path.items[i];
+      if (item.find ("$") == 0)
+        {
+          i++;
+        }
+      else if (i + 1 < path.items.size () && table->IsCachedContainerName (item))
+        {
+          i += 2;
+        }
+      else
+        {
+          break;
+        }
+    }
+  return i;
+}
+
+const ConfigImpl::PrefixMatches &
+ConfigImpl::LookupPrefixMatches (const CompiledPath &path, uint32_t prefix)
+{
+  NS_LOG_FUNCTION (this << &path << prefix);
+  std::string key;
+  for (uint32_t i = 0; i < prefix; i++)
+    {
+      key += "/" + path.items[i];
+    }
+  std::map<std::string, PrefixMatches>::const_iterator it = m_prefixes.find (key);
+  if (it != m_prefixes.end ())
+    {
+      NS_LOG_DEBUG ("cached prefix=" << key);
+      return it->second;
+    }
+  class PrefixResolver : public Resolver 
+  {
+  public:
+    PrefixResolver (const CompiledPath &path, uint32_t end, PrefixMatches *matches)
+      : Resolver (path, end),
+        m_matches (matches)
+    {}
+    virtual void DoOne (Ptr<Object> object, std::string path) {
+      PrefixMatch match;
+      match.object = object;
+      match.context = GetWorkStack ();
+      m_matches->push_back (match);
+    }
+    PrefixMatches *m_matches;
+  };
+  PrefixMatches matches;
+  PrefixResolver resolver (path, prefix, &matches);
+  for (Roots::const_iterator i = m_roots.begin (); i != m_roots.end (); i++)
+    {
+      resolver.Resolve (*i);
+    }
+  if (!resolver.IsCacheable ())
+    {
+      m_uncached.swap (matches);
+      return m_uncached;
+    }
+  if (m_prefixes.size () >= MAX_CACHED_PATHS)
+    {
+      m_prefixes.clear ();
+    }
+  PrefixMatches &cached = m_prefixes[key];
+  cached.swap (matches);
+  return cached;
+}
+
 void 
 ConfigImpl::Set (std::string path, const AttributeValue &value)
 {
@@ -593,8 +1062,8 @@ ConfigImpl::LookupMatches (std::string path)
   class LookupMatchesResolver : public Resolver 
   {
   public:
-    LookupMatchesResolver (std::string path)
-      : Resolver (path)
+    LookupMatchesResolver (const CompiledPath &path)
+      : Resolver (path, path.items.size ())
     {}
     virtual void DoOne (Ptr<Object> object, std::string path) {
       m_objects.push_back (object);
@@ -602,10 +1071,30 @@ ConfigImpl::LookupMatches (std::string path)
     }
     std::vector<Ptr<Object> > m_objects;
     std::vector<std::string> m_contexts;
-  } resolver = LookupMatchesResolver (path);
-  for (Roots::const_iterator i = m_roots.begin (); i != m_roots.end (); i++)
+  };
+  const CompiledPath &compiled = Compile (path);
+  LookupMatchesResolver resolver (compiled);
+  uint32_t prefix = GetCachedPrefix (compiled);
+  if (prefix > 0)
     {
-      resolver.Resolve (*i);
+      //
+      // The objects matched by the beginning of the path change only when
+      // Config::InvalidateCache is called: resolve the rest of the path
+      // from them.
+      //
+      const PrefixMatches &matches = LookupPrefixMatches (compiled, prefix);
+      for (PrefixMatches::const_iterator i = matches.begin (); i != matches.end (); ++i)
+        {
+          resolver.Resolve (prefix, i->object, i->context);
+        }
+      m_uncached.clear ();
+    }
+  else
+    {
+      for (Roots::const_iterator i = m_roots.begin (); i != m_roots.end (); i++)
+        {
+          resolver.Resolve (*i);
+        }
     }
 
   //
@@ -623,6 +1112,7 @@ ConfigImpl::RegisterRootNamespaceObject (Ptr<Object> obj)
 {
   NS_LOG_FUNCTION (this << obj);
   m_roots.push_back (obj);
+  InvalidateCache ();
 }
 
 void 
@@ -635,6 +1125,7 @@ ConfigImpl::UnregisterRootNamespaceObject (Ptr<Object> obj)
       if (*i == obj)
         {
           m_roots.erase (i);
+          InvalidateCache ();
           return;
         }
     }
@@ -653,6 +1144,13 @@ ConfigImpl::GetRootNamespaceObject (uint32_t i) const
   return m_roots[i];
 }
 
+void
+ConfigImpl::InvalidateCache (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_prefixes.clear ();
+}
+
 namespace Config {
 
 void Reset (void)
@@ -770,6 +1268,25 @@ void UnregisterRootNamespaceObject (Ptr<Object> obj)
   Singleton<ConfigImpl>::Get ()->UnregisterRootNamespaceObject (obj);
 }
 
+void RegisterCachedContainer (TypeId tid, std::string name)
+{
+  NS_LOG_FUNCTION (tid << name);
+  Singleton<PathAttributeTable>::Get ()->RegisterCachedContainer (tid, name);
+  InvalidateCache ();
+}
+
+void InvalidateCache (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  // may be called during the destruction of static objects: do not
+  // create the ConfigImpl instance again.
+  ConfigImpl *impl = ConfigImpl::Peek ();
+  if (impl != 0)
+    {
+      impl->InvalidateCache ();
+    }
+}
+
 uint32_t GetRootNamespaceObjectN (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
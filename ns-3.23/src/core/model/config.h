@@ -35,6 +35,8 @@ namespace ns3 {
 class AttributeValue;
 class Object;
 class CallbackBase;
+class TypeId;
+class TraceSourceAccessor;
 
 /**
  * \ingroup core
@@ -233,6 +235,16 @@ public:
    */
   void DisconnectWithoutContext (std::string name, const CallbackBase &cb);
 private:
+  /**
+   * \param i index of the item whose trace source is needed.
+   * \param name the name of the trace source.
+   * \param tid the TypeId of the previous item, updated.
+   * \param accessor the trace source of the previous item.
+   * \returns the trace source of item i, zero if it has none.
+   */
+  Ptr<const TraceSourceAccessor> LookupTraceSource (uint32_t i, std::string name, TypeId *tid,
+                                                    Ptr<const TraceSourceAccessor> accessor) const;
+
   std::vector<Ptr<Object> > m_objects;
   std::vector<std::string> m_contexts;
   std::string m_path;
@@ -262,6 +274,32 @@ void RegisterRootNamespaceObject (Ptr<Object> obj);
  */
 void UnregisterRootNamespaceObject (Ptr<Object> obj);
 
+/**
+ * \ingroup config
+ * \param tid the TypeId which defines a container attribute.
+ * \param name the name of the container attribute, an ObjectVector or
+ *        ObjectMap.
+ *
+ * Declare that the code which modifies the content of this container
+ * calls Config::InvalidateCache. The objects matched by the beginning of
+ * a path are cached when this path goes only through root namespace
+ * objects, names, aggregated objects ("$ns3::Type") and declared
+ * containers, such as "/NodeList/[i]/DeviceList/[i]/$ns3::WifiNetDevice"
+ * since ns3::NodeList and ns3::Node declare their containers. The rest
+ * of the path is resolved every time.
+ */
+void RegisterCachedContainer (TypeId tid, std::string name);
+
+/**
+ * \ingroup config
+ *
+ * Forget the objects matched by the beginning of paths. This is done
+ * when an object is aggregated, when names or root namespace objects
+ * change, and must be done whenever the content of a container declared
+ * with Config::RegisterCachedContainer changes.
+ */
+void InvalidateCache (void);
+
 /**
  * \ingroup config
  * \returns the number of registered root namespace objects.
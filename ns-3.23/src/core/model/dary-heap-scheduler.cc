@@ -0,0 +1,199 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "dary-heap-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::DaryHeapScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DaryHeapScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (DaryHeapScheduler);
+
+TypeId
+DaryHeapScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DaryHeapScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<DaryHeapScheduler> ()
+  ;
+  return tid;
+}
+
+DaryHeapScheduler::DaryHeapScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+DaryHeapScheduler::~DaryHeapScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+DaryHeapScheduler::Parent (uint32_t id) const
+{
+  return (id - 1) / ARITY;
+}
+
+uint32_t
+DaryHeapScheduler::FirstChild (uint32_t id) const
+{
+  return id * ARITY + 1;
+}
+
+void
+DaryHeapScheduler::Store (uint32_t id, const EventKey &key, EventImpl *impl)
+{
+  m_keys[id] = key;
+  m_impls[id] = impl;
+  impl->SetSchedulerSlot (id);
+}
+
+void
+DaryHeapScheduler::SiftUp (uint32_t id, const EventKey &key, EventImpl *impl)
+{
+  while (id != 0)
+    {
+      uint32_t parent = Parent (id);
+      if (!(key < m_keys[parent]))
+        {
+          break;
+        }
+      Store (id, m_keys[parent], m_impls[parent]);
+      id = parent;
+    }
+  Store (id, key, impl);
+}
+
+void
+DaryHeapScheduler::SiftDown (uint32_t id, const EventKey &key, EventImpl *impl)
+{
+  uint32_t size = m_keys.size ();
+  while (true)
+    {
+      uint32_t first = FirstChild (id);
+      if (first >= size)
+        {
+          break;
+        }
+      uint32_t end = first + ARITY;
+      if (end > size)
+        {
+          end = size;
+        }
+      uint32_t smallest = first;
+      for (uint32_t child = first + 1; child < end; child++)
+        {
+          if (m_keys[child] < m_keys[smallest])
+            {
+              smallest = child;
+            }
+        }
+      if (!(m_keys[smallest] < key))
+        {
+          break;
+        }
+      Store (id, m_keys[smallest], m_impls[smallest]);
+      id = smallest;
+    }
+  Store (id, key, impl);
+}
+
+void
+DaryHeapScheduler::RemoveAt (uint32_t id)
+{
+  uint32_t last = m_keys.size () - 1;
+  EventKey key = m_keys[last];
+  EventImpl *impl = m_impls[last];
+  m_keys.pop_back ();
+  m_impls.pop_back ();
+  if (id == last)
+    {
+      return;
+    }
+  // Fill the hole with the last element: it may need to travel in
+  // either direction when the hole is not at the root.
+  if (id != 0 && key < m_keys[Parent (id)])
+    {
+      SiftUp (id, key, impl);
+    }
+  else
+    {
+      SiftDown (id, key, impl);
+    }
+}
+
+void
+DaryHeapScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  m_keys.push_back (ev.key);
+  m_impls.push_back (ev.impl);
+  SiftUp (m_keys.size () - 1, ev.key, ev.impl);
+}
+
+bool
+DaryHeapScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_keys.empty ();
+}
+
+Scheduler::Event
+DaryHeapScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Event next;
+  next.impl = m_impls[0];
+  next.key = m_keys[0];
+  return next;
+}
+
+Scheduler::Event
+DaryHeapScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Event next;
+  next.impl = m_impls[0];
+  next.key = m_keys[0];
+  RemoveAt (0);
+  return next;
+}
+
+void
+DaryHeapScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  uint32_t id = ev.impl->GetSchedulerSlot ();
+  NS_ASSERT (id < m_keys.size ());
+  NS_ASSERT (m_impls[id] == ev.impl);
+  NS_ASSERT (m_keys[id].m_uid == ev.key.m_uid);
+  RemoveAt (id);
+}
+
+} // namespace ns3
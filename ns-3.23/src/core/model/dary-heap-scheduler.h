@@ -0,0 +1,98 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DARY_HEAP_SCHEDULER_H
+#define DARY_HEAP_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::DaryHeapScheduler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a 4-ary indexed heap event scheduler
+ *
+ * This scheduler differs from HeapScheduler in three ways:
+ *  - each node has four children instead of two, which halves the
+ *    depth of the heap. The four sibling keys are adjacent in memory
+ *    (4 x 16 bytes), so picking the smallest child touches a single
+ *    cache line on most hosts.
+ *  - the sort keys and the EventImpl pointers are stored in two
+ *    separate arrays, so that the comparisons done while sifting
+ *    never load the (cold) EventImpl pointers.
+ *  - the position of every pending event in the heap is recorded in
+ *    the event itself (see EventImpl::SetSchedulerSlot), so Remove
+ *    runs in O(log n) instead of the linear search done by
+ *    HeapScheduler::Remove.
+ *
+ * Sifting moves a "hole" rather than swapping elements, so each level
+ * costs one key copy instead of three.
+ */
+class DaryHeapScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  DaryHeapScheduler ();
+  virtual ~DaryHeapScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Event PeekNext (void) const;
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+
+private:
+  /** Number of children of each node. */
+  static const uint32_t ARITY = 4;
+
+  inline uint32_t Parent (uint32_t id) const;
+  inline uint32_t FirstChild (uint32_t id) const;
+  /**
+   * Store an event at a given position and record that position
+   * in the event.
+   */
+  inline void Store (uint32_t id, const EventKey &key, EventImpl *impl);
+  /**
+   * Move the hole at position id towards the root until key fits,
+   * then store the event there.
+   */
+  void SiftUp (uint32_t id, const EventKey &key, EventImpl *impl);
+  /**
+   * Move the hole at position id towards the leaves until key fits,
+   * then store the event there.
+   */
+  void SiftDown (uint32_t id, const EventKey &key, EventImpl *impl);
+  /** Remove the event stored at position id. */
+  void RemoveAt (uint32_t id);
+
+  /** Sort keys, in heap order. */
+  std::vector<Scheduler::EventKey> m_keys;
+  /** Events, at the same positions as their keys in m_keys. */
+  std::vector<EventImpl *> m_impls;
+};
+
+} // namespace ns3
+
+#endif /* DARY_HEAP_SCHEDULER_H */
@@ -27,8 +27,15 @@
 #include "pointer.h"
 #include "assert.h"
 #include "log.h"
+#include "uinteger.h"
+#include "boolean.h"
+#include "string.h"
 
+#include <algorithm>
 #include <cmath>
+#include <fstream>
+#include <iostream>
+#include <vector>
 
 
 /**
@@ -53,11 +60,36 @@ DefaultSimulatorImpl::GetTypeId (void)
     .SetParent<SimulatorImpl> ()
     .SetGroupName ("Core")
     .AddConstructor<DefaultSimulatorImpl> ()
+    .AddAttribute ("ProfileSampling",
+                   "Time one event out of this number, on average, to "
+                   "report where the time of the simulation goes when "
+                   "it is destroyed. 0 disables event profiling.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&DefaultSimulatorImpl::SetProfileSampling,
+                                         &DefaultSimulatorImpl::GetProfileSampling),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("ProfileFile",
+                   "The file where the event profile is written. "
+                   "By default, it goes to the standard error.",
+                   StringValue (""),
+                   MakeStringAccessor (&DefaultSimulatorImpl::m_profileFile),
+                   MakeStringChecker ())
+    .AddAttribute ("EventBatching",
+                   "Append the events inserted in a row with the same "
+                   "timestamp to a FIFO rather than to the scheduler.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&DefaultSimulatorImpl::SetEventBatching,
+                                        &DefaultSimulatorImpl::GetEventBatching),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
 
+const uint32_t DefaultSimulatorImpl::EVENTS_WITH_CONTEXT_CAPACITY;
+
 DefaultSimulatorImpl::DefaultSimulatorImpl ()
+  : m_eventsWithContext (EVENTS_WITH_CONTEXT_CAPACITY),
+    m_eventsWithContextOverflowing (false)
 {
   NS_LOG_FUNCTION (this);
   m_stop = false;
@@ -71,8 +103,15 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = 0xffffffff;
   m_unscheduledEvents = 0;
-  m_eventsWithContextEmpty = true;
   m_main = SystemThread::Self();
+  m_batching = true;
+  m_batchTs = 0;
+  // no event was inserted yet: this cannot match a timestamp.
+  m_lastInsertTs = ~static_cast<uint64_t> (0);
+  m_batchStats.events = 0;
+  m_batchStats.batchedEvents = 0;
+  m_batchStats.batches = 0;
+  m_batchStats.largestBatch = 0;
 }
 
 DefaultSimulatorImpl::~DefaultSimulatorImpl ()
@@ -84,9 +123,9 @@ void
 DefaultSimulatorImpl::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
-  while (!m_events->IsEmpty ())
+  while (!IsEmpty ())
     {
-      Scheduler::Event next = m_events->RemoveNext ();
+      Scheduler::Event next = RemoveNext ();
       next.impl->Unref ();
     }
   m_events = 0;
@@ -106,6 +145,172 @@ DefaultSimulatorImpl::Destroy ()
           ev->Invoke ();
         }
     }
+  if (m_profiler.GetEventCount () > 0)
+    {
+      if (m_profileFile.empty ())
+        {
+          m_profiler.Report (std::cerr);
+        }
+      else
+        {
+          std::ofstream os (m_profileFile.c_str ());
+          if (!os.is_open ())
+            {
+              NS_LOG_ERROR ("Cannot open profile file " << m_profileFile);
+            }
+          m_profiler.Report (os);
+        }
+      m_profiler.Clear ();
+    }
+}
+
+void
+DefaultSimulatorImpl::SetProfileSampling (uint32_t period)
+{
+  NS_LOG_FUNCTION (this << period);
+  m_profiler.SetSampling (period);
+}
+
+uint32_t
+DefaultSimulatorImpl::GetProfileSampling (void) const
+{
+  return m_profiler.GetSampling ();
+}
+
+const EventProfiler &
+DefaultSimulatorImpl::GetProfiler (void) const
+{
+  return m_profiler;
+}
+
+void
+DefaultSimulatorImpl::SetEventBatching (bool enable)
+{
+  NS_LOG_FUNCTION (this << enable);
+  if (!enable && m_events != 0)
+    {
+      FlushBatch ();
+    }
+  m_batching = enable;
+}
+
+bool
+DefaultSimulatorImpl::GetEventBatching (void) const
+{
+  return m_batching;
+}
+
+EventBatchStats
+DefaultSimulatorImpl::GetBatchStats (void) const
+{
+  return m_batchStats;
+}
+
+void
+DefaultSimulatorImpl::FlushBatch (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_batch.empty ())
+    {
+      m_events->Insert (m_batch.front ());
+      m_batch.pop_front ();
+    }
+}
+
+void
+DefaultSimulatorImpl::Insert (const Scheduler::Event &ev)
+{
+  uint64_t ts = ev.key.m_ts;
+  if (m_batching)
+    {
+      // The uids are increasing: appending keeps the batch sorted.
+      // The first event of a timestamp goes to the scheduler, so that
+      // isolated events never pay for the merge in RemoveNext.
+      if (m_batch.empty () ? ts == m_lastInsertTs : ts == m_batchTs)
+        {
+          if (m_batch.empty ())
+            {
+              m_batchTs = ts;
+              m_batchStats.batches++;
+            }
+          m_batch.push_back (ev);
+          m_batchStats.largestBatch = std::max (m_batchStats.largestBatch,
+                                                static_cast<uint32_t> (m_batch.size ()));
+          return;
+        }
+      m_lastInsertTs = ts;
+    }
+  m_events->Insert (ev);
+}
+
+Scheduler::Event
+DefaultSimulatorImpl::RemoveNext (void)
+{
+  if (m_batch.empty ()
+      || (!m_events->IsEmpty () && m_events->PeekNext ().key < m_batch.front ().key))
+    {
+      return m_events->RemoveNext ();
+    }
+  Scheduler::Event next = m_batch.front ();
+  m_batch.pop_front ();
+  m_batchStats.batchedEvents++;
+  return next;
+}
+
+bool
+DefaultSimulatorImpl::IsEmpty (void) const
+{
+  return m_batch.empty () && m_events->IsEmpty ();
+}
+
+uint32_t
+DefaultSimulatorImpl::Reset (Time const &time)
+{
+  NS_LOG_FUNCTION (this << time);
+  NS_ASSERT_MSG (SystemThread::Equals (m_main), "Simulator::Reset Thread-unsafe invocation!");
+  ProcessEventsWithContext ();
+  uint32_t discarded = 0;
+  while (!IsEmpty ())
+    {
+      Scheduler::Event next = RemoveNext ();
+      if (!next.impl->IsCancelled ())
+        {
+          discarded++;
+        }
+      next.impl->Cancel ();
+      next.impl->Unref ();
+    }
+  m_unscheduledEvents = 0;
+  m_currentTs = time.GetTimeStep ();
+  m_currentUid = 0;
+  m_currentContext = 0xffffffff;
+  m_stop = false;
+  return discarded;
+}
+
+uint32_t
+DefaultSimulatorImpl::CountPendingEvents (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (SystemThread::Equals (m_main), "Simulator::CountPendingEvents Thread-unsafe invocation!");
+  ProcessEventsWithContext ();
+  FlushBatch ();
+  std::vector<Scheduler::Event> events;
+  while (!m_events->IsEmpty ())
+    {
+      events.push_back (m_events->RemoveNext ());
+    }
+  uint32_t pending = 0;
+  for (std::vector<Scheduler::Event>::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      if (!i->impl->IsCancelled ())
+        {
+          pending++;
+        }
+      // the keys are unchanged, so the events keep their order.
+      m_events->Insert (*i);
+    }
+  return pending;
 }
 
 void
@@ -116,6 +321,7 @@ DefaultSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
 
   if (m_events != 0)
     {
+      FlushBatch ();
       while (!m_events->IsEmpty ())
         {
           Scheduler::Event next = m_events->RemoveNext ();
@@ -135,16 +341,24 @@ DefaultSimulatorImpl::GetSystemId (void) const
 void
 DefaultSimulatorImpl::ProcessOneEvent (void)
 {
-  Scheduler::Event next = m_events->RemoveNext ();
+  Scheduler::Event next = RemoveNext ();
 
   NS_ASSERT (next.key.m_ts >= m_currentTs);
   m_unscheduledEvents--;
+  m_batchStats.events++;
 
   NS_LOG_LOGIC ("handle " << next.key.m_ts);
   m_currentTs = next.key.m_ts;
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
-  next.impl->Invoke ();
+  if (m_profiler.IsEnabled ())
+    {
+      m_profiler.Invoke (next.impl, m_currentContext);
+    }
+  else
+    {
+      next.impl->Invoke ();
+    }
   next.impl->Unref ();
 
   ProcessEventsWithContext ();
@@ -153,36 +367,59 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
 bool 
 DefaultSimulatorImpl::IsFinished (void) const
 {
-  return m_events->IsEmpty () || m_stop;
+  return IsEmpty () || m_stop;
+}
+
+void
+DefaultSimulatorImpl::InsertEventWithContext (const EventWithContext &event)
+{
+  Scheduler::Event ev;
+  ev.impl = event.event;
+  ev.key.m_ts = m_currentTs + event.timestamp;
+  ev.key.m_context = event.context;
+  ev.key.m_uid = m_uid;
+  m_uid++;
+  m_unscheduledEvents++;
+  Insert (ev);
+}
+
+void
+DefaultSimulatorImpl::DrainEventsWithContext (void)
+{
+  EventWithContext event;
+  while (m_eventsWithContext.Pop (event))
+    {
+      InsertEventWithContext (event);
+    }
 }
 
 void
 DefaultSimulatorImpl::ProcessEventsWithContext (void)
 {
-  if (m_eventsWithContextEmpty)
+  if (m_eventsWithContext.IsEmpty () && !m_eventsWithContextOverflowing)
+    {
+      return;
+    }
+
+  DrainEventsWithContext ();
+  if (!m_eventsWithContextOverflowing)
     {
       return;
     }
 
-  // swap queues
   EventsWithContext eventsWithContext;
   {
     CriticalSection cs (m_eventsWithContextMutex);
-    m_eventsWithContext.swap(eventsWithContext);
-    m_eventsWithContextEmpty = true;
+    // A thread only uses the overflow list after its previous events
+    // were published in the ring: drain these first.
+    DrainEventsWithContext ();
+    m_eventsWithContextOverflow.swap (eventsWithContext);
+    m_eventsWithContextOverflowing = false;
   }
-  while (!eventsWithContext.empty ())
+  for (EventsWithContext::const_iterator i = eventsWithContext.begin ();
+       i != eventsWithContext.end (); ++i)
     {
-       EventWithContext event = eventsWithContext.front ();
-       eventsWithContext.pop_front ();
-       Scheduler::Event ev;
-       ev.impl = event.event;
-       ev.key.m_ts = m_currentTs + event.timestamp;
-       ev.key.m_context = event.context;
-       ev.key.m_uid = m_uid;
-       m_uid++;
-       m_unscheduledEvents++;
-       m_events->Insert (ev);
+      InsertEventWithContext (*i);
     }
 }
 
@@ -195,14 +432,14 @@ DefaultSimulatorImpl::Run (void)
   ProcessEventsWithContext ();
   m_stop = false;
 
-  while (!m_events->IsEmpty () && !m_stop) 
+  while (!IsEmpty () && !m_stop) 
     {
       ProcessOneEvent ();
     }
 
   // If the simulator stopped naturally by lack of events, make a
   // consistency test to check that we didn't lose any events along the way.
-  NS_ASSERT (!m_events->IsEmpty () || m_unscheduledEvents == 0);
+  NS_ASSERT (!IsEmpty () || m_unscheduledEvents == 0);
 }
 
 void 
@@ -239,7 +476,7 @@ DefaultSimulatorImpl::Schedule (Time const &time, EventImpl *event)
   ev.key.m_uid = m_uid;
   m_uid++;
   m_unscheduledEvents++;
-  m_events->Insert (ev);
+  Insert (ev);
   return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
 }
 
@@ -258,7 +495,7 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time, E
       ev.key.m_uid = m_uid;
       m_uid++;
       m_unscheduledEvents++;
-      m_events->Insert (ev);
+      Insert (ev);
     }
   else
     {
@@ -266,11 +503,12 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time, E
       ev.context = context;
       ev.timestamp = time.GetTimeStep ();
       ev.event = event;
-      {
-        CriticalSection cs (m_eventsWithContextMutex);
-        m_eventsWithContext.push_back(ev);
-        m_eventsWithContextEmpty = false;
-      }
+      if (m_eventsWithContextOverflowing || !m_eventsWithContext.Push (ev))
+        {
+          CriticalSection cs (m_eventsWithContextMutex);
+          m_eventsWithContextOverflow.push_back (ev);
+          m_eventsWithContextOverflowing = true;
+        }
     }
 }
 
@@ -286,7 +524,7 @@ DefaultSimulatorImpl::ScheduleNow (EventImpl *event)
   ev.key.m_uid = m_uid;
   m_uid++;
   m_unscheduledEvents++;
-  m_events->Insert (ev);
+  Insert (ev);
   return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
 }
 
@@ -346,7 +584,19 @@ DefaultSimulatorImpl::Remove (const EventId &id)
   event.key.m_ts = id.GetTs ();
   event.key.m_context = id.GetContext ();
   event.key.m_uid = id.GetUid ();
-  m_events->Remove (event);
+  std::deque<Scheduler::Event>::iterator i = m_batch.end ();
+  if (!m_batch.empty () && event.key.m_ts == m_batchTs)
+    {
+      i = std::lower_bound (m_batch.begin (), m_batch.end (), event);
+    }
+  if (i != m_batch.end () && i->key.m_uid == event.key.m_uid)
+    {
+      m_batch.erase (i);
+    }
+  else
+    {
+      m_events->Remove (event);
+    }
   event.impl->Cancel ();
   // whenever we remove an event from the event list, we have to unref it.
   event.impl->Unref ();
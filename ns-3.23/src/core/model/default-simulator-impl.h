@@ -26,10 +26,14 @@
 #include "event-impl.h"
 #include "system-thread.h"
 #include "ns3/system-mutex.h"
+#include "mpsc-queue.h"
+#include "event-profiler.h"
 
 #include "ptr.h"
 
+#include <deque>
 #include <list>
+#include <string>
 
 /**
  * \file
@@ -39,10 +43,35 @@
 
 namespace ns3 {
 
+/**
+ * \ingroup simulator
+ * Counters describing the use of the same-timestamp fast path of
+ * DefaultSimulatorImpl.
+ */
+struct EventBatchStats
+{
+  uint64_t events;         /**< Number of events run. */
+  uint64_t batchedEvents;  /**< Number of events run without going through the scheduler. */
+  uint64_t batches;        /**< Number of timestamps which used the fast path. */
+  uint32_t largestBatch;   /**< Largest number of events held by the fast path. */
+};
+
 /**
  * \ingroup simulator
  *
  * The default single process simulator implementation.
+ *
+ * Setting the ProfileSampling attribute enables an EventProfiler: the
+ * time spent in the events is then reported by function, object type
+ * and node context when the simulator is destroyed.
+ *
+ * When the EventBatching attribute is set, as it is by default, events
+ * inserted in a row with the same timestamp (a broadcast delivered to
+ * many receivers, for example) are appended to a FIFO instead of being
+ * inserted in the scheduler. Events have increasing uids, so that FIFO
+ * is sorted and is merged with the scheduler when events are removed,
+ * which preserves the order of execution. Only one timestamp uses the
+ * FIFO at a time. GetBatchStats tells how many events took this path.
  */
 class DefaultSimulatorImpl : public SimulatorImpl
 {
@@ -71,19 +100,97 @@ public:
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
 
+  /**
+   * \returns The profiler of the events run by this simulator.
+   */
+  const EventProfiler &GetProfiler (void) const;
+  /**
+   * \returns The counters of the same-timestamp fast path since the
+   *   creation of this simulator.
+   */
+  EventBatchStats GetBatchStats (void) const;
+  /**
+   * Cancel and discard all the pending events, except the destroy
+   * events, and move the clock to a new time. This is used to resume
+   * a simulation from a Checkpoint.
+   * \param [in] time The new current time.
+   * \returns The number of discarded events which were not cancelled.
+   */
+  uint32_t Reset (Time const &time);
+  /**
+   * Count the pending events, except the destroy events. The
+   * schedulers cannot be iterated, so this takes all the events out
+   * of the scheduler and puts them back: it is meant for rare uses
+   * such as Checkpoint::Save.
+   * \returns The number of pending events which are not cancelled.
+   */
+  uint32_t CountPendingEvents (void);
+
 private:
   virtual void DoDispose (void);
   void ProcessOneEvent (void);
   void ProcessEventsWithContext (void);
- 
+  /** Move all the events published in m_eventsWithContext to the scheduler. */
+  void DrainEventsWithContext (void);
+  /**
+   * Set the sampling period of the event profiler.
+   * \param [in] period The sampling period, 0 to disable profiling.
+   */
+  void SetProfileSampling (uint32_t period);
+  /** \returns The sampling period of the event profiler. */
+  uint32_t GetProfileSampling (void) const;
+  /**
+   * Enable or disable the same-timestamp fast path.
+   * \param [in] enable Whether to use it.
+   */
+  void SetEventBatching (bool enable);
+  /** \returns Whether the same-timestamp fast path is used. */
+  bool GetEventBatching (void) const;
+  /**
+   * Insert an event in the batch or in the scheduler.
+   * \param [in] ev The event.
+   */
+  void Insert (const Scheduler::Event &ev);
+  /**
+   * Remove the earliest event of the batch and of the scheduler.
+   * \returns The event.
+   */
+  Scheduler::Event RemoveNext (void);
+  /** \returns true if there are no pending events. */
+  bool IsEmpty (void) const;
+  /** Move the events of the batch to the scheduler. */
+  void FlushBatch (void);
+
   struct EventWithContext {
     uint32_t context;
     uint64_t timestamp;
     EventImpl *event;
   };
+  /**
+   * Insert an event received from another thread in the scheduler.
+   * \param [in] event The event.
+   */
+  void InsertEventWithContext (const EventWithContext &event);
+
+  /** Capacity of m_eventsWithContext. */
+  static const uint32_t EVENTS_WITH_CONTEXT_CAPACITY = 1024;
+
+  /**
+   * Events scheduled from other threads. Producers never lock this
+   * ring: only when it is full do they fall back to
+   * m_eventsWithContextOverflow.
+   */
+  MpscQueue<struct EventWithContext> m_eventsWithContext;
   typedef std::list<struct EventWithContext> EventsWithContext;
-  EventsWithContext m_eventsWithContext;
-  bool m_eventsWithContextEmpty;
+  /** Events which did not fit in m_eventsWithContext. */
+  EventsWithContext m_eventsWithContextOverflow;
+  /**
+   * Set while m_eventsWithContextOverflow is not empty. Producers keep
+   * using the overflow list while it is set, so that the events of
+   * each thread are inserted in the order they were scheduled.
+   */
+  volatile bool m_eventsWithContextOverflowing;
+  /** Protects m_eventsWithContextOverflow. */
   SystemMutex m_eventsWithContextMutex;
 
   typedef std::list<EventId> DestroyEvents;
@@ -100,6 +207,15 @@ private:
   int m_unscheduledEvents;
 
   SystemThread::ThreadId m_main;
+
+  bool m_batching;                   /**< Use the same-timestamp fast path. */
+  std::deque<Scheduler::Event> m_batch; /**< Events with timestamp m_batchTs, by uid. */
+  uint64_t m_batchTs;                /**< The timestamp of the events in m_batch. */
+  uint64_t m_lastInsertTs;           /**< The timestamp of the last event inserted. */
+  EventBatchStats m_batchStats;      /**< Fast path counters. */
+
+  EventProfiler m_profiler;     /**< Profiles the events. */
+  std::string m_profileFile;    /**< Where to write the profile. */
 };
 
 } // namespace ns3
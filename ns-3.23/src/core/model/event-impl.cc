@@ -20,6 +20,12 @@
 
 #include "event-impl.h"
 #include "log.h"
+#include "ns3/core-config.h"
+#include <new>
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 /**
  * \file
@@ -31,13 +37,277 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
+/**
+ * \ingroup events
+ * \defgroup eventpool EventImpl memory pool.
+ *
+ * Events are allocated and released at a very high rate. Each thread
+ * which allocates events has its own pool: blocks are carved out of
+ * large slabs, in size classes which are multiples of
+ * EVENT_POOL_GRANULARITY bytes up to EVENT_POOL_MAX_SIZE, and released
+ * blocks are kept in one free list per size class for the next events
+ * of the same class. Each block starts with a header which records the
+ * pool it belongs to, so a block released by another thread, for
+ * instance an event scheduled across the partitions of a multithreaded
+ * simulation, goes back to its own pool: it is pushed on a lock-free
+ * stack which the owning thread drains when a free list runs out.
+ *
+ * The pool of a thread which exits is adopted by the next thread which
+ * needs one, with its slabs and its counters, so the blocks it still
+ * has out remain valid. Pools and slabs are never freed, so events may
+ * be created and released during static initialization and
+ * destruction.
+ */
+/**
+ * \ingroup eventpool
+ * @{
+ */
+/** Size classes are multiples of this number of bytes. */
+#define EVENT_POOL_GRANULARITY 16
+/** Events larger than this use the system allocator. */
+#define EVENT_POOL_MAX_SIZE 256
+/** Number of size classes. */
+#define EVENT_POOL_CLASSES (EVENT_POOL_MAX_SIZE / EVENT_POOL_GRANULARITY)
+/** The size of the slabs blocks are carved out of. */
+#define EVENT_POOL_SLAB_SIZE 65536
+
+struct EventPool;
+
+/** The header of a block. The event follows it. */
+struct EventPoolBlock
+{
+  EventPool *owner;     //!< The pool of the allocating thread.
+  EventPoolBlock *next; //!< The next block of a free list.
+};
+
+/** The pool of a thread. */
+struct EventPool
+{
+  EventPoolBlock *free[EVENT_POOL_CLASSES]; //!< The free blocks of each size class.
+  EventPoolBlock * volatile remote;         //!< The blocks released by other threads.
+  uint8_t *slab;                            //!< The unused part of the current slab.
+  uint8_t *slabEnd;                         //!< The end of the current slab.
+  uint64_t allocations;                     //!< Number of blocks allocated.
+  uint64_t reused;                          //!< Number of blocks taken from a free list.
+  uint64_t frees;                           //!< Number of blocks released by the owning thread.
+  volatile uint64_t remoteFrees;            //!< Number of blocks released by other threads.
+  int64_t highWaterMark;                    //!< Largest number of live blocks.
+  EventPool *next;                          //!< The next pool.
+  volatile uint32_t inUse;                  //!< Whether a live thread owns this pool.
+};
+
+/** The pool of the calling thread, zero until it allocates an event. */
+static __thread EventPool *t_eventPool;
+/** All the pools. */
+static EventPool *g_eventPools;
+/** Protects g_eventPools. */
+static volatile uint32_t g_eventPoolsLock;
+#ifdef HAVE_PTHREAD_H
+/** The key whose destructor releases the pool of exiting threads. */
+static pthread_key_t g_eventPoolExitKey;
+/** Creates g_eventPoolExitKey. */
+static pthread_once_t g_eventPoolExitKeyOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Let the next thread adopt the pool of an exiting thread.
+ * \param [in] pool The pool.
+ */
+static void
+EventPoolRelease (void *pool)
+{
+  __sync_synchronize ();
+  static_cast<EventPool *> (pool)->inUse = 0;
+}
+
+/** Create g_eventPoolExitKey. */
+static void
+EventPoolCreateExitKey (void)
+{
+  pthread_key_create (&g_eventPoolExitKey, &EventPoolRelease);
+}
+#endif /* HAVE_PTHREAD_H */
+
+/**
+ * \returns The pool of the calling thread, adopting or creating one
+ *   if needed.
+ */
+static EventPool *
+EventPoolGet (void)
+{
+  EventPool *pool = t_eventPool;
+  if (pool != 0)
+    {
+      return pool;
+    }
+  while (__sync_lock_test_and_set (&g_eventPoolsLock, 1))
+    {
+    }
+  pool = g_eventPools;
+  while (pool != 0 && pool->inUse)
+    {
+      pool = pool->next;
+    }
+  if (pool == 0)
+    {
+      pool = new EventPool ();
+      pool->next = g_eventPools;
+      g_eventPools = pool;
+    }
+  pool->inUse = 1;
+  __sync_lock_release (&g_eventPoolsLock);
+  t_eventPool = pool;
+#ifdef HAVE_PTHREAD_H
+  pthread_once (&g_eventPoolExitKeyOnce, &EventPoolCreateExitKey);
+  pthread_setspecific (g_eventPoolExitKey, pool);
+#endif /* HAVE_PTHREAD_H */
+  return pool;
+}
+
+/**
+ * \param [in] pool A pool.
+ * \returns The number of blocks of the pool which are allocated.
+ */
+static inline int64_t
+EventPoolLive (const EventPool *pool)
+{
+  return pool->allocations - pool->frees - pool->remoteFrees;
+}
+
+/**
+ * \param [in] size The size of an event.
+ * \returns The index of the size class of the event.
+ */
+static inline uint32_t
+EventPoolClass (std::size_t size)
+{
+  return (size + EVENT_POOL_GRANULARITY - 1) / EVENT_POOL_GRANULARITY - 1;
+}
+
+/**
+ * \param [in] sizeClass A size class.
+ * \returns The size of the blocks of this class, header included.
+ */
+static inline std::size_t
+EventPoolBlockSize (uint32_t sizeClass)
+{
+  return sizeof (EventPoolBlock) + (sizeClass + 1) * EVENT_POOL_GRANULARITY;
+}
+
+/**
+ * Move the blocks released by other threads to the free lists.
+ * \param [in] pool The pool of the calling thread.
+ */
+static void
+EventPoolDrain (EventPool *pool)
+{
+  EventPoolBlock *blocks = __sync_lock_test_and_set (&pool->remote, static_cast<EventPoolBlock *> (0));
+  while (blocks != 0)
+    {
+      EventPoolBlock *block = blocks;
+      blocks = block->next;
+      // the size class was stored in the event, which is dead.
+      uint32_t sizeClass = *reinterpret_cast<uint32_t *> (block + 1);
+      block->next = pool->free[sizeClass];
+      pool->free[sizeClass] = block;
+    }
+}
+/**@}*/
+
+void *
+EventImpl::operator new (std::size_t size)
+{
+  if (size > EVENT_POOL_MAX_SIZE || size == 0)
+    {
+      return ::operator new (size);
+    }
+  uint32_t sizeClass = EventPoolClass (size);
+  EventPool *pool = EventPoolGet ();
+  pool->allocations++;
+  int64_t live = EventPoolLive (pool);
+  if (live > pool->highWaterMark)
+    {
+      pool->highWaterMark = live;
+    }
+  if (pool->free[sizeClass] == 0 && pool->remote != 0)
+    {
+      EventPoolDrain (pool);
+    }
+  EventPoolBlock *block = pool->free[sizeClass];
+  if (block != 0)
+    {
+      pool->free[sizeClass] = block->next;
+      pool->reused++;
+      return block + 1;
+    }
+  std::size_t blockSize = EventPoolBlockSize (sizeClass);
+  if (pool->slab == 0 || pool->slab + blockSize > pool->slabEnd)
+    {
+      // the end of the previous slab, if any, is smaller than a
+      // block and is not used.
+      pool->slab = static_cast<uint8_t *> (::operator new (EVENT_POOL_SLAB_SIZE));
+      pool->slabEnd = pool->slab + EVENT_POOL_SLAB_SIZE;
+    }
+  block = reinterpret_cast<EventPoolBlock *> (pool->slab);
+  pool->slab += blockSize;
+  block->owner = pool;
+  return block + 1;
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  if (p == 0)
+    {
+      return;
+    }
+  if (size > EVENT_POOL_MAX_SIZE || size == 0)
+    {
+      ::operator delete (p);
+      return;
+    }
+  uint32_t sizeClass = EventPoolClass (size);
+  EventPoolBlock *block = static_cast<EventPoolBlock *> (p) - 1;
+  EventPool *owner = block->owner;
+  if (owner == t_eventPool)
+    {
+      owner->frees++;
+      block->next = owner->free[sizeClass];
+      owner->free[sizeClass] = block;
+      return;
+    }
+  // the owner cannot tell the size of the event: keep it in the event.
+  *static_cast<uint32_t *> (p) = sizeClass;
+  __sync_fetch_and_add (&owner->remoteFrees, 1);
+  EventPoolBlock *head;
+  do
+    {
+      head = owner->remote;
+      block->next = head;
+    }
+  while (!__sync_bool_compare_and_swap (&owner->remote, head, block));
+}
+
+EventPoolStats
+EventImpl::GetPoolStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  EventPool *pool = EventPoolGet ();
+  EventPoolStats stats;
+  stats.allocations = pool->allocations;
+  stats.reused = pool->reused;
+  stats.live = EventPoolLive (pool);
+  stats.highWaterMark = pool->highWaterMark;
+  return stats;
+}
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
 }
 
 EventImpl::EventImpl ()
-  : m_cancel (false)
+  : m_cancel (false),
+    m_schedulerSlot (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -66,4 +336,12 @@ EventImpl::IsCancelled (void)
   return m_cancel;
 }
 
+void
+EventImpl::GetTarget (const void * &function, const std::type_info * &object)
+{
+  NS_LOG_FUNCTION (this);
+  function = 0;
+  object = 0;
+}
+
 } // namespace ns3
@@ -21,6 +21,8 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
+#include <typeinfo>
 #include "simple-ref-count.h"
 
 /**
@@ -31,6 +33,22 @@
 
 namespace ns3 {
 
+/**
+ * \ingroup events
+ * Counters describing the use of the EventImpl memory pool of a thread.
+ *
+ * Every block records the pool it was allocated from, so an event
+ * released by another thread is still counted by the pool of the
+ * thread which allocated it, and live is exact.
+ */
+struct EventPoolStats
+{
+  uint64_t allocations;    /**< Number of events allocated. */
+  uint64_t reused;         /**< Number of allocations served from the pool. */
+  int64_t live;            /**< Number of events currently allocated. */
+  int64_t highWaterMark;   /**< Largest value reached by live. */
+};
+
 /**
  * \ingroup events
  * \brief A simulation event.
@@ -65,6 +83,58 @@ public:
    * Checked by the simulation engine before calling Invoke().
    */
   bool IsCancelled (void);
+  /**
+   * \param [in] slot The position of this event inside the storage
+   *   of the Scheduler which currently holds it.
+   *
+   * Schedulers which need to locate a pending event in constant time,
+   * such as DaryHeapScheduler, record its position here whenever they
+   * move it.  Other schedulers ignore this field.
+   */
+  inline void SetSchedulerSlot (uint32_t slot);
+  /**
+   * \returns The last position recorded with SetSchedulerSlot().
+   */
+  inline uint32_t GetSchedulerSlot (void) const;
+  /**
+   * Describe the function which Invoke() calls, for profiling.
+   *
+   * Must not be called on a cancelled event: the object it targets
+   * may have been deleted.
+   *
+   * \param [out] function The address of the function, or 0 if it
+   *   cannot be determined.
+   * \param [out] object The dynamic type of the object the function
+   *   is called on, or 0 if the function is not a class method.
+   */
+  virtual void GetTarget (const void * &function, const std::type_info * &object);
+
+  /**
+   * Allocate the storage of an event.
+   *
+   * Each thread has its own pool: the storage is taken from a free
+   * list of blocks of the same size class, or carved out of a slab of
+   * the pool, so no call to the system allocator is made once the pool
+   * is warm.
+   *
+   * \param [in] size The size of the event subclass.
+   * \returns The storage for the event.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Release the storage of an event, from any thread. The storage goes
+   * back to the pool of the thread which allocated it.
+   *
+   * \param [in] p The storage to release.
+   * \param [in] size The size of the event subclass.
+   */
+  static void operator delete (void *p, std::size_t size);
+  /**
+   * \returns The counters of the event pool of the calling thread.
+   *   The pool of a thread which exited is adopted, counters included,
+   *   by the next thread which needs one.
+   */
+  static EventPoolStats GetPoolStats (void);
 
 protected:
   /**
@@ -77,8 +147,21 @@ protected:
 
 private:
   bool m_cancel;  /**< Has this event been cancelled. */
+  uint32_t m_schedulerSlot;  /**< Position in the scheduler storage. */
 };
 
+void
+EventImpl::SetSchedulerSlot (uint32_t slot)
+{
+  m_schedulerSlot = slot;
+}
+
+uint32_t
+EventImpl::GetSchedulerSlot (void) const
+{
+  return m_schedulerSlot;
+}
+
 } // namespace ns3
 
 #endif /* EVENT_IMPL_H */
@@ -0,0 +1,371 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "event-profiler.h"
+#include "log.h"
+#include "ns3/core-config.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <sys/time.h>
+#include <cxxabi.h>
+#ifdef HAVE_DLADDR
+#include <dlfcn.h>
+#endif
+
+/**
+ * \file
+ * \ingroup simulator
+ * Implementation of class ns3::EventProfiler.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EventProfiler");
+
+namespace {
+
+/**
+ * \param [in] mangled A mangled C++ name.
+ * \returns The demangled name, or mangled if it cannot be demangled.
+ */
+std::string
+Demangle (const char *mangled)
+{
+  int status;
+  char *demangled = abi::__cxa_demangle (mangled, 0, 0, &status);
+  if (status != 0 || demangled == 0)
+    {
+      return mangled;
+    }
+  std::string name = demangled;
+  std::free (demangled);
+  return name;
+}
+
+/**
+ * \param [in] function The address of a function.
+ * \returns The name of the function, if it can be found.
+ */
+std::string
+GetFunctionName (const void *function)
+{
+  std::ostringstream oss;
+#ifdef HAVE_DLADDR
+  Dl_info info;
+  if (dladdr (function, &info) != 0 && info.dli_sname != 0)
+    {
+      return Demangle (info.dli_sname);
+    }
+  if (dladdr (function, &info) != 0 && info.dli_fname != 0)
+    {
+      oss << info.dli_fname << " ";
+    }
+#endif
+  oss << function;
+  return oss.str ();
+}
+
+/**
+ * Order entries by decreasing time.
+ * \param [in] a An entry.
+ * \param [in] b An entry.
+ * \returns true if a must be reported before b.
+ */
+bool
+CompareEntries (const EventProfiler::Entry &a, const EventProfiler::Entry &b)
+{
+  if (a.seconds != b.seconds)
+    {
+      return a.seconds > b.seconds;
+    }
+  return a.name < b.name;
+}
+
+} // anonymous namespace
+
+bool
+EventProfiler::FunctionKey::operator < (const FunctionKey &o) const
+{
+  if (function != o.function)
+    {
+      return function < o.function;
+    }
+  return TypeLess () (event, o.event);
+}
+
+bool
+EventProfiler::TypeLess::operator () (const std::type_info *a, const std::type_info *b) const
+{
+  if (a == 0 || b == 0)
+    {
+      return a < b;
+    }
+  return a->before (*b);
+}
+
+EventProfiler::EventProfiler ()
+  : m_period (0),
+    m_countdown (0),
+    m_random (0x9e3779b9)
+{
+  NS_LOG_FUNCTION (this);
+  Clear ();
+}
+
+void
+EventProfiler::SetSampling (uint32_t period)
+{
+  NS_LOG_FUNCTION (this << period);
+  m_period = period;
+  Clear ();
+}
+
+uint32_t
+EventProfiler::GetSampling (void) const
+{
+  return m_period;
+}
+
+uint64_t
+EventProfiler::GetEventCount (void) const
+{
+  return m_events;
+}
+
+uint64_t
+EventProfiler::GetSampleCount (void) const
+{
+  return m_samples;
+}
+
+void
+EventProfiler::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_events = 0;
+  m_samples = 0;
+  m_functions.clear ();
+  m_objects.clear ();
+  m_contexts.clear ();
+  m_countdown = NextCountdown ();
+  m_startTicks = GetTicks ();
+  m_startSeconds = GetSeconds ();
+}
+
+uint32_t
+EventProfiler::NextCountdown (void)
+{
+  if (m_period <= 1)
+    {
+      return 1;
+    }
+  // xorshift: cheap, and independent from the simulation random streams.
+  m_random ^= m_random << 13;
+  m_random ^= m_random >> 17;
+  m_random ^= m_random << 5;
+  // uniform in [1, 2 * period - 1], period on average.
+  return 1 + m_random % (2 * m_period - 1);
+}
+
+uint64_t
+EventProfiler::GetTicks (void)
+{
+#if defined (__x86_64__) || defined (__i386__)
+  uint32_t lo, hi;
+  __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+  return (static_cast<uint64_t> (hi) << 32) | lo;
+#else
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return static_cast<uint64_t> (tv.tv_sec) * 1000000 + tv.tv_usec;
+#endif
+}
+
+double
+EventProfiler::GetSeconds (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+double
+EventProfiler::GetTickRate (void) const
+{
+#if defined (__x86_64__) || defined (__i386__)
+  // calibrate the cycle counter against the system clock over the
+  // whole profile.
+  double elapsed = GetSeconds () - m_startSeconds;
+  uint64_t ticks = GetTicks () - m_startTicks;
+  if (elapsed <= 0 || ticks == 0)
+    {
+      return 1e9;
+    }
+  return ticks / elapsed;
+#else
+  return 1e6;
+#endif
+}
+
+void
+EventProfiler::InvokeSampled (EventImpl *event, uint32_t context)
+{
+  m_countdown = NextCountdown ();
+  FunctionKey key;
+  key.function = 0;
+  key.event = 0;
+  const std::type_info *object = 0;
+  // the object of a cancelled event may be gone.
+  if (!event->IsCancelled ())
+    {
+      event->GetTarget (key.function, object);
+      if (key.function == 0)
+        {
+          key.event = &typeid (*event);
+        }
+    }
+  uint64_t start = GetTicks ();
+  event->Invoke ();
+  uint64_t ticks = GetTicks () - start;
+
+  m_samples++;
+  Counter &f = m_functions[key];
+  f.samples++;
+  f.ticks += ticks;
+  Counter &o = m_objects[object];
+  o.samples++;
+  o.ticks += ticks;
+  Counter &c = m_contexts[context];
+  c.samples++;
+  c.ticks += ticks;
+}
+
+std::vector<EventProfiler::Entry>
+EventProfiler::GetEntries (enum Category category) const
+{
+  NS_LOG_FUNCTION (this << category);
+  std::vector<Entry> entries;
+  if (m_samples == 0)
+    {
+      return entries;
+    }
+  double scale = static_cast<double> (m_events) / m_samples;
+  double rate = GetTickRate ();
+  Entry entry;
+  switch (category)
+    {
+    case FUNCTION:
+      for (std::map<FunctionKey, Counter>::const_iterator i = m_functions.begin (); i != m_functions.end (); ++i)
+        {
+          if (i->first.function != 0)
+            {
+              entry.name = GetFunctionName (i->first.function);
+            }
+          else if (i->first.event != 0)
+            {
+              entry.name = Demangle (i->first.event->name ());
+            }
+          else
+            {
+              entry.name = "(cancelled)";
+            }
+          entry.events = static_cast<uint64_t> (i->second.samples * scale + 0.5);
+          entry.seconds = i->second.ticks / rate * scale;
+          entries.push_back (entry);
+        }
+      break;
+    case OBJECT:
+      for (std::map<const std::type_info *, Counter, TypeLess>::const_iterator i = m_objects.begin (); i != m_objects.end (); ++i)
+        {
+          entry.name = i->first != 0 ? Demangle (i->first->name ()) : "(none)";
+          entry.events = static_cast<uint64_t> (i->second.samples * scale + 0.5);
+          entry.seconds = i->second.ticks / rate * scale;
+          entries.push_back (entry);
+        }
+      break;
+    case CONTEXT:
+      for (std::map<uint32_t, Counter>::const_iterator i = m_contexts.begin (); i != m_contexts.end (); ++i)
+        {
+          std::ostringstream oss;
+          if (i->first == 0xffffffff)
+            {
+              oss << "(none)";
+            }
+          else
+            {
+              oss << i->first;
+            }
+          entry.name = oss.str ();
+          entry.events = static_cast<uint64_t> (i->second.samples * scale + 0.5);
+          entry.seconds = i->second.ticks / rate * scale;
+          entries.push_back (entry);
+        }
+      break;
+    default:
+      NS_ASSERT (false);
+      break;
+    }
+  std::sort (entries.begin (), entries.end (), &CompareEntries);
+  return entries;
+}
+
+void
+EventProfiler::Report (std::ostream &os, uint32_t lines) const
+{
+  NS_LOG_FUNCTION (this << &os << lines);
+  os << "Event profile: " << m_events << " events, " << m_samples
+     << " timed (1 in " << m_period << ")" << std::endl;
+  if (m_samples == 0)
+    {
+      return;
+    }
+  static const char *titles[CATEGORY_COUNT] = { "function", "object type", "context" };
+  for (uint32_t category = 0; category < CATEGORY_COUNT; category++)
+    {
+      std::vector<Entry> entries = GetEntries (static_cast<enum Category> (category));
+      double total = 0;
+      for (std::vector<Entry>::const_iterator i = entries.begin (); i != entries.end (); ++i)
+        {
+          total += i->seconds;
+        }
+      os << std::endl << "By " << titles[category] << ":" << std::endl;
+      os << std::setw (12) << "time (s)" << std::setw (8) << "%"
+         << std::setw (14) << "events" << std::setw (12) << "mean (us)"
+         << "  " << titles[category] << std::endl;
+      for (uint32_t j = 0; j < entries.size () && j < lines; j++)
+        {
+          const Entry &e = entries[j];
+          os << std::fixed
+             << std::setw (12) << std::setprecision (6) << e.seconds
+             << std::setw (8) << std::setprecision (2) << (total > 0 ? 100 * e.seconds / total : 0)
+             << std::setw (14) << e.events
+             << std::setw (12) << std::setprecision (3) << (e.events > 0 ? 1e6 * e.seconds / e.events : 0)
+             << "  " << e.name << std::endl;
+        }
+      if (entries.size () > lines)
+        {
+          os << "  (" << entries.size () - lines << " more)" << std::endl;
+        }
+      os.unsetf (std::ios_base::floatfield);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,181 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef EVENT_PROFILER_H
+#define EVENT_PROFILER_H
+
+#include "event-impl.h"
+
+#include <stdint.h>
+#include <map>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup simulator
+ * Declaration of class ns3::EventProfiler.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ *
+ * \brief Measure where the time of a simulation goes, event by event.
+ *
+ * A SimulatorImpl hands the events it runs to Invoke. One event out
+ * of the sampling period, picked at random, is timed with the cycle
+ * counter of the processor (or the system clock where there is none),
+ * and its time is charged to:
+ *  - the function it calls: the class method or function given to
+ *    Simulator::Schedule,
+ *  - the dynamic type of the object the method is called on,
+ *  - the node context it runs in.
+ *
+ * The counts and times of each entry are estimated from the samples;
+ * they are exact with a sampling period of 1. Profiling never uses
+ * the simulation random variables, so it does not change the results.
+ */
+class EventProfiler
+{
+public:
+  /** The ways events are grouped in a profile. */
+  enum Category
+  {
+    FUNCTION = 0,   /**< By function called. */
+    OBJECT,         /**< By type of the object the method is called on. */
+    CONTEXT,        /**< By node context. */
+    CATEGORY_COUNT  /**< Number of categories. */
+  };
+  /** The profile of a group of events. */
+  struct Entry
+  {
+    std::string name;   /**< The function, type or context. */
+    uint64_t events;    /**< Estimated number of events. */
+    double seconds;     /**< Estimated time spent running them. */
+  };
+
+  EventProfiler ();
+
+  /**
+   * \param [in] period Time one event out of this number, on average;
+   *   0 disables profiling. Changing the period clears the profile.
+   */
+  void SetSampling (uint32_t period);
+  /** \returns The sampling period, 0 if profiling is disabled. */
+  uint32_t GetSampling (void) const;
+  /** \returns true if events are being profiled. */
+  inline bool IsEnabled (void) const;
+
+  /**
+   * Run an event, timing it if it is sampled.
+   * \param [in] event The event.
+   * \param [in] context The context of the event.
+   */
+  inline void Invoke (EventImpl *event, uint32_t context);
+
+  /** \returns The number of events run through Invoke. */
+  uint64_t GetEventCount (void) const;
+  /** \returns The number of events timed. */
+  uint64_t GetSampleCount (void) const;
+  /**
+   * \param [in] category How to group events.
+   * \returns The profile, by decreasing time.
+   */
+  std::vector<Entry> GetEntries (enum Category category) const;
+
+  /**
+   * Print the profile, by decreasing time.
+   * \param [in] os The output stream.
+   * \param [in] lines The largest number of entries of each category.
+   */
+  void Report (std::ostream &os, uint32_t lines = 20) const;
+  /** Forget all the events profiled so far. */
+  void Clear (void);
+
+private:
+  /** Accumulated samples of one entry. */
+  struct Counter
+  {
+    uint64_t samples;   /**< Number of samples. */
+    uint64_t ticks;     /**< Time of the samples. */
+  };
+  /** Identify a function: its address, or the type of the event. */
+  struct FunctionKey
+  {
+    const void *function;          /**< Address of the function, or 0. */
+    const std::type_info *event;   /**< Type of the event if function is 0. */
+    /** Order by function, then type. */
+    bool operator < (const FunctionKey &o) const;
+  };
+  /** Order std::type_info which may come from several libraries. */
+  struct TypeLess
+  {
+    /** Compare two types. */
+    bool operator () (const std::type_info *a, const std::type_info *b) const;
+  };
+
+  /**
+   * Time an event and record it.
+   * \param [in] event The event.
+   * \param [in] context The context of the event.
+   */
+  void InvokeSampled (EventImpl *event, uint32_t context);
+  /** \returns The current value of the time counter. */
+  static uint64_t GetTicks (void);
+  /** \returns The current system time, in seconds. */
+  static double GetSeconds (void);
+  /** \returns The number of ticks in a second. */
+  double GetTickRate (void) const;
+  /** \returns The number of events until the next sample. */
+  uint32_t NextCountdown (void);
+
+  uint32_t m_period;          /**< Sampling period. */
+  uint32_t m_countdown;       /**< Events left until the next sample. */
+  uint32_t m_random;          /**< State of the sample selection generator. */
+  uint64_t m_events;          /**< Events run. */
+  uint64_t m_samples;         /**< Events timed. */
+  uint64_t m_startTicks;      /**< Time counter at the start of the profile. */
+  double m_startSeconds;      /**< System time at the start of the profile. */
+  std::map<FunctionKey, Counter> m_functions;                 /**< By function. */
+  std::map<const std::type_info *, Counter, TypeLess> m_objects;  /**< By object type. */
+  std::map<uint32_t, Counter> m_contexts;                     /**< By context. */
+};
+
+bool
+EventProfiler::IsEnabled (void) const
+{
+  return m_period != 0;
+}
+
+void
+EventProfiler::Invoke (EventImpl *event, uint32_t context)
+{
+  m_events++;
+  if (--m_countdown != 0)
+    {
+      event->Invoke ();
+      return;
+    }
+  InvokeSampled (event, context);
+}
+
+} // namespace ns3
+
+#endif /* EVENT_PROFILER_H */
@@ -0,0 +1,427 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+namespace {
+
+/**
+ * \ingroup scheduler
+ * Order used to keep Bottom sorted.
+ * \param [in] a The first event.
+ * \param [in] b The second event.
+ * \returns true if a must be dequeued before b.
+ */
+bool
+IsEarlier (const Scheduler::Event &a, const Scheduler::Event &b)
+{
+  return a.key < b.key;
+}
+
+} // anonymous namespace
+
+const uint32_t LadderScheduler::THRESHOLD;
+const uint32_t LadderScheduler::MAX_RUNGS;
+const uint32_t LadderScheduler::NONE;
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_freeNodes (NONE),
+    m_top (NONE),
+    m_topCount (0),
+    m_topMin (~(uint64_t)0),
+    m_topMax (0),
+    m_topStart (0),
+    m_nRungs (0),
+    m_bottomHead (0),
+    m_size (0)
+{
+  NS_LOG_FUNCTION (this);
+  // rungs are never deallocated so that their buckets can be reused
+  m_rungs.resize (MAX_RUNGS);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+LadderScheduler::AllocateNode (const Event &ev)
+{
+  uint32_t node;
+  if (m_freeNodes != NONE)
+    {
+      node = m_freeNodes;
+      m_freeNodes = m_nodes[node].next;
+    }
+  else
+    {
+      node = m_nodes.size ();
+      m_nodes.push_back (Node ());
+    }
+  m_nodes[node].ev = ev;
+  return node;
+}
+
+void
+LadderScheduler::FreeNode (uint32_t node)
+{
+  m_nodes[node].next = m_freeNodes;
+  m_freeNodes = node;
+}
+
+void
+LadderScheduler::RemoveFromList (uint32_t &head, const Event &ev)
+{
+  uint32_t *prev = &head;
+  while (*prev != NONE)
+    {
+      uint32_t node = *prev;
+      if (m_nodes[node].ev.key.m_uid == ev.key.m_uid)
+        {
+          NS_ASSERT (m_nodes[node].ev.impl == ev.impl);
+          *prev = m_nodes[node].next;
+          FreeNode (node);
+          return;
+        }
+      prev = &m_nodes[node].next;
+    }
+  NS_ASSERT_MSG (false, "Event not found");
+}
+
+void
+LadderScheduler::SpawnRung (uint64_t start, uint64_t range, uint32_t head, uint32_t count)
+{
+  NS_LOG_FUNCTION (this << start << range << count);
+  NS_ASSERT (m_nRungs < MAX_RUNGS);
+  NS_ASSERT (count > 0);
+  // aim for about one event per bucket
+  uint64_t width = range / count;
+  if (width == 0)
+    {
+      width = 1;
+    }
+  uint32_t nBuckets = (range + width - 1) / width;
+
+  Rung &rung = m_rungs[m_nRungs];
+  m_nRungs++;
+  rung.start = start;
+  rung.width = width;
+  rung.current = 0;
+  rung.count = count;
+  rung.heads.assign (nBuckets, NONE);
+  rung.sizes.assign (nBuckets, 0);
+  while (head != NONE)
+    {
+      uint32_t node = head;
+      head = m_nodes[node].next;
+      uint32_t bucket = (m_nodes[node].ev.key.m_ts - start) / width;
+      NS_ASSERT (bucket < nBuckets);
+      m_nodes[node].next = rung.heads[bucket];
+      rung.heads[bucket] = node;
+      rung.sizes[bucket]++;
+    }
+}
+
+void
+LadderScheduler::FillBottom (uint32_t head)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_bottom.empty ());
+  while (head != NONE)
+    {
+      uint32_t node = head;
+      head = m_nodes[node].next;
+      m_bottom.push_back (m_nodes[node].ev);
+      FreeNode (node);
+    }
+  std::sort (m_bottom.begin (), m_bottom.end (), IsEarlier);
+}
+
+uint32_t
+LadderScheduler::PurgeTop (void)
+{
+  NS_LOG_FUNCTION (this << m_topRemoved.size ());
+  uint32_t *prev = &m_top;
+  while (*prev != NONE && !m_topRemoved.empty ())
+    {
+      uint32_t node = *prev;
+      std::set<uint32_t>::iterator i = m_topRemoved.find (m_nodes[node].ev.key.m_uid);
+      if (i != m_topRemoved.end ())
+        {
+          m_topRemoved.erase (i);
+          *prev = m_nodes[node].next;
+          FreeNode (node);
+        }
+      else
+        {
+          prev = &m_nodes[node].next;
+        }
+    }
+  NS_ASSERT (m_topRemoved.empty ());
+  return m_top;
+}
+
+void
+LadderScheduler::SpillBottom (void)
+{
+  uint32_t count = m_bottom.size () - m_bottomHead;
+  if (count <= THRESHOLD || m_nRungs == MAX_RUNGS
+      || m_bottom[m_bottomHead].key.m_ts == m_bottom.back ().key.m_ts)
+    {
+      // Bottom is small, or there is no rung left, or all its events
+      // have the same time stamp and would land in the same bucket.
+      return;
+    }
+  NS_LOG_FUNCTION (this << count);
+  // The new rung ends where the events stop going to Bottom: at the
+  // first bucket not dequeued yet of the lowest rung, or at Top.
+  uint64_t end = m_topStart;
+  if (m_nRungs > 0)
+    {
+      const Rung &lowest = m_rungs[m_nRungs - 1];
+      end = lowest.start + lowest.current * lowest.width;
+    }
+  uint64_t start = m_bottom[m_bottomHead].key.m_ts;
+  NS_ASSERT (m_bottom.back ().key.m_ts < end);
+  uint32_t head = NONE;
+  for (uint32_t i = m_bottomHead; i < m_bottom.size (); i++)
+    {
+      uint32_t node = AllocateNode (m_bottom[i]);
+      m_nodes[node].next = head;
+      head = node;
+    }
+  m_bottom.clear ();
+  m_bottomHead = 0;
+  SpawnRung (start, end - start, head, count);
+}
+
+void
+LadderScheduler::RefillBottom (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (m_bottom.empty ())
+    {
+      if (m_nRungs == 0)
+        {
+          // start a new epoch from the content of Top
+          NS_ASSERT (m_topCount != 0);
+          uint32_t head = PurgeTop ();
+          uint32_t count = m_topCount;
+          uint64_t start = m_topMin;
+          uint64_t range = m_topMax - m_topMin + 1;
+          m_top = NONE;
+          m_topCount = 0;
+          m_topMin = ~(uint64_t)0;
+          m_topMax = 0;
+          if (count <= THRESHOLD)
+            {
+              m_topStart = start + range;
+              FillBottom (head);
+              return;
+            }
+          SpawnRung (start, range, head, count);
+          m_topStart = m_rungs[0].start + m_rungs[0].heads.size () * m_rungs[0].width;
+          continue;
+        }
+      Rung &rung = m_rungs[m_nRungs - 1];
+      if (rung.count == 0)
+        {
+          m_nRungs--;
+          continue;
+        }
+      while (rung.heads[rung.current] == NONE)
+        {
+          rung.current++;
+        }
+      uint32_t i = rung.current;
+      uint32_t head = rung.heads[i];
+      uint32_t size = rung.sizes[i];
+      rung.heads[i] = NONE;
+      rung.sizes[i] = 0;
+      rung.current++;
+      rung.count -= size;
+      if (size > THRESHOLD && m_nRungs < MAX_RUNGS && rung.width > 1)
+        {
+          SpawnRung (rung.start + i * rung.width, rung.width, head, size);
+        }
+      else
+        {
+          FillBottom (head);
+        }
+    }
+}
+
+void
+LadderScheduler::InsertBottom (const Event &ev)
+{
+  if (m_bottomHead > 0 && m_bottomHead * 2 >= m_bottom.size ())
+    {
+      // drop the dequeued events once they are half of the array
+      m_bottom.erase (m_bottom.begin (), m_bottom.begin () + m_bottomHead);
+      m_bottomHead = 0;
+    }
+  // events scheduled for the current time stamp are the most frequent
+  // case here: they have the largest uid of their time stamp and only
+  // the later events of Bottom move.
+  std::vector<Event>::iterator i = std::upper_bound (m_bottom.begin () + m_bottomHead,
+                                                     m_bottom.end (), ev, IsEarlier);
+  m_bottom.insert (i, ev);
+  SpillBottom ();
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  m_size++;
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      uint32_t node = AllocateNode (ev);
+      m_nodes[node].next = m_top;
+      m_top = node;
+      m_topCount++;
+      m_topMin = std::min (m_topMin, ts);
+      m_topMax = std::max (m_topMax, ts);
+      return;
+    }
+  for (uint32_t r = 0; r < m_nRungs; r++)
+    {
+      Rung &rung = m_rungs[r];
+      if (ts >= rung.start + rung.current * rung.width)
+        {
+          uint32_t bucket = (ts - rung.start) / rung.width;
+          NS_ASSERT (bucket < rung.heads.size ());
+          uint32_t node = AllocateNode (ev);
+          m_nodes[node].next = rung.heads[bucket];
+          rung.heads[bucket] = node;
+          rung.sizes[bucket]++;
+          rung.count++;
+          return;
+        }
+    }
+  InsertBottom (ev);
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_size == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (m_bottomHead == m_bottom.size ())
+    {
+      // Refilling Bottom moves events between tiers but does not
+      // change the set of events held by this scheduler.
+      const_cast<LadderScheduler *> (this)->RefillBottom ();
+    }
+  return m_bottom[m_bottomHead];
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (m_bottomHead == m_bottom.size ())
+    {
+      RefillBottom ();
+    }
+  Event next = m_bottom[m_bottomHead];
+  m_bottomHead++;
+  if (m_bottomHead == m_bottom.size ())
+    {
+      m_bottom.clear ();
+      m_bottomHead = 0;
+    }
+  m_size--;
+  return next;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+  m_size--;
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      // m_topMin and m_topMax may now be loose bounds, which only
+      // makes the next rung a little wider.
+      m_topRemoved.insert (ev.key.m_uid);
+      m_topCount--;
+      return;
+    }
+  for (uint32_t r = 0; r < m_nRungs; r++)
+    {
+      Rung &rung = m_rungs[r];
+      if (ts >= rung.start + rung.current * rung.width)
+        {
+          uint32_t bucket = (ts - rung.start) / rung.width;
+          NS_ASSERT (bucket < rung.heads.size ());
+          RemoveFromList (rung.heads[bucket], ev);
+          rung.sizes[bucket]--;
+          rung.count--;
+          return;
+        }
+    }
+  std::vector<Event>::iterator i = std::lower_bound (m_bottom.begin () + m_bottomHead,
+                                                     m_bottom.end (), ev, IsEarlier);
+  NS_ASSERT (i != m_bottom.end () && i->key.m_uid == ev.key.m_uid);
+  m_bottom.erase (i);
+  if (m_bottomHead == m_bottom.size ())
+    {
+      m_bottom.clear ();
+      m_bottomHead = 0;
+    }
+}
+
+} // namespace ns3
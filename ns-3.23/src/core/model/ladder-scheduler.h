@@ -0,0 +1,166 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <set>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+class EventImpl;
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue described in
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by Wai Teng Tang, Rick Siow Mong Goh and
+ * Ian Li-Jin Thng (ACM TOMACS, 2005).
+ *
+ * Events are kept in three tiers:
+ *  - Top: an unsorted list of all the events in the far future, that
+ *    is, with a timestamp greater or equal to m_topStart.
+ *  - Ladder: up to MAX_RUNGS rungs of buckets. Each rung covers the
+ *    time range of one bucket of the rung above it, with finer buckets.
+ *    Buckets are unsorted.
+ *  - Bottom: a small sorted array holding the events which are about
+ *    to be dequeued. When an insertion makes it hold more than
+ *    THRESHOLD events of different timestamps, Bottom is spilled into
+ *    a new lowest rung, so that bursts of events scheduled close to
+ *    the current time do not make it grow without bound.
+ *
+ * When Bottom is empty, the next non-empty bucket of the lowest rung is
+ * either sorted into Bottom or, if it holds more than THRESHOLD events,
+ * split into a new rung. When the whole ladder is empty, Top is
+ * transferred into a new first rung, which starts a new epoch. Each
+ * event is thus moved a bounded number of times and the sorting is
+ * done lazily on small sets, which gives amortized O(1) insertion and
+ * removal. Unlike CalendarScheduler, there is never a resize of the
+ * whole structure.
+ *
+ * Events stored in Top and in the ladder live in a pool of nodes
+ * linked by index, so moving an event between tiers never allocates.
+ *
+ * Remove locates the tier of an event from its timestamp. Events in
+ * the ladder are unlinked from their bucket and events in Bottom are
+ * found by binary search. Events in Top are only recorded as removed,
+ * in a set of uids, and are dropped when Top is transferred to the
+ * ladder: a Remove costs O(log r) for r pending removals instead of a
+ * scan of Top.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  LadderScheduler ();
+  virtual ~LadderScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Event PeekNext (void) const;
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+
+private:
+  /** Bucket size above which a bucket is split into a new rung. */
+  static const uint32_t THRESHOLD = 50;
+  /** Maximum number of rungs in the ladder. */
+  static const uint32_t MAX_RUNGS = 8;
+  /** Index used to terminate node lists. */
+  static const uint32_t NONE = 0xffffffff;
+
+  /** An element of the node pool. */
+  struct Node
+  {
+    Event ev;       /**< The stored event. */
+    uint32_t next;  /**< Index of the next node in the list, or NONE. */
+  };
+  /** A rung of the ladder. */
+  struct Rung
+  {
+    uint64_t start;                /**< Timestamp of the start of the first bucket. */
+    uint64_t width;                /**< Duration covered by each bucket. */
+    uint32_t current;              /**< Index of the first bucket not dequeued yet. */
+    uint32_t count;                /**< Number of events in this rung. */
+    std::vector<uint32_t> heads;   /**< First node of each bucket. */
+    std::vector<uint32_t> sizes;   /**< Number of events in each bucket. */
+  };
+
+  uint32_t AllocateNode (const Event &ev);
+  void FreeNode (uint32_t node);
+  /** Remove the node holding ev from the list starting at head. */
+  void RemoveFromList (uint32_t &head, const Event &ev);
+  /**
+   * Create a new lowest rung covering [start, start + range) and
+   * distribute the count events of the list head into it.
+   */
+  void SpawnRung (uint64_t start, uint64_t range, uint32_t head, uint32_t count);
+  /** Sort the events of the list head into Bottom. */
+  void FillBottom (uint32_t head);
+  /**
+   * Drop the nodes of the events removed from Top.
+   * \returns The first node of Top without them.
+   */
+  uint32_t PurgeTop (void);
+  /**
+   * Move Bottom into a new lowest rung if it holds more than
+   * THRESHOLD events of different timestamps.
+   */
+  void SpillBottom (void);
+  /** Move events from the ladder and Top into Bottom until it is not empty. */
+  void RefillBottom (void);
+  /** Insert an event in sorted order into Bottom. */
+  void InsertBottom (const Event &ev);
+
+  std::vector<Node> m_nodes;   /**< Pool of nodes for Top and the ladder. */
+  uint32_t m_freeNodes;        /**< First node of the free list. */
+
+  uint32_t m_top;              /**< First node of Top. */
+  uint32_t m_topCount;         /**< Number of events in Top. */
+  uint64_t m_topMin;           /**< Smallest timestamp in Top. */
+  uint64_t m_topMax;           /**< Largest timestamp in Top. */
+  uint64_t m_topStart;         /**< Events at or after this time go to Top. */
+  std::set<uint32_t> m_topRemoved; /**< Uids of the events removed from Top but still in its list. */
+
+  std::vector<Rung> m_rungs;   /**< Rung storage, reused across epochs. */
+  uint32_t m_nRungs;           /**< Number of rungs in use. */
+
+  /**
+   * Bottom, sorted in increasing order from m_bottomHead: the events
+   * before m_bottomHead were already dequeued. Events scheduled for
+   * the current time are inserted after the other events of the same
+   * time stamp, that is close to the end of the array.
+   */
+  std::vector<Event> m_bottom;
+  uint32_t m_bottomHead;       /**< Index of the next event of Bottom. */
+  uint32_t m_size;             /**< Total number of events. */
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
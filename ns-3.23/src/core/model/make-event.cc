@@ -52,6 +52,11 @@ protected:
     {
       (*m_function)();
     }
+    virtual void GetTarget (const void * &function, const std::type_info * &object)
+    {
+      function = reinterpret_cast<const void *> (m_function);
+      object = 0;
+    }
 private:
     F m_function;
   } *ev = new EventFunctionImpl0 (f);
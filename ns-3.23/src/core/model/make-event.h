@@ -302,6 +302,38 @@ struct EventMemberImplObjTraits<T *>
   }
 };
 
+/**
+ * \ingroup makeeventmemptr
+ * Find the function called through a class method pointer.
+ *
+ * This relies on the g++ extension which converts a bound pointer to
+ * member function to a function pointer, resolving virtual methods.
+ * Other compilers return 0.
+ *
+ * \tparam MEM The class method function signature.
+ * \tparam T The class type.
+ * \param mem_ptr Class method member function pointer.
+ * \param obj Class instance.
+ * \returns The address of the function, or 0.
+ */
+#if defined (__GNUC__) && !defined (__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpmf-conversions"
+template <typename MEM, typename T>
+const void * GetMemberFunctionAddress (MEM mem_ptr, T &obj)
+{
+  typedef void (*F)(void);
+  return reinterpret_cast<const void *> ((F)(obj.*mem_ptr));
+}
+#pragma GCC diagnostic pop
+#else
+template <typename MEM, typename T>
+const void * GetMemberFunctionAddress (MEM mem_ptr, T &obj)
+{
+  return 0;
+}
+#endif
+
 template <typename MEM, typename OBJ>
 EventImpl * MakeEvent (MEM mem_ptr, OBJ obj)
 {
@@ -322,6 +354,11 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)();
     }
+    virtual void GetTarget (const void * &function, const std::type_info * &object)
+    {
+      function = GetMemberFunctionAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+      object = &typeid (EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
     OBJ m_obj;
     MEM m_function;
   } *ev = new EventMemberImpl0 (obj, mem_ptr);
@@ -352,6 +389,11 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1);
     }
+    virtual void GetTarget (const void * &function, const std::type_info * &object)
+    {
+      function = GetMemberFunctionAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+      object = &typeid (EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -383,6 +425,11 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1, m_a2);
     }
+    virtual void GetTarget (const void * &function, const std::type_info * &object)
+    {
+      function = GetMemberFunctionAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+      object = &typeid (EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -416,6 +463,11 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1, m_a2, m_a3);
     }
+    virtual void GetTarget (const void * &function, const std::type_info * &object)
+    {
+      function = GetMemberFunctionAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+      object = &typeid (EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -451,6 +503,11 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1, m_a2, m_a3, m_a4);
     }
+    virtual void GetTarget (const void * &function, const std::type_info * &object)
+    {
+      function = GetMemberFunctionAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+      object = &typeid (EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -489,6 +546,11 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1, m_a2, m_a3, m_a4, m_a5);
     }
+    virtual void GetTarget (const void * &function, const std::type_info * &object)
+    {
+      function = GetMemberFunctionAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+      object = &typeid (EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -523,6 +585,11 @@ private:
     {
       (*m_function)(m_a1);
     }
+    virtual void GetTarget (const void * &function, const std::type_info * &object)
+    {
+      function = reinterpret_cast<const void *> (m_function);
+      object = 0;
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
   } *ev = new EventFunctionImpl1 (f, a1);
@@ -553,6 +620,11 @@ private:
     {
       (*m_function)(m_a1, m_a2);
     }
+    virtual void GetTarget (const void * &function, const std::type_info * &object)
+    {
+      function = reinterpret_cast<const void *> (m_function);
+      object = 0;
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
     typename TypeTraits<T2>::ReferencedType m_a2;
@@ -586,6 +658,11 @@ private:
     {
       (*m_function)(m_a1, m_a2, m_a3);
     }
+    virtual void GetTarget (const void * &function, const std::type_info * &object)
+    {
+      function = reinterpret_cast<const void *> (m_function);
+      object = 0;
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
     typename TypeTraits<T2>::ReferencedType m_a2;
@@ -621,6 +698,11 @@ private:
     {
       (*m_function)(m_a1, m_a2, m_a3, m_a4);
     }
+    virtual void GetTarget (const void * &function, const std::type_info * &object)
+    {
+      function = reinterpret_cast<const void *> (m_function);
+      object = 0;
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
     typename TypeTraits<T2>::ReferencedType m_a2;
@@ -658,6 +740,11 @@ private:
     {
       (*m_function)(m_a1, m_a2, m_a3, m_a4, m_a5);
     }
+    virtual void GetTarget (const void * &function, const std::type_info * &object)
+    {
+      function = reinterpret_cast<const void *> (m_function);
+      object = 0;
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
     typename TypeTraits<T2>::ReferencedType m_a2;
@@ -0,0 +1,210 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <stdint.h>
+#include "assert.h"
+
+/**
+ * \file
+ * \ingroup thread
+ * ns3::MpscQueue template declaration and implementation.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup thread
+ * \brief A bounded lock-free multi-producer single-consumer queue.
+ *
+ * Any number of threads may call Push concurrently while a single
+ * thread calls Pop and IsEmpty. The queue never blocks and never
+ * allocates after construction: Push returns false when the queue is
+ * full and the caller decides how to handle the overflow.
+ *
+ * This is the bounded array queue of Dmitry Vyukov: each cell carries a
+ * sequence number which tells producers whether the cell is free for
+ * the current lap of the ring and tells the consumer whether the item
+ * it holds has been completely written. Producers only contend on the
+ * enqueue position, with a compare-and-swap.
+ *
+ * Items are copied in and out of the queue, so T should be a small
+ * plain data type.
+ *
+ * \tparam T The type of the queued items.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+  /**
+   * \param [in] capacity The maximum number of queued items, rounded
+   *   up to a power of two.
+   */
+  MpscQueue (uint32_t capacity);
+  ~MpscQueue ();
+
+  /**
+   * Append an item. Can be called from any thread.
+   *
+   * \param [in] item The item to append.
+   * \returns false if the queue is full, in which case nothing is done.
+   */
+  bool Push (const T &item);
+  /**
+   * Remove the oldest item. Must only be called by the consumer thread.
+   *
+   * \param [out] item The removed item.
+   * \returns false if the queue is empty.
+   */
+  bool Pop (T &item);
+  /**
+   * \returns true if Pop would fail. Must only be called by the consumer thread.
+   */
+  bool IsEmpty (void) const;
+  /**
+   * \returns The number of items the queue can hold.
+   */
+  uint32_t GetCapacity (void) const;
+
+private:
+  /** Copying is not supported. */
+  MpscQueue (const MpscQueue &o);
+  /**
+   * Copying is not supported.
+   * \returns This queue.
+   */
+  MpscQueue &operator = (const MpscQueue &o);
+
+  /** A slot of the ring. */
+  struct Cell
+  {
+    /**
+     * Equal to the position of the cell when it is free for that
+     * position, and to the position plus one once the item is written.
+     */
+    volatile uint32_t sequence;
+    T item;  //!< The queued item.
+  };
+
+  Cell *m_cells;                   //!< The ring.
+  uint32_t m_mask;                 //!< Capacity minus one.
+  uint32_t m_dequeuePos;           //!< Next position to pop, consumer only.
+  /** Keep the producers' position away from the consumer's cache line. */
+  char m_pad[64];
+  volatile uint32_t m_enqueuePos;  //!< Next position to push.
+};
+
+template <typename T>
+MpscQueue<T>::MpscQueue (uint32_t capacity)
+  : m_dequeuePos (0),
+    m_enqueuePos (0)
+{
+  uint32_t size = 2;
+  while (size < capacity)
+    {
+      size *= 2;
+    }
+  m_cells = new Cell[size];
+  m_mask = size - 1;
+  for (uint32_t i = 0; i < size; i++)
+    {
+      m_cells[i].sequence = i;
+    }
+}
+
+template <typename T>
+MpscQueue<T>::~MpscQueue ()
+{
+  delete [] m_cells;
+}
+
+template <typename T>
+bool
+MpscQueue<T>::Push (const T &item)
+{
+  uint32_t pos = m_enqueuePos;
+  Cell *cell;
+  while (true)
+    {
+      cell = &m_cells[pos & m_mask];
+      uint32_t sequence = cell->sequence;
+      __sync_synchronize ();
+      int32_t diff = (int32_t)(sequence - pos);
+      if (diff == 0)
+        {
+          if (__sync_bool_compare_and_swap (&m_enqueuePos, pos, pos + 1))
+            {
+              break;
+            }
+          pos = m_enqueuePos;
+        }
+      else if (diff < 0)
+        {
+          // the consumer has not yet released this cell from the previous lap
+          return false;
+        }
+      else
+        {
+          // another producer took this position
+          pos = m_enqueuePos;
+        }
+    }
+  cell->item = item;
+  // publish the item before the sequence number which announces it
+  __sync_synchronize ();
+  cell->sequence = pos + 1;
+  return true;
+}
+
+template <typename T>
+bool
+MpscQueue<T>::Pop (T &item)
+{
+  Cell *cell = &m_cells[m_dequeuePos & m_mask];
+  uint32_t sequence = cell->sequence;
+  __sync_synchronize ();
+  if (sequence != m_dequeuePos + 1)
+    {
+      return false;
+    }
+  item = cell->item;
+  // read the item before handing the cell back to the producers
+  __sync_synchronize ();
+  cell->sequence = m_dequeuePos + m_mask + 1;
+  m_dequeuePos++;
+  return true;
+}
+
+template <typename T>
+bool
+MpscQueue<T>::IsEmpty (void) const
+{
+  return m_cells[m_dequeuePos & m_mask].sequence != m_dequeuePos + 1;
+}
+
+template <typename T>
+uint32_t
+MpscQueue<T>::GetCapacity (void) const
+{
+  return m_mask + 1;
+}
+
+} // namespace ns3
+
+#endif /* MPSC_QUEUE_H */
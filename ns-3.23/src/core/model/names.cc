@@ -22,6 +22,7 @@
 #include "assert.h"
 #include "abort.h"
 #include "names.h"
+#include "config.h"
 
 /**
  * \file
@@ -623,6 +624,7 @@ Names::Add (std::string name, Ptr<Object> object)
 {
   NS_LOG_FUNCTION (name << object);
   bool result = NamesPriv::Get ()->Add (name, object);
+  Config::InvalidateCache ();
   NS_ABORT_MSG_UNLESS (result, "Names::Add(): Error adding name " << name);
 }
 
@@ -631,6 +633,7 @@ Names::Rename (std::string oldpath, std::string newname)
 {
   NS_LOG_FUNCTION (oldpath << newname);
   bool result = NamesPriv::Get ()->Rename (oldpath, newname);
+  Config::InvalidateCache ();
   NS_ABORT_MSG_UNLESS (result, "Names::Rename(): Error renaming " << oldpath << " to " << newname);
 }
 
@@ -639,6 +642,7 @@ Names::Add (std::string path, std::string name, Ptr<Object> object)
 {
   NS_LOG_FUNCTION (path << name << object);
   bool result = NamesPriv::Get ()->Add (path, name, object);
+  Config::InvalidateCache ();
   NS_ABORT_MSG_UNLESS (result, "Names::Add(): Error adding " << path << " " << name);
 }
 
@@ -647,6 +651,7 @@ Names::Rename (std::string path, std::string oldname, std::string newname)
 {
   NS_LOG_FUNCTION (path << oldname << newname);
   bool result = NamesPriv::Get ()->Rename (path, oldname, newname);
+  Config::InvalidateCache ();
   NS_ABORT_MSG_UNLESS (result, "Names::Rename (): Error renaming " << path << " " << oldname << " to " << newname);
 }
 
@@ -655,6 +660,7 @@ Names::Add (Ptr<Object> context, std::string name, Ptr<Object> object)
 {
   NS_LOG_FUNCTION (context << name << object);
   bool result = NamesPriv::Get ()->Add (context, name, object);
+  Config::InvalidateCache ();
   NS_ABORT_MSG_UNLESS (result, "Names::Add(): Error adding name " << name << " under context " << &context);
 }
 
@@ -663,6 +669,7 @@ Names::Rename (Ptr<Object> context, std::string oldname, std::string newname)
 {
   NS_LOG_FUNCTION (context << oldname << newname);
   bool result = NamesPriv::Get ()->Rename (context, oldname, newname);
+  Config::InvalidateCache ();
   NS_ABORT_MSG_UNLESS (result, "Names::Rename (): Error renaming " << oldname << " to " << newname << " under context " <<
                        &context);
 }
@@ -685,6 +692,7 @@ void
 Names::Clear (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
+  Config::InvalidateCache ();
   return NamesPriv::Get ()->Clear ();
 }
 
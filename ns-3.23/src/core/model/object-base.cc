@@ -78,96 +78,108 @@ ObjectBase::NotifyConstructionCompleted (void)
 void
 ObjectBase::ConstructSelf (const AttributeConstructionList &attributes)
 {
-  // loop over the inheritance tree back to the Object base class.
+  // loop over the attributes of the inheritance tree back to the Object
+  // base class, gathered once for each type.
   NS_LOG_FUNCTION (this << &attributes);
-  TypeId tid = GetInstanceTypeId ();
-  do {
-      // loop over all attributes in object type
-      NS_LOG_DEBUG ("construct tid="<<tid.GetName ()<<", params="<<tid.GetAttributeN ());
-      for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
+  const TypeId::ConstructionInformation *construction =
+    GetInstanceTypeId ().GetConstructionInformation ();
+  bool hasValues = attributes.Begin () != attributes.End ();
+#ifdef HAVE_GETENV
+  char *envVar = getenv ("NS_ATTRIBUTE_DEFAULT");
+#endif /* HAVE_GETENV */
+  for (uint32_t i = 0; i < construction->attributes.size (); i++)
+    {
+      const struct TypeId::AttributeInformation &info = construction->attributes[i];
+      const std::string &tidName = construction->tidNames[i];
+      NS_LOG_DEBUG ("try to construct \""<< tidName <<"::"<<
+                    info.name <<"\"");
+      // is this attribute stored in this AttributeConstructionList instance ?
+      Ptr<AttributeValue> value;
+      if (hasValues)
         {
-          struct TypeId::AttributeInformation info = tid.GetAttribute(i);
-          NS_LOG_DEBUG ("try to construct \""<< tid.GetName ()<<"::"<<
-                        info.name <<"\"");
-          // is this attribute stored in this AttributeConstructionList instance ?
-          Ptr<AttributeValue> value = attributes.Find(info.checker);
-          // See if this attribute should not be set here in the
-          // constructor.
-          if (!(info.flags & TypeId::ATTR_CONSTRUCT))
-            {
-              // Handle this attribute if it should not be 
-              // set here.
-              if (value == 0)
-                {
-                  // Skip this attribute if it's not in the
-                  // AttributeConstructionList.
-                  continue;
-                }              
-              else
-                {
-                  // This is an error because this attribute is not
-                  // settable in its constructor but is present in
-                  // the AttributeConstructionList.
-                  NS_FATAL_ERROR ("Attribute name="<<info.name<<" tid="<<tid.GetName () << ": initial value cannot be set using attributes");
-                }
-            }
-          bool found = false;
-          if (value != 0)
+          value = attributes.Find (info.checker);
+        }
+      // See if this attribute should not be set here in the
+      // constructor.
+      if (!(info.flags & TypeId::ATTR_CONSTRUCT))
+        {
+          // Handle this attribute if it should not be 
+          // set here.
+          if (value == 0)
             {
-              // We have a matching attribute value.
-              if (DoSet (info.accessor, info.checker, *value))
-                {
-                  NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
-                                info.name<<"\"");
-                  found = true;
-                  continue;
-                }
+              // Skip this attribute if it's not in the
+              // AttributeConstructionList.
+              continue;
             }              
-          if (!found)
+          else
             {
-              // No matching attribute value so we try to look at the env var.
+              // This is an error because this attribute is not
+              // settable in its constructor but is present in
+              // the AttributeConstructionList.
+              NS_FATAL_ERROR ("Attribute name="<<info.name<<" tid="<<tidName << ": initial value cannot be set using attributes");
+            }
+        }
+      bool found = false;
+      if (value != 0)
+        {
+          // We have a matching attribute value.
+          if (DoSet (info.accessor, info.checker, *value))
+            {
+              NS_LOG_DEBUG ("construct \""<< tidName <<"::"<<
+                            info.name<<"\"");
+              found = true;
+              continue;
+            }
+        }              
 #ifdef HAVE_GETENV
-              char *envVar = getenv ("NS_ATTRIBUTE_DEFAULT");
-              if (envVar != 0)
+      if (!found && envVar != 0)
+        {
+          // No matching attribute value so we try to look at the env var.
+          std::string env = std::string (envVar);
+          std::string fullName = tidName + "::" + info.name;
+          std::string::size_type cur = 0;
+          std::string::size_type next = 0;
+          while (next != std::string::npos)
+            {
+              next = env.find (";", cur);
+              std::string tmp = std::string (env, cur, next-cur);
+              std::string::size_type equal = tmp.find ("=");
+              if (equal != std::string::npos)
                 {
-                  std::string env = std::string (envVar);
-                  std::string::size_type cur = 0;
-                  std::string::size_type next = 0;
-                  while (next != std::string::npos)
+                  std::string name = tmp.substr (0, equal);
+                  std::string value = tmp.substr (equal+1, tmp.size () - equal - 1);
+                  if (name == fullName)
                     {
-                      next = env.find (";", cur);
-                      std::string tmp = std::string (env, cur, next-cur);
-                      std::string::size_type equal = tmp.find ("=");
-                      if (equal != std::string::npos)
+                      if (DoSet (info.accessor, info.checker, StringValue (value)))
                         {
-                          std::string name = tmp.substr (0, equal);
-                          std::string value = tmp.substr (equal+1, tmp.size () - equal - 1);
-                          if (name == tid.GetAttributeFullName (i))
-                            {
-                              if (DoSet (info.accessor, info.checker, StringValue (value)))
-                                {
-                                  NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
-                                                info.name <<"\" from env var");
-                                  found = true;
-                                  break;
-                                }
-                            }
+                          NS_LOG_DEBUG ("construct \""<< tidName <<"::"<<
+                                        info.name <<"\" from env var");
+                          found = true;
+                          break;
                         }
-                      cur = next + 1;
                     }
                 }
+              cur = next + 1;
+            }
+        }
 #endif /* HAVE_GETENV */
+      if (!found)
+        {
+          // No matching attribute value so we try to set the default value.
+          // The checker accepts most initial values as they are: they need
+          // not be converted and copied for every object.
+          if (construction->initialValueChecked[i])
+            {
+              info.accessor->Set (this, *info.initialValue);
             }
-          if (!found)
+          else
             {
-              // No matching attribute value so we try to set the default value.
               DoSet (info.accessor, info.checker, *info.initialValue);
-              NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
-                            info.name <<"\" from initial value.");
             }
+          NS_LOG_DEBUG ("construct \""<< tidName <<"::"<<
+                        info.name <<"\" from initial value.");
         }
-      tid = tid.GetParent ();
-    } while (tid != ObjectBase::GetTypeId ());
+    }
   NotifyConstructionCompleted ();
 }
 
@@ -25,6 +25,7 @@
 #include "attribute.h"
 #include "log.h"
 #include "string.h"
+#include "config.h"
 #include <vector>
 #include <sstream>
 #include <cstdlib>
@@ -258,6 +259,9 @@ Object::AggregateObject (Ptr<Object> o)
                       o->GetInstanceTypeId ().GetName ());
     }
 
+  // the objects matched by Config paths through "$ns3::Type" change.
+  Config::InvalidateCache ();
+
   Object *other = PeekPointer (o);
   // first create the new aggregate buffer.
   uint32_t total = m_aggregates->n + other->m_aggregates->n;
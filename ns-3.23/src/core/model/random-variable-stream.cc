@@ -33,8 +33,11 @@
 #include "log.h"
 #include "rng-stream.h"
 #include "rng-seed-manager.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <limits>
+#include <set>
 
 /**
  * \file
@@ -48,6 +51,134 @@ NS_LOG_COMPONENT_DEFINE ("RandomVariableStream");
 
 NS_OBJECT_ENSURE_REGISTERED (RandomVariableStream);
 
+namespace {
+
+/** Protects GetAllStreams: streams may be created by several threads. */
+volatile uint32_t g_allStreamsLock = 0;
+
+/**
+ * \returns All the RandomVariableStream objects alive. The set is
+ * never deleted, so that streams may outlive static destruction.
+ */
+std::set<RandomVariableStream *> &
+GetAllStreams (void)
+{
+  static std::set<RandomVariableStream *> *streams = new std::set<RandomVariableStream *> ();
+  return *streams;
+}
+
+/** Lock g_allStreamsLock. */
+void
+LockAllStreams (void)
+{
+  while (__sync_lock_test_and_set (&g_allStreamsLock, 1))
+    {
+    }
+}
+
+/** Unlock g_allStreamsLock. */
+void
+UnlockAllStreams (void)
+{
+  __sync_lock_release (&g_allStreamsLock);
+}
+
+/**
+ * The number of uniform numbers that the GetValues methods which need
+ * a scratch buffer draw at once.
+ */
+const uint32_t BATCH_SIZE = 64;
+
+/**
+ * Fill an array with bounded values, each computed from one uniform
+ * number and rejected if it exceeds the bound, as the GetValue methods
+ * of the exponential, Pareto and Weibull distributions do.
+ *
+ * Each value takes one uniform number, plus one for each rejection:
+ * drawing as many uniform numbers as there are values missing never
+ * takes one that GetValue would not have taken. The accepted values
+ * are packed in place.
+ *
+ * \param [in] rng The stream to draw from.
+ * \param [in] antithetic Whether to use 1 - u instead of u.
+ * \param [in] bound The largest value accepted, or zero.
+ * \param [in] transform Computes a value from a uniform number.
+ * \param [out] values The array to fill.
+ * \param [in] n The number of values.
+ */
+template <typename Transform>
+void
+GetBoundedValues (RngStream *rng, bool antithetic, double bound,
+                  const Transform &transform, double *values, uint32_t n)
+{
+  uint32_t done = 0;
+  while (done < n)
+    {
+      uint32_t count = n - done;
+      rng->RandU01 (values + done, count);
+      uint32_t end = done + count;
+      for (uint32_t i = done; i < end; i++)
+        {
+          double v = values[i];
+          if (antithetic)
+            {
+              v = (1 - v);
+            }
+          double r = transform (v);
+          if (bound == 0 || r <= bound)
+            {
+              values[done++] = r;
+            }
+        }
+    }
+}
+
+/** Computes an exponential value from a uniform number. */
+struct ExponentialTransform
+{
+  double mean; //!< The mean.
+  /**
+   * \param [in] v A uniform number.
+   * \returns The value.
+   */
+  double operator () (double v) const
+  {
+    return -mean*std::log (v);
+  }
+};
+
+/** Computes a Pareto value from a uniform number. */
+struct ParetoTransform
+{
+  double scale; //!< The scale.
+  double shape; //!< The shape.
+  /**
+   * \param [in] v A uniform number.
+   * \returns The value.
+   */
+  double operator () (double v) const
+  {
+    return (scale * ( 1.0 / std::pow (v, 1.0 / shape)));
+  }
+};
+
+/** Computes a Weibull value from a uniform number. */
+struct WeibullTransform
+{
+  double scale;    //!< The scale.
+  double exponent; //!< The inverse of the shape.
+  /**
+   * \param [in] v A uniform number.
+   * \returns The value.
+   */
+  double operator () (double v) const
+  {
+    return scale * std::pow ( -std::log (v), exponent);
+  }
+};
+
+} // anonymous namespace
+
 TypeId 
 RandomVariableStream::GetTypeId (void)
 {
@@ -72,16 +203,45 @@ RandomVariableStream::GetTypeId (void)
 }
 
 RandomVariableStream::RandomVariableStream()
-  : m_rng (0)
+  : m_rng (0),
+    m_rngStream (0)
 {
   NS_LOG_FUNCTION (this);
+  LockAllStreams ();
+  GetAllStreams ().insert (this);
+  UnlockAllStreams ();
 }
 RandomVariableStream::~RandomVariableStream()
 {
   NS_LOG_FUNCTION (this);
+  LockAllStreams ();
+  GetAllStreams ().erase (this);
+  UnlockAllStreams ();
   delete m_rng;
 }
 
+void
+RandomVariableStream::ResetAllStreams (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  LockAllStreams ();
+  for (std::set<RandomVariableStream *>::const_iterator i = GetAllStreams ().begin ();
+       i != GetAllStreams ().end (); ++i)
+    {
+      RandomVariableStream *stream = *i;
+      if (stream->m_rng == 0)
+        {
+          continue;
+        }
+      delete stream->m_rng;
+      stream->m_rng = new RngStream (RngSeedManager::GetSeed (),
+                                     stream->m_rngStream,
+                                     RngSeedManager::GetRun ());
+      stream->DoResetStream ();
+    }
+  UnlockAllStreams ();
+}
+
 void
 RandomVariableStream::SetAntithetic(bool isAntithetic)
 {
@@ -107,6 +267,7 @@ RandomVariableStream::SetStream (int64_t stream)
       // number assignment.
       uint64_t nextStream = RngSeedManager::GetNextStreamIndex ();
       NS_ASSERT(nextStream <= ((1ULL)<<63));
+      m_rngStream = nextStream;
       m_rng = new RngStream (RngSeedManager::GetSeed (),
                              nextStream,
                              RngSeedManager::GetRun ());
@@ -117,6 +278,7 @@ RandomVariableStream::SetStream (int64_t stream)
       // number assignment.
       uint64_t base = ((1ULL)<<63);
       uint64_t target = base + stream;
+      m_rngStream = target;
       m_rng = new RngStream (RngSeedManager::GetSeed (),
                              target,
                              RngSeedManager::GetRun ());
@@ -137,6 +299,46 @@ RandomVariableStream::Peek(void) const
   return m_rng;
 }
 
+void
+RandomVariableStream::DoResetStream (void)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+RandomVariableStream::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      values[i] = GetValue ();
+    }
+}
+
+void
+RandomVariableStream::SaveCheckpoint (CheckpointWriter &writer) const
+{
+  NS_LOG_FUNCTION (this << &writer);
+  double state[6];
+  m_rng->GetState (state);
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      writer.WriteDouble (state[i]);
+    }
+}
+
+void
+RandomVariableStream::RestoreCheckpoint (CheckpointReader &reader)
+{
+  NS_LOG_FUNCTION (this << &reader);
+  double state[6];
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      state[i] = reader.ReadDouble ();
+    }
+  m_rng->SetState (state);
+}
+
 NS_OBJECT_ENSURE_REGISTERED(UniformRandomVariable);
 
 TypeId 
@@ -208,6 +410,46 @@ UniformRandomVariable::GetInteger (void)
   return (uint32_t)GetValue (m_min, m_max + 1);
 }
 
+void
+UniformRandomVariable::GetValues (double *values, uint32_t n, double min, double max)
+{
+  NS_LOG_FUNCTION (this << values << n << min << max);
+  Peek ()->RandU01 (values, n);
+  bool antithetic = IsAntithetic ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double v = min + values[i] * (max - min);
+      if (antithetic)
+        {
+          v = min + (max - v);
+        }
+      values[i] = v;
+    }
+}
+void
+UniformRandomVariable::GetIntegers (uint32_t *values, uint32_t n, uint32_t min, uint32_t max)
+{
+  NS_LOG_FUNCTION (this << values << n << min << max);
+  NS_ASSERT (min <= max);
+  double buffer[BATCH_SIZE];
+  for (uint32_t done = 0; done < n; )
+    {
+      uint32_t count = std::min (n - done, BATCH_SIZE);
+      GetValues (buffer, count, (double) (min), (double) (max) + 1.0);
+      for (uint32_t i = 0; i < count; i++)
+        {
+          values[done + i] = static_cast<uint32_t> (buffer[i]);
+        }
+      done += count;
+    }
+}
+void
+UniformRandomVariable::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  GetValues (values, n, m_min, m_max);
+}
+
 NS_OBJECT_ENSURE_REGISTERED(ConstantRandomVariable);
 
 TypeId 
@@ -262,6 +504,12 @@ ConstantRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_constant);
 }
+void
+ConstantRandomVariable::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  std::fill (values, values + n, m_constant);
+}
 
 NS_OBJECT_ENSURE_REGISTERED(SequentialRandomVariable);
 
@@ -445,6 +693,15 @@ ExponentialRandomVariable::GetInteger (void)
   return (uint32_t)GetValue (m_mean, m_bound);
 }
 
+void
+ExponentialRandomVariable::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  ExponentialTransform transform;
+  transform.mean = m_mean;
+  GetBoundedValues (Peek (), IsAntithetic (), m_bound, transform, values, n);
+}
+
 NS_OBJECT_ENSURE_REGISTERED(ParetoRandomVariable);
 
 TypeId 
@@ -541,6 +798,16 @@ ParetoRandomVariable::GetInteger (void)
   return (uint32_t)GetValue (m_mean, m_shape, m_bound);
 }
 
+void
+ParetoRandomVariable::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  ParetoTransform transform;
+  transform.scale = m_mean * (m_shape - 1.0) / m_shape;
+  transform.shape = m_shape;
+  GetBoundedValues (Peek (), IsAntithetic (), m_bound, transform, values, n);
+}
+
 NS_OBJECT_ENSURE_REGISTERED(WeibullRandomVariable);
 
 TypeId 
@@ -635,6 +902,16 @@ WeibullRandomVariable::GetInteger (void)
   return (uint32_t)GetValue (m_scale, m_shape, m_bound);
 }
 
+void
+WeibullRandomVariable::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  WeibullTransform transform;
+  transform.scale = m_scale;
+  transform.exponent = 1.0 / m_shape;
+  GetBoundedValues (Peek (), IsAntithetic (), m_bound, transform, values, n);
+}
+
 NS_OBJECT_ENSURE_REGISTERED(NormalRandomVariable);
 
 const double NormalRandomVariable::INFINITE_VALUE = 1e307;
@@ -755,6 +1032,84 @@ NormalRandomVariable::GetInteger (void)
   return (uint32_t)GetValue (m_mean, m_variance, m_bound);
 }
 
+void
+NormalRandomVariable::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  uint32_t done = 0;
+  if (n > 0 && m_nextValid)
+    { // use previously generated
+      m_nextValid = false;
+      values[done++] = m_next;
+    }
+  bool antithetic = IsAntithetic ();
+  double stddev = std::sqrt (m_variance);
+  double buffer[BATCH_SIZE];
+  while (done < n)
+    {
+      // A pair gives at most two values, so the first
+      // ceil (missing / 2) pairs are all needed by GetValue.
+      uint32_t pairs = std::min ((n - done + 1) / 2, BATCH_SIZE / 2);
+      Peek ()->RandU01 (buffer, 2 * pairs);
+      for (uint32_t i = 0; i < pairs; i++)
+        {
+          // Same Box-Muller transform as GetValue (mean, variance, bound).
+          double u1 = buffer[2 * i];
+          double u2 = buffer[2 * i + 1];
+          if (antithetic)
+            {
+              u1 = (1 - u1);
+              u2 = (1 - u2);
+            }
+          double v1 = 2 * u1 - 1;
+          double v2 = 2 * u2 - 1;
+          double w = v1 * v1 + v2 * v2;
+          if (w > 1.0)
+            {
+              continue;
+            }
+          double y = std::sqrt ((-2 * std::log (w)) / w);
+          m_next = m_mean + v2 * y * stddev;
+          m_nextValid = std::fabs (m_next - m_mean) <= m_bound;
+          double x1 = m_mean + v1 * y * stddev;
+          if (std::fabs (x1 - m_mean) <= m_bound)
+            {
+              values[done++] = x1;
+            }
+          if (m_nextValid && done < n)
+            {
+              m_nextValid = false;
+              values[done++] = m_next;
+            }
+        }
+    }
+}
+
+void
+NormalRandomVariable::SaveCheckpoint (CheckpointWriter &writer) const
+{
+  NS_LOG_FUNCTION (this << &writer);
+  RandomVariableStream::SaveCheckpoint (writer);
+  writer.WriteU8 (m_nextValid);
+  writer.WriteDouble (m_next);
+}
+
+void
+NormalRandomVariable::RestoreCheckpoint (CheckpointReader &reader)
+{
+  NS_LOG_FUNCTION (this << &reader);
+  RandomVariableStream::RestoreCheckpoint (reader);
+  m_nextValid = reader.ReadU8 ();
+  m_next = reader.ReadDouble ();
+}
+
+void
+NormalRandomVariable::DoResetStream (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_nextValid = false;
+}
+
 NS_OBJECT_ENSURE_REGISTERED(LogNormalRandomVariable);
 
 TypeId 
@@ -1005,6 +1360,31 @@ GammaRandomVariable::GetInteger (void)
   return (uint32_t)GetValue (m_alpha, m_beta);
 }
 
+void
+GammaRandomVariable::SaveCheckpoint (CheckpointWriter &writer) const
+{
+  NS_LOG_FUNCTION (this << &writer);
+  RandomVariableStream::SaveCheckpoint (writer);
+  writer.WriteU8 (m_nextValid);
+  writer.WriteDouble (m_next);
+}
+
+void
+GammaRandomVariable::RestoreCheckpoint (CheckpointReader &reader)
+{
+  NS_LOG_FUNCTION (this << &reader);
+  RandomVariableStream::RestoreCheckpoint (reader);
+  m_nextValid = reader.ReadU8 ();
+  m_next = reader.ReadDouble ();
+}
+
+void
+GammaRandomVariable::DoResetStream (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_nextValid = false;
+}
+
 double 
 GammaRandomVariable::GetNormalValue (double mean, double variance, double bound)
 {
@@ -1279,6 +1659,8 @@ ZipfRandomVariable::GetTypeId (void)
   return tid;
 }
 ZipfRandomVariable::ZipfRandomVariable ()
+  : m_setupN (0),
+    m_setupAlpha (std::numeric_limits<double>::quiet_NaN ())
 {
   // m_n and m_alpha are initialized after constructor by attributes
   NS_LOG_FUNCTION (this);
@@ -1297,36 +1679,112 @@ ZipfRandomVariable::GetAlpha (void) const
   return m_alpha;
 }
 
-double 
-ZipfRandomVariable::GetValue (uint32_t n, double alpha)
+namespace {
+
+/**
+ * \param [in] x The argument.
+ * \return \f$ \log (1 + x) / x \f$, also for \f$ x \f$ close to 0.
+ */
+double
+ZipfHelper1 (double x)
 {
-  NS_LOG_FUNCTION (this << n << alpha);
-  // Calculate the normalization constant c.
-  m_c = 0.0;
-  for (uint32_t i = 1; i <= n; i++)
+  if (std::fabs (x) > 1e-8)
     {
-      m_c += (1.0 / std::pow ((double)i,alpha));
+      return log1p (x) / x;
     }
-  m_c = 1.0 / m_c;
+  return 1 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+}
 
-  // Get a uniform random variable in [0,1].
-  double u = Peek ()->RandU01 ();
-  if (IsAntithetic ())
+/**
+ * \param [in] x The argument.
+ * \return \f$ (e^x - 1) / x \f$, also for \f$ x \f$ close to 0.
+ */
+double
+ZipfHelper2 (double x)
+{
+  if (std::fabs (x) > 1e-8)
     {
-      u = (1 - u);
+      return expm1 (x) / x;
+    }
+  return 1 + x * 0.5 * (1 + x * 1.0 / 3.0 * (1 + 0.25 * x));
+}
+
+} // anonymous namespace
+
+double
+ZipfRandomVariable::HIntegral (double x) const
+{
+  double logX = std::log (x);
+  return ZipfHelper2 ((1 - m_setupAlpha) * logX) * logX;
+}
+
+double
+ZipfRandomVariable::H (double x) const
+{
+  return std::exp (-m_setupAlpha * std::log (x));
+}
+
+double
+ZipfRandomVariable::HIntegralInverse (double x) const
+{
+  double t = x * (1 - m_setupAlpha);
+  if (t < -1)
+    {
+      // Limit value for alpha > 1, reached through rounding.
+      t = -1;
     }
+  return std::exp (ZipfHelper1 (t) * x);
+}
 
-  double sum_prob = 0,zipf_value = 0;
-  for (uint32_t i = 1; i <= m_n; i++)
+void
+ZipfRandomVariable::Setup (uint32_t n, double alpha)
+{
+  if (n == m_setupN && alpha == m_setupAlpha)
     {
-      sum_prob += m_c / std::pow ((double)i,m_alpha);
-      if (sum_prob > u)
+      return;
+    }
+  NS_LOG_FUNCTION (this << n << alpha);
+  NS_ASSERT_MSG (n >= 1 && alpha >= 0, "Invalid Zipf parameters");
+  m_setupN = n;
+  m_setupAlpha = alpha;
+  m_hIntegralX1 = HIntegral (1.5) - 1;
+  m_hIntegralN = HIntegral (n + 0.5);
+  m_s = 2 - HIntegralInverse (HIntegral (2.5) - H (2));
+}
+
+double 
+ZipfRandomVariable::GetValue (uint32_t n, double alpha)
+{
+  NS_LOG_FUNCTION (this << n << alpha);
+  Setup (n, alpha);
+  while (1)
+    {
+      // Get a uniform random variable in [0,1].
+      double u = Peek ()->RandU01 ();
+      if (IsAntithetic ())
         {
-          zipf_value = i;
-          break;
+          u = (1 - u);
+        }
+
+      // Invert the integral of the hat function, and accept the
+      // nearest integer k if the point is below the distribution
+      // over [k - 0.5, k + 0.5].
+      double hu = m_hIntegralN + u * (m_hIntegralX1 - m_hIntegralN);
+      double x = HIntegralInverse (hu);
+      double k = std::floor (x + 0.5);
+      if (k < 1)
+        {
+          k = 1;
+        }
+      else if (k > n)
+        {
+          k = n;
+        }
+      if (k - x <= m_s || hu >= HIntegral (k + 0.5) - H (k))
+        {
+          return k;
         }
     }
-  return zipf_value;
 }
 
 uint32_t 
@@ -1535,12 +1993,19 @@ EmpiricalRandomVariable::GetTypeId (void)
     .SetParent<RandomVariableStream>()
     .SetGroupName ("Core")
     .AddConstructor<EmpiricalRandomVariable> ()
+    .AddAttribute ("Interpolate",
+                   "Whether the values between the points of the CDF are interpolated. "
+                   "If false, only the values of the points are returned.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&EmpiricalRandomVariable::SetInterpolate),
+                   MakeBooleanChecker ())
     ;
   return tid;
 }
 EmpiricalRandomVariable::EmpiricalRandomVariable ()
   :
-  validated (false)
+  validated (false),
+  m_interpolate (true)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -1567,6 +2032,18 @@ EmpiricalRandomVariable::GetValue (void)
       r = (1 - r);
     }
 
+  if (!m_interpolate)
+    {
+      // Use r for both the column and the coin of the alias table.
+      uint32_t size = m_alias.size ();
+      double x = r * size;
+      uint32_t i = std::min (static_cast<uint32_t> (x), size - 1);
+      if (x - i >= m_aliasProbability[i])
+        {
+          i = m_alias[i];
+        }
+      return emp[i].value;
+    }
   if (r <= emp.front ().cdf)
     {
       return emp.front ().value; // Less than first
@@ -1575,28 +2052,22 @@ EmpiricalRandomVariable::GetValue (void)
     {
       return emp.back ().value;  // Greater than last
     }
-  // Binary search
-  std::vector<ValueCDF>::size_type bottom = 0;
-  std::vector<ValueCDF>::size_type top = emp.size () - 1;
-  while (1)
+  // The first point above r is at or after the guide entry of r, and
+  // there is one point per entry on average.
+  uint32_t size = m_guide.size ();
+  uint32_t c = m_guide[std::min (static_cast<uint32_t> (r * size), size - 1)];
+  while (c > 0 && emp[c - 1].cdf > r)
     {
-      std::vector<ValueCDF>::size_type c = (top + bottom) / 2;
-      if (r >= emp[c].cdf && r < emp[c + 1].cdf)
-        { // Found it
-          return Interpolate (emp[c].cdf, emp[c + 1].cdf,
-                              emp[c].value, emp[c + 1].value,
-                              r);
-        }
-      // Not here, adjust bounds
-      if (r < emp[c].cdf)
-        {
-          top    = c - 1;
-        }
-      else
-        {
-          bottom = c + 1;
-        }
+      // Only after rounding errors in the guide index.
+      c--;
+    }
+  while (emp[c].cdf <= r)
+    {
+      c++;
     }
+  return Interpolate (emp[c - 1].cdf, emp[c].cdf,
+                      emp[c - 1].value, emp[c].value,
+                      r);
 }
 
 uint32_t 
@@ -1611,6 +2082,15 @@ void EmpiricalRandomVariable::CDF (double v, double c)
   // NOTE.   These MUST be inserted in non-decreasing order
   NS_LOG_FUNCTION (this << v << c);
   emp.push_back (ValueCDF (v, c));
+  validated = false;
+}
+
+void
+EmpiricalRandomVariable::SetInterpolate (bool interpolate)
+{
+  NS_LOG_FUNCTION (this << interpolate);
+  m_interpolate = interpolate;
+  validated = false;
 }
 
 void EmpiricalRandomVariable::Validate ()
@@ -1631,9 +2111,86 @@ void EmpiricalRandomVariable::Validate ()
         }
       prior = current;
     }
+  if (m_interpolate)
+    {
+      BuildGuideTable ();
+    }
+  else
+    {
+      BuildAliasTable ();
+    }
   validated = true;
 }
 
+void
+EmpiricalRandomVariable::BuildGuideTable (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t size = emp.size ();
+  m_guide.resize (size);
+  uint32_t c = 0;
+  for (uint32_t j = 0; j < size; ++j)
+    {
+      double start = static_cast<double> (j) / size;
+      while (c < size - 1 && emp[c].cdf <= start)
+        {
+          c++;
+        }
+      m_guide[j] = c;
+    }
+}
+
+void
+EmpiricalRandomVariable::BuildAliasTable (void)
+{
+  NS_LOG_FUNCTION (this);
+  // The probability of each point is its step of the CDF; the
+  // points beyond the last cdf, if it is below 1, are the last value.
+  uint32_t size = emp.size ();
+  std::vector<double> scaled (size);
+  double prior = 0.0;
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      double cdf = std::min (emp[i].cdf, 1.0);
+      scaled[i] = (cdf - prior) * size;
+      prior = cdf;
+    }
+  scaled[size - 1] += (1.0 - prior) * size;
+
+  m_aliasProbability.assign (size, 1.0);
+  m_alias.resize (size);
+  std::vector<uint32_t> small;
+  std::vector<uint32_t> large;
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      m_alias[i] = i;
+      if (scaled[i] < 1.0)
+        {
+          small.push_back (i);
+        }
+      else
+        {
+          large.push_back (i);
+        }
+    }
+  while (!small.empty () && !large.empty ())
+    {
+      uint32_t less = small.back ();
+      uint32_t more = large.back ();
+      small.pop_back ();
+      m_aliasProbability[less] = scaled[less];
+      m_alias[less] = more;
+      scaled[more] = (scaled[more] + scaled[less]) - 1.0;
+      if (scaled[more] < 1.0)
+        {
+          large.pop_back ();
+          small.push_back (more);
+        }
+    }
+  // What is left has a probability of 1 up to rounding errors, and
+  // keeps its default m_aliasProbability of 1.
+}
+
 double EmpiricalRandomVariable::Interpolate (double c1, double c2,
                                            double v1, double v2, double r)
 { // Interpolate random value in range [v1..v2) based on [c1 .. r .. c2)
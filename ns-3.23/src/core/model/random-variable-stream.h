@@ -29,6 +29,7 @@
 #include "type-id.h"
 #include "object.h"
 #include "attribute-helper.h"
+#include "checkpoint.h"
 #include <stdint.h>
 
 namespace ns3 {
@@ -84,7 +85,7 @@ class RngStream;
  * "RngRun".  Also by default, the stream number value for this RNG
  * stream is automatically allocated.
  */
-class RandomVariableStream : public Object
+class RandomVariableStream : public Object, public Checkpointable
 {
 public:
   /**
@@ -133,11 +134,58 @@ public:
    */
   virtual uint32_t GetInteger (void) = 0;
 
+  /**
+   * \brief Fills an array with random doubles from the underlying distribution
+   * \param [out] values The random values.
+   * \param [in] n The number of values to generate.
+   *
+   * The values are those that \p n successive calls to GetValue
+   * would return, and the stream is left in the same state.  The
+   * default implementation calls GetValue; subclasses override it to
+   * draw the underlying uniform numbers in one batch (see
+   * RngStream::RandU01 (double *, uint32_t)) and to avoid a virtual
+   * call per value.
+   */
+  virtual void GetValues (double *values, uint32_t n);
+
+  /**
+   * Save the position of the underlying RNG stream.
+   * \param [in] writer Where to save it.
+   */
+  virtual void SaveCheckpoint (CheckpointWriter &writer) const;
+  /**
+   * Restore the position of the underlying RNG stream.
+   * \param [in] reader Where to read it.
+   */
+  virtual void RestoreCheckpoint (CheckpointReader &reader);
+
+  /**
+   * \brief Restart all the existing RNG streams from the current seed
+   * and run number.
+   *
+   * Each stream keeps its stream number: this gives the existing
+   * random variables the values they would have had if they had been
+   * created after the last RngSeedManager::SetSeed or SetRun, without
+   * allocating new stream numbers. SweepRunner uses this to give a
+   * different run number to each replica after a shared warm-up.
+   */
+  static void ResetAllStreams (void);
+
 protected:
   /**
    * \brief Returns a pointer to the underlying RNG stream.
    */
   RngStream *Peek(void) const;
+  /**
+   * \brief Forget the state drawn from the previous RNG stream.
+   *
+   * Called by ResetAllStreams after the RNG stream of this variable
+   * was restarted. Variables which keep values drawn in advance, such
+   * as the second normal value of NormalRandomVariable, drop them here
+   * so that they only return values of the new stream. The default
+   * implementation does nothing.
+   */
+  virtual void DoResetStream (void);
 
 private:
   // you can't copy these objects.
@@ -154,6 +202,9 @@ private:
 
   /// The stream number for this RNG stream.
   int64_t m_stream;
+
+  /// The stream number given to the underlying RNG stream.
+  uint64_t m_rngStream;
 };
 
 /**
@@ -290,6 +341,37 @@ public:
    * upper bound.
    */
   virtual uint32_t GetInteger (void);
+
+  /**
+   * \brief Fills an array with random doubles from the uniform distribution with the range [min,max).
+   * \param [out] values The random values.
+   * \param [in] n The number of values to generate.
+   * \param [in] min Low end of the range.
+   * \param [in] max High end of the range.
+   *
+   * The values are those that \p n successive calls to
+   * GetValue (min, max) would return.
+   */
+  void GetValues (double *values, uint32_t n, double min, double max);
+
+  /**
+   * \brief Fills an array with random unsigned integers from a uniform distribution over the interval [min,max] including both ends.
+   * \param [out] values The random values.
+   * \param [in] n The number of values to generate.
+   * \param [in] min Low end of the range.
+   * \param [in] max High end of the range.
+   *
+   * The values are those that \p n successive calls to
+   * GetInteger (min, max) would return.
+   */
+  void GetIntegers (uint32_t *values, uint32_t n, uint32_t min, uint32_t max);
+
+  /**
+   * \brief Fills an array with random doubles from the uniform distribution with the current lower and upper bounds.
+   * \param [out] values The random values.
+   * \param [in] n The number of values to generate.
+   */
+  virtual void GetValues (double *values, uint32_t n);
 private:
   /// The lower bound on values that can be returned by this RNG stream.
   double m_min;
@@ -343,6 +425,13 @@ public:
    */
   virtual uint32_t GetInteger (void);
 
+  /**
+   * \brief Fills an array with the constant value returned by this RNG stream.
+   * \param [out] values The constant values.
+   * \param [in] n The number of values.
+   */
+  virtual void GetValues (double *values, uint32_t n);
+
 private:
   /// The constant value returned by this RNG stream.
   double m_constant;
@@ -599,6 +688,16 @@ public:
    */
   virtual uint32_t GetInteger (void);
 
+  /**
+   * \brief Fills an array with random doubles with the current parameters.
+   * \param [out] values The random values.
+   * \param [in] n The number of values to generate.
+   *
+   * The values are those that \p n successive calls to GetValue
+   * would return.
+   */
+  virtual void GetValues (double *values, uint32_t n);
+
 private:
   /// The mean value of the random variables returned by this RNG stream.
   double m_mean;
@@ -811,6 +910,16 @@ public:
    */
   virtual uint32_t GetInteger (void);
 
+  /**
+   * \brief Fills an array with random doubles with the current parameters.
+   * \param [out] values The random values.
+   * \param [in] n The number of values to generate.
+   *
+   * The values are those that \p n successive calls to GetValue
+   * would return.
+   */
+  virtual void GetValues (double *values, uint32_t n);
+
 private:
   /// The mean parameter for the Pareto distribution returned by this RNG stream.
   double m_mean;
@@ -1011,6 +1120,16 @@ public:
    */
   virtual uint32_t GetInteger (void);
 
+  /**
+   * \brief Fills an array with random doubles with the current parameters.
+   * \param [out] values The random values.
+   * \param [in] n The number of values to generate.
+   *
+   * The values are those that \p n successive calls to GetValue
+   * would return.
+   */
+  virtual void GetValues (double *values, uint32_t n);
+
 private:
   /// The scale parameter for the Weibull distribution returned by this RNG stream.
   double m_scale;
@@ -1237,7 +1356,24 @@ public:
    */
   virtual uint32_t GetInteger (void);
 
+  /**
+   * \brief Fills an array with random doubles with the current parameters.
+   * \param [out] values The random values.
+   * \param [in] n The number of values to generate.
+   *
+   * The values are those that \p n successive calls to GetValue
+   * would return.
+   */
+  virtual void GetValues (double *values, uint32_t n);
+
+  // Inherited
+  virtual void SaveCheckpoint (CheckpointWriter &writer) const;
+  virtual void RestoreCheckpoint (CheckpointReader &reader);
+
 private:
+  // Inherited
+  virtual void DoResetStream (void);
+
   /// The mean value for the normal distribution returned by this RNG stream.
   double m_mean;
 
@@ -1584,7 +1720,14 @@ public:
    */
   virtual uint32_t GetInteger (void);
 
+  // Inherited
+  virtual void SaveCheckpoint (CheckpointWriter &writer) const;
+  virtual void RestoreCheckpoint (CheckpointReader &reader);
+
 private:
+  // Inherited
+  virtual void DoResetStream (void);
+
   /**
    * \brief Returns a random double from a normal distribution with the specified mean, variance, and bound.
    * \param mean Mean value for the normal distribution.
@@ -2036,6 +2179,14 @@ private:
  * Probability Mass Function is \f$ f(k; \alpha, N) = k^{-\alpha}/ H_{N,\alpha} \f$
  * where \f$ H_{N,\alpha} = \sum_{m=1}^N m^{-\alpha} \f$
  *
+ * The values are drawn with the rejection-inversion method of
+ * W. Hormann and G. Derflinger, "Rejection-inversion to generate
+ * variates from monotone discrete distributions", ACM TOMACS 6(3),
+ * 1996.  Its cost does not depend on N: it takes one uniform
+ * number per value, plus one for each rejection, and the expected
+ * number of rejections is small.  The constants of the method are
+ * computed again only when n or alpha change.
+ *
  * Here is an example of how to use this class:
  * \code
  *   uint32_t n = 1;
@@ -2167,8 +2318,42 @@ private:
   /// The alpha value for the Zipf distribution returned by this RNG stream.
   double m_alpha;
 
-  /// The normalization constant.
-  double m_c;
+  /**
+   * Compute the constants of the rejection-inversion method for
+   * the given n and alpha, unless they are already known.
+   * \param [in] n N value for the Zipf distribution.
+   * \param [in] alpha Alpha value for the Zipf distribution.
+   */
+  void Setup (uint32_t n, double alpha);
+  /**
+   * The integral of the hat function, \f$ H(x) = (x^{1-\alpha} - 1) / (1 - \alpha) \f$.
+   * \param [in] x The upper bound of the integral.
+   * \return The value of the integral.
+   */
+  double HIntegral (double x) const;
+  /**
+   * The hat function, \f$ h(x) = x^{-\alpha} \f$.
+   * \param [in] x The argument.
+   * \return The value of the function.
+   */
+  double H (double x) const;
+  /**
+   * The inverse of HIntegral.
+   * \param [in] x The value of the integral.
+   * \return The argument of HIntegral that gives \p x.
+   */
+  double HIntegralInverse (double x) const;
+
+  /// The n value of the constants below.
+  uint32_t m_setupN;
+  /// The alpha value of the constants below, or a NaN before the first Setup.
+  double m_setupAlpha;
+  /// HIntegral (1.5) - 1: the upper end of the inversion interval.
+  double m_hIntegralX1;
+  /// HIntegral (n + 0.5): the lower end of the inversion interval.
+  double m_hIntegralN;
+  /// The values within this distance of their integer are always accepted.
+  double m_s;
 };
 
 /**
@@ -2383,6 +2568,15 @@ private:
  * two appropriate points in the CDF.  The method is known
  * as inverse transform sampling:
  * (http://en.wikipedia.org/wiki/Inverse_transform_sampling).
+ * A guide table built with the CDF finds the two points in
+ * constant expected time.
+ *
+ * If the Interpolate attribute is false, the distribution is
+ * discrete instead: each value is returned with the probability of
+ * its step of the CDF, \f$ c_i - c_{i-1} \f$.  The values are drawn
+ * from an alias table in constant time.  The alias method does not
+ * map the uniform numbers monotonically to the values, so antithetic
+ * values are not negatively correlated in this case.
  *
  * Here is an example of how to use this class:
  * \code
@@ -2418,6 +2612,16 @@ public:
    */
   void CDF (double v, double c);  // Value, prob <= Value
 
+  /**
+   * \brief Specifies whether the values between the points of the
+   * CDF are interpolated.
+   * \param interpolate If false, only the values of the points are
+   *   returned, each with the probability of its step of the CDF.
+   *
+   * This is the same as setting the Interpolate attribute.
+   */
+  void SetInterpolate (bool interpolate);
+
   /**
    * \brief Returns the next value in the empirical distribution.
    * \return The floating point next value in the empirical distribution.
@@ -2456,8 +2660,27 @@ public:
   };
   virtual void Validate ();  // Insure non-decreasing emiprical values
   virtual double Interpolate (double, double, double, double, double);
+  /**
+   * Build the guide table of the interpolated CDF: the first point
+   * above \f$ j / size \f$ for each \f$ j \f$, so that each search
+   * only visits a few points on average.
+   */
+  void BuildGuideTable (void);
+  /**
+   * Build the alias table (Vose's method) of the discrete distribution
+   * of the points of the CDF, which gives a value in constant time.
+   */
+  void BuildAliasTable (void);
   bool validated; // True if non-decreasing validated
   std::vector<ValueCDF> emp;       // Empicical CDF
+  /// If true, interpolate between the points of the CDF.
+  bool m_interpolate;
+  /// For each interval \f$ [j / size, (j + 1) / size) \f$, the index of the first point with a larger cdf.
+  std::vector<uint32_t> m_guide;
+  /// For each point, the probability of returning it rather than its alias.
+  std::vector<double> m_aliasProbability;
+  /// For each point, the index of its alias.
+  std::vector<uint32_t> m_alias;
 };
 
 } // namespace ns3
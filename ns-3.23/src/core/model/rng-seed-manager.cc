@@ -99,4 +99,11 @@ uint64_t RngSeedManager::GetNextStreamIndex (void)
   return next;
 }
 
+void
+RngSeedManager::SetNextStreamIndex (uint64_t next)
+{
+  NS_LOG_FUNCTION (next);
+  g_nextStreamIndex = next;
+}
+
 } // namespace ns3
@@ -80,6 +80,13 @@ public:
   static uint64_t GetRun (void);
 
   static uint64_t GetNextStreamIndex(void);
+  /**
+   * \brief Set the next stream index for automatic assignment.
+   *
+   * This is used to resume a simulation from a Checkpoint.
+   * \param [in] next The next stream index to allocate.
+   */
+  static void SetNextStreamIndex (uint64_t next);
 
 };
 
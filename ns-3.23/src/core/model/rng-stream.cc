@@ -281,6 +281,37 @@ double RngStream::RandU01 ()
   return u;
 }
 
+void RngStream::RandU01 (double *values, uint32_t n)
+{
+  // The same arithmetic as RandU01 (void), so that the sequence is
+  // identical, with the state kept in registers. The two components
+  // are independent: the compiler interleaves their divisions.
+  double s0 = m_currentState[0], s1 = m_currentState[1], s2 = m_currentState[2];
+  double s3 = m_currentState[3], s4 = m_currentState[4], s5 = m_currentState[5];
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double p1 = a12 * s1 - a13n * s0;
+      double p2 = a21 * s5 - a23n * s3;
+      int32_t k1 = static_cast<int32_t> (p1 / m1);
+      int32_t k2 = static_cast<int32_t> (p2 / m2);
+      p1 -= k1 * m1;
+      p2 -= k2 * m2;
+      if (p1 < 0.0)
+        {
+          p1 += m1;
+        }
+      if (p2 < 0.0)
+        {
+          p2 += m2;
+        }
+      s0 = s1; s1 = s2; s2 = p1;
+      s3 = s4; s4 = s5; s5 = p2;
+      values[i] = ((p1 > p2) ? (p1 - p2) * norm : (p1 - p2 + m1) * norm);
+    }
+  m_currentState[0] = s0; m_currentState[1] = s1; m_currentState[2] = s2;
+  m_currentState[3] = s3; m_currentState[4] = s4; m_currentState[5] = s5;
+}
+
 RngStream::RngStream (uint32_t seedNumber, uint64_t stream, uint64_t substream)
 {
   if (seedNumber >= m1 || seedNumber >= m2 || seedNumber == 0)
@@ -303,6 +334,24 @@ RngStream::RngStream(const RngStream& r)
     }
 }
 
+void
+RngStream::GetState (double state[6]) const
+{
+  for (int i = 0; i < 6; ++i)
+    {
+      state[i] = m_currentState[i];
+    }
+}
+
+void
+RngStream::SetState (const double state[6])
+{
+  for (int i = 0; i < 6; ++i)
+    {
+      m_currentState[i] = state[i];
+    }
+}
+
 void 
 RngStream::AdvanceNthBy (uint64_t nth, int by, double state[6])
 {
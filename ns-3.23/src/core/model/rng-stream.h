@@ -45,6 +45,23 @@ public:
    * Uniformly distributed between 0 and 1.
    */
   double RandU01 (void);
+  /**
+   * Generate the next n random numbers of this stream, the same as n
+   * calls to RandU01 would.
+   * \param [out] values The random numbers, uniformly distributed
+   *   between 0 and 1.
+   * \param [in] n The number of random numbers.
+   */
+  void RandU01 (double *values, uint32_t n);
+  /**
+   * \param [out] state The current state of the generator.
+   */
+  void GetState (double state[6]) const;
+  /**
+   * Resume the generator from a state obtained with GetState.
+   * \param [in] state The state.
+   */
+  void SetState (const double state[6]);
 
 private:
   void AdvanceNthBy (uint64_t nth, int by, double state[6]);
@@ -0,0 +1,285 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "sweep-runner.h"
+#include "simulator.h"
+#include "config.h"
+#include "rng-seed-manager.h"
+#include "random-variable-stream.h"
+#include "fatal-error.h"
+#include "assert.h"
+#include "log.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * \file
+ * \ingroup core
+ * Implementation of class ns3::SweepRunner.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SweepRunner");
+
+SweepRunner::SweepRunner ()
+  : m_warmup (Time (0)),
+    m_stop (Time (0)),
+    m_maxProcesses (1)
+{
+  NS_LOG_FUNCTION (this);
+  long n = sysconf (_SC_NPROCESSORS_ONLN);
+  if (n > 0)
+    {
+      m_maxProcesses = n;
+    }
+}
+
+void
+SweepRunner::SetWarmup (Time warmup)
+{
+  NS_LOG_FUNCTION (this << warmup);
+  m_warmup = warmup;
+}
+
+void
+SweepRunner::SetStopTime (Time stop)
+{
+  NS_LOG_FUNCTION (this << stop);
+  m_stop = stop;
+}
+
+void
+SweepRunner::SetMaxProcesses (uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  NS_ASSERT (n > 0);
+  m_maxProcesses = n;
+}
+
+void
+SweepRunner::SetResultCallback (Callback<std::string> cb)
+{
+  NS_LOG_FUNCTION (this << &cb);
+  m_result = cb;
+}
+
+uint32_t
+SweepRunner::AddVariant (uint64_t run)
+{
+  NS_LOG_FUNCTION (this << run);
+  Variant variant;
+  variant.run = run;
+  variant.success = false;
+  m_variants.push_back (variant);
+  return m_variants.size () - 1;
+}
+
+void
+SweepRunner::AddConfig (uint32_t variant, std::string path, const AttributeValue &value)
+{
+  NS_LOG_FUNCTION (this << variant << path << &value);
+  NS_ASSERT (variant < m_variants.size ());
+  m_variants[variant].configs.push_back (std::make_pair (path, value.Copy ()));
+}
+
+uint32_t
+SweepRunner::GetVariantN (void) const
+{
+  return m_variants.size ();
+}
+
+bool
+SweepRunner::IsSuccess (uint32_t variant) const
+{
+  NS_ASSERT (variant < m_variants.size ());
+  return m_variants[variant].success;
+}
+
+std::string
+SweepRunner::GetResult (uint32_t variant) const
+{
+  NS_ASSERT (variant < m_variants.size ());
+  return m_variants[variant].result;
+}
+
+void
+SweepRunner::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_warmup > Simulator::Now ())
+    {
+      Simulator::Stop (m_warmup - Simulator::Now ());
+      Simulator::Run ();
+    }
+  NS_LOG_INFO ("Warm-up done at " << Simulator::Now ().GetSeconds () << "s");
+
+  // the children must not write again what is buffered now.
+  std::cout.flush ();
+  std::cerr.flush ();
+  std::clog.flush ();
+  std::fflush (0);
+
+  std::vector<Child> running;
+  uint32_t next = 0;
+  while (next < m_variants.size () || !running.empty ())
+    {
+      while (next < m_variants.size () && running.size () < m_maxProcesses)
+        {
+          running.push_back (Start (next));
+          next++;
+        }
+      std::vector<struct pollfd> fds (running.size ());
+      for (uint32_t i = 0; i < running.size (); i++)
+        {
+          fds[i].fd = running[i].fd;
+          fds[i].events = POLLIN;
+          fds[i].revents = 0;
+        }
+      if (poll (&fds[0], fds.size (), -1) < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+          NS_FATAL_ERROR ("poll failed: " << std::strerror (errno));
+        }
+      for (uint32_t i = running.size (); i-- > 0; )
+        {
+          if (fds[i].revents == 0)
+            {
+              continue;
+            }
+          char buffer[4096];
+          ssize_t n = read (running[i].fd, buffer, sizeof (buffer));
+          if (n > 0)
+            {
+              running[i].output.append (buffer, n);
+              continue;
+            }
+          if (n < 0 && errno == EINTR)
+            {
+              continue;
+            }
+          Finish (running[i]);
+          running.erase (running.begin () + i);
+        }
+    }
+}
+
+SweepRunner::Child
+SweepRunner::Start (uint32_t variant)
+{
+  NS_LOG_FUNCTION (this << variant);
+  int fds[2];
+  if (pipe (fds) != 0)
+    {
+      NS_FATAL_ERROR ("pipe failed: " << std::strerror (errno));
+    }
+  pid_t pid = fork ();
+  if (pid < 0)
+    {
+      NS_FATAL_ERROR ("fork failed: " << std::strerror (errno));
+    }
+  if (pid == 0)
+    {
+      close (fds[0]);
+      RunChild (variant, fds[1]);
+    }
+  close (fds[1]);
+  Child child;
+  child.pid = pid;
+  child.fd = fds[0];
+  child.variant = variant;
+  return child;
+}
+
+void
+SweepRunner::RunChild (uint32_t variant, int fd)
+{
+  const Variant &v = m_variants[variant];
+  RngSeedManager::SetRun (v.run);
+  RandomVariableStream::ResetAllStreams ();
+  for (uint32_t i = 0; i < v.configs.size (); i++)
+    {
+      Config::Set (v.configs[i].first, *v.configs[i].second);
+    }
+  if (m_stop > Simulator::Now ())
+    {
+      Simulator::Stop (m_stop - Simulator::Now ());
+    }
+  Simulator::Run ();
+  std::string result;
+  if (!m_result.IsNull ())
+    {
+      result = m_result ();
+    }
+  const char *data = result.data ();
+  size_t left = result.size ();
+  while (left > 0)
+    {
+      ssize_t n = write (fd, data, left);
+      if (n < 0 && errno == EINTR)
+        {
+          continue;
+        }
+      if (n <= 0)
+        {
+          _exit (1);
+        }
+      data += n;
+      left -= n;
+    }
+  close (fd);
+  Simulator::Destroy ();
+  std::cout.flush ();
+  std::cerr.flush ();
+  std::clog.flush ();
+  std::fflush (0);
+  // do not run the static destructors of the parent.
+  _exit (0);
+}
+
+void
+SweepRunner::Finish (Child &child)
+{
+  NS_LOG_FUNCTION (this << child.pid);
+  close (child.fd);
+  int status;
+  while (waitpid (child.pid, &status, 0) < 0)
+    {
+      if (errno != EINTR)
+        {
+          NS_FATAL_ERROR ("waitpid failed: " << std::strerror (errno));
+        }
+    }
+  Variant &v = m_variants[child.variant];
+  v.success = WIFEXITED (status) && WEXITSTATUS (status) == 0;
+  v.result = v.success ? child.output : "";
+  if (!v.success)
+    {
+      NS_LOG_WARN ("Variant " << child.variant << " failed");
+    }
+}
+
+} // namespace ns3
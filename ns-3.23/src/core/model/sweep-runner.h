@@ -0,0 +1,178 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SWEEP_RUNNER_H
+#define SWEEP_RUNNER_H
+
+#include "nstime.h"
+#include "callback.h"
+#include "attribute.h"
+#include "ptr.h"
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup core
+ * Declaration of class ns3::SweepRunner.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup core
+ * \brief Run several variants of a simulation after a shared warm-up.
+ *
+ * The simulation built by the program is first run up to the warm-up
+ * time in the current process. The process then forks one child per
+ * variant: the children share the memory of the warm-up copy-on-write
+ * and each of them
+ *  - sets the RngRun of the variant and restarts all the existing
+ *    random variables from it (see RandomVariableStream::ResetAllStreams),
+ *  - applies the Config::Set values of the variant,
+ *  - runs the simulation up to the stop time,
+ *  - calls the result callback, whose string is sent to the parent
+ *    through a pipe,
+ *  - destroys the simulation and exits.
+ *
+ * At most SetMaxProcesses children run at the same time. Run returns
+ * in the parent when all of them are done, with the simulation still
+ * at the end of the warm-up.
+ *
+ * \code
+ *   SweepRunner sweep;
+ *   sweep.SetWarmup (Seconds (600));
+ *   sweep.SetStopTime (Seconds (1200));
+ *   sweep.SetResultCallback (MakeCallback (&CollectStatistics));
+ *   for (uint32_t i = 0; i < 10; i++)
+ *     {
+ *       uint32_t v = sweep.AddVariant (i + 1);
+ *       sweep.AddConfig (v, "/NodeList/0/ApplicationList/0/DataRate", DataRateValue (rates[i]));
+ *     }
+ *   sweep.Run ();
+ *   for (uint32_t i = 0; i < sweep.GetVariantN (); i++)
+ *     {
+ *       std::cout << sweep.GetResult (i) << std::endl;
+ *     }
+ * \endcode
+ *
+ * This is only available on POSIX systems.
+ */
+class SweepRunner
+{
+public:
+  SweepRunner ();
+
+  /**
+   * \param [in] warmup The time at which the simulation is forked.
+   */
+  void SetWarmup (Time warmup);
+  /**
+   * \param [in] stop The time at which the variants stop; zero, the
+   *   default, runs them until there are no more events.
+   */
+  void SetStopTime (Time stop);
+  /**
+   * \param [in] n The largest number of children running at the same
+   *   time, by default the number of online processors.
+   */
+  void SetMaxProcesses (uint32_t n);
+  /**
+   * \param [in] cb Called in each child at the end of its run; the
+   *   string it returns is the result of the variant.
+   */
+  void SetResultCallback (Callback<std::string> cb);
+
+  /**
+   * Add a variant.
+   * \param [in] run The RngRun of the variant.
+   * \returns The index of the variant.
+   */
+  uint32_t AddVariant (uint64_t run);
+  /**
+   * Add an attribute value to set with Config::Set in a variant.
+   * \param [in] variant The index of the variant.
+   * \param [in] path The Config path of the attribute.
+   * \param [in] value The value.
+   */
+  void AddConfig (uint32_t variant, std::string path, const AttributeValue &value);
+
+  /** Run the warm-up, then all the variants. */
+  void Run (void);
+
+  /** \returns The number of variants. */
+  uint32_t GetVariantN (void) const;
+  /**
+   * \param [in] variant The index of a variant.
+   * \returns true if the child which ran this variant exited normally.
+   */
+  bool IsSuccess (uint32_t variant) const;
+  /**
+   * \param [in] variant The index of a variant.
+   * \returns The result of the variant, empty if it failed.
+   */
+  std::string GetResult (uint32_t variant) const;
+
+private:
+  /** A variant of the simulation. */
+  struct Variant
+  {
+    uint64_t run;       /**< The RngRun. */
+    /** The values to set. */
+    std::vector<std::pair<std::string, Ptr<AttributeValue> > > configs;
+    bool success;       /**< Did it complete. */
+    std::string result; /**< Its result. */
+  };
+  /** A child process. */
+  struct Child
+  {
+    int pid;              /**< The process id. */
+    int fd;               /**< The read end of its pipe. */
+    uint32_t variant;     /**< The index of its variant. */
+    std::string output;   /**< What it has written so far. */
+  };
+
+  /**
+   * Fork a child running a variant.
+   * \param [in] variant The index of the variant.
+   * \returns The child.
+   */
+  Child Start (uint32_t variant);
+  /**
+   * Run a variant in the child process. Does not return.
+   * \param [in] variant The index of the variant.
+   * \param [in] fd The write end of the pipe.
+   */
+  void RunChild (uint32_t variant, int fd);
+  /**
+   * Wait for a child to complete and record its result.
+   * \param [in] child The child.
+   */
+  void Finish (Child &child);
+
+  Time m_warmup;                  //!< When to fork.
+  Time m_stop;                    //!< When the variants stop.
+  uint32_t m_maxProcesses;        //!< Children running at the same time.
+  Callback<std::string> m_result; //!< Produces the result of a variant.
+  std::vector<Variant> m_variants; //!< The variants.
+};
+
+} // namespace ns3
+
+#endif /* SWEEP_RUNNER_H */
@@ -21,7 +21,7 @@
 #ifndef TRACED_CALLBACK_H
 #define TRACED_CALLBACK_H
 
-#include <list>
+#include <vector>
 #include "callback.h"
 
 /**
@@ -46,6 +46,14 @@ namespace ns3 {
  * calling one of the \c operator() forms with the appropriate
  * number of arguments.
  *
+ * The chain is stored in a flat array which is empty, and holds no
+ * memory, until a Callback is connected.  Invoking a TracedCallback
+ * with no Callback connected only tests that the array is empty,
+ * inline.  Code which computes the arguments of a trace can call
+ * IsEmpty first to skip this work when nothing is connected.
+ * A Callback connected with a context gets the context bound when
+ * it is connected, not each time it is invoked.
+ *
  * \tparam T1 Type of the first argument to the functor.
  * \tparam T2 Type of the second argument to the functor.
  * \tparam T3 Type of the third argument to the functor.
@@ -93,6 +101,10 @@ public:
    * \param path Context path which was used to connect the Callback.
    */
   void Disconnect (const CallbackBase & callback, std::string path);
+  /**
+   * \return True if no Callback is connected.
+   */
+  bool IsEmpty (void) const;
   /**
    * \name Functors taking various numbers of arguments.
    *
@@ -234,11 +246,72 @@ private:
    * \tparam T7 Type of the seventh argument to the functor.
    * \tparam T8 Type of the eighth argument to the functor.
    */
-  typedef std::list<Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> > CallbackList;
+  typedef std::vector<Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> > CallbackList;
   /** The chain of Callbacks. */
   CallbackList m_callbackList;
 };
 
+/**
+ * \ingroup tracing
+ * \brief A TracedCallback which is compiled out.
+ *
+ * NullTracedCallback has the API of TracedCallback, but connecting to
+ * it does nothing and invoking it compiles to nothing.  A model can
+ * declare a high-frequency trace source with this type under a
+ * preprocessor flag of its own, so that simulations built with the
+ * flag pay nothing for it:
+ * \code
+ *   #ifdef NS3_MY_PHY_DISABLE_RX_DROP_TRACE
+ *     NullTracedCallback<Ptr<const Packet> > m_phyRxDropTrace;
+ *   #else
+ *     TracedCallback<Ptr<const Packet> > m_phyRxDropTrace;
+ *   #endif
+ * \endcode
+ * The trace source stays registered in the TypeId, so Config::Connect
+ * and the helpers still succeed, but their Callbacks are never invoked.
+ *
+ * \tparam T1 Type of the first argument to the functor.
+ * \tparam T2 Type of the second argument to the functor.
+ * \tparam T3 Type of the third argument to the functor.
+ * \tparam T4 Type of the fourth argument to the functor.
+ * \tparam T5 Type of the fifth argument to the functor.
+ * \tparam T6 Type of the sixth argument to the functor.
+ * \tparam T7 Type of the seventh argument to the functor.
+ * \tparam T8 Type of the eighth argument to the functor.
+ */
+template<typename T1 = empty, typename T2 = empty, 
+         typename T3 = empty, typename T4 = empty,
+         typename T5 = empty, typename T6 = empty,
+         typename T7 = empty, typename T8 = empty>
+class NullTracedCallback 
+{
+public:
+  /** \copydoc TracedCallback::ConnectWithoutContext */
+  void ConnectWithoutContext (const CallbackBase & callback) {}
+  /** \copydoc TracedCallback::Connect */
+  void Connect (const CallbackBase & callback, std::string path) {}
+  /** \copydoc TracedCallback::DisconnectWithoutContext */
+  void DisconnectWithoutContext (const CallbackBase & callback) {}
+  /** \copydoc TracedCallback::Disconnect */
+  void Disconnect (const CallbackBase & callback, std::string path) {}
+  /** \return True: no Callback is ever connected. */
+  bool IsEmpty (void) const { return true; }
+  /**
+   * \name Functors taking various numbers of arguments, which do nothing.
+   */
+  /**@{*/
+  void operator() (void) const {}
+  void operator() (T1 a1) const {}
+  void operator() (T1 a1, T2 a2) const {}
+  void operator() (T1 a1, T2 a2, T3 a3) const {}
+  void operator() (T1 a1, T2 a2, T3 a3, T4 a4) const {}
+  void operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5) const {}
+  void operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6) const {}
+  void operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7) const {}
+  void operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8) const {}
+  /**@}*/
+};
+
 } // namespace ns3
 
 
@@ -315,117 +388,126 @@ template<typename T1, typename T2,
          typename T3, typename T4,
          typename T5, typename T6,
          typename T7, typename T8>
-void 
+inline bool
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::IsEmpty (void) const
+{
+  return m_callbackList.empty ();
+}
+template<typename T1, typename T2, 
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+inline void
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (void) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // Index rather than iterate: a Callback may connect another one.
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)();
+      m_callbackList[i] ();
     }
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
          typename T5, typename T6,
          typename T7, typename T8>
-void 
+inline void
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // Index rather than iterate: a Callback may connect another one.
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1);
+      m_callbackList[i] (a1);
     }
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
          typename T5, typename T6,
          typename T7, typename T8>
-void 
+inline void
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // Index rather than iterate: a Callback may connect another one.
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2);
+      m_callbackList[i] (a1, a2);
     }
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
          typename T5, typename T6,
          typename T7, typename T8>
-void 
+inline void
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // Index rather than iterate: a Callback may connect another one.
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3);
+      m_callbackList[i] (a1, a2, a3);
     }
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
          typename T5, typename T6,
          typename T7, typename T8>
-void 
+inline void
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // Index rather than iterate: a Callback may connect another one.
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4);
+      m_callbackList[i] (a1, a2, a3, a4);
     }
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
          typename T5, typename T6,
          typename T7, typename T8>
-void 
+inline void
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // Index rather than iterate: a Callback may connect another one.
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5);
+      m_callbackList[i] (a1, a2, a3, a4, a5);
     }
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
          typename T5, typename T6,
          typename T7, typename T8>
-void 
+inline void
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // Index rather than iterate: a Callback may connect another one.
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5, a6);
+      m_callbackList[i] (a1, a2, a3, a4, a5, a6);
     }
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
          typename T5, typename T6,
          typename T7, typename T8>
-void 
+inline void
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // Index rather than iterate: a Callback may connect another one.
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5, a6, a7);
+      m_callbackList[i] (a1, a2, a3, a4, a5, a6, a7);
     }
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
          typename T5, typename T6,
          typename T7, typename T8>
-void 
+inline void
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  // Index rather than iterate: a Callback may connect another one.
+  for (typename CallbackList::size_type i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5, a6, a7, a8);
+      m_callbackList[i] (a1, a2, a3, a4, a5, a6, a7, a8);
     }
 }
 
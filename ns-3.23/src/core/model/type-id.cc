@@ -23,6 +23,7 @@
 #include "singleton.h"
 #include "trace-source-accessor.h"
 
+#include <algorithm>
 #include <map>
 #include <vector>
 #include <sstream>
@@ -46,12 +47,125 @@ NS_LOG_COMPONENT_DEFINE ("TypeId");
 // IidManager needs to be in ns3 namespace for NS_ASSERT and NS_LOG
 // to find g_log
 
+/**
+ * \brief An open addressing hash table from the names of the attributes
+ * or trace sources of a TypeId and of its parents to their positions.
+ */
+class NameIndex
+{
+public:
+  /** The position of an attribute or trace source. */
+  struct Entry
+  {
+    std::string name; //!< The name.
+    uint32_t hash;    //!< The hash of the name.
+    uint16_t uid;     //!< The TypeId which defines it.
+    uint32_t index;   //!< The index in the TypeId.
+  };
+
+  /**
+   * Index a set of entries, ignoring those whose name is already indexed.
+   * \param entries the entries, first those of a TypeId, then those of
+   *        its parents.
+   */
+  void Build (const std::vector<Entry> &entries);
+  /**
+   * \param name a name.
+   * \returns the entry of this name, or zero.
+   */
+  const Entry *Find (const std::string &name) const;
+  /**
+   * \param name a name.
+   * \returns the hash of the name.
+   */
+  static uint32_t Hash (const std::string &name);
+
+private:
+  std::vector<Entry> m_entries;    //!< The indexed entries.
+  std::vector<uint32_t> m_buckets; //!< The entry indexes plus one, zero when empty.
+};
+
+uint32_t
+NameIndex::Hash (const std::string &name)
+{
+  // FNV-1a: cheap for short names, and reentrant.
+  uint32_t hash = 2166136261U;
+  for (std::string::const_iterator i = name.begin (); i != name.end (); ++i)
+    {
+      hash ^= static_cast<uint8_t> (*i);
+      hash *= 16777619U;
+    }
+  return hash;
+}
+
+void
+NameIndex::Build (const std::vector<Entry> &entries)
+{
+  m_entries.clear ();
+  m_buckets.clear ();
+  uint32_t size = 8;
+  while (size < 2 * entries.size ())
+    {
+      size *= 2;
+    }
+  m_buckets.resize (size, 0);
+  for (std::vector<Entry>::const_iterator i = entries.begin (); i != entries.end (); ++i)
+    {
+      uint32_t bucket = i->hash & (size - 1);
+      bool found = false;
+      while (m_buckets[bucket] != 0)
+        {
+          if (m_entries[m_buckets[bucket] - 1].name == i->name)
+            {
+              // hidden by an entry of a child TypeId.
+              found = true;
+              break;
+            }
+          bucket = (bucket + 1) & (size - 1);
+        }
+      if (!found)
+        {
+          m_entries.push_back (*i);
+          m_buckets[bucket] = m_entries.size ();
+        }
+    }
+}
+
+const NameIndex::Entry *
+NameIndex::Find (const std::string &name) const
+{
+  if (m_buckets.empty ())
+    {
+      return 0;
+    }
+  uint32_t size = m_buckets.size ();
+  uint32_t hash = Hash (name);
+  for (uint32_t bucket = hash & (size - 1); m_buckets[bucket] != 0; bucket = (bucket + 1) & (size - 1))
+    {
+      const Entry *entry = &m_entries[m_buckets[bucket] - 1];
+      if (entry->hash == hash && entry->name == name)
+        {
+          return entry;
+        }
+    }
+  return 0;
+}
+
 /**
  * \brief TypeId information manager
  *
  * Information records are stored in a vector.  Name and hash lookup
  * are performed by maps to the vector index.
  *
+ * The attributes and trace sources of a TypeId and of its parents are
+ * indexed by name in hash tables, and the attributes set at construction
+ * are gathered in a ConstructionInformation. These are rebuilt, for the
+ * TypeId and its subclasses, as soon as a TypeId gets a new parent,
+ * attribute, trace source or attribute initial value, so that lookups
+ * only read them and may run concurrently once the TypeIds are
+ * registered. The ConstructionInformation of a TypeId is refilled in
+ * place, so pointers to it remain valid.
+ *
  * \internal
  * <b>Hash Chaining</b>
  *
@@ -78,6 +192,7 @@ class IidManager
 {
 public:
   IidManager ();
+  ~IidManager ();
   uint16_t AllocateUid (std::string name);
   void SetParent (uint16_t uid, uint16_t parent);
   void SetGroupName (uint16_t uid, std::string groupName);
@@ -115,6 +230,9 @@ public:
   uint32_t GetTraceSourceN (uint16_t uid) const;
   struct TypeId::TraceSourceInformation GetTraceSource(uint16_t uid, uint32_t i) const;
   bool MustHideFromDocumentation (uint16_t uid) const;
+  const struct TypeId::AttributeInformation *LookupAttribute (uint16_t uid, const std::string &name) const;
+  Ptr<const TraceSourceAccessor> LookupTraceSource (uint16_t uid, const std::string &name) const;
+  const TypeId::ConstructionInformation *GetConstructionInformation (uint16_t uid) const;
 
 private:
   bool HasTraceSource (uint16_t uid, std::string name);
@@ -132,10 +250,16 @@ private:
     bool mustHideFromDocumentation;
     std::vector<struct TypeId::AttributeInformation> attributes;
     std::vector<struct TypeId::TraceSourceInformation> traceSources;
+    std::vector<uint16_t> children; // the TypeIds whose parent is this one
+    NameIndex attributeIndex;    // attributes, including inherited ones
+    NameIndex traceSourceIndex;  // trace sources, including inherited ones
+    TypeId::ConstructionInformation *construction; // owned by the IidManager
   };
   typedef std::vector<struct IidInformation>::const_iterator Iterator;
 
   struct IidManager::IidInformation *LookupInformation (uint16_t uid) const;
+  // rebuild the tables of a TypeId and of its subclasses.
+  void UpdateTables (uint16_t uid);
 
   std::vector<struct IidInformation> m_information;
 
@@ -156,6 +280,17 @@ IidManager::IidManager ()
   NS_LOG_FUNCTION (this);
 }
 
+IidManager::~IidManager ()
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<struct IidInformation>::iterator i = m_information.begin ();
+       i != m_information.end (); ++i)
+    {
+      delete i->construction;
+      i->construction = 0;
+    }
+}
+
   //static
 TypeId::hash_t
 IidManager::Hasher (const std::string name)
@@ -225,6 +360,7 @@ IidManager::AllocateUid (std::string name)
   information.size = (std::size_t)(-1);
   information.hasConstructor = false;
   information.mustHideFromDocumentation = false;
+  information.construction = new TypeId::ConstructionInformation ();
   m_information.push_back (information);
   uint32_t uid = m_information.size ();
   NS_ASSERT (uid <= 0xffff);
@@ -249,7 +385,17 @@ IidManager::SetParent (uint16_t uid, uint16_t parent)
   NS_LOG_FUNCTION (this << uid << parent);
   NS_ASSERT (parent <= m_information.size ());
   struct IidInformation *information = LookupInformation (uid);
+  if (information->parent != 0 && information->parent != uid)
+    {
+      std::vector<uint16_t> &siblings = LookupInformation (information->parent)->children;
+      siblings.erase (std::find (siblings.begin (), siblings.end (), uid));
+    }
   information->parent = parent;
+  if (parent != 0 && parent != uid)
+    {
+      LookupInformation (parent)->children.push_back (uid);
+    }
+  UpdateTables (uid);
 }
 void 
 IidManager::SetGroupName (uint16_t uid, std::string groupName)
@@ -435,6 +581,7 @@ IidManager::AddAttribute (uint16_t uid,
   info.accessor = accessor;
   info.checker = checker;
   information->attributes.push_back (info);
+  UpdateTables (uid);
 }
 void 
 IidManager::SetAttributeInitialValue(uint16_t uid,
@@ -445,6 +592,7 @@ IidManager::SetAttributeInitialValue(uint16_t uid,
   struct IidInformation *information = LookupInformation (uid);
   NS_ASSERT (i < information->attributes.size ());
   information->attributes[i].initialValue = initialValue;
+  UpdateTables (uid);
 }
 
 
@@ -513,6 +661,7 @@ IidManager::AddTraceSource (uint16_t uid,
   source.accessor = accessor;
   source.callback = callback;
   information->traceSources.push_back (source);
+  UpdateTables (uid);
 }
 uint32_t 
 IidManager::GetTraceSourceN (uint16_t uid) const
@@ -537,6 +686,93 @@ IidManager::MustHideFromDocumentation (uint16_t uid) const
   return information->mustHideFromDocumentation;
 }
 
+void
+IidManager::UpdateTables (uint16_t uid)
+{
+  NS_LOG_FUNCTION (this << uid);
+  struct IidInformation *information = LookupInformation (uid);
+  std::vector<NameIndex::Entry> attributes;
+  std::vector<NameIndex::Entry> traceSources;
+  TypeId::ConstructionInformation *construction = information->construction;
+  construction->attributes.clear ();
+  construction->tidNames.clear ();
+  construction->initialValueChecked.clear ();
+  uint16_t current = uid;
+  while (true)
+    {
+      struct IidInformation *info = LookupInformation (current);
+      for (uint32_t i = 0; i < info->attributes.size (); i++)
+        {
+          const struct TypeId::AttributeInformation &attribute = info->attributes[i];
+          NameIndex::Entry entry;
+          entry.name = attribute.name;
+          entry.hash = NameIndex::Hash (attribute.name);
+          entry.uid = current;
+          entry.index = i;
+          attributes.push_back (entry);
+          construction->attributes.push_back (attribute);
+          construction->tidNames.push_back (info->name);
+          construction->initialValueChecked.push_back (attribute.initialValue != 0 &&
+                                                       attribute.checker->Check (*attribute.initialValue));
+        }
+      for (uint32_t i = 0; i < info->traceSources.size (); i++)
+        {
+          NameIndex::Entry entry;
+          entry.name = info->traceSources[i].name;
+          entry.hash = NameIndex::Hash (entry.name);
+          entry.uid = current;
+          entry.index = i;
+          traceSources.push_back (entry);
+        }
+      if (info->parent == current || info->parent == 0)
+        {
+          // top of inheritance tree
+          break;
+        }
+      current = info->parent;
+    }
+  information->attributeIndex.Build (attributes);
+  information->traceSourceIndex.Build (traceSources);
+  // copy the list: the subclasses do not change it, but a reference
+  // into m_information would not survive a registration.
+  std::vector<uint16_t> children = information->children;
+  for (std::vector<uint16_t>::const_iterator i = children.begin (); i != children.end (); ++i)
+    {
+      UpdateTables (*i);
+    }
+}
+
+const struct TypeId::AttributeInformation *
+IidManager::LookupAttribute (uint16_t uid, const std::string &name) const
+{
+  NS_LOG_FUNCTION (this << uid << name);
+  const NameIndex::Entry *entry = LookupInformation (uid)->attributeIndex.Find (name);
+  if (entry == 0)
+    {
+      return 0;
+    }
+  return &LookupInformation (entry->uid)->attributes[entry->index];
+}
+
+Ptr<const TraceSourceAccessor>
+IidManager::LookupTraceSource (uint16_t uid, const std::string &name) const
+{
+  NS_LOG_FUNCTION (this << uid << name);
+  const NameIndex::Entry *entry = LookupInformation (uid)->traceSourceIndex.Find (name);
+  if (entry == 0)
+    {
+      return 0;
+    }
+  return LookupInformation (entry->uid)->traceSources[entry->index].accessor;
+}
+
+const TypeId::ConstructionInformation *
+IidManager::GetConstructionInformation (uint16_t uid) const
+{
+  NS_LOG_FUNCTION (this << uid);
+  return LookupInformation (uid)->construction;
+}
+
 } // namespace ns3
 
 namespace ns3 {
@@ -616,22 +852,14 @@ bool
 TypeId::LookupAttributeByName (std::string name, struct TypeId::AttributeInformation *info) const
 {
   NS_LOG_FUNCTION (this << name << info);
-  TypeId tid;
-  TypeId nextTid = *this;
-  do {
-      tid = nextTid;
-      for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
-        {
-          struct TypeId::AttributeInformation tmp = tid.GetAttribute(i);
-          if (tmp.name == name)
-            {
-              *info = tmp;
-              return true;
-            }
-        }
-      nextTid = tid.GetParent ();
-    } while (nextTid != tid);
-  return false;
+  const struct TypeId::AttributeInformation *attribute =
+    Singleton<IidManager>::Get ()->LookupAttribute (m_tid, name);
+  if (attribute == 0)
+    {
+      return false;
+    }
+  *info = *attribute;
+  return true;
 }
 
 TypeId 
@@ -842,21 +1070,14 @@ Ptr<const TraceSourceAccessor>
 TypeId::LookupTraceSourceByName (std::string name) const
 {
   NS_LOG_FUNCTION (this << name);
-  TypeId tid;
-  TypeId nextTid = *this;
-  do {
-      tid = nextTid;
-      for (uint32_t i = 0; i < tid.GetTraceSourceN (); i++)
-        {
-          struct TypeId::TraceSourceInformation info = tid.GetTraceSource (i);
-          if (info.name == name)
-            {
-              return info.accessor;
-            }
-        }
-      nextTid = tid.GetParent ();
-    } while (nextTid != tid);
-  return 0;
+  return Singleton<IidManager>::Get ()->LookupTraceSource (m_tid, name);
+}
+
+const TypeId::ConstructionInformation *
+TypeId::GetConstructionInformation (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return Singleton<IidManager>::Get ()->GetConstructionInformation (m_tid);
 }
 
 uint16_t 
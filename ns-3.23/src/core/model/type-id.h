@@ -28,6 +28,7 @@
 #include "deprecated.h"
 #include "hash.h"
 #include <string>
+#include <vector>
 #include <stdint.h>
 
 /**
@@ -81,6 +82,18 @@ public:
     std::string callback;
     Ptr<const TraceSourceAccessor> accessor;
   };
+  /**
+   * The attributes which ObjectBase::ConstructSelf sets on the objects
+   * of a TypeId: the attributes of the TypeId, then those of its
+   * parents. It is kept up to date as the TypeIds are registered and
+   * their initial values change, and its address never changes.
+   */
+  struct ConstructionInformation
+  {
+    std::vector<struct AttributeInformation> attributes; //!< The attributes.
+    std::vector<std::string> tidNames;                   //!< The name of the TypeId which defines each attribute.
+    std::vector<bool> initialValueChecked;               //!< Whether the checker of each attribute accepts its initial value as is.
+  };
 
   /**
    * Type of hash values
@@ -369,6 +382,13 @@ public:
    * If no matching trace source is found, this method returns zero.
    */
   Ptr<const TraceSourceAccessor> LookupTraceSourceByName (std::string name) const;
+  /**
+   * \returns the attributes to set on the objects of this TypeId when
+   *          they are constructed.
+   *
+   * This is an internal method used by ObjectBase::ConstructSelf.
+   */
+  const ConstructionInformation *GetConstructionInformation (void) const;
 
   /**
    * \returns the internal integer which uniquely identifies this
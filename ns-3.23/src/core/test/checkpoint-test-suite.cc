@@ -0,0 +1,276 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/checkpoint.h"
+#include "ns3/simulator.h"
+#include "ns3/object.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
+#include "ns3/nstime.h"
+#include "ns3/config.h"
+#include "ns3/random-variable-stream.h"
+
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * An object which draws random numbers at a rate given by an
+ * attribute, and counts them.
+ */
+class CheckpointTestObject : public Object, public Checkpointable
+{
+public:
+  static TypeId GetTypeId (void) {
+    static TypeId tid = TypeId ("ns3::CheckpointTestObject")
+      .AddConstructor<CheckpointTestObject> ()
+      .SetParent<Object> ()
+      .HideFromDocumentation ()
+      .AddAttribute ("Interval", "Time between two draws.",
+                     TimeValue (MilliSeconds (100)),
+                     MakeTimeAccessor (&CheckpointTestObject::m_interval),
+                     MakeTimeChecker ())
+      .AddAttribute ("Random", "The random variable.",
+                     StringValue ("ns3::NormalRandomVariable"),
+                     MakePointerAccessor (&CheckpointTestObject::m_random),
+                     MakePointerChecker<RandomVariableStream> ())
+    ;
+    return tid;
+  }
+  CheckpointTestObject ()
+    : m_count (0)
+  {
+  }
+  void Start (void)
+  {
+    m_event = Simulator::Schedule (m_interval, &CheckpointTestObject::Draw, this);
+  }
+  virtual void SaveCheckpoint (CheckpointWriter &writer) const
+  {
+    writer.WriteU32 (m_count);
+    writer.WriteEvent (m_event);
+  }
+  virtual void RestoreCheckpoint (CheckpointReader &reader)
+  {
+    m_count = reader.ReadU32 ();
+    Time delay;
+    if (reader.ReadEvent (delay))
+      {
+        m_event = Simulator::Schedule (delay, &CheckpointTestObject::Draw, this);
+      }
+  }
+  void Draw (void)
+  {
+    m_count++;
+    m_log.push_back (std::make_pair (Simulator::Now ().GetTimeStep (), m_random->GetValue ()));
+    m_event = Simulator::Schedule (m_interval, &CheckpointTestObject::Draw, this);
+  }
+
+  std::vector<std::pair<int64_t, double> > m_log;
+  uint32_t m_count;
+  Ptr<RandomVariableStream> m_random;
+private:
+  Time m_interval;
+  EventId m_event;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (CheckpointTestObject);
+
+/**
+ * The root of the objects of the test, registered as a root
+ * namespace object.
+ */
+class CheckpointTestRoot : public Object
+{
+public:
+  static TypeId GetTypeId (void) {
+    static TypeId tid = TypeId ("ns3::CheckpointTestRoot")
+      .AddConstructor<CheckpointTestRoot> ()
+      .SetParent<Object> ()
+      .HideFromDocumentation ()
+      .AddAttribute ("Child", "The object which draws numbers.",
+                     PointerValue (),
+                     MakePointerAccessor (&CheckpointTestRoot::m_child),
+                     MakePointerChecker<CheckpointTestObject> ())
+    ;
+    return tid;
+  }
+  Ptr<CheckpointTestObject> m_child;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (CheckpointTestRoot);
+
+/**
+ * A run resumed from a checkpoint must continue exactly as the run
+ * which saved it.
+ */
+class CheckpointResumeTestCase : public TestCase
+{
+public:
+  CheckpointResumeTestCase ();
+private:
+  virtual void DoRun (void);
+  /** Build the objects and register them. */
+  Ptr<CheckpointTestRoot> Build (void);
+  /** Change the interval of the child. */
+  static void SetInterval (Ptr<CheckpointTestRoot> root, Time interval);
+  /**
+   * Save a checkpoint, then stop the simulation, so that no event
+   * which belongs to no object is pending at the checkpoint.
+   */
+  static void SaveAndStop (std::string filename, Time delay);
+};
+
+CheckpointResumeTestCase::CheckpointResumeTestCase ()
+  : TestCase ("Check that a restored simulation resumes where it was saved")
+{
+}
+
+Ptr<CheckpointTestRoot>
+CheckpointResumeTestCase::Build (void)
+{
+  Ptr<CheckpointTestRoot> root = CreateObject<CheckpointTestRoot> ();
+  root->m_child = CreateObject<CheckpointTestObject> ();
+  Config::RegisterRootNamespaceObject (root);
+  root->m_child->Start ();
+  return root;
+}
+
+void
+CheckpointResumeTestCase::SetInterval (Ptr<CheckpointTestRoot> root, Time interval)
+{
+  root->m_child->SetAttribute ("Interval", TimeValue (interval));
+}
+
+void
+CheckpointResumeTestCase::SaveAndStop (std::string filename, Time delay)
+{
+  Checkpoint::Save (filename);
+  Simulator::Stop (delay);
+}
+
+void
+CheckpointResumeTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("simulation.ckpt");
+  std::string lossyFilename = CreateTempDirFilename ("lossy.ckpt");
+  Time lossy = Seconds (1);
+  Time save = MilliSeconds (5550);
+  Time stop = Seconds (10);
+
+  Ptr<CheckpointTestRoot> first = Build ();
+  // the attributes saved are the ones at the time of the checkpoint.
+  Simulator::Schedule (Seconds (2), &CheckpointResumeTestCase::SetInterval, first, MilliSeconds (70));
+  // the SetInterval and SaveAndStop events are pending at this
+  // checkpoint and belong to no object.
+  Simulator::Schedule (lossy, &Checkpoint::Save, lossyFilename);
+  Simulator::Schedule (save, &CheckpointResumeTestCase::SaveAndStop, filename, stop - save);
+  Simulator::Run ();
+  std::vector<std::pair<int64_t, double> > expected;
+  uint32_t countAtSave = 0;
+  for (uint32_t i = 0; i < first->m_child->m_log.size (); i++)
+    {
+      if (first->m_child->m_log[i].first > save.GetTimeStep ())
+        {
+          expected.push_back (first->m_child->m_log[i]);
+        }
+      else
+        {
+          countAtSave++;
+        }
+    }
+  Config::UnregisterRootNamespaceObject (first);
+  Simulator::Destroy ();
+
+  Ptr<CheckpointTestRoot> second = Build ();
+  // draws made before the restore must not matter.
+  second->m_child->m_random->GetValue ();
+  NS_TEST_ASSERT_MSG_EQ (Checkpoint::GetLostEvents (filename), 0, "complete checkpoint lost events");
+  NS_TEST_ASSERT_MSG_EQ (Checkpoint::Restore (filename), 0, "complete checkpoint lost events");
+  NS_TEST_ASSERT_MSG_EQ (Simulator::Now (), save, "clock not restored");
+  NS_TEST_ASSERT_MSG_EQ (second->m_child->m_count, countAtSave, "state not restored");
+  Simulator::Stop (stop - save);
+  Simulator::Run ();
+  std::vector<std::pair<int64_t, double> > &log = second->m_child->m_log;
+  NS_TEST_ASSERT_MSG_EQ (log.size (), expected.size (), "wrong number of draws after restore");
+  for (uint32_t i = 0; i < log.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (log[i].first, expected[i].first, "wrong time of draw " << i);
+      NS_TEST_ASSERT_MSG_EQ (log[i].second, expected[i].second, "wrong value of draw " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (second->m_child->m_count, countAtSave + expected.size (), "wrong count");
+  Config::UnregisterRootNamespaceObject (second);
+  Simulator::Destroy ();
+
+  // a checkpoint which lost events is only restored when asked to.
+  NS_TEST_ASSERT_MSG_EQ (Checkpoint::GetLostEvents (lossyFilename), 2, "wrong number of lost events");
+  Ptr<CheckpointTestRoot> third = Build ();
+  NS_TEST_ASSERT_MSG_EQ (Checkpoint::Restore (lossyFilename, true), 2, "wrong number of lost events");
+  NS_TEST_ASSERT_MSG_EQ (Simulator::Now (), lossy, "clock not restored");
+  Config::UnregisterRootNamespaceObject (third);
+  Simulator::Destroy ();
+}
+
+/**
+ * The archive classes read back what they wrote.
+ */
+class CheckpointArchiveTestCase : public TestCase
+{
+public:
+  CheckpointArchiveTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+CheckpointArchiveTestCase::CheckpointArchiveTestCase ()
+  : TestCase ("Check the checkpoint writer and reader")
+{
+}
+
+void
+CheckpointArchiveTestCase::DoRun (void)
+{
+  CheckpointWriter writer;
+  writer.WriteU8 (0xab);
+  writer.WriteU32 (0xdeadbeef);
+  writer.WriteU64 (0x0123456789abcdefULL);
+  writer.WriteDouble (-1.5);
+  writer.WriteString ("ns-3");
+  writer.WriteString ("");
+  writer.WriteTime (MicroSeconds (42));
+  CheckpointReader reader (&writer.GetData ()[0], writer.GetData ().size ());
+  NS_TEST_ASSERT_MSG_EQ (reader.ReadU8 (), 0xab, "wrong u8");
+  NS_TEST_ASSERT_MSG_EQ (reader.ReadU32 (), 0xdeadbeef, "wrong u32");
+  NS_TEST_ASSERT_MSG_EQ (reader.ReadU64 (), 0x0123456789abcdefULL, "wrong u64");
+  NS_TEST_ASSERT_MSG_EQ (reader.ReadDouble (), -1.5, "wrong double");
+  NS_TEST_ASSERT_MSG_EQ (reader.ReadString (), "ns-3", "wrong string");
+  NS_TEST_ASSERT_MSG_EQ (reader.ReadString (), "", "wrong empty string");
+  NS_TEST_ASSERT_MSG_EQ (reader.ReadTime (), MicroSeconds (42), "wrong time");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetRemaining (), 0, "data left");
+}
+
+static class CheckpointTestSuite : public TestSuite
+{
+public:
+  CheckpointTestSuite ()
+    : TestSuite ("checkpoint")
+  {
+    AddTestCase (new CheckpointArchiveTestCase, TestCase::QUICK);
+    AddTestCase (new CheckpointResumeTestCase, TestCase::QUICK);
+  }
+} g_checkpointTestSuite;
@@ -721,6 +721,134 @@ SearchAttributesOfParentObjectsTestCase::DoRun (void)
 
 }
 
+// ===========================================================================
+// An object with a container declared to Config, whose matches are cached.
+// ===========================================================================
+class CachedConfigTestObject : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  void AddChild (Ptr<ConfigTestObject> child);
+
+private:
+  std::vector<Ptr<ConfigTestObject> > m_children;
+};
+
+TypeId
+CachedConfigTestObject::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("CachedConfigTestObject")
+    .SetParent<Object> ()
+    .AddAttribute ("Children", "",
+                   ObjectVectorValue (),
+                   MakeObjectVectorAccessor (&CachedConfigTestObject::m_children),
+                   MakeObjectVectorChecker<ConfigTestObject> ())
+    ;
+  return tid;
+}
+
+void
+CachedConfigTestObject::AddChild (Ptr<ConfigTestObject> child)
+{
+  m_children.push_back (child);
+  Config::InvalidateCache ();
+}
+
+// ===========================================================================
+// Test that the objects matched through declared containers are cached
+// until the cache is invalidated, and that the index matchers still work
+// on cached paths.
+// ===========================================================================
+class CachedPathConfigTestCase : public TestCase
+{
+public:
+  CachedPathConfigTestCase ();
+  virtual ~CachedPathConfigTestCase () {}
+
+private:
+  virtual void DoRun (void);
+};
+
+CachedPathConfigTestCase::CachedPathConfigTestCase ()
+  : TestCase ("Check that cached paths follow the changes of containers, aggregates and pointers")
+{
+}
+
+void
+CachedPathConfigTestCase::DoRun (void)
+{
+  IntegerValue iv;
+  Config::RegisterCachedContainer (CachedConfigTestObject::GetTypeId (), "Children");
+  Ptr<CachedConfigTestObject> root = CreateObject<CachedConfigTestObject> ();
+  Config::RegisterRootNamespaceObject (root);
+
+  std::vector<Ptr<ConfigTestObject> > children;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      children.push_back (CreateObject<ConfigTestObject> ());
+      root->AddChild (children[i]);
+    }
+
+  Config::Set ("/Children/*/A", IntegerValue (1));
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      children[i]->GetAttribute ("A", iv);
+      NS_TEST_ASSERT_MSG_EQ (iv.Get (), 1, "Object Attribute \"A\" not set correctly");
+    }
+
+  //
+  // The index matchers give the same results on cached paths.
+  //
+  Config::MatchContainer matches = Config::LookupMatches ("/Children/[0-1]|2");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 3, "Unexpected number of matches for [0-1]|2");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetMatchedPath (2), "/Children/2/", "Unexpected matched path");
+  matches = Config::LookupMatches ("/Children/1");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 1, "Unexpected number of matches for 1");
+  NS_TEST_ASSERT_MSG_EQ (matches.Get (0), children[1], "Unexpected match for 1");
+  matches = Config::LookupMatches ("/Children/5");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 0, "Unexpected match for an index out of range");
+
+  //
+  // Adding a child invalidates the cache.
+  //
+  children.push_back (CreateObject<ConfigTestObject> ());
+  root->AddChild (children[3]);
+  matches = Config::LookupMatches ("/Children/*");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 4, "New child not matched");
+  matches = Config::LookupMatches ("/Children/[2-9]");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 2, "Unexpected number of matches for [2-9]");
+
+  //
+  // So does aggregating an object.
+  //
+  matches = Config::LookupMatches ("/Children/*/$DerivedConfigObject");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 0, "Unexpected aggregated object");
+  Ptr<DerivedConfigObject> derived = CreateObject<DerivedConfigObject> ();
+  children[2]->AggregateObject (derived);
+  Config::Set ("/Children/*/$DerivedConfigObject/X", IntegerValue (42));
+  derived->GetAttribute ("X", iv);
+  NS_TEST_ASSERT_MSG_EQ (iv.Get (), 42, "Aggregated object not matched");
+
+  //
+  // Pointers are not cached: changing one is seen at once.
+  //
+  Ptr<ConfigTestObject> a = CreateObject<ConfigTestObject> ();
+  Ptr<ConfigTestObject> b = CreateObject<ConfigTestObject> ();
+  children[0]->SetNodeA (a);
+  matches = Config::LookupMatches ("/Children/0/NodeA");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 1, "Unexpected number of matches for NodeA");
+  NS_TEST_ASSERT_MSG_EQ (matches.Get (0), a, "Unexpected match for NodeA");
+  children[0]->SetNodeA (b);
+  matches = Config::LookupMatches ("/Children/0/NodeA");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 1, "Unexpected number of matches for NodeA");
+  NS_TEST_ASSERT_MSG_EQ (matches.Get (0), b, "Pointer change not seen");
+
+  Config::UnregisterRootNamespaceObject (root);
+  matches = Config::LookupMatches ("/Children/*");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 0, "Unregistered root still matched");
+}
+
 // ===========================================================================
 // The Test Suite that glues all of the Test Cases together.
 // ===========================================================================
@@ -737,6 +865,7 @@ ConfigTestSuite::ConfigTestSuite ()
   AddTestCase (new UnderRootNamespaceConfigTestCase, TestCase::QUICK);
   AddTestCase (new ObjectVectorConfigTestCase, TestCase::QUICK);
   AddTestCase (new SearchAttributesOfParentObjectsTestCase, TestCase::QUICK);
+  AddTestCase (new CachedPathConfigTestCase, TestCase::QUICK);
 }
 
 static ConfigTestSuite configTestSuite;
@@ -0,0 +1,213 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/event-profiler.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/core-config.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Events of two methods, one much slower than the other, are run with
+ * every event timed: the counts must be exact and the slow method must
+ * come first.
+ */
+class EventProfilerExactTestCase : public TestCase
+{
+public:
+  EventProfilerExactTestCase ();
+  virtual ~EventProfilerExactTestCase ();
+private:
+  virtual void DoRun (void);
+  void Slow (void);
+  void Fast (uint32_t i);
+  /**
+   * \returns The entry of a profile whose name contains name, or an
+   *   entry without events.
+   */
+  EventProfiler::Entry Find (const std::vector<EventProfiler::Entry> &entries, std::string name);
+};
+
+EventProfilerExactTestCase::EventProfilerExactTestCase ()
+  : TestCase ("Check the profile of events timed one by one")
+{
+}
+
+EventProfilerExactTestCase::~EventProfilerExactTestCase ()
+{
+}
+
+void
+EventProfilerExactTestCase::Slow (void)
+{
+  volatile uint32_t sum = 0;
+  for (uint32_t i = 0; i < 100000; i++)
+    {
+      sum += i;
+    }
+}
+
+void
+EventProfilerExactTestCase::Fast (uint32_t i)
+{
+}
+
+EventProfiler::Entry
+EventProfilerExactTestCase::Find (const std::vector<EventProfiler::Entry> &entries, std::string name)
+{
+  for (std::vector<EventProfiler::Entry>::const_iterator i = entries.begin (); i != entries.end (); ++i)
+    {
+      if (i->name.find (name) != std::string::npos)
+        {
+          return *i;
+        }
+    }
+  EventProfiler::Entry none;
+  none.events = 0;
+  none.seconds = 0;
+  return none;
+}
+
+void
+EventProfilerExactTestCase::DoRun (void)
+{
+  Simulator::Destroy ();
+  std::string filename = CreateTempDirFilename ("profile.txt");
+  Ptr<DefaultSimulatorImpl> impl = CreateObject<DefaultSimulatorImpl> ();
+  impl->SetAttribute ("ProfileSampling", UintegerValue (1));
+  impl->SetAttribute ("ProfileFile", StringValue (filename));
+  Simulator::SetImplementation (impl);
+
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      Simulator::ScheduleWithContext (7, MicroSeconds (i), &EventProfilerExactTestCase::Slow, this);
+    }
+  for (uint32_t i = 0; i < 500; i++)
+    {
+      Simulator::Schedule (MicroSeconds (i), &EventProfilerExactTestCase::Fast, this, i);
+    }
+  Simulator::Run ();
+
+  const EventProfiler &profiler = impl->GetProfiler ();
+  NS_TEST_ASSERT_MSG_EQ (profiler.GetEventCount (), 520, "wrong number of events");
+  NS_TEST_ASSERT_MSG_EQ (profiler.GetSampleCount (), 520, "every event must be timed");
+
+  std::vector<EventProfiler::Entry> functions = profiler.GetEntries (EventProfiler::FUNCTION);
+  NS_TEST_ASSERT_MSG_EQ (functions.size (), 2, "wrong number of functions");
+  NS_TEST_ASSERT_MSG_EQ (functions[0].events, 20, "the slow method must come first");
+  NS_TEST_ASSERT_MSG_EQ (functions[1].events, 500, "wrong number of fast events");
+  NS_TEST_ASSERT_MSG_GT (functions[0].seconds, functions[1].seconds, "profile not sorted");
+#ifdef HAVE_DLADDR
+  NS_TEST_ASSERT_MSG_EQ (Find (functions, "EventProfilerExactTestCase::Slow").events, 20, "slow method not named");
+#endif
+
+  std::vector<EventProfiler::Entry> objects = profiler.GetEntries (EventProfiler::OBJECT);
+  NS_TEST_ASSERT_MSG_EQ (objects.size (), 1, "wrong number of object types");
+  NS_TEST_ASSERT_MSG_EQ (objects[0].name, "EventProfilerExactTestCase", "wrong object type");
+
+  std::vector<EventProfiler::Entry> contexts = profiler.GetEntries (EventProfiler::CONTEXT);
+  NS_TEST_ASSERT_MSG_EQ (contexts.size (), 2, "wrong number of contexts");
+  NS_TEST_ASSERT_MSG_EQ (Find (contexts, "7").events, 20, "wrong number of events in context 7");
+
+  Simulator::Destroy ();
+  std::ifstream is (filename.c_str ());
+  std::stringstream report;
+  report << is.rdbuf ();
+  NS_TEST_ASSERT_MSG_NE (report.str ().find ("By function:"), std::string::npos, "profile not written");
+  NS_TEST_ASSERT_MSG_NE (report.str ().find ("EventProfilerExactTestCase"), std::string::npos, "object type not reported");
+  Simulator::SetImplementation (CreateObject<DefaultSimulatorImpl> ());
+}
+
+/**
+ * With sampling, all events are counted but only some are timed, and
+ * the counts are estimated.
+ */
+class EventProfilerSamplingTestCase : public TestCase
+{
+public:
+  EventProfilerSamplingTestCase ();
+  virtual ~EventProfilerSamplingTestCase ();
+private:
+  virtual void DoRun (void);
+  void Event (void);
+};
+
+EventProfilerSamplingTestCase::EventProfilerSamplingTestCase ()
+  : TestCase ("Check the profile of sampled events")
+{
+}
+
+EventProfilerSamplingTestCase::~EventProfilerSamplingTestCase ()
+{
+}
+
+void
+EventProfilerSamplingTestCase::Event (void)
+{
+}
+
+void
+EventProfilerSamplingTestCase::DoRun (void)
+{
+  Simulator::Destroy ();
+  Ptr<DefaultSimulatorImpl> impl = CreateObject<DefaultSimulatorImpl> ();
+  impl->SetAttribute ("ProfileSampling", UintegerValue (16));
+  Simulator::SetImplementation (impl);
+
+  const uint32_t n = 16000;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      EventId id = Simulator::Schedule (NanoSeconds (i), &EventProfilerSamplingTestCase::Event, this);
+      if (i % 4 == 0)
+        {
+          id.Cancel ();
+        }
+    }
+  Simulator::Run ();
+
+  const EventProfiler &profiler = impl->GetProfiler ();
+  NS_TEST_ASSERT_MSG_EQ (profiler.GetEventCount (), n, "wrong number of events");
+  NS_TEST_ASSERT_MSG_EQ_TOL (profiler.GetSampleCount (), n / 16, n / 64, "wrong number of samples");
+  std::vector<EventProfiler::Entry> functions = profiler.GetEntries (EventProfiler::FUNCTION);
+  NS_TEST_ASSERT_MSG_EQ (functions.size (), 2, "cancelled events must be counted apart");
+  uint64_t total = functions[0].events + functions[1].events;
+  NS_TEST_ASSERT_MSG_EQ_TOL (total, n, 2, "wrong estimated number of events");
+
+  // the profile is written to the standard error: turn it off.
+  impl->SetAttribute ("ProfileSampling", UintegerValue (0));
+  Simulator::Destroy ();
+  Simulator::SetImplementation (CreateObject<DefaultSimulatorImpl> ());
+}
+
+static class EventProfilerTestSuite : public TestSuite
+{
+public:
+  EventProfilerTestSuite ()
+    : TestSuite ("event-profiler")
+  {
+    AddTestCase (new EventProfilerExactTestCase, TestCase::QUICK);
+    AddTestCase (new EventProfilerSamplingTestCase, TestCase::QUICK);
+  }
+} g_eventProfilerTestSuite;
@@ -0,0 +1,172 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/mpsc-queue.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/system-thread.h"
+
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+class MpscQueueSingleThreadTestCase : public TestCase
+{
+public:
+  MpscQueueSingleThreadTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+MpscQueueSingleThreadTestCase::MpscQueueSingleThreadTestCase ()
+  : TestCase ("Check FIFO order, full queue and wraparound of MpscQueue")
+{
+}
+
+void
+MpscQueueSingleThreadTestCase::DoRun (void)
+{
+  MpscQueue<uint32_t> queue (5);
+  NS_TEST_ASSERT_MSG_EQ (queue.GetCapacity (), 8, "capacity not rounded to a power of two");
+  NS_TEST_ASSERT_MSG_EQ (queue.IsEmpty (), true, "new queue not empty");
+
+  uint32_t item;
+  NS_TEST_ASSERT_MSG_EQ (queue.Pop (item), false, "pop from an empty queue");
+
+  uint32_t pushed = 0;
+  uint32_t popped = 0;
+  // go around the ring several times with varying fill levels
+  for (uint32_t round = 0; round < 20; round++)
+    {
+      uint32_t n = round % 9;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (queue.Push (pushed), true, "push failed before the queue was full");
+          pushed++;
+        }
+      if (n == 8)
+        {
+          NS_TEST_ASSERT_MSG_EQ (queue.Push (pushed), false, "full queue accepted an item");
+        }
+      while (queue.Pop (item))
+        {
+          NS_TEST_ASSERT_MSG_EQ (item, popped, "items not popped in FIFO order");
+          popped++;
+        }
+      NS_TEST_ASSERT_MSG_EQ (queue.IsEmpty (), true, "queue not empty after draining");
+    }
+  NS_TEST_ASSERT_MSG_EQ (popped, pushed, "items lost");
+}
+
+/**
+ * Several threads schedule events with ScheduleWithContext while the
+ * simulation runs, more than the cross-thread ring can hold, and each
+ * event records its sequence number within its thread.
+ */
+class MpscQueueSimulatorTestCase : public TestCase
+{
+public:
+  MpscQueueSimulatorTestCase ();
+private:
+  virtual void DoRun (void);
+  static void Producer (std::pair<MpscQueueSimulatorTestCase *, uint32_t> context);
+  void Record (uint32_t thread, uint32_t seq);
+  void Tick (void);
+
+  static const uint32_t THREADS = 4;
+  static const uint32_t EVENTS = 5000;
+  std::vector<uint32_t> m_next;
+  uint32_t m_received;
+  bool m_ordered;
+};
+
+MpscQueueSimulatorTestCase::MpscQueueSimulatorTestCase ()
+  : TestCase ("Check that events scheduled from other threads keep their order")
+{
+}
+
+void
+MpscQueueSimulatorTestCase::Producer (std::pair<MpscQueueSimulatorTestCase *, uint32_t> context)
+{
+  MpscQueueSimulatorTestCase *me = context.first;
+  uint32_t thread = context.second;
+  for (uint32_t seq = 0; seq < EVENTS; seq++)
+    {
+      Simulator::ScheduleWithContext (thread, Time (0),
+                                      &MpscQueueSimulatorTestCase::Record, me, thread, seq);
+    }
+}
+
+void
+MpscQueueSimulatorTestCase::Record (uint32_t thread, uint32_t seq)
+{
+  if (m_next[thread] != seq)
+    {
+      m_ordered = false;
+    }
+  m_next[thread] = seq + 1;
+  m_received++;
+}
+
+void
+MpscQueueSimulatorTestCase::Tick (void)
+{
+  if (m_received < THREADS * EVENTS)
+    {
+      Simulator::Schedule (MicroSeconds (1), &MpscQueueSimulatorTestCase::Tick, this);
+    }
+}
+
+void
+MpscQueueSimulatorTestCase::DoRun (void)
+{
+  m_next.assign (THREADS, 0);
+  m_received = 0;
+  m_ordered = true;
+  // make sure the simulator records this thread as the main one
+  Simulator::Now ();
+  Simulator::Schedule (MicroSeconds (1), &MpscQueueSimulatorTestCase::Tick, this);
+
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < THREADS; i++)
+    {
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (&MpscQueueSimulatorTestCase::Producer,
+                                                                std::make_pair (this, i))));
+      threads.back ()->Start ();
+    }
+  Simulator::Run ();
+  for (uint32_t i = 0; i < THREADS; i++)
+    {
+      threads[i]->Join ();
+    }
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_received, THREADS * EVENTS, "events lost");
+  NS_TEST_ASSERT_MSG_EQ (m_ordered, true, "events of a thread were reordered");
+}
+
+static class MpscQueueTestSuite : public TestSuite
+{
+public:
+  MpscQueueTestSuite ()
+    : TestSuite ("mpsc-queue")
+  {
+    AddTestCase (new MpscQueueSingleThreadTestCase, TestCase::QUICK);
+    AddTestCase (new MpscQueueSimulatorTestCase, TestCase::QUICK);
+  }
+} g_mpscQueueTestSuite;
@@ -0,0 +1,151 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/integer.h"
+#include "ns3/object-factory.h"
+#include "ns3/random-variable-stream.h"
+#include <algorithm>
+#include <vector>
+
+using namespace ns3;
+
+
+// ===========================================================================
+// Test case for the batch GetValues methods
+// ===========================================================================
+
+class RandomVariableStreamBatchTestCase : public TestCase
+{
+public:
+  static const uint32_t N_MEASUREMENTS = 10000;
+
+  RandomVariableStreamBatchTestCase ();
+  virtual ~RandomVariableStreamBatchTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Check that two identical random variables give the same values,
+   * one through GetValue and the other through GetValues with
+   * batches of increasing sizes.
+   * \param [in] one The random variable read through GetValue.
+   * \param [in] two The random variable read through GetValues.
+   */
+  void CheckSameValues (Ptr<RandomVariableStream> one, Ptr<RandomVariableStream> two);
+};
+
+RandomVariableStreamBatchTestCase::RandomVariableStreamBatchTestCase ()
+  : TestCase ("Batch generation of random values")
+{
+}
+
+RandomVariableStreamBatchTestCase::~RandomVariableStreamBatchTestCase ()
+{
+}
+
+void
+RandomVariableStreamBatchTestCase::CheckSameValues (Ptr<RandomVariableStream> one, Ptr<RandomVariableStream> two)
+{
+  std::vector<double> values (N_MEASUREMENTS);
+  uint32_t done = 0;
+  for (uint32_t batch = 1; done < N_MEASUREMENTS; batch++)
+    {
+      uint32_t n = std::min (batch, N_MEASUREMENTS - done);
+      two->GetValues (&values[done], n);
+      done += n;
+    }
+  for (uint32_t i = 0; i < N_MEASUREMENTS; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (one->GetValue (), values[i],
+                             one->GetInstanceTypeId ().GetName () << " value " << i << " differs.");
+    }
+  // Both streams must be at the same position afterwards.
+  NS_TEST_ASSERT_MSG_EQ (one->GetValue (), two->GetValue (),
+                         one->GetInstanceTypeId ().GetName () << " stream position differs.");
+}
+
+void
+RandomVariableStreamBatchTestCase::DoRun (void)
+{
+  const char *types[] = {
+    "ns3::UniformRandomVariable",
+    "ns3::ConstantRandomVariable",
+    "ns3::SequentialRandomVariable",
+    "ns3::ExponentialRandomVariable",
+    "ns3::ParetoRandomVariable",
+    "ns3::WeibullRandomVariable",
+    "ns3::NormalRandomVariable",
+    "ns3::LogNormalRandomVariable",
+  };
+  for (uint32_t antithetic = 0; antithetic < 2; ++antithetic)
+    {
+      for (uint32_t i = 0; i < sizeof (types) / sizeof (types[0]); ++i)
+        {
+          ObjectFactory factory;
+          factory.SetTypeId (types[i]);
+          factory.Set ("Stream", IntegerValue (10 + i));
+          factory.Set ("Antithetic", BooleanValue (antithetic));
+          // Bounds that reject a good part of the values.
+          if (i == 3 || i == 4)
+            {
+              factory.Set ("Bound", DoubleValue (2.0));
+            }
+          else if (i == 5)
+            {
+              factory.Set ("Bound", DoubleValue (0.5));
+            }
+          else if (i == 6)
+            {
+              factory.Set ("Bound", DoubleValue (0.8));
+            }
+          CheckSameValues (factory.Create<RandomVariableStream> (),
+                           factory.Create<RandomVariableStream> ());
+        }
+    }
+
+  // The integer variant of the uniform distribution.
+  Ptr<UniformRandomVariable> one = CreateObject<UniformRandomVariable> ();
+  Ptr<UniformRandomVariable> two = CreateObject<UniformRandomVariable> ();
+  one->SetStream (20);
+  two->SetStream (20);
+  std::vector<uint32_t> integers (N_MEASUREMENTS);
+  two->GetIntegers (&integers[0], N_MEASUREMENTS, 3, 17);
+  for (uint32_t i = 0; i < N_MEASUREMENTS; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (one->GetInteger (3, 17), integers[i], "Integer " << i << " differs.");
+    }
+}
+
+// ===========================================================================
+// Test suite for the batch GetValues methods
+// ===========================================================================
+
+class RandomVariableStreamBatchTestSuite : public TestSuite
+{
+public:
+  RandomVariableStreamBatchTestSuite ();
+};
+
+RandomVariableStreamBatchTestSuite::RandomVariableStreamBatchTestSuite ()
+  : TestSuite ("random-variable-stream-batch", UNIT)
+{
+  AddTestCase (new RandomVariableStreamBatchTestCase, TestCase::QUICK);
+}
+
+static RandomVariableStreamBatchTestSuite randomVariableStreamBatchTestSuite;
@@ -0,0 +1,261 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/integer.h"
+#include "ns3/random-variable-stream.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace ns3;
+
+
+// ===========================================================================
+// Test case for the guide table of the interpolated empirical distribution
+// ===========================================================================
+
+class EmpiricalGuideTableTestCase : public TestCase
+{
+public:
+  static const uint32_t N_MEASUREMENTS = 100000;
+  static const uint32_t N_POINTS = 1000;
+
+  EmpiricalGuideTableTestCase ();
+  virtual ~EmpiricalGuideTableTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+EmpiricalGuideTableTestCase::EmpiricalGuideTableTestCase ()
+  : TestCase ("Interpolated empirical distribution with many points")
+{
+}
+
+EmpiricalGuideTableTestCase::~EmpiricalGuideTableTestCase ()
+{
+}
+
+void
+EmpiricalGuideTableTestCase::DoRun (void)
+{
+  // A CDF with unequal steps and some flat parts.
+  Ptr<UniformRandomVariable> step = CreateObject<UniformRandomVariable> ();
+  step->SetStream (1);
+  std::vector<double> values;
+  std::vector<double> cdfs;
+  double value = 0.0;
+  double cdf = 0.0;
+  for (uint32_t i = 0; i < N_POINTS; ++i)
+    {
+      value += step->GetValue (0.0, 10.0);
+      if (i % 7 != 3)
+        {
+          cdf += step->GetValue (0.0, 2.0 / N_POINTS);
+        }
+      values.push_back (value);
+      cdfs.push_back (i == N_POINTS - 1 ? 1.0 : std::min (cdf, 1.0));
+    }
+  Ptr<EmpiricalRandomVariable> x = CreateObject<EmpiricalRandomVariable> ();
+  x->SetStream (2);
+  for (uint32_t i = 0; i < N_POINTS; ++i)
+    {
+      x->CDF (values[i], cdfs[i]);
+    }
+
+  // A uniform variable on the same stream gives the same uniform
+  // numbers: check the results against a linear search.
+  Ptr<UniformRandomVariable> u = CreateObject<UniformRandomVariable> ();
+  u->SetStream (2);
+  for (uint32_t i = 0; i < N_MEASUREMENTS; ++i)
+    {
+      double r = u->GetValue ();
+      double expected;
+      if (r <= cdfs.front ())
+        {
+          expected = values.front ();
+        }
+      else
+        {
+          uint32_t c = 1;
+          while (cdfs[c] <= r)
+            {
+              c++;
+            }
+          expected = values[c - 1] + ((values[c] - values[c - 1]) / (cdfs[c] - cdfs[c - 1])) * (r - cdfs[c - 1]);
+        }
+      NS_TEST_ASSERT_MSG_EQ (x->GetValue (), expected, "Wrong value " << i);
+    }
+}
+
+
+// ===========================================================================
+// Test case for the alias table of the discrete empirical distribution
+// ===========================================================================
+
+class EmpiricalAliasTableTestCase : public TestCase
+{
+public:
+  static const uint32_t N_MEASUREMENTS = 1000000;
+
+  EmpiricalAliasTableTestCase ();
+  virtual ~EmpiricalAliasTableTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+EmpiricalAliasTableTestCase::EmpiricalAliasTableTestCase ()
+  : TestCase ("Discrete empirical distribution")
+{
+}
+
+EmpiricalAliasTableTestCase::~EmpiricalAliasTableTestCase ()
+{
+}
+
+void
+EmpiricalAliasTableTestCase::DoRun (void)
+{
+  Ptr<EmpiricalRandomVariable> x = CreateObject<EmpiricalRandomVariable> ();
+  x->SetStream (3);
+  x->SetAttribute ("Interpolate", BooleanValue (false));
+  // Probabilities 0.1, 0, 0.2, 0.3 and 0.4.
+  x->CDF (0.0, 0.1);
+  x->CDF (1.0, 0.1);
+  x->CDF (2.0, 0.3);
+  x->CDF (3.0, 0.6);
+  x->CDF (4.0, 1.0);
+  double expected[] = { 0.1, 0.0, 0.2, 0.3, 0.4 };
+
+  uint32_t counts[5] = { 0, 0, 0, 0, 0 };
+  for (uint32_t i = 0; i < N_MEASUREMENTS; ++i)
+    {
+      double value = x->GetValue ();
+      uint32_t index = static_cast<uint32_t> (value);
+      NS_TEST_ASSERT_MSG_EQ ((index < 5 && index == value), true, "Not a point of the CDF: " << value);
+      counts[index]++;
+    }
+  for (uint32_t i = 0; i < 5; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ_TOL (counts[i] / double (N_MEASUREMENTS), expected[i], 0.003,
+                                 "Wrong frequency of " << i);
+    }
+}
+
+
+// ===========================================================================
+// Test case for the rejection-inversion Zipf distribution
+// ===========================================================================
+
+class ZipfRejectionInversionTestCase : public TestCase
+{
+public:
+  static const uint32_t N_MEASUREMENTS = 1000000;
+
+  ZipfRejectionInversionTestCase ();
+  virtual ~ZipfRejectionInversionTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Check the frequencies of the values of a Zipf distribution.
+   * \param [in] n N value for the Zipf distribution.
+   * \param [in] alpha Alpha value for the Zipf distribution.
+   */
+  void CheckFrequencies (uint32_t n, double alpha);
+};
+
+ZipfRejectionInversionTestCase::ZipfRejectionInversionTestCase ()
+  : TestCase ("Zipf distribution")
+{
+}
+
+ZipfRejectionInversionTestCase::~ZipfRejectionInversionTestCase ()
+{
+}
+
+void
+ZipfRejectionInversionTestCase::CheckFrequencies (uint32_t n, double alpha)
+{
+  Ptr<ZipfRandomVariable> x = CreateObject<ZipfRandomVariable> ();
+  x->SetStream (4);
+  x->SetAttribute ("N", IntegerValue (n));
+  x->SetAttribute ("Alpha", DoubleValue (alpha));
+
+  std::vector<uint32_t> counts (n + 1, 0);
+  for (uint32_t i = 0; i < N_MEASUREMENTS; ++i)
+    {
+      uint32_t value = x->GetInteger ();
+      NS_TEST_ASSERT_MSG_EQ ((value >= 1 && value <= n), true, "Value out of range: " << value);
+      counts[value]++;
+    }
+  double h = 0.0;
+  for (uint32_t k = 1; k <= n; ++k)
+    {
+      h += std::pow (k, -alpha);
+    }
+  for (uint32_t k = 1; k <= n; ++k)
+    {
+      NS_TEST_ASSERT_MSG_EQ_TOL (counts[k] / double (N_MEASUREMENTS), std::pow (k, -alpha) / h, 0.002,
+                                 "Wrong frequency of " << k << " for n=" << n << " alpha=" << alpha);
+    }
+}
+
+void
+ZipfRejectionInversionTestCase::DoRun (void)
+{
+  CheckFrequencies (1, 2.0);
+  CheckFrequencies (10, 0.0);
+  CheckFrequencies (10, 1.0);
+  CheckFrequencies (20, 1.2);
+  CheckFrequencies (5, 3.5);
+
+  // The cost does not depend on n.
+  Ptr<ZipfRandomVariable> x = CreateObject<ZipfRandomVariable> ();
+  x->SetStream (5);
+  x->SetAttribute ("N", IntegerValue (100000000));
+  x->SetAttribute ("Alpha", DoubleValue (0.9));
+  for (uint32_t i = 0; i < N_MEASUREMENTS; ++i)
+    {
+      double value = x->GetValue ();
+      NS_TEST_ASSERT_MSG_EQ ((value >= 1 && value <= 100000000), true, "Value out of range: " << value);
+    }
+}
+
+
+// ===========================================================================
+// Test suite for the table-based samplers
+// ===========================================================================
+
+class RandomVariableStreamTablesTestSuite : public TestSuite
+{
+public:
+  RandomVariableStreamTablesTestSuite ();
+};
+
+RandomVariableStreamTablesTestSuite::RandomVariableStreamTablesTestSuite ()
+  : TestSuite ("random-variable-stream-tables", UNIT)
+{
+  AddTestCase (new EmpiricalGuideTableTestCase, TestCase::QUICK);
+  AddTestCase (new EmpiricalAliasTableTestCase, TestCase::QUICK);
+  AddTestCase (new ZipfRejectionInversionTestCase, TestCase::QUICK);
+}
+
+static RandomVariableStreamTablesTestSuite randomVariableStreamTablesTestSuite;
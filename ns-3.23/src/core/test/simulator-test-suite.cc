@@ -21,8 +21,14 @@
 #include "ns3/simulator.h"
 #include "ns3/list-scheduler.h"
 #include "ns3/heap-scheduler.h"
+#include "ns3/dary-heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/boolean.h"
+
+#include <vector>
 
 using namespace ns3;
 
@@ -168,6 +174,290 @@ SimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_destroy, true, "Event should have run");
 }
 
+class SimulatorRemoveTestCase : public TestCase
+{
+public:
+  SimulatorRemoveTestCase (ObjectFactory schedulerFactory);
+private:
+  virtual void DoRun (void);
+  void Handle (uint32_t index);
+
+  ObjectFactory m_schedulerFactory;
+  std::vector<bool> m_removed;
+  uint64_t m_lastTs;
+  uint32_t m_lastIndex;
+  uint32_t m_handled;
+  bool m_ordered;
+};
+
+SimulatorRemoveTestCase::SimulatorRemoveTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check that removed events do not run and that the others run in order with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+SimulatorRemoveTestCase::Handle (uint32_t index)
+{
+  uint64_t ts = Simulator::Now ().GetTimeStep ();
+  if (m_removed[index]
+      || ts < m_lastTs
+      || (ts == m_lastTs && m_handled != 0 && index < m_lastIndex))
+    {
+      m_ordered = false;
+    }
+  m_lastTs = ts;
+  m_lastIndex = index;
+  m_handled++;
+}
+
+void
+SimulatorRemoveTestCase::DoRun (void)
+{
+  const uint32_t n = 2000;
+  m_removed.assign (n, false);
+  m_lastTs = 0;
+  m_lastIndex = 0;
+  m_handled = 0;
+  m_ordered = true;
+
+  Simulator::SetScheduler (m_schedulerFactory);
+
+  std::vector<EventId> ids;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      // many events share a timestamp to exercise the uid tie-break
+      Time delay = MicroSeconds ((i * 7919) % 97);
+      ids.push_back (Simulator::Schedule (delay, &SimulatorRemoveTestCase::Handle, this, i));
+    }
+  uint32_t expected = n;
+  for (uint32_t i = 0; i < n; i += 3)
+    {
+      Simulator::Remove (ids[i]);
+      m_removed[i] = true;
+      expected--;
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_ordered, true, "Events ran out of order or after removal");
+  NS_TEST_EXPECT_MSG_EQ (m_handled, expected, "Unexpected number of events");
+}
+
+class SimulatorBurstTestCase : public TestCase
+{
+public:
+  SimulatorBurstTestCase (ObjectFactory schedulerFactory);
+private:
+  virtual void DoRun (void);
+  void Burst (void);
+  void Handle (uint32_t index);
+
+  ObjectFactory m_schedulerFactory;
+  std::vector<EventId> m_ids;
+  std::vector<bool> m_removed;
+  uint64_t m_lastTs;
+  uint32_t m_lastIndex;
+  uint32_t m_handled;
+  bool m_ordered;
+};
+
+SimulatorBurstTestCase::SimulatorBurstTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check a burst of events close to the current time, and removals of far events, with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+SimulatorBurstTestCase::Burst (void)
+{
+  const uint32_t n = 20000;
+  m_removed.assign (n, false);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      // mostly within a few nanoseconds of now, some far in the future
+      Time delay = (i % 10 == 0) ? Seconds (1 + i % 7) : NanoSeconds ((i * 7919) % 13);
+      m_ids.push_back (Simulator::Schedule (delay, &SimulatorBurstTestCase::Handle, this, i));
+    }
+  for (uint32_t i = 0; i < n; i += 5)
+    {
+      Simulator::Remove (m_ids[i]);
+      m_removed[i] = true;
+    }
+}
+
+void
+SimulatorBurstTestCase::Handle (uint32_t index)
+{
+  uint64_t ts = Simulator::Now ().GetTimeStep ();
+  if (m_removed[index]
+      || ts < m_lastTs
+      || (ts == m_lastTs && m_handled != 0 && index < m_lastIndex))
+    {
+      m_ordered = false;
+    }
+  m_lastTs = ts;
+  m_lastIndex = index;
+  m_handled++;
+}
+
+void
+SimulatorBurstTestCase::DoRun (void)
+{
+  m_lastTs = 0;
+  m_lastIndex = 0;
+  m_handled = 0;
+  m_ordered = true;
+
+  Simulator::SetScheduler (m_schedulerFactory);
+  Simulator::Schedule (MicroSeconds (1), &SimulatorBurstTestCase::Burst, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_ordered, true, "Events ran out of order or after removal");
+  NS_TEST_EXPECT_MSG_EQ (m_handled, 20000 - 20000 / 5, "Unexpected number of events");
+}
+
+class SimulatorEventPoolTestCase : public TestCase
+{
+public:
+  SimulatorEventPoolTestCase ();
+private:
+  virtual void DoRun (void);
+  void Handle (void);
+};
+
+SimulatorEventPoolTestCase::SimulatorEventPoolTestCase ()
+  : TestCase ("Check that the storage of completed events is reused")
+{
+}
+
+void
+SimulatorEventPoolTestCase::Handle (void)
+{
+}
+
+void
+SimulatorEventPoolTestCase::DoRun (void)
+{
+  const uint32_t n = 100;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Simulator::Schedule (MicroSeconds (i), &SimulatorEventPoolTestCase::Handle, this);
+    }
+  Simulator::Run ();
+  EventPoolStats before = EventImpl::GetPoolStats ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Simulator::Schedule (MicroSeconds (i), &SimulatorEventPoolTestCase::Handle, this);
+    }
+  EventPoolStats after = EventImpl::GetPoolStats ();
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (after.allocations - before.allocations, n, "Unexpected number of allocations");
+  NS_TEST_EXPECT_MSG_EQ (after.reused - before.reused, n, "Storage of completed events was not reused");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (after.highWaterMark, after.live, "High-water mark below live count");
+}
+
+class SimulatorBatchTestCase : public TestCase
+{
+public:
+  SimulatorBatchTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Run the same set of events.
+   * \param [in] batching The EventBatching attribute of the simulator.
+   * \param [out] stats The fast path counters at the end of the run.
+   * \returns The indexes of the events, in the order they ran.
+   */
+  std::vector<uint32_t> RunEvents (bool batching, EventBatchStats &stats);
+  void Handle (uint32_t index);
+  void Spawn (uint32_t index);
+
+  std::vector<uint32_t> m_order;
+};
+
+SimulatorBatchTestCase::SimulatorBatchTestCase ()
+  : TestCase ("Check that events with the same timestamp run in order on the fast path")
+{
+}
+
+void
+SimulatorBatchTestCase::Handle (uint32_t index)
+{
+  m_order.push_back (index);
+}
+
+void
+SimulatorBatchTestCase::Spawn (uint32_t index)
+{
+  m_order.push_back (index);
+  // these join the batch of the current timestamp, if any.
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Simulator::ScheduleNow (&SimulatorBatchTestCase::Handle, this, 10000 + index * 10 + i);
+    }
+}
+
+std::vector<uint32_t>
+SimulatorBatchTestCase::RunEvents (bool batching, EventBatchStats &stats)
+{
+  m_order.clear ();
+  Ptr<DefaultSimulatorImpl> impl = CreateObject<DefaultSimulatorImpl> ();
+  impl->SetAttribute ("EventBatching", BooleanValue (batching));
+  Simulator::SetImplementation (impl);
+
+  std::vector<EventId> ids;
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      // runs of the same timestamp, interleaved with other times
+      Time delay = MicroSeconds (i < 100 ? 10 : (i < 150 ? 20 + i % 2 : 10 + i % 3));
+      if (i % 50 == 7)
+        {
+          ids.push_back (Simulator::Schedule (delay, &SimulatorBatchTestCase::Spawn, this, i));
+        }
+      else
+        {
+          ids.push_back (Simulator::Schedule (delay, &SimulatorBatchTestCase::Handle, this, i));
+        }
+    }
+  for (uint32_t i = 1; i < ids.size (); i += 13)
+    {
+      Simulator::Remove (ids[i]);
+    }
+  for (uint32_t i = 2; i < ids.size (); i += 17)
+    {
+      Simulator::Cancel (ids[i]);
+    }
+  Simulator::Run ();
+  stats = impl->GetBatchStats ();
+  Simulator::Destroy ();
+  return m_order;
+}
+
+void
+SimulatorBatchTestCase::DoRun (void)
+{
+  EventBatchStats withoutStats;
+  std::vector<uint32_t> without = RunEvents (false, withoutStats);
+  EventBatchStats withStats;
+  std::vector<uint32_t> with = RunEvents (true, withStats);
+
+  NS_TEST_ASSERT_MSG_EQ (with.size (), without.size (), "Unexpected number of events");
+  for (uint32_t i = 0; i < with.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (with[i], without[i], "Events ran in a different order at " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (withoutStats.batchedEvents, 0, "Fast path used while disabled");
+  NS_TEST_EXPECT_MSG_EQ (withStats.events, withoutStats.events, "Unexpected number of events run");
+  NS_TEST_EXPECT_MSG_GT (withStats.batchedEvents, withStats.events / 2, "Fast path not used");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (withStats.largestBatch, 90, "Same-timestamp events were not batched");
+}
+
 class SimulatorTemplateTestCase : public TestCase
 {
 public:
@@ -475,5 +765,36 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (DaryHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    factory.SetTypeId (ListScheduler::GetTypeId ());
+    AddTestCase (new SimulatorRemoveTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorRemoveTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorRemoveTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SimulatorRemoveTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (DaryHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorRemoveTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorRemoveTestCase (factory), TestCase::QUICK);
+
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorBurstTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorBurstTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SimulatorBurstTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (DaryHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorBurstTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorBurstTestCase (factory), TestCase::QUICK);
+
+    AddTestCase (new SimulatorEventPoolTestCase (), TestCase::QUICK);
+    AddTestCase (new SimulatorBatchTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
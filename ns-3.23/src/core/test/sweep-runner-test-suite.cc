@@ -0,0 +1,237 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/sweep-runner.h"
+#include "ns3/simulator.h"
+#include "ns3/object.h"
+#include "ns3/pointer.h"
+#include "ns3/object-factory.h"
+#include "ns3/string.h"
+#include "ns3/boolean.h"
+#include "ns3/nstime.h"
+#include "ns3/config.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/random-variable-stream.h"
+
+#include <sstream>
+#include <unistd.h>
+
+using namespace ns3;
+
+/**
+ * An object which draws random numbers at a rate given by an
+ * attribute, and sums them.
+ */
+class SweepRunnerTestObject : public Object
+{
+public:
+  static TypeId GetTypeId (void) {
+    static TypeId tid = TypeId ("ns3::SweepRunnerTestObject")
+      .AddConstructor<SweepRunnerTestObject> ()
+      .SetParent<Object> ()
+      .HideFromDocumentation ()
+      .AddAttribute ("Interval", "Time between two draws.",
+                     TimeValue (MilliSeconds (100)),
+                     MakeTimeAccessor (&SweepRunnerTestObject::m_interval),
+                     MakeTimeChecker ())
+      .AddAttribute ("Fail", "Make the result callback fail.",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&SweepRunnerTestObject::m_fail),
+                     MakeBooleanChecker ())
+      .AddAttribute ("Random", "The random variable.",
+                     StringValue ("ns3::UniformRandomVariable"),
+                     MakePointerAccessor (&SweepRunnerTestObject::m_random),
+                     MakePointerChecker<RandomVariableStream> ())
+    ;
+    return tid;
+  }
+  SweepRunnerTestObject ()
+    : m_count (0),
+      m_sum (0)
+  {
+  }
+  void Draw (void)
+  {
+    m_count++;
+    m_sum += m_random->GetValue ();
+    Simulator::Schedule (m_interval, &SweepRunnerTestObject::Draw, this);
+  }
+  std::string GetResult (void) const
+  {
+    if (m_fail)
+      {
+        _exit (3);
+      }
+    std::ostringstream oss;
+    oss.precision (17);
+    oss << m_count << " " << m_sum;
+    return oss.str ();
+  }
+
+  uint32_t m_count;
+  double m_sum;
+private:
+  Time m_interval;
+  bool m_fail;
+  Ptr<RandomVariableStream> m_random;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (SweepRunnerTestObject);
+
+/**
+ * Each variant continues the warm-up with its own run number and
+ * attribute values.
+ */
+class SweepRunnerTestCase : public TestCase
+{
+public:
+  SweepRunnerTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+SweepRunnerTestCase::SweepRunnerTestCase ()
+  : TestCase ("Check the variants run by the sweep runner")
+{
+}
+
+void
+SweepRunnerTestCase::DoRun (void)
+{
+  Ptr<SweepRunnerTestObject> object = CreateObject<SweepRunnerTestObject> ();
+  Config::RegisterRootNamespaceObject (object);
+  Simulator::Schedule (MilliSeconds (100), &SweepRunnerTestObject::Draw, object);
+
+  SweepRunner sweep;
+  sweep.SetWarmup (MilliSeconds (1050));
+  sweep.SetStopTime (MilliSeconds (2020));
+  sweep.SetMaxProcesses (2);
+  sweep.SetResultCallback (MakeCallback (&SweepRunnerTestObject::GetResult, object));
+  uint32_t v0 = sweep.AddVariant (1);
+  uint32_t v1 = sweep.AddVariant (1);
+  uint32_t v2 = sweep.AddVariant (2);
+  uint32_t v3 = sweep.AddVariant (1);
+  sweep.AddConfig (v3, "/Interval", TimeValue (MilliSeconds (50)));
+  uint32_t v4 = sweep.AddVariant (1);
+  sweep.AddConfig (v4, "/Fail", BooleanValue (true));
+  uint64_t run = RngSeedManager::GetRun ();
+  sweep.Run ();
+
+  // the parent is left at the end of the warm-up.
+  NS_TEST_ASSERT_MSG_EQ (Simulator::Now (), MilliSeconds (1050), "wrong time after the sweep");
+  NS_TEST_ASSERT_MSG_EQ (object->m_count, 10, "the variants ran in the parent");
+  NS_TEST_ASSERT_MSG_EQ (RngSeedManager::GetRun (), run, "the run changed in the parent");
+
+  NS_TEST_ASSERT_MSG_EQ (sweep.GetVariantN (), 5, "wrong number of variants");
+  for (uint32_t v = 0; v < 4; v++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (sweep.IsSuccess (v), true, "variant " << v << " failed");
+    }
+  NS_TEST_ASSERT_MSG_EQ (sweep.IsSuccess (v4), false, "failing variant succeeded");
+  NS_TEST_ASSERT_MSG_EQ (sweep.GetResult (v4), "", "failing variant has a result");
+
+  NS_TEST_ASSERT_MSG_EQ (sweep.GetResult (v0), sweep.GetResult (v1), "same run gave different results");
+  NS_TEST_ASSERT_MSG_NE (sweep.GetResult (v0), sweep.GetResult (v2), "different runs gave the same result");
+
+  uint32_t count;
+  std::istringstream (sweep.GetResult (v0)) >> count;
+  NS_TEST_ASSERT_MSG_EQ (count, 20, "wrong number of draws in variant 0");
+  std::istringstream (sweep.GetResult (v3)) >> count;
+  NS_TEST_ASSERT_MSG_EQ (count, 29, "wrong number of draws in variant 3");
+
+  Config::UnregisterRootNamespaceObject (object);
+  Simulator::Destroy ();
+}
+
+/**
+ * A variable which cached state before the fork, for instance the
+ * second value of a normal pair, must not leak it into the variant:
+ * the variant draws the same values as a fresh variable of its run.
+ */
+class SweepRunnerResetTestCase : public TestCase
+{
+public:
+  SweepRunnerResetTestCase (std::string type);
+private:
+  virtual void DoRun (void);
+  Ptr<RandomVariableStream> Create (void) const;
+  std::string m_type;
+};
+
+SweepRunnerResetTestCase::SweepRunnerResetTestCase (std::string type)
+  : TestCase ("Check that " + type + " is reset in the variants"),
+    m_type (type)
+{
+}
+
+Ptr<RandomVariableStream>
+SweepRunnerResetTestCase::Create (void) const
+{
+  ObjectFactory factory;
+  factory.SetTypeId (m_type);
+  Ptr<RandomVariableStream> random = factory.Create<RandomVariableStream> ();
+  random->SetStream (100);
+  return random;
+}
+
+void
+SweepRunnerResetTestCase::DoRun (void)
+{
+  Ptr<SweepRunnerTestObject> object = CreateObject<SweepRunnerTestObject> ();
+  object->SetAttribute ("Random", PointerValue (Create ()));
+  Config::RegisterRootNamespaceObject (object);
+  Simulator::Schedule (MilliSeconds (100), &SweepRunnerTestObject::Draw, object);
+
+  // a single draw in the warm-up leaves half of a normal pair cached.
+  SweepRunner sweep;
+  sweep.SetWarmup (MilliSeconds (150));
+  sweep.SetStopTime (MilliSeconds (1050));
+  sweep.SetResultCallback (MakeCallback (&SweepRunnerTestObject::GetResult, object));
+  uint32_t v = sweep.AddVariant (3);
+  sweep.Run ();
+  NS_TEST_ASSERT_MSG_EQ (object->m_count, 1, "wrong number of draws in the warm-up");
+  NS_TEST_ASSERT_MSG_EQ (sweep.IsSuccess (v), true, "variant failed");
+
+  uint64_t run = RngSeedManager::GetRun ();
+  RngSeedManager::SetRun (3);
+  Ptr<RandomVariableStream> fresh = Create ();
+  RngSeedManager::SetRun (run);
+  double sum = object->m_sum;
+  for (uint32_t i = 0; i < 9; i++)
+    {
+      sum += fresh->GetValue ();
+    }
+  std::ostringstream oss;
+  oss.precision (17);
+  oss << 10 << " " << sum;
+  NS_TEST_ASSERT_MSG_EQ (sweep.GetResult (v), oss.str (), "the variant did not draw fresh values");
+
+  Config::UnregisterRootNamespaceObject (object);
+  Simulator::Destroy ();
+}
+
+static class SweepRunnerTestSuite : public TestSuite
+{
+public:
+  SweepRunnerTestSuite ()
+    : TestSuite ("sweep-runner")
+  {
+    AddTestCase (new SweepRunnerTestCase, TestCase::QUICK);
+    AddTestCase (new SweepRunnerResetTestCase ("ns3::NormalRandomVariable"), TestCase::QUICK);
+    AddTestCase (new SweepRunnerResetTestCase ("ns3::GammaRandomVariable"), TestCase::QUICK);
+  }
+} g_sweepRunnerTestSuite;
@@ -26,10 +26,13 @@
 #include "ns3/config.h"
 #include "ns3/string.h"
 #include "ns3/system-thread.h"
+#include "ns3/make-event.h"
+#include "ns3/event-impl.h"
 
 #include <ctime>
 #include <list>
 #include <utility>
+#include <vector>
 
 using namespace ns3;
 
@@ -225,6 +228,82 @@ ThreadedSimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_a, m_d, "Bad scheduling");
 }
 
+class ThreadedEventPoolTestCase : public TestCase
+{
+public:
+  ThreadedEventPoolTestCase ();
+private:
+  virtual void DoRun (void);
+  /** Allocate the events of m_events. */
+  void Allocate (void);
+  /** Release the events of m_events. */
+  void Release (void);
+  /** Does nothing: the function of the events. */
+  static void Nothing (void);
+
+  std::vector<EventImpl *> m_events;
+};
+
+ThreadedEventPoolTestCase::ThreadedEventPoolTestCase ()
+  : TestCase ("Check the event pools with events released by another thread")
+{
+}
+
+void
+ThreadedEventPoolTestCase::Nothing (void)
+{
+}
+
+void
+ThreadedEventPoolTestCase::Allocate (void)
+{
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      m_events.push_back (MakeEvent (&ThreadedEventPoolTestCase::Nothing));
+    }
+}
+
+void
+ThreadedEventPoolTestCase::Release (void)
+{
+  for (uint32_t i = 0; i < m_events.size (); i++)
+    {
+      m_events[i]->Unref ();
+    }
+  m_events.clear ();
+}
+
+void
+ThreadedEventPoolTestCase::DoRun (void)
+{
+  // events allocated here and released by another thread go back to
+  // the pool of this thread.
+  EventPoolStats before = EventImpl::GetPoolStats ();
+  Allocate ();
+  Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&ThreadedEventPoolTestCase::Release, this));
+  thread->Start ();
+  thread->Join ();
+  EventPoolStats after = EventImpl::GetPoolStats ();
+  NS_TEST_EXPECT_MSG_EQ (after.allocations - before.allocations, 100, "Wrong number of allocations");
+  NS_TEST_EXPECT_MSG_EQ (after.live, before.live, "Events released by another thread still live");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (after.highWaterMark, before.live + 100, "Wrong high-water mark");
+  Allocate ();
+  Release ();
+  EventPoolStats reused = EventImpl::GetPoolStats ();
+  NS_TEST_EXPECT_MSG_EQ (reused.reused - after.reused, 100, "Events released by another thread were not reused");
+
+  // events allocated by another thread are not counted here, even
+  // when this thread releases them.
+  thread = Create<SystemThread> (MakeCallback (&ThreadedEventPoolTestCase::Allocate, this));
+  thread->Start ();
+  thread->Join ();
+  before = EventImpl::GetPoolStats ();
+  Release ();
+  after = EventImpl::GetPoolStats ();
+  NS_TEST_EXPECT_MSG_EQ (after.live, before.live, "Live count changed by foreign events");
+  NS_TEST_EXPECT_MSG_EQ (after.allocations, before.allocations, "Foreign events counted");
+}
+
 class ThreadedSimulatorTestSuite : public TestSuite
 {
 public:
@@ -240,8 +319,10 @@ public:
     std::string schedulerTypes[] = {
       "ns3::ListScheduler",
       "ns3::HeapScheduler",
+      "ns3::DaryHeapScheduler",
       "ns3::MapScheduler",
-      "ns3::CalendarScheduler"
+      "ns3::CalendarScheduler",
+      "ns3::LadderScheduler"
     };
     unsigned int threadcounts[] = {
       0,
@@ -262,5 +343,6 @@ public:
               }
           }
       }
+    AddTestCase (new ThreadedEventPoolTestCase (), TestCase::QUICK);
   }
 } g_threadedSimulatorTestSuite;
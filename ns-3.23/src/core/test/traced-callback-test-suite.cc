@@ -108,6 +108,79 @@ BasicTracedCallbackTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_two, true, "Callback CbTwo not called");
 }
 
+class ConnectDuringTraceTestCase : public TestCase
+{
+public:
+  ConnectDuringTraceTestCase ();
+  virtual ~ConnectDuringTraceTestCase () {}
+
+private:
+  virtual void DoRun (void);
+
+  void CbConnect (uint32_t a);
+  void CbCount (uint32_t a);
+
+  TracedCallback<uint32_t> m_trace;
+  uint32_t m_count;
+};
+
+ConnectDuringTraceTestCase::ConnectDuringTraceTestCase ()
+  : TestCase ("Check TracedCallback sinks connected while tracing, and NullTracedCallback")
+{
+}
+
+void
+ConnectDuringTraceTestCase::CbConnect (uint32_t a)
+{
+  // Grow the chain while it is being invoked.
+  for (uint32_t i = 0; i < a; i++)
+    {
+      m_trace.ConnectWithoutContext (MakeCallback (&ConnectDuringTraceTestCase::CbCount, this));
+    }
+}
+
+void
+ConnectDuringTraceTestCase::CbCount (uint32_t a)
+{
+  m_count++;
+}
+
+void
+ConnectDuringTraceTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_trace.IsEmpty (), true, "New TracedCallback not empty");
+  m_count = 0;
+  m_trace (1);
+  NS_TEST_ASSERT_MSG_EQ (m_count, 0, "Empty TracedCallback called something");
+
+  m_trace.ConnectWithoutContext (MakeCallback (&ConnectDuringTraceTestCase::CbConnect, this));
+  NS_TEST_ASSERT_MSG_EQ (m_trace.IsEmpty (), false, "Connected TracedCallback empty");
+
+  //
+  // The sinks connected during the trace are called by the same trace.
+  //
+  m_trace (10);
+  NS_TEST_ASSERT_MSG_EQ (m_count, 10, "Sinks connected during the trace not called");
+
+  m_trace.DisconnectWithoutContext (MakeCallback (&ConnectDuringTraceTestCase::CbConnect, this));
+  m_count = 0;
+  m_trace (10);
+  NS_TEST_ASSERT_MSG_EQ (m_count, 10, "Wrong number of sinks called");
+
+  m_trace.DisconnectWithoutContext (MakeCallback (&ConnectDuringTraceTestCase::CbCount, this));
+  NS_TEST_ASSERT_MSG_EQ (m_trace.IsEmpty (), true, "Disconnected TracedCallback not empty");
+
+  //
+  // A NullTracedCallback accepts sinks and never calls them.
+  //
+  NullTracedCallback<uint32_t> null;
+  null.ConnectWithoutContext (MakeCallback (&ConnectDuringTraceTestCase::CbCount, this));
+  m_count = 0;
+  null (1);
+  NS_TEST_ASSERT_MSG_EQ (m_count, 0, "NullTracedCallback called a sink");
+  NS_TEST_ASSERT_MSG_EQ (null.IsEmpty (), true, "NullTracedCallback not empty");
+}
+
 class TracedCallbackTestSuite : public TestSuite
 {
 public:
@@ -118,6 +191,7 @@ TracedCallbackTestSuite::TracedCallbackTestSuite ()
   : TestSuite ("traced-callback", UNIT)
 {
   AddTestCase (new BasicTracedCallbackTestCase, TestCase::QUICK);
+  AddTestCase (new ConnectDuringTraceTestCase, TestCase::QUICK);
 }
 
 static TracedCallbackTestSuite tracedCallbackTestSuite;
@@ -23,6 +23,8 @@
 #include <ctime>
 
 #include "ns3/type-id.h"
+#include "ns3/object.h"
+#include "ns3/uinteger.h"
 #include "ns3/test.h"
 #include "ns3/log.h"
 
@@ -188,6 +190,130 @@ CollisionTestCase::DoRun (void)
 }
   
   
+//----------------------------
+//
+// Test the attribute and trace source tables against the TypeId hierarchy
+
+class AttributeLookupTestCase : public TestCase
+{
+public:
+  AttributeLookupTestCase ();
+  virtual ~AttributeLookupTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+AttributeLookupTestCase::AttributeLookupTestCase ()
+  : TestCase ("Check attribute and trace source lookup of all TypeIds")
+{
+}
+
+AttributeLookupTestCase::~AttributeLookupTestCase ()
+{
+}
+
+void
+AttributeLookupTestCase::DoRun (void)
+{
+  uint32_t nids = TypeId::GetRegisteredN ();
+  for (uint32_t i = 0; i < nids; ++i)
+    {
+      const TypeId tid = TypeId::GetRegistered (i);
+      uint32_t nAttributes = 0;
+      TypeId current = tid;
+      while (true)
+        {
+          for (uint32_t j = 0; j < current.GetAttributeN (); ++j)
+            {
+              struct TypeId::AttributeInformation expected = current.GetAttribute (j);
+              struct TypeId::AttributeInformation info;
+              NS_TEST_ASSERT_MSG_EQ (tid.LookupAttributeByName (expected.name, &info), true,
+                                     "Attribute " << expected.name << " not found in " << tid.GetName ());
+              NS_TEST_ASSERT_MSG_EQ (info.accessor, expected.accessor,
+                                     "Wrong attribute " << expected.name << " found in " << tid.GetName ());
+            }
+          for (uint32_t j = 0; j < current.GetTraceSourceN (); ++j)
+            {
+              struct TypeId::TraceSourceInformation expected = current.GetTraceSource (j);
+              NS_TEST_ASSERT_MSG_EQ (tid.LookupTraceSourceByName (expected.name), expected.accessor,
+                                     "Wrong trace source " << expected.name << " found in " << tid.GetName ());
+            }
+          nAttributes += current.GetAttributeN ();
+          if (!current.HasParent () || current.GetParent ().GetUid () == 0)
+            {
+              break;
+            }
+          current = current.GetParent ();
+        }
+      struct TypeId::AttributeInformation info;
+      NS_TEST_ASSERT_MSG_EQ (tid.LookupAttributeByName ("NoSuchAttribute", &info), false,
+                             "Unexpected attribute found in " << tid.GetName ());
+      NS_TEST_ASSERT_MSG_EQ (tid.LookupTraceSourceByName ("NoSuchTraceSource"), 0,
+                             "Unexpected trace source found in " << tid.GetName ());
+      NS_TEST_ASSERT_MSG_EQ (tid.GetConstructionInformation ()->attributes.size (), nAttributes,
+                             "Wrong number of attributes to construct " << tid.GetName ());
+    }
+}
+
+
+/**
+ * Holds the attribute added by TableUpdateTestCase.
+ */
+class TableUpdateTestObject : public Object
+{
+public:
+  uint32_t m_value; //!< The attribute.
+};
+
+class TableUpdateTestCase : public TestCase
+{
+public:
+  TableUpdateTestCase ();
+  virtual ~TableUpdateTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TableUpdateTestCase::TableUpdateTestCase ()
+  : TestCase ("Check that the tables of subclasses follow their parents")
+{
+}
+
+TableUpdateTestCase::~TableUpdateTestCase ()
+{
+}
+
+void
+TableUpdateTestCase::DoRun (void)
+{
+  TypeId parent = TypeId ("ns3::TableUpdateTestParent")
+    .SetParent<Object> ()
+    .HideFromDocumentation ();
+  TypeId child = TypeId ("ns3::TableUpdateTestChild")
+    .SetParent (parent)
+    .HideFromDocumentation ();
+  const TypeId::ConstructionInformation *construction = child.GetConstructionInformation ();
+  uint32_t n = construction->attributes.size ();
+
+  parent.AddAttribute ("Value", "A value.",
+                       UintegerValue (1),
+                       MakeUintegerAccessor (&TableUpdateTestObject::m_value),
+                       MakeUintegerChecker<uint32_t> ());
+  NS_TEST_ASSERT_MSG_EQ (child.GetConstructionInformation (), construction,
+                         "The construction information moved");
+  NS_TEST_ASSERT_MSG_EQ (construction->attributes.size (), n + 1,
+                         "The attribute of the parent is not constructed");
+  struct TypeId::AttributeInformation info;
+  NS_TEST_ASSERT_MSG_EQ (child.LookupAttributeByName ("Value", &info), true,
+                         "The attribute of the parent is not found");
+
+  parent.SetAttributeInitialValue (parent.GetAttributeN () - 1, Create<UintegerValue> (2));
+  NS_TEST_ASSERT_MSG_EQ (construction->attributes[0].name, "Value", "Wrong attribute order");
+  Ptr<const UintegerValue> value = DynamicCast<const UintegerValue> (construction->attributes[0].initialValue);
+  NS_TEST_ASSERT_MSG_EQ (value->Get (), 2, "The initial value is out of date");
+}
+
+
 //----------------------------
 //
 // Performance test
@@ -298,6 +424,8 @@ TypeIdTestSuite::TypeIdTestSuite ()
   // as chained.
   AddTestCase (new UniqueTypeIdTestCase, QUICK);
   AddTestCase (new CollisionTestCase, QUICK);
+  AddTestCase (new AttributeLookupTestCase, QUICK);
+  AddTestCase (new TableUpdateTestCase, QUICK);
 }
 
 static TypeIdTestSuite g_TypeIdTestSuite;  
@@ -189,11 +189,26 @@ CsmaChannel::TransmitStart (Ptr<Packet> p, uint32_t srcId)
 
   NS_LOG_LOGIC ("switch to TRANSMITTING");
   m_currentPkt = p;
+  m_currentTrain.clear ();
   m_currentSrc = srcId;
   m_state = TRANSMITTING;
   return true;
 }
 
+bool
+CsmaChannel::TransmitStart (const std::vector<Ptr<Packet> > &packets, uint32_t srcId)
+{
+  NS_LOG_FUNCTION (this << packets.size () << srcId);
+  NS_ASSERT (!packets.empty ());
+
+  if (!TransmitStart (packets.front (), srcId))
+    {
+      return false;
+    }
+  m_currentTrain = packets;
+  return true;
+}
+
 bool
 CsmaChannel::IsActive (uint32_t deviceId)
 {
@@ -229,13 +244,32 @@ CsmaChannel::TransmitEnd ()
       if (it->IsActive ())
         {
           // schedule reception events
-          Simulator::ScheduleWithContext (it->devicePtr->GetNode ()->GetId (),
-                                          m_delay,
-                                          &CsmaNetDevice::Receive, it->devicePtr,
-                                          m_currentPkt->Copy (), m_deviceList[m_currentSrc].devicePtr);
+          if (m_currentTrain.empty ())
+            {
+              Simulator::ScheduleWithContext (it->devicePtr->GetNode ()->GetId (),
+                                              m_delay,
+                                              &CsmaNetDevice::Receive, it->devicePtr,
+                                              m_currentPkt->Copy (), m_deviceList[m_currentSrc].devicePtr);
+            }
+          else if (devId != m_currentSrc)
+            {
+              // the sender never receives its own packets, so it gets no event
+              std::vector<Ptr<Packet> > train;
+              train.reserve (m_currentTrain.size ());
+              for (std::vector<Ptr<Packet> >::const_iterator i = m_currentTrain.begin ();
+                   i != m_currentTrain.end (); ++i)
+                {
+                  train.push_back ((*i)->Copy ());
+                }
+              Simulator::ScheduleWithContext (it->devicePtr->GetNode ()->GetId (),
+                                              m_delay,
+                                              &CsmaNetDevice::ReceiveBatch, it->devicePtr,
+                                              train, m_deviceList[m_currentSrc].devicePtr);
+            }
         }
       devId++;
     }
+  m_currentTrain.clear ();
 
   // also schedule for the tx side to go back to IDLE
   Simulator::Schedule (m_delay, &CsmaChannel::PropagationCompleteEvent,
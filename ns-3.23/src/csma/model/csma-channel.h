@@ -21,6 +21,7 @@
 #ifndef CSMA_CHANNEL_H
 #define CSMA_CHANNEL_H
 
+#include <vector>
 #include "ns3/channel.h"
 #include "ns3/ptr.h"
 #include "ns3/nstime.h"
@@ -167,6 +168,21 @@ public:
    */
   bool TransmitStart (Ptr<Packet> p, uint32_t srcId);
 
+  /**
+   * \brief Start transmitting a train of packets over the channel
+   *
+   * The channel is held for the whole train, and each attached net
+   * device receives the train in a single event when TransmitEnd is
+   * called at the end of its last packet.
+   *
+   * \param packets The packets that will be transmitted, in order
+   * \param srcId The device Id of the net device that wants to
+   * transmit on the channel.
+   * \return True if the channel is not busy and the transmitting net
+   * device is currently active.
+   */
+  bool TransmitStart (const std::vector<Ptr<Packet> > &packets, uint32_t srcId);
+
   /**
    * \brief Indicates that the net device has finished transmitting
    * the packet over the channel
@@ -308,6 +324,12 @@ private:
    */
   Ptr<Packet> m_currentPkt;
 
+  /**
+   * The train that is currently being transmitted on the channel, if the
+   * current transmission is a train. Its first packet is m_currentPkt.
+   */
+  std::vector<Ptr<Packet> > m_currentTrain;
+
   /**
    * Device Id of the source that is currently transmitting on the
    * channel. Or last source to have transmitted a packet on the
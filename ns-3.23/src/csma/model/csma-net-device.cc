@@ -217,6 +217,8 @@ CsmaNetDevice::DoDispose ()
   NS_LOG_FUNCTION_NOARGS ();
   m_channel = 0;
   m_node = 0;
+  m_currentTrain.clear ();
+  m_txTrains.clear ();
   NetDevice::DoDispose ();
 }
 
@@ -454,8 +456,9 @@ CsmaNetDevice::TransmitStart (void)
   //
   if (IsSendEnabled () == false)
     {
-      m_phyTxDropTrace (m_currentPkt);
+      TraceCurrent (m_phyTxDropTrace);
       m_currentPkt = 0;
+      m_currentTrain.clear ();
       return;
     }
 
@@ -489,7 +492,7 @@ CsmaNetDevice::TransmitStart (void)
         } 
       else 
         {
-          m_macTxBackoffTrace (m_currentPkt);
+          TraceCurrent (m_macTxBackoffTrace);
 
           m_backoff.IncrNumRetries ();
           Time backoffTime = m_backoff.GetBackoffTime ();
@@ -502,26 +505,35 @@ CsmaNetDevice::TransmitStart (void)
   else 
     {
       //
-      // The channel is free, transmit the packet
+      // The channel is free, transmit the packet, or the train
       //
-      if (m_channel->TransmitStart (m_currentPkt, m_deviceId) == false)
+      bool started = m_currentTrain.empty () ?
+        m_channel->TransmitStart (m_currentPkt, m_deviceId) :
+        m_channel->TransmitStart (m_currentTrain, m_deviceId);
+      if (started == false)
         {
           NS_LOG_WARN ("Channel TransmitStart returns an error");
-          m_phyTxDropTrace (m_currentPkt);
+          TraceCurrent (m_phyTxDropTrace);
           m_currentPkt = 0;
+          m_currentTrain.clear ();
           m_txMachineState = READY;
         } 
       else 
         {
           //
           // Transmission succeeded, reset the backoff time parameters and
-          // schedule a transmit complete event.
+          // schedule a transmit complete event.  The packets of a train
+          // are separated by the interframe gap.
           //
           m_backoff.ResetBackoffTime ();
           m_txMachineState = BUSY;
-          m_phyTxBeginTrace (m_currentPkt);
+          TraceCurrent (m_phyTxBeginTrace);
 
           Time tEvent = m_bps.CalculateBytesTxTime (m_currentPkt->GetSize ());
+          for (uint32_t i = 1; i < m_currentTrain.size (); ++i)
+            {
+              tEvent += m_tInterframeGap + m_bps.CalculateBytesTxTime (m_currentTrain[i]->GetSize ());
+            }
           NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << tEvent.GetSeconds () << "sec");
           Simulator::Schedule (tEvent, &CsmaNetDevice::TransmitCompleteEvent, this);
         }
@@ -541,8 +553,9 @@ CsmaNetDevice::TransmitAbort (void)
   NS_LOG_LOGIC ("m_currentPkt=" << m_currentPkt);
   NS_LOG_LOGIC ("Pkt UID is " << m_currentPkt->GetUid () << ")");
 
-  m_phyTxDropTrace (m_currentPkt);
+  TraceCurrent (m_phyTxDropTrace);
   m_currentPkt = 0;
+  m_currentTrain.clear ();
 
   NS_ASSERT_MSG (m_txMachineState == BACKOFF, "Must be in BACKOFF state to abort.  Tx state is: " << m_txMachineState);
 
@@ -558,18 +571,7 @@ CsmaNetDevice::TransmitAbort (void)
   // get that out.  If the queue is empty we just wait until someone puts one
   // in.
   //
-  if (m_queue->IsEmpty ())
-    {
-      return;
-    }
-  else
-    {
-      m_currentPkt = m_queue->Dequeue ();
-      NS_ASSERT_MSG (m_currentPkt != 0, "CsmaNetDevice::TransmitAbort(): IsEmpty false but no Packet on queue?");
-      m_snifferTrace (m_currentPkt);
-      m_promiscSnifferTrace (m_currentPkt);
-      TransmitStart ();
-    }
+  TransmitNext ();
 }
 
 void
@@ -596,8 +598,9 @@ CsmaNetDevice::TransmitCompleteEvent (void)
   NS_LOG_LOGIC ("Pkt UID is " << m_currentPkt->GetUid () << ")");
 
   m_channel->TransmitEnd (); 
-  m_phyTxEndTrace (m_currentPkt);
+  TraceCurrent (m_phyTxEndTrace);
   m_currentPkt = 0;
+  m_currentTrain.clear ();
 
   NS_LOG_LOGIC ("Schedule TransmitReadyEvent in " << m_tInterframeGap.GetSeconds () << "sec");
 
@@ -626,17 +629,67 @@ CsmaNetDevice::TransmitReadyEvent (void)
   //
   // Get the next packet from the queue for transmitting
   //
+  TransmitNext ();
+}
+
+void
+CsmaNetDevice::TransmitNext (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
   if (m_queue->IsEmpty ())
     {
+      //
+      // The queue may have dropped packets of the trains we knew about.
+      //
+      m_txTrains.clear ();
       return;
     }
-  else
+
+  uint32_t n = 1;
+  if (!m_txTrains.empty ())
+    {
+      n = m_txTrains.front ();
+      m_txTrains.pop_front ();
+    }
+
+  m_currentPkt = m_queue->Dequeue ();
+  NS_ASSERT_MSG (m_currentPkt != 0, "CsmaNetDevice::TransmitNext(): IsEmpty false but no Packet on queue?");
+  m_snifferTrace (m_currentPkt);
+  m_promiscSnifferTrace (m_currentPkt);
+
+  if (n > 1)
+    {
+      m_currentTrain.reserve (n);
+      m_currentTrain.push_back (m_currentPkt);
+      while (m_currentTrain.size () < n && !m_queue->IsEmpty ())
+        {
+          Ptr<Packet> p = m_queue->Dequeue ();
+          NS_ASSERT_MSG (p != 0, "CsmaNetDevice::TransmitNext(): IsEmpty false but no Packet on queue?");
+          m_snifferTrace (p);
+          m_promiscSnifferTrace (p);
+          m_currentTrain.push_back (p);
+        }
+      if (m_currentTrain.size () == 1)
+        {
+          m_currentTrain.clear ();
+        }
+    }
+  TransmitStart ();
+}
+
+void
+CsmaNetDevice::TraceCurrent (TracedCallback<Ptr<const Packet> > &trace)
+{
+  if (m_currentTrain.empty ())
     {
-      m_currentPkt = m_queue->Dequeue ();
-      NS_ASSERT_MSG (m_currentPkt != 0, "CsmaNetDevice::TransmitReadyEvent(): IsEmpty false but no Packet on queue?");
-      m_snifferTrace (m_currentPkt);
-      m_promiscSnifferTrace (m_currentPkt);
-      TransmitStart ();
+      trace (m_currentPkt);
+      return;
+    }
+  for (std::vector<Ptr<Packet> >::const_iterator i = m_currentTrain.begin ();
+       i != m_currentTrain.end (); ++i)
+    {
+      trace (*i);
     }
 }
 
@@ -682,6 +735,64 @@ CsmaNetDevice::SetReceiveErrorModel (Ptr<ErrorModel> em)
 
 void
 CsmaNetDevice::Receive (Ptr<Packet> packet, Ptr<CsmaNetDevice> senderDevice)
+{
+  NS_LOG_FUNCTION (packet << senderDevice);
+  uint16_t protocol;
+  Mac48Address source;
+
+  if (DoReceive (packet, senderDevice, protocol, source))
+    {
+      m_rxCallback (this, packet, protocol, source);
+    }
+}
+
+void
+CsmaNetDevice::ReceiveBatch (std::vector<Ptr<Packet> > packets, Ptr<CsmaNetDevice> senderDevice)
+{
+  NS_LOG_FUNCTION (packets.size () << senderDevice);
+
+  if (m_rxBatchCallback.IsNull ())
+    {
+      for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+        {
+          Receive (*i, senderDevice);
+        }
+      return;
+    }
+
+  //
+  // Forward the runs of packets with the same protocol and source up the
+  // stack together, once the whole train went through the receive path.
+  //
+  std::vector<Ptr<const Packet> > run;
+  uint16_t runProtocol = 0;
+  Mac48Address runSource;
+  for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+    {
+      uint16_t protocol;
+      Mac48Address source;
+      if (!DoReceive (*i, senderDevice, protocol, source))
+        {
+          continue;
+        }
+      if (!run.empty () && (protocol != runProtocol || source != runSource))
+        {
+          m_rxBatchCallback (this, run, runProtocol, runSource);
+          run.clear ();
+        }
+      run.push_back (*i);
+      runProtocol = protocol;
+      runSource = source;
+    }
+  if (!run.empty ())
+    {
+      m_rxBatchCallback (this, run, runProtocol, runSource);
+    }
+}
+
+bool
+CsmaNetDevice::DoReceive (Ptr<Packet> packet, Ptr<CsmaNetDevice> senderDevice,
+                          uint16_t &protocol, Mac48Address &source)
 {
   NS_LOG_FUNCTION (packet << senderDevice);
   NS_LOG_LOGIC ("UID is " << packet->GetUid ());
@@ -692,7 +803,7 @@ CsmaNetDevice::Receive (Ptr<Packet> packet, Ptr<CsmaNetDevice> senderDevice)
   // 
   if (senderDevice == this)
     {
-      return;
+      return false;
     }
 
   //
@@ -707,14 +818,14 @@ CsmaNetDevice::Receive (Ptr<Packet> packet, Ptr<CsmaNetDevice> senderDevice)
   if (IsReceiveEnabled () == false)
     {
       m_phyRxDropTrace (packet);
-      return;
+      return false;
     }
 
   if (m_receiveErrorModel && m_receiveErrorModel->IsCorrupt (packet) )
     {
       NS_LOG_LOGIC ("Dropping pkt due to error model ");
       m_phyRxDropTrace (packet);
-      return;
+      return false;
     }
 
   //
@@ -735,7 +846,7 @@ CsmaNetDevice::Receive (Ptr<Packet> packet, Ptr<CsmaNetDevice> senderDevice)
     {
       NS_LOG_INFO ("CRC error on Packet " << packet);
       m_phyRxDropTrace (packet);
-      return;
+      return false;
     }
 
   EthernetHeader header (false);
@@ -744,7 +855,6 @@ CsmaNetDevice::Receive (Ptr<Packet> packet, Ptr<CsmaNetDevice> senderDevice)
   NS_LOG_LOGIC ("Pkt source is " << header.GetSource ());
   NS_LOG_LOGIC ("Pkt destination is " << header.GetDestination ());
 
-  uint16_t protocol;
   //
   // If the length/type is less than 1500, it corresponds to a length 
   // interpretation packet.  In this case, it is an 802.3 packet and 
@@ -813,8 +923,10 @@ CsmaNetDevice::Receive (Ptr<Packet> packet, Ptr<CsmaNetDevice> senderDevice)
     {
       m_snifferTrace (originalPacket);
       m_macRxTrace (originalPacket);
-      m_rxCallback (this, packet, protocol, header.GetSource ());
+      source = header.GetSource ();
+      return true;
     }
+  return false;
 }
 
 Ptr<Queue>
@@ -990,9 +1102,66 @@ CsmaNetDevice::SendFrom (Ptr<Packet> packet, const Address& src, const Address&
           TransmitStart ();
         }
     }
+  else if (!m_txTrains.empty ())
+    {
+      m_txTrains.push_back (1);
+    }
   return true;
 }
 
+uint32_t
+CsmaNetDevice::SendBatch (const std::vector<Ptr<Packet> > &packets, const Address& dest, uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (packets.size () << dest << protocolNumber);
+
+  NS_ASSERT (IsLinkUp ());
+
+  //
+  // Only transmit if send side of net device is enabled
+  //
+  if (IsSendEnabled () == false)
+    {
+      for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+        {
+          m_macTxDropTrace (*i);
+        }
+      return 0;
+    }
+
+  if (m_txTrains.empty ())
+    {
+      //
+      // The packets already queued by SendFrom go out one by one.
+      //
+      m_txTrains.assign (m_queue->GetNPackets (), 1);
+    }
+
+  Mac48Address destination = Mac48Address::ConvertFrom (dest);
+  uint32_t sent = 0;
+  for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+    {
+      Ptr<Packet> packet = *i;
+      AddHeader (packet, m_address, destination, protocolNumber);
+      m_macTxTrace (packet);
+      if (m_queue->Enqueue (packet) == false)
+        {
+          m_macTxDropTrace (packet);
+          break;
+        }
+      sent++;
+    }
+
+  if (sent > 0)
+    {
+      m_txTrains.push_back (sent);
+      if (m_txMachineState == READY)
+        {
+          TransmitNext ();
+        }
+    }
+  return sent;
+}
+
 Ptr<Node>
 CsmaNetDevice::GetNode (void) const
 {
@@ -1030,6 +1199,13 @@ Address CsmaNetDevice::GetMulticast (Ipv6Address addr) const
   return ad;
 }
 
+void
+CsmaNetDevice::SetReceiveBatchCallback (NetDevice::ReceiveBatchCallback cb)
+{
+  NS_LOG_FUNCTION (&cb);
+  m_rxBatchCallback = cb;
+}
+
 void
 CsmaNetDevice::SetPromiscReceiveCallback (NetDevice::PromiscReceiveCallback cb)
 {
@@ -22,6 +22,8 @@
 #define CSMA_NET_DEVICE_H
 
 #include <cstring>
+#include <deque>
+#include <vector>
 #include "ns3/node.h"
 #include "ns3/backoff.h"
 #include "ns3/address.h"
@@ -162,6 +164,19 @@ public:
    */
   void Receive (Ptr<Packet> p, Ptr<CsmaNetDevice> sender);
 
+  /**
+   * Receive a train of packets from a connected CsmaChannel.
+   *
+   * The packets go through the same receive path as with Receive, but
+   * consecutive packets with the same protocol and source are forwarded
+   * up the stack together when a ReceiveBatchCallback is set.
+   *
+   * \see CsmaChannel
+   * \param packets the received packets, in order
+   * \param sender the CsmaNetDevice that transmitted the packets in the first place
+   */
+  void ReceiveBatch (std::vector<Ptr<Packet> > packets, Ptr<CsmaNetDevice> sender);
+
   /**
    * Is the send side of the network device enabled?
    *
@@ -278,6 +293,25 @@ public:
   virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, 
                          uint16_t protocolNumber);
 
+  /**
+   * Send a burst of packets.
+   *
+   * The packets are queued like with Send. When the transmitter reaches
+   * them, they are sent back to back as a single train which holds the
+   * channel from the start of its first packet to the end of its last
+   * one: the transmission is one event on this device and the reception
+   * one event on each of the other devices. The first packets of a train
+   * are therefore received later than if they had been sent one by one.
+   *
+   * \param packets packets to send
+   * \param dest layer 2 destination address
+   * \param protocolNumber protocol number
+   * \return the number of packets, counted from the first one, which
+   *         were queued
+   */
+  virtual uint32_t SendBatch (const std::vector<Ptr<Packet> > &packets, const Address& dest,
+                              uint16_t protocolNumber);
+
   /**
    * Get the node to which this device is attached.
    *
@@ -308,6 +342,14 @@ public:
    */
   virtual void SetReceiveCallback (NetDevice::ReceiveCallback cb);
 
+  /**
+   * Set the callback to be used to notify higher layers when a train of
+   * packets has been received.
+   *
+   * \param cb The callback.
+   */
+  virtual void SetReceiveBatchCallback (NetDevice::ReceiveBatchCallback cb);
+
   /**
    * \brief Get the MAC multicast address corresponding
    * to the IPv6 address provided.
@@ -435,6 +477,32 @@ private:
    */
   void TransmitAbort (void);
 
+  /**
+   * Dequeue the next packet, or the next train of packets queued by
+   * SendBatch, and start transmitting it.
+   */
+  void TransmitNext (void);
+
+  /**
+   * Fire a trace for the packet being transmitted, or for each packet of
+   * the train being transmitted.
+   *
+   * \param trace the trace to fire
+   */
+  void TraceCurrent (TracedCallback<Ptr<const Packet> > &trace);
+
+  /**
+   * Run a packet received from the channel through the receive traces,
+   * the error model and the promiscuous callback, and remove its headers.
+   *
+   * \param packet the received packet
+   * \param sender the CsmaNetDevice that transmitted the packet
+   * \param [out] protocol the protocol of the packet
+   * \param [out] source the source address of the packet
+   * \returns true if the packet must be forwarded up the stack
+   */
+  bool DoReceive (Ptr<Packet> packet, Ptr<CsmaNetDevice> sender, uint16_t &protocol, Mac48Address &source);
+
   /**
    * Notify any interested parties that the link has come up.
    */
@@ -509,6 +577,19 @@ private:
    */
   Ptr<Packet> m_currentPkt;
 
+  /**
+   * Train that will be transmitted, or is being transmitted, if the
+   * current transmission is a train. Its first packet is m_currentPkt.
+   */
+  std::vector<Ptr<Packet> > m_currentTrain;
+
+  /**
+   * The sizes of the trains waiting in the queue, in order. It is only
+   * used while trains are queued, and then counts single packets as
+   * trains of one packet.
+   */
+  std::deque<uint32_t> m_txTrains;
+
   /**
    * The CsmaChannel to which this CsmaNetDevice has been
    * attached.
@@ -686,6 +767,11 @@ private:
    */
   NetDevice::ReceiveCallback m_rxCallback;
 
+  /**
+   * The callback used to notify higher layers that a train of packets has been received.
+   */
+  NetDevice::ReceiveBatchCallback m_rxBatchCallback;
+
   /**
    * The callback used to notify higher layers that a packet has been received in promiscuous mode.
    */
@@ -384,30 +384,33 @@ Ipv4Header::Serialize (Buffer::Iterator start) const
 {
   NS_LOG_FUNCTION (this << &start);
   Buffer::Iterator i = start;
-
-  uint8_t verIhl = (4 << 4) | (5);
-  i.WriteU8 (verIhl);
-  i.WriteU8 (m_tos);
-  i.WriteHtonU16 (m_payloadSize + 5*4);
-  i.WriteHtonU16 (m_identification);
-  uint32_t fragmentOffset = m_fragmentOffset / 8;
-  uint8_t flagsFrag = (fragmentOffset >> 8) & 0x1f;
-  if (m_flags & DONT_FRAGMENT) 
-    {
-      flagsFrag |= (1<<6);
-    }
-  if (m_flags & MORE_FRAGMENTS) 
-    {
-      flagsFrag |= (1<<5);
-    }
-  i.WriteU8 (flagsFrag);
-  uint8_t frag = fragmentOffset & 0xff;
-  i.WriteU8 (frag);
-  i.WriteU8 (m_ttl);
-  i.WriteU8 (m_protocol);
-  i.WriteHtonU16 (0);
-  i.WriteHtonU32 (m_source.Get ());
-  i.WriteHtonU32 (m_destination.Get ());
+  {
+    Buffer::WriteSpan span (i, 20);
+
+    uint8_t verIhl = (4 << 4) | (5);
+    span.WriteU8 (verIhl);
+    span.WriteU8 (m_tos);
+    span.WriteHtonU16 (m_payloadSize + 5*4);
+    span.WriteHtonU16 (m_identification);
+    uint32_t fragmentOffset = m_fragmentOffset / 8;
+    uint8_t flagsFrag = (fragmentOffset >> 8) & 0x1f;
+    if (m_flags & DONT_FRAGMENT) 
+      {
+        flagsFrag |= (1<<6);
+      }
+    if (m_flags & MORE_FRAGMENTS) 
+      {
+        flagsFrag |= (1<<5);
+      }
+    span.WriteU8 (flagsFrag);
+    uint8_t frag = fragmentOffset & 0xff;
+    span.WriteU8 (frag);
+    span.WriteU8 (m_ttl);
+    span.WriteU8 (m_protocol);
+    span.WriteHtonU16 (0);
+    span.WriteHtonU32 (m_source.Get ());
+    span.WriteHtonU32 (m_destination.Get ());
+  }
 
   if (m_calcChecksum) 
     {
@@ -424,15 +427,16 @@ Ipv4Header::Deserialize (Buffer::Iterator start)
 {
   NS_LOG_FUNCTION (this << &start);
   Buffer::Iterator i = start;
-  uint8_t verIhl = i.ReadU8 ();
+  Buffer::ReadSpan span (i, 20);
+  uint8_t verIhl = span.ReadU8 ();
   uint8_t ihl = verIhl & 0x0f; 
   uint16_t headerSize = ihl * 4;
   NS_ASSERT ((verIhl >> 4) == 4);
-  m_tos = i.ReadU8 ();
-  uint16_t size = i.ReadNtohU16 ();
+  m_tos = span.ReadU8 ();
+  uint16_t size = span.ReadNtohU16 ();
   m_payloadSize = size - headerSize;
-  m_identification = i.ReadNtohU16 ();
-  uint8_t flags = i.ReadU8 ();
+  m_identification = span.ReadNtohU16 ();
+  uint8_t flags = span.ReadU8 ();
   m_flags = 0;
   if (flags & (1<<6)) 
     {
@@ -442,17 +446,15 @@ Ipv4Header::Deserialize (Buffer::Iterator start)
     {
       m_flags |= MORE_FRAGMENTS;
     }
-  i.Prev ();
-  m_fragmentOffset = i.ReadU8 () & 0x1f;
+  m_fragmentOffset = flags & 0x1f;
   m_fragmentOffset <<= 8;
-  m_fragmentOffset |= i.ReadU8 ();
+  m_fragmentOffset |= span.ReadU8 ();
   m_fragmentOffset <<= 3;
-  m_ttl = i.ReadU8 ();
-  m_protocol = i.ReadU8 ();
-  m_checksum = i.ReadU16 ();
-  /* i.Next (2); // checksum */
-  m_source.Set (i.ReadNtohU32 ());
-  m_destination.Set (i.ReadNtohU32 ());
+  m_ttl = span.ReadU8 ();
+  m_protocol = span.ReadU8 ();
+  m_checksum = span.ReadU16 ();
+  m_source.Set (span.ReadNtohU32 ());
+  m_destination.Set (span.ReadNtohU32 ());
   m_headerSize = headerSize;
 
   if (m_calcChecksum) 
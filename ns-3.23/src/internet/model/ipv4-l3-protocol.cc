@@ -280,7 +280,8 @@ Ipv4L3Protocol::SetupLoopback (void)
   interface->AddAddress (ifaceAddr);
   uint32_t index = AddIpv4Interface (interface);
   Ptr<Node> node = GetObject<Node> ();
-  node->RegisterProtocolHandler (MakeCallback (&Ipv4L3Protocol::Receive, this), 
+  node->RegisterProtocolHandler (MakeCallback (&Ipv4L3Protocol::Receive, this),
+                                 MakeCallback (&Ipv4L3Protocol::ReceiveBatch, this),
                                  Ipv4L3Protocol::PROT_NUMBER, device);
   interface->SetUp ();
   if (m_routingProtocol != 0)
@@ -302,7 +303,8 @@ Ipv4L3Protocol::AddInterface (Ptr<NetDevice> device)
   NS_LOG_FUNCTION (this << device);
 
   Ptr<Node> node = GetObject<Node> ();
-  node->RegisterProtocolHandler (MakeCallback (&Ipv4L3Protocol::Receive, this), 
+  node->RegisterProtocolHandler (MakeCallback (&Ipv4L3Protocol::Receive, this),
+                                 MakeCallback (&Ipv4L3Protocol::ReceiveBatch, this),
                                  Ipv4L3Protocol::PROT_NUMBER, device);
   node->RegisterProtocolHandler (MakeCallback (&ArpL3Protocol::Receive, PeekPointer (GetObject<ArpL3Protocol> ())),
                                  ArpL3Protocol::PROT_NUMBER, device);
@@ -478,8 +480,34 @@ Ipv4L3Protocol::Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t p
                 m_node->GetId ());
 
   uint32_t interface = 0;
-  Ptr<Packet> packet = p->Copy ();
+  Ptr<Ipv4Interface> ipv4Interface = GetReceiveInterface (device, interface);
+  ReceiveOnInterface (device, p->Copy (), ipv4Interface, interface);
+}
+
+void
+Ipv4L3Protocol::ReceiveBatch (Ptr<NetDevice> device, const std::vector<Ptr<const Packet> > &packets,
+                              uint16_t protocol, const Address &from,
+                              const Address &to, NetDevice::PacketType packetType)
+{
+  NS_LOG_FUNCTION (this << device << packets.size () << protocol << from << to << packetType);
+
+  NS_LOG_LOGIC (packets.size () << " packets from " << from << " received on node " <<
+                m_node->GetId ());
+
+  uint32_t interface = 0;
+  Ptr<Ipv4Interface> ipv4Interface = GetReceiveInterface (device, interface);
+  for (std::vector<Ptr<const Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+    {
+      ReceiveOnInterface (device, (*i)->Copy (), ipv4Interface, interface);
+    }
+}
+
+Ptr<Ipv4Interface>
+Ipv4L3Protocol::GetReceiveInterface (Ptr<NetDevice> device, uint32_t &interface) const
+{
+  NS_LOG_FUNCTION (this << device);
 
+  interface = 0;
   Ptr<Ipv4Interface> ipv4Interface;
   for (Ipv4InterfaceList::const_iterator i = m_interfaces.begin (); 
        i != m_interfaces.end (); 
@@ -488,19 +516,31 @@ Ipv4L3Protocol::Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t p
       ipv4Interface = *i;
       if (ipv4Interface->GetDevice () == device)
         {
-          if (ipv4Interface->IsUp ())
-            {
-              m_rxTrace (packet, m_node->GetObject<Ipv4> (), interface);
-              break;
-            }
-          else
-            {
-              NS_LOG_LOGIC ("Dropping received packet -- interface is down");
-              Ipv4Header ipHeader;
-              packet->RemoveHeader (ipHeader);
-              m_dropTrace (ipHeader, packet, DROP_INTERFACE_DOWN, m_node->GetObject<Ipv4> (), interface);
-              return;
-            }
+          break;
+        }
+    }
+  return ipv4Interface;
+}
+
+void
+Ipv4L3Protocol::ReceiveOnInterface (Ptr<NetDevice> device, Ptr<Packet> packet,
+                                    Ptr<Ipv4Interface> ipv4Interface, uint32_t interface)
+{
+  NS_LOG_FUNCTION (this << device << packet << ipv4Interface << interface);
+
+  if (interface < m_interfaces.size ())
+    {
+      if (ipv4Interface->IsUp ())
+        {
+          m_rxTrace (packet, m_node->GetObject<Ipv4> (), interface);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("Dropping received packet -- interface is down");
+          Ipv4Header ipHeader;
+          packet->RemoveHeader (ipHeader);
+          m_dropTrace (ipHeader, packet, DROP_INTERFACE_DOWN, m_node->GetObject<Ipv4> (), interface);
+          return;
         }
     }
 
@@ -169,6 +169,22 @@ public:
   void Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from,
                  const Address &to, NetDevice::PacketType packetType);
 
+  /**
+   * Lower layer calls this method for a train of packets received on the
+   * same device from the same sender. The packets are processed in order
+   * as with Receive, but the receiving interface is only looked up once.
+   *
+   * \param device network device
+   * \param packets the packets
+   * \param protocol protocol value
+   * \param from address of the correspondant
+   * \param to address of the destination
+   * \param packetType type of the packets
+   */
+  void ReceiveBatch (Ptr<NetDevice> device, const std::vector<Ptr<const Packet> > &packets,
+                     uint16_t protocol, const Address &from,
+                     const Address &to, NetDevice::PacketType packetType);
+
   /**
    * \param packet packet to send
    * \param source source address of packet
@@ -366,6 +382,25 @@ private:
    */
   void LocalDeliver (Ptr<const Packet> p, Ipv4Header const&ip, uint32_t iif);
 
+  /**
+   * \brief Find the interface of a device.
+   * \param device the device
+   * \param [out] interface the index of the interface, or the number of
+   *        interfaces if the device has none
+   * \returns the interface, or the last interface if the device has none
+   */
+  Ptr<Ipv4Interface> GetReceiveInterface (Ptr<NetDevice> device, uint32_t &interface) const;
+
+  /**
+   * \brief Process a packet received on an interface.
+   * \param device the receiving device
+   * \param packet the packet, which is modified
+   * \param ipv4Interface the interface, as returned by GetReceiveInterface
+   * \param interface the index of the interface
+   */
+  void ReceiveOnInterface (Ptr<NetDevice> device, Ptr<Packet> packet,
+                           Ptr<Ipv4Interface> ipv4Interface, uint32_t interface);
+
   /**
    * \brief Fallback when no route is found.
    * \param p packet
@@ -149,37 +149,39 @@ uint32_t Ipv6Header::GetSerializedSize () const
 void Ipv6Header::Serialize (Buffer::Iterator start) const
 {
   Buffer::Iterator i = start;
+  Buffer::WriteSpan span (i, 40);
   uint32_t vTcFl = 0; /* version, Traffic Class and Flow Label fields */
 
   vTcFl= (6 << 28) | (m_trafficClass << 20) | (m_flowLabel);
 
-  i.WriteHtonU32 (vTcFl);
-  i.WriteHtonU16 (m_payloadLength);
-  i.WriteU8 (m_nextHeader);
-  i.WriteU8 (m_hopLimit);
+  span.WriteHtonU32 (vTcFl);
+  span.WriteHtonU16 (m_payloadLength);
+  span.WriteU8 (m_nextHeader);
+  span.WriteU8 (m_hopLimit);
 
-  WriteTo (i, m_sourceAddress);
-  WriteTo (i, m_destinationAddress);
+  WriteTo (span, m_sourceAddress);
+  WriteTo (span, m_destinationAddress);
 }
 
 uint32_t Ipv6Header::Deserialize (Buffer::Iterator start)
 {
   Buffer::Iterator i = start;
+  Buffer::ReadSpan span (i, 40);
   uint32_t vTcFl = 0;
 
-  vTcFl = i.ReadNtohU32 ();
+  vTcFl = span.ReadNtohU32 ();
   m_version = vTcFl >> 28;
 
   NS_ASSERT ((m_version) == 6);
 
   m_trafficClass = (uint8_t)((vTcFl >> 20) & 0x000000ff);
   m_flowLabel = vTcFl & 0xfff00000;
-  m_payloadLength = i.ReadNtohU16 ();
-  m_nextHeader = i.ReadU8 ();
-  m_hopLimit = i.ReadU8 ();
+  m_payloadLength = span.ReadNtohU16 ();
+  m_nextHeader = span.ReadU8 ();
+  m_hopLimit = span.ReadU8 ();
 
-  ReadFrom (i, m_sourceAddress);
-  ReadFrom (i, m_destinationAddress);
+  ReadFrom (span, m_sourceAddress);
+  ReadFrom (span, m_destinationAddress);
 
   return GetSerializedSize ();
 }
@@ -184,22 +184,24 @@ void
 UdpHeader::Serialize (Buffer::Iterator start) const
 {
   Buffer::Iterator i = start;
-
-  i.WriteHtonU16 (m_sourcePort);
-  i.WriteHtonU16 (m_destinationPort);
-  if (m_payloadSize == 0)
-    {
-      i.WriteHtonU16 (start.GetSize ());
-    }
-  else
-    {
-      i.WriteHtonU16 (m_payloadSize);
-    }
+  {
+    Buffer::WriteSpan span (i, 8);
+
+    span.WriteHtonU16 (m_sourcePort);
+    span.WriteHtonU16 (m_destinationPort);
+    if (m_payloadSize == 0)
+      {
+        span.WriteHtonU16 (start.GetSize ());
+      }
+    else
+      {
+        span.WriteHtonU16 (m_payloadSize);
+      }
+    span.WriteU16 (m_checksum);
+  }
 
   if ( m_checksum == 0)
     {
-      i.WriteU16 (0);
-
       if (m_calcChecksum)
         {
           uint16_t headerChecksum = CalculateHeaderChecksum (start.GetSize ());
@@ -211,19 +213,18 @@ UdpHeader::Serialize (Buffer::Iterator start) const
           i.WriteU16 (checksum);
         }
     }
-  else
-    {
-      i.WriteU16 (m_checksum);
-    }
 }
 uint32_t
 UdpHeader::Deserialize (Buffer::Iterator start)
 {
   Buffer::Iterator i = start;
-  m_sourcePort = i.ReadNtohU16 ();
-  m_destinationPort = i.ReadNtohU16 ();
-  m_payloadSize = i.ReadNtohU16 () - GetSerializedSize ();
-  m_checksum = i.ReadU16 ();
+  {
+    Buffer::ReadSpan span (i, 8);
+    m_sourcePort = span.ReadNtohU16 ();
+    m_destinationPort = span.ReadNtohU16 ();
+    m_payloadSize = span.ReadNtohU16 () - GetSerializedSize ();
+    m_checksum = span.ReadU16 ();
+  }
 
   if (m_calcChecksum)
     {
@@ -0,0 +1,785 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "topology-partitioner.h"
+
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/net-device.h"
+#include "ns3/channel.h"
+#include "ns3/channel-list.h"
+#include "ns3/data-rate.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "ns3/abort.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <set>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TopologyPartitioner");
+
+namespace {
+
+/** Marks an unassigned vertex. */
+const uint32_t NONE = 0xffffffff;
+/** Graphs of at most this size are bisected directly. */
+const uint32_t COARSEST_SIZE = 32;
+/**
+ * Coarsening stops at the first level which removes less than this
+ * fraction of the vertices.
+ */
+const double MIN_SHRINK = 0.1;
+/** Maximum number of refinement passes per level. */
+const uint32_t MAX_PASSES = 8;
+/** Moves without improvement before a refinement pass gives up. */
+const uint32_t MAX_FRUITLESS_MOVES = 64;
+
+/** A link between two nodes. */
+struct Link
+{
+  uint32_t a;          //!< Index of the first node.
+  uint32_t b;          //!< Index of the second node.
+  uint64_t delay;      //!< Delay of the link, in time steps.
+  double traffic;      //!< Expected traffic.
+};
+
+/** An undirected graph with weighted vertices and edges. */
+struct Graph
+{
+  std::vector<double> weights;                   //!< Vertex weights.
+  std::vector<std::map<uint32_t, double> > adj;  //!< Edge weights, in both directions.
+
+  /** \returns The number of vertices. */
+  uint32_t GetN (void) const
+  {
+    return weights.size ();
+  }
+  /** \returns The sum of the vertex weights. */
+  double GetTotal (void) const
+  {
+    double total = 0;
+    for (uint32_t i = 0; i < weights.size (); i++)
+      {
+        total += weights[i];
+      }
+    return total;
+  }
+  /**
+   * Add the weight of an edge.
+   * \param [in] a A vertex.
+   * \param [in] b Another vertex.
+   * \param [in] w The edge weight.
+   */
+  void AddEdge (uint32_t a, uint32_t b, double w)
+  {
+    if (a != b)
+      {
+        adj[a][b] += w;
+        adj[b][a] += w;
+      }
+  }
+};
+
+/** Disjoint sets of node indexes. */
+class UnionFind
+{
+public:
+  /** \param [in] n The number of elements. */
+  UnionFind (uint32_t n)
+    : m_parent (n)
+  {
+    for (uint32_t i = 0; i < n; i++)
+      {
+        m_parent[i] = i;
+      }
+  }
+  /**
+   * \param [in] i An element.
+   * \returns The representative of the set of i.
+   */
+  uint32_t Find (uint32_t i)
+  {
+    while (m_parent[i] != i)
+      {
+        m_parent[i] = m_parent[m_parent[i]];
+        i = m_parent[i];
+      }
+    return i;
+  }
+  /**
+   * Merge the sets of two elements.
+   * \param [in] a An element.
+   * \param [in] b Another element.
+   */
+  void Union (uint32_t a, uint32_t b)
+  {
+    a = Find (a);
+    b = Find (b);
+    if (a < b)
+      {
+        m_parent[b] = a;
+      }
+    else if (b < a)
+      {
+        m_parent[a] = b;
+      }
+  }
+private:
+  std::vector<uint32_t> m_parent;  //!< Parent of each element.
+};
+
+/**
+ * Merge vertices pairwise along their heaviest edges.
+ * \param [in] g The graph to coarsen.
+ * \param [out] map The coarse vertex of each vertex of g.
+ * \param [in] maxWeight Vertices heavier than this are not created.
+ * \returns The coarse graph.
+ */
+Graph
+Coarsen (const Graph &g, std::vector<uint32_t> &map, double maxWeight)
+{
+  uint32_t n = g.GetN ();
+  // visit the vertices with few neighbors first, so that they find a match
+  std::vector<std::pair<uint32_t, uint32_t> > order;
+  for (uint32_t v = 0; v < n; v++)
+    {
+      order.push_back (std::make_pair (g.adj[v].size (), v));
+    }
+  std::sort (order.begin (), order.end ());
+  std::vector<uint32_t> match (n, NONE);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t v = order[i].second;
+      if (match[v] != NONE)
+        {
+          continue;
+        }
+      uint32_t best = v;
+      double bestWeight = 0;
+      for (std::map<uint32_t, double>::const_iterator j = g.adj[v].begin (); j != g.adj[v].end (); ++j)
+        {
+          uint32_t u = j->first;
+          if (match[u] == NONE && j->second > bestWeight
+              && g.weights[u] + g.weights[v] <= maxWeight)
+            {
+              best = u;
+              bestWeight = j->second;
+            }
+        }
+      match[v] = best;
+      match[best] = v;
+    }
+
+  map.assign (n, NONE);
+  Graph coarse;
+  for (uint32_t v = 0; v < n; v++)
+    {
+      if (map[v] == NONE)
+        {
+          map[v] = coarse.GetN ();
+          map[match[v]] = coarse.GetN ();
+          coarse.weights.push_back (g.weights[v] + (match[v] != v ? g.weights[match[v]] : 0));
+        }
+    }
+  coarse.adj.resize (coarse.GetN ());
+  for (uint32_t v = 0; v < n; v++)
+    {
+      for (std::map<uint32_t, double>::const_iterator j = g.adj[v].begin (); j != g.adj[v].end (); ++j)
+        {
+          if (map[v] != map[j->first])
+            {
+              coarse.adj[map[v]][map[j->first]] += j->second;
+            }
+        }
+    }
+  return coarse;
+}
+
+/**
+ * \param [in] g A graph.
+ * \param [in] side The side of each vertex.
+ * \returns The weight of the edges between the two sides.
+ */
+double
+GetCut (const Graph &g, const std::vector<uint8_t> &side)
+{
+  double cut = 0;
+  for (uint32_t v = 0; v < g.GetN (); v++)
+    {
+      for (std::map<uint32_t, double>::const_iterator j = g.adj[v].begin (); j != g.adj[v].end (); ++j)
+        {
+          if (side[v] != side[j->first])
+            {
+              cut += j->second;
+            }
+        }
+    }
+  return cut / 2;
+}
+
+/**
+ * Compare two states of a bisection: balanced states first, then the
+ * smallest imbalance, then the largest gain.
+ */
+bool
+IsBetter (double imbalance, double gain, double bestImbalance, double bestGain, double slack)
+{
+  bool balanced = imbalance <= slack;
+  bool bestBalanced = bestImbalance <= slack;
+  if (balanced != bestBalanced)
+    {
+      return balanced;
+    }
+  if (!balanced)
+    {
+      return imbalance < bestImbalance;
+    }
+  return gain > bestGain + 1e-9;
+}
+
+/**
+ * Improve a bisection with Fiduccia-Mattheyses passes. Side 0 should
+ * weigh target, give or take slack.
+ */
+void
+Refine (const Graph &g, std::vector<uint8_t> &side, double target, double slack)
+{
+  uint32_t n = g.GetN ();
+  double weight0 = 0;
+  for (uint32_t v = 0; v < n; v++)
+    {
+      if (side[v] == 0)
+        {
+          weight0 += g.weights[v];
+        }
+    }
+  for (uint32_t pass = 0; pass < MAX_PASSES; pass++)
+    {
+      std::vector<double> gain (n, 0);
+      std::set<std::pair<double, uint32_t> > queue;
+      for (uint32_t v = 0; v < n; v++)
+        {
+          for (std::map<uint32_t, double>::const_iterator j = g.adj[v].begin (); j != g.adj[v].end (); ++j)
+            {
+              gain[v] += side[v] != side[j->first] ? j->second : -j->second;
+            }
+          queue.insert (std::make_pair (-gain[v], v));
+        }
+      std::vector<bool> locked (n, false);
+      std::vector<uint32_t> moves;
+      double total = 0;
+      double bestGain = 0;
+      double bestImbalance = std::fabs (weight0 - target);
+      uint32_t bestMoves = 0;
+      while (!queue.empty () && moves.size () - bestMoves < MAX_FRUITLESS_MOVES)
+        {
+          // best gain first, among the moves which do not break the balance
+          uint32_t v = NONE;
+          double imbalance = 0;
+          double current = std::fabs (weight0 - target);
+          for (std::set<std::pair<double, uint32_t> >::const_iterator i = queue.begin (); i != queue.end (); ++i)
+            {
+              uint32_t u = i->second;
+              double w = side[u] == 0 ? weight0 - g.weights[u] : weight0 + g.weights[u];
+              imbalance = std::fabs (w - target);
+              if (imbalance <= slack || imbalance < current)
+                {
+                  v = u;
+                  break;
+                }
+            }
+          if (v == NONE)
+            {
+              break;
+            }
+          queue.erase (std::make_pair (-gain[v], v));
+          locked[v] = true;
+          weight0 += side[v] == 0 ? -g.weights[v] : g.weights[v];
+          side[v] = 1 - side[v];
+          total += gain[v];
+          moves.push_back (v);
+          for (std::map<uint32_t, double>::const_iterator j = g.adj[v].begin (); j != g.adj[v].end (); ++j)
+            {
+              uint32_t u = j->first;
+              if (locked[u])
+                {
+                  continue;
+                }
+              queue.erase (std::make_pair (-gain[u], u));
+              gain[u] += side[u] == side[v] ? -2 * j->second : 2 * j->second;
+              queue.insert (std::make_pair (-gain[u], u));
+            }
+          if (IsBetter (imbalance, total, bestImbalance, bestGain, slack))
+            {
+              bestGain = total;
+              bestImbalance = imbalance;
+              bestMoves = moves.size ();
+            }
+        }
+      // roll back the moves after the best state
+      while (moves.size () > bestMoves)
+        {
+          uint32_t v = moves.back ();
+          moves.pop_back ();
+          weight0 += side[v] == 0 ? -g.weights[v] : g.weights[v];
+          side[v] = 1 - side[v];
+        }
+      if (bestMoves == 0)
+        {
+          break;
+        }
+    }
+}
+
+/**
+ * Bisect a small graph by growing side 0 from a few seed vertices.
+ */
+std::vector<uint8_t>
+GrowBisection (const Graph &g, double target, double slack)
+{
+  uint32_t n = g.GetN ();
+  std::vector<uint8_t> best;
+  double bestCut = 0;
+  double bestImbalance = 0;
+  std::set<uint32_t> seeds;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      seeds.insert (i * n / 4);
+    }
+  for (std::set<uint32_t>::const_iterator s = seeds.begin (); s != seeds.end (); ++s)
+    {
+      std::vector<uint8_t> side (n, 1);
+      std::vector<double> connection (n, 0);
+      // the vertices of side 1 which are connected to side 0
+      std::set<std::pair<double, uint32_t> > frontier;
+      uint32_t unconnected = 0;
+      double weight0 = 0;
+      uint32_t next = *s;
+      while (next != NONE && std::fabs (weight0 + g.weights[next] - target) < std::fabs (weight0 - target))
+        {
+          side[next] = 0;
+          weight0 += g.weights[next];
+          frontier.erase (std::make_pair (-connection[next], next));
+          for (std::map<uint32_t, double>::const_iterator j = g.adj[next].begin (); j != g.adj[next].end (); ++j)
+            {
+              uint32_t u = j->first;
+              if (side[u] == 1)
+                {
+                  frontier.erase (std::make_pair (-connection[u], u));
+                  connection[u] += j->second;
+                  frontier.insert (std::make_pair (-connection[u], u));
+                }
+            }
+          // the most connected vertex, or any vertex if the graph is not connected
+          if (!frontier.empty ())
+            {
+              next = frontier.begin ()->second;
+              continue;
+            }
+          while (unconnected < n && side[unconnected] == 0)
+            {
+              unconnected++;
+            }
+          next = unconnected < n ? unconnected : NONE;
+        }
+      Refine (g, side, target, slack);
+      double w = 0;
+      for (uint32_t v = 0; v < n; v++)
+        {
+          w += side[v] == 0 ? g.weights[v] : 0;
+        }
+      double cut = GetCut (g, side);
+      double imbalance = std::fabs (w - target);
+      if (best.empty () || IsBetter (imbalance, -cut, bestImbalance, -bestCut, slack))
+        {
+          best = side;
+          bestCut = cut;
+          bestImbalance = imbalance;
+        }
+    }
+  return best;
+}
+
+/**
+ * Multilevel bisection.
+ * \returns The side of each vertex: side 0 weighs about target.
+ */
+std::vector<uint8_t>
+Bisect (const Graph &g, double target, double slack)
+{
+  if (g.GetN () > COARSEST_SIZE)
+    {
+      std::vector<uint32_t> map;
+      Graph coarse = Coarsen (g, map, std::max (slack, g.GetTotal () / COARSEST_SIZE));
+      if (coarse.GetN () < g.GetN ())
+        {
+          // Coarsening stalls on stars, whose hub only absorbs one leaf
+          // per level: then bisect the last level directly rather than
+          // run one level per leaf.
+          std::vector<uint8_t> coarseSide = coarse.GetN () < g.GetN () * (1 - MIN_SHRINK)
+            ? Bisect (coarse, target, slack) : GrowBisection (coarse, target, slack);
+          std::vector<uint8_t> side (g.GetN ());
+          for (uint32_t v = 0; v < g.GetN (); v++)
+            {
+              side[v] = coarseSide[map[v]];
+            }
+          Refine (g, side, target, slack);
+          return side;
+        }
+    }
+  return GrowBisection (g, target, slack);
+}
+
+/**
+ * \param [in] g A graph.
+ * \param [in] vertices The vertices to keep.
+ * \returns The subgraph induced by the vertices.
+ */
+Graph
+Extract (const Graph &g, const std::vector<uint32_t> &vertices)
+{
+  std::vector<uint32_t> index (g.GetN (), NONE);
+  Graph sub;
+  for (uint32_t i = 0; i < vertices.size (); i++)
+    {
+      index[vertices[i]] = i;
+      sub.weights.push_back (g.weights[vertices[i]]);
+    }
+  sub.adj.resize (vertices.size ());
+  for (uint32_t i = 0; i < vertices.size (); i++)
+    {
+      const std::map<uint32_t, double> &adj = g.adj[vertices[i]];
+      for (std::map<uint32_t, double>::const_iterator j = adj.begin (); j != adj.end (); ++j)
+        {
+          if (index[j->first] != NONE)
+            {
+              sub.adj[i][index[j->first]] = j->second;
+            }
+        }
+    }
+  return sub;
+}
+
+/**
+ * Split a graph into k parts by recursive bisection.
+ *
+ * The imbalance allowed to the final parts is spread over the levels of
+ * the recursion: each bisection may use its share of it, and the
+ * imbalance actually reached is charged to the next levels, so that
+ * the parts never exceed (1 + imbalance) times the average.
+ *
+ * \param [in] g The graph.
+ * \param [in] k The number of parts.
+ * \param [in] first The number of the first part.
+ * \param [in] imbalance The allowed imbalance.
+ * \param [out] parts The part of each vertex of g.
+ */
+void
+Split (const Graph &g, uint32_t k, uint32_t first, double imbalance, std::vector<uint32_t> &parts)
+{
+  parts.assign (g.GetN (), first);
+  if (k == 1 || g.GetN () == 0)
+    {
+      return;
+    }
+  uint32_t k0 = k / 2;
+  uint32_t counts[2] = { k0, k - k0 };
+  uint32_t firsts[2] = { first, first + k0 };
+  uint32_t levels = 0;
+  while ((1U << levels) < k)
+    {
+      levels++;
+    }
+  double total = g.GetTotal ();
+  double maxPart = (1 + imbalance) * total / k;
+  double factor = std::pow (1 + imbalance, 1.0 / levels);
+  double slack = (factor - 1) * total * k0 / k;
+  std::vector<uint8_t> side = Bisect (g, total * k0 / k, slack);
+  std::vector<uint32_t> vertices[2];
+  double weights[2] = { 0, 0 };
+  for (uint32_t v = 0; v < g.GetN (); v++)
+    {
+      vertices[side[v]].push_back (v);
+      weights[side[v]] += g.weights[v];
+    }
+  for (uint32_t s = 0; s < 2; s++)
+    {
+      double subImbalance = imbalance;
+      if (weights[s] > 0)
+        {
+          subImbalance = std::max (0.0, maxPart * counts[s] / weights[s] - 1);
+        }
+      std::vector<uint32_t> subParts;
+      Split (Extract (g, vertices[s]), counts[s], firsts[s], subImbalance, subParts);
+      for (uint32_t i = 0; i < vertices[s].size (); i++)
+        {
+          parts[vertices[s][i]] = subParts[i];
+        }
+    }
+}
+
+} // anonymous namespace
+
+TopologyPartitioner::TopologyPartitioner ()
+  : m_imbalance (0.05),
+    m_lookahead (Simulator::GetMaximumSimulationTime ()),
+    m_cutTraffic (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TopologyPartitioner::SetImbalance (double imbalance)
+{
+  NS_LOG_FUNCTION (this << imbalance);
+  m_imbalance = imbalance;
+}
+
+void
+TopologyPartitioner::SetNodeWeight (Ptr<Node> node, double weight)
+{
+  NS_LOG_FUNCTION (this << node << weight);
+  m_nodeWeights[node->GetId ()] = weight;
+}
+
+void
+TopologyPartitioner::SetChannelTraffic (Ptr<Channel> channel, double traffic)
+{
+  NS_LOG_FUNCTION (this << channel << traffic);
+  m_channelTraffic[channel->GetId ()] = traffic;
+}
+
+std::vector<uint32_t>
+TopologyPartitioner::Partition (uint32_t nPartitions)
+{
+  NS_LOG_FUNCTION (this << nPartitions);
+  NS_ABORT_MSG_IF (nPartitions == 0, "At least one partition is needed");
+  uint32_t n = NodeList::GetNNodes ();
+  std::vector<double> weights (n, 1);
+  for (std::map<uint32_t, double>::const_iterator i = m_nodeWeights.begin (); i != m_nodeWeights.end (); ++i)
+    {
+      weights[i->first] = i->second;
+    }
+
+  // the nodes of shared medium channels stay together, the other links
+  // may be cut.
+  UnionFind shared (n);
+  std::vector<Link> links;
+  for (ChannelList::Iterator i = ChannelList::Begin (); i != ChannelList::End (); ++i)
+    {
+      Ptr<Channel> channel = *i;
+      std::vector<uint32_t> nodes;
+      bool pointToPoint = true;
+      for (uint32_t j = 0; j < channel->GetNDevices (); j++)
+        {
+          Ptr<NetDevice> device = channel->GetDevice (j);
+          if (device == 0 || device->GetNode () == 0)
+            {
+              continue;
+            }
+          nodes.push_back (device->GetNode ()->GetId ());
+          pointToPoint = pointToPoint && device->IsPointToPoint ();
+        }
+      if (nodes.size () < 2)
+        {
+          continue;
+        }
+      TimeValue delay;
+      if (!pointToPoint || nodes.size () != 2
+          || !channel->GetAttributeFailSafe ("Delay", delay)
+          || !delay.Get ().IsStrictlyPositive ())
+        {
+          for (uint32_t j = 1; j < nodes.size (); j++)
+            {
+              shared.Union (nodes[0], nodes[j]);
+            }
+          continue;
+        }
+      Link link;
+      link.a = nodes[0];
+      link.b = nodes[1];
+      link.delay = delay.Get ().GetTimeStep ();
+      link.traffic = 1;
+      std::map<uint32_t, double>::const_iterator traffic = m_channelTraffic.find (channel->GetId ());
+      DataRateValue rate;
+      if (traffic != m_channelTraffic.end ())
+        {
+          link.traffic = traffic->second;
+        }
+      else if (channel->GetDevice (0)->GetAttributeFailSafe ("DataRate", rate)
+               && rate.Get ().GetBitRate () > 0)
+        {
+          link.traffic = rate.Get ().GetBitRate ();
+        }
+      links.push_back (link);
+    }
+
+  // Find the largest lookahead for which the groups of nodes joined by
+  // shorter links can still be balanced.
+  double total = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      total += weights[i];
+    }
+  double maxPartition = (1 + m_imbalance) * total / nPartitions;
+  std::set<uint64_t> delays;
+  for (uint32_t i = 0; i < links.size (); i++)
+    {
+      delays.insert (links[i].delay);
+    }
+  uint64_t threshold = delays.empty () ? 0 : *delays.begin ();
+  for (std::set<uint64_t>::const_reverse_iterator d = delays.rbegin (); d != delays.rend (); ++d)
+    {
+      UnionFind groups = shared;
+      for (uint32_t i = 0; i < links.size (); i++)
+        {
+          if (links[i].delay < *d)
+            {
+              groups.Union (links[i].a, links[i].b);
+            }
+        }
+      std::map<uint32_t, double> groupWeights;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          groupWeights[groups.Find (i)] += weights[i];
+        }
+      double heaviest = 0;
+      for (std::map<uint32_t, double>::const_iterator i = groupWeights.begin (); i != groupWeights.end (); ++i)
+        {
+          heaviest = std::max (heaviest, i->second);
+        }
+      if (groupWeights.size () >= nPartitions && heaviest <= maxPartition)
+        {
+          threshold = *d;
+          break;
+        }
+    }
+  NS_LOG_DEBUG ("lookahead threshold " << TimeStep (threshold));
+
+  // contract the groups and partition the resulting graph
+  UnionFind groups = shared;
+  for (uint32_t i = 0; i < links.size (); i++)
+    {
+      if (links[i].delay < threshold)
+        {
+          groups.Union (links[i].a, links[i].b);
+        }
+    }
+  std::vector<uint32_t> vertexOf (n);
+  std::map<uint32_t, uint32_t> vertexOfGroup;
+  Graph g;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t group = groups.Find (i);
+      std::map<uint32_t, uint32_t>::const_iterator v = vertexOfGroup.find (group);
+      if (v == vertexOfGroup.end ())
+        {
+          v = vertexOfGroup.insert (std::make_pair (group, g.GetN ())).first;
+          g.weights.push_back (0);
+        }
+      vertexOf[i] = v->second;
+      g.weights[v->second] += weights[i];
+    }
+  g.adj.resize (g.GetN ());
+  for (uint32_t i = 0; i < links.size (); i++)
+    {
+      g.AddEdge (vertexOf[links[i].a], vertexOf[links[i].b], links[i].traffic);
+    }
+  std::vector<uint32_t> parts;
+  Split (g, nPartitions, 0, m_imbalance, parts);
+
+  std::vector<uint32_t> assignment (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      assignment[i] = parts[vertexOf[i]];
+    }
+  m_lookahead = Simulator::GetMaximumSimulationTime ();
+  m_cutTraffic = 0;
+  for (uint32_t i = 0; i < links.size (); i++)
+    {
+      if (assignment[links[i].a] != assignment[links[i].b])
+        {
+          m_lookahead = std::min (m_lookahead, TimeStep (links[i].delay));
+          m_cutTraffic += links[i].traffic;
+        }
+    }
+  NS_LOG_DEBUG ("lookahead " << m_lookahead << " cut traffic " << m_cutTraffic);
+  return assignment;
+}
+
+Time
+TopologyPartitioner::GetLookahead (void) const
+{
+  return m_lookahead;
+}
+
+double
+TopologyPartitioner::GetCutTraffic (void) const
+{
+  return m_cutTraffic;
+}
+
+void
+TopologyPartitioner::Apply (const std::vector<uint32_t> &assignment)
+{
+  NS_LOG_FUNCTION (&assignment);
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      uint32_t id = (*i)->GetId ();
+      NS_ABORT_MSG_UNLESS (id < assignment.size (), "No partition for node " << id);
+      (*i)->SetAttribute ("SystemId", UintegerValue (assignment[id]));
+    }
+}
+
+void
+TopologyPartitioner::Write (std::string filename, const std::vector<uint32_t> &assignment)
+{
+  NS_LOG_FUNCTION (filename << &assignment);
+  std::ofstream os (filename.c_str ());
+  NS_ABORT_MSG_UNLESS (os.good (), "Cannot open " << filename);
+  for (uint32_t i = 0; i < assignment.size (); i++)
+    {
+      os << i << " " << assignment[i] << std::endl;
+    }
+}
+
+std::vector<uint32_t>
+TopologyPartitioner::Read (std::string filename)
+{
+  NS_LOG_FUNCTION (filename);
+  std::ifstream is (filename.c_str ());
+  NS_ABORT_MSG_UNLESS (is.good (), "Cannot open " << filename);
+  std::vector<uint32_t> assignment;
+  uint32_t node;
+  uint32_t systemId;
+  while (is >> node >> systemId)
+    {
+      if (node >= assignment.size ())
+        {
+          assignment.resize (node + 1, 0);
+        }
+      assignment[node] = systemId;
+    }
+  return assignment;
+}
+
+} // namespace ns3
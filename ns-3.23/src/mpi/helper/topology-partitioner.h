@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_TOPOLOGY_PARTITIONER_H
+#define NS3_TOPOLOGY_PARTITIONER_H
+
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+class Node;
+class Channel;
+
+/**
+ * \ingroup mpi
+ *
+ * \brief Compute balanced system id assignments for parallel runs.
+ *
+ * The partitioner reads the topology from NodeList and ChannelList: each
+ * node is a vertex and each point-to-point channel an edge, carrying the
+ * Delay of the channel and its expected traffic. The nodes attached to
+ * a shared medium channel (CsmaChannel, wireless channels...) are
+ * always kept in the same partition.
+ *
+ * The partition is computed in two steps:
+ *  - the lookahead is maximized first: all the links shorter than a
+ *    threshold are contracted, and the threshold is the largest link
+ *    delay for which the remaining groups of nodes can still be
+ *    balanced. No link shorter than the resulting lookahead is cut.
+ *  - the contracted graph is then split by multilevel recursive
+ *    bisection, in the style of METIS: the graph is coarsened by heavy
+ *    edge matching, the coarsest graph is bisected by greedy graph
+ *    growing and the bisection is refined with Fiduccia-Mattheyses
+ *    passes while it is projected back to the finer graphs. This
+ *    minimizes the traffic crossing partitions while keeping the node
+ *    weight of each partition within the allowed imbalance.
+ *
+ * The expected traffic of a link defaults to the DataRate attribute of
+ * its first device, if any, and to 1 otherwise. The result is
+ * deterministic.
+ *
+ * The assignment can be applied to the SystemId attribute of the nodes
+ * with Apply, which is what MultithreadedSimulatorImpl uses. For the
+ * MPI simulators, the system ids must be known when the topology is
+ * built: the assignment can be saved with Write and loaded by the
+ * parallel run with Read.
+ */
+class TopologyPartitioner
+{
+public:
+  TopologyPartitioner ();
+
+  /**
+   * \param [in] imbalance The allowed excess of node weight of a
+   *   partition over the average, as a fraction: 0.05 by default.
+   */
+  void SetImbalance (double imbalance);
+  /**
+   * \param [in] node A node.
+   * \param [in] weight The expected load of this node, 1 by default.
+   */
+  void SetNodeWeight (Ptr<Node> node, double weight);
+  /**
+   * \param [in] channel A point-to-point channel.
+   * \param [in] traffic The expected traffic through this channel.
+   */
+  void SetChannelTraffic (Ptr<Channel> channel, double traffic);
+
+  /**
+   * Partition all the nodes of NodeList.
+   *
+   * \param [in] nPartitions The number of partitions.
+   * \returns The partition of each node, indexed by node id.
+   */
+  std::vector<uint32_t> Partition (uint32_t nPartitions);
+
+  /**
+   * \returns The smallest delay of the links cut by the last Partition,
+   *   or the maximum simulation time if no link was cut.
+   */
+  Time GetLookahead (void) const;
+  /**
+   * \returns The total traffic of the links cut by the last Partition.
+   */
+  double GetCutTraffic (void) const;
+
+  /**
+   * Set the SystemId attribute of every node.
+   * \param [in] assignment The partition of each node, indexed by node id.
+   */
+  static void Apply (const std::vector<uint32_t> &assignment);
+  /**
+   * Save an assignment as lines of "node-id system-id".
+   * \param [in] filename The output file.
+   * \param [in] assignment The partition of each node, indexed by node id.
+   */
+  static void Write (std::string filename, const std::vector<uint32_t> &assignment);
+  /**
+   * Load an assignment saved by Write.
+   * \param [in] filename The input file.
+   * \returns The partition of each node, indexed by node id.
+   */
+  static std::vector<uint32_t> Read (std::string filename);
+
+private:
+  double m_imbalance;                            //!< Allowed imbalance.
+  std::map<uint32_t, double> m_nodeWeights;      //!< Node weights, by node id.
+  std::map<uint32_t, double> m_channelTraffic;   //!< Link traffic, by channel id.
+  Time m_lookahead;                              //!< Lookahead of the last partition.
+  double m_cutTraffic;                           //!< Cut traffic of the last partition.
+};
+
+} // namespace ns3
+
+#endif /* NS3_TOPOLOGY_PARTITIONER_H */
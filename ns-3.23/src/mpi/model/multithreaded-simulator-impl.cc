@@ -0,0 +1,698 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/system-thread.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/net-device.h"
+#include "ns3/channel.h"
+#include "ns3/channel-list.h"
+#include "ns3/abort.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <set>
+#include <sched.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+namespace {
+
+/**
+ * Index of the partition run by the calling thread, or -1 if the
+ * thread does not run a partition.
+ */
+__thread int32_t g_partitionIndex = -1;
+
+/** Time stamp larger than any event. */
+const uint64_t INFINITE_TS = 0x7fffffffffffffffULL;
+
+} // anonymous namespace
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Mpi")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("Lookahead",
+                   "The minimum delay of the events sent from a partition "
+                   "to another one. If zero, the smallest delay of the "
+                   "point-to-point channels between nodes of different "
+                   "partitions is used.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&MultithreadedSimulatorImpl::m_lookaheadAttribute),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_running (false),
+    m_stop (false),
+    m_stopTs (INFINITE_TS),
+    m_lookahead (INFINITE_TS),
+    m_uidStride (1),
+    m_windowStop (false),
+    m_windowEnd (0),
+    m_barrierCount (0),
+    m_barrierGeneration (0)
+{
+  NS_LOG_FUNCTION (this);
+  Partition *partition = new Partition ();
+  // uids are allocated from 4.
+  // uid 0 is "invalid" events
+  // uid 1 is "now" events
+  // uid 2 is "destroy" events
+  partition->nextUid = 4;
+  // before ::Run is entered, the currentUid will be zero
+  partition->currentUid = 0;
+  partition->currentTs = 0;
+  partition->currentContext = 0xffffffff;
+  partition->unscheduledEvents = 0;
+  partition->nextTs = INFINITE_TS;
+  m_partitions.push_back (partition);
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      Partition *partition = m_partitions[i];
+      while (partition->events != 0 && !partition->events->IsEmpty ())
+        {
+          Scheduler::Event next = partition->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      for (uint32_t j = 0; j < partition->outbox.size (); j++)
+        {
+          std::vector<RemoteEvent> &outbox = partition->outbox[j];
+          for (std::vector<RemoteEvent>::const_iterator k = outbox.begin (); k != outbox.end (); ++k)
+            {
+              k->event->Unref ();
+            }
+        }
+      delete partition;
+    }
+  m_partitions.clear ();
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  NS_ASSERT_MSG (!m_running, "Cannot change the scheduler while running");
+  m_schedulerFactory = schedulerFactory;
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      Partition *partition = m_partitions[i];
+      if (partition->events != 0)
+        {
+          while (!partition->events->IsEmpty ())
+            {
+              Scheduler::Event next = partition->events->RemoveNext ();
+              scheduler->Insert (next);
+            }
+        }
+      partition->events = scheduler;
+    }
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return g_partitionIndex < 0 ? 0 : g_partitionIndex;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionCount (void) const
+{
+  return m_partitions.size ();
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookahead (void) const
+{
+  return TimeStep (m_lookahead);
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartition (void) const
+{
+  if (g_partitionIndex >= 0)
+    {
+      return m_partitions[g_partitionIndex];
+    }
+  NS_ASSERT_MSG (!m_running, "Simulator invoked from a thread which does not run a partition");
+  return m_partitions[0];
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionOf (uint32_t context, uint32_t current) const
+{
+  if (context < m_partitionOfNode.size ())
+    {
+      return m_partitionOfNode[context];
+    }
+  return current;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = partition->nextUid;
+  partition->nextUid += m_uidStride;
+  partition->unscheduledEvents++;
+  partition->events->Insert (ev);
+  return ev.key.m_uid;
+}
+
+void
+MultithreadedSimulatorImpl::Setup (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_partitionOfNode.clear ();
+  uint32_t nPartitions = 1;
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      if (node->GetId () >= m_partitionOfNode.size ())
+        {
+          m_partitionOfNode.resize (node->GetId () + 1, 0);
+        }
+      m_partitionOfNode[node->GetId ()] = node->GetSystemId ();
+      nPartitions = std::max (nPartitions, node->GetSystemId () + 1);
+    }
+  NS_ASSERT_MSG (nPartitions >= m_partitions.size (), "Partitions cannot be removed");
+  while (m_partitions.size () < nPartitions)
+    {
+      Partition *partition = new Partition ();
+      partition->events = m_schedulerFactory.Create<Scheduler> ();
+      partition->unscheduledEvents = 0;
+      m_partitions.push_back (partition);
+    }
+  for (uint32_t i = 0; i < nPartitions; i++)
+    {
+      m_partitions[i]->outbox.resize (nPartitions);
+    }
+
+  if (m_lookaheadAttribute.IsStrictlyPositive ())
+    {
+      m_lookahead = m_lookaheadAttribute.GetTimeStep ();
+      return;
+    }
+  m_lookahead = INFINITE_TS;
+  for (ChannelList::Iterator i = ChannelList::Begin (); i != ChannelList::End (); ++i)
+    {
+      Ptr<Channel> channel = *i;
+      std::set<uint32_t> partitions;
+      bool pointToPoint = true;
+      for (uint32_t j = 0; j < channel->GetNDevices (); j++)
+        {
+          Ptr<NetDevice> device = channel->GetDevice (j);
+          if (device == 0 || device->GetNode () == 0)
+            {
+              continue;
+            }
+          partitions.insert (device->GetNode ()->GetSystemId ());
+          pointToPoint = pointToPoint && device->IsPointToPoint ();
+        }
+      if (partitions.size () <= 1)
+        {
+          continue;
+        }
+      NS_ABORT_MSG_UNLESS (pointToPoint,
+                           "Channel " << channel->GetId () << " (" << channel->GetInstanceTypeId ().GetName ()
+                           << ") connects several partitions but is not a point-to-point channel: keep it "
+                           "in one partition or set ns3::MultithreadedSimulatorImpl::Lookahead");
+      TimeValue delay;
+      NS_ABORT_MSG_UNLESS (channel->GetAttributeFailSafe ("Delay", delay),
+                           "Channel " << channel->GetId () << " connects several partitions but has no "
+                           "Delay attribute: set ns3::MultithreadedSimulatorImpl::Lookahead");
+      NS_ABORT_MSG_UNLESS (delay.Get ().IsStrictlyPositive (),
+                           "Channel " << channel->GetId () << " connects several partitions with no delay");
+      m_lookahead = std::min (m_lookahead, (uint64_t)delay.Get ().GetTimeStep ());
+    }
+  NS_LOG_DEBUG ("partitions=" << nPartitions << " lookahead=" << m_lookahead);
+}
+
+void
+MultithreadedSimulatorImpl::Scatter (void)
+{
+  NS_LOG_FUNCTION (this);
+  Partition *first = m_partitions[0];
+  // uids are interleaved between partitions so that they remain unique
+  // and only depend on the order of the events within each partition.
+  uint32_t base = first->nextUid;
+  m_uidStride = m_partitions.size ();
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      Partition *partition = m_partitions[i];
+      partition->nextUid = base + i;
+      partition->currentTs = first->currentTs;
+      partition->currentUid = first->currentUid;
+      partition->currentContext = 0xffffffff;
+    }
+
+  std::vector<Scheduler::Event> events;
+  while (!first->events->IsEmpty ())
+    {
+      events.push_back (first->events->RemoveNext ());
+    }
+  first->unscheduledEvents -= events.size ();
+  for (std::vector<Scheduler::Event>::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      Partition *partition = m_partitions[GetPartitionOf (i->key.m_context, 0)];
+      partition->unscheduledEvents++;
+      partition->events->Insert (*i);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Gather (void)
+{
+  NS_LOG_FUNCTION (this);
+  Partition *first = m_partitions[0];
+  for (uint32_t i = 1; i < m_partitions.size (); i++)
+    {
+      Partition *partition = m_partitions[i];
+      while (!partition->events->IsEmpty ())
+        {
+          first->events->Insert (partition->events->RemoveNext ());
+        }
+      first->unscheduledEvents += partition->unscheduledEvents;
+      partition->unscheduledEvents = 0;
+      // all the pending events are after the end of the last window, so
+      // they are after the current time of every partition.
+      if (partition->currentTs > first->currentTs)
+        {
+          first->currentTs = partition->currentTs;
+          first->currentUid = partition->currentUid;
+        }
+      first->nextUid = std::max (first->nextUid, partition->nextUid);
+    }
+  first->currentContext = 0xffffffff;
+  m_uidStride = 1;
+}
+
+void
+MultithreadedSimulatorImpl::Barrier (bool startWindow)
+{
+  uint32_t generation = m_barrierGeneration;
+  __sync_synchronize ();
+  if (__sync_add_and_fetch (&m_barrierCount, 1) == m_partitions.size ())
+    {
+      if (startWindow)
+        {
+          StartWindow ();
+        }
+      m_barrierCount = 0;
+      __sync_synchronize ();
+      __sync_fetch_and_add (&m_barrierGeneration, 1);
+      return;
+    }
+  uint32_t spins = 0;
+  while (m_barrierGeneration == generation)
+    {
+      spins++;
+      if (spins > 1000)
+        {
+          // more threads than cores: let the others reach the barrier
+          sched_yield ();
+        }
+    }
+  __sync_synchronize ();
+}
+
+void
+MultithreadedSimulatorImpl::StartWindow (void)
+{
+  uint64_t next = INFINITE_TS;
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      next = std::min (next, m_partitions[i]->nextTs);
+    }
+  // m_stop and m_stopTs may be changed by events of the window which
+  // is about to start: read them only here, so that all the partitions
+  // take the same decision.
+  uint64_t stopTs = m_stopTs;
+  m_windowStop = m_stop || next == INFINITE_TS || next > stopTs;
+  m_windowEnd = INFINITE_TS - next > m_lookahead ? next + m_lookahead : INFINITE_TS;
+  if (stopTs < m_windowEnd)
+    {
+      m_windowEnd = stopTs + 1;
+    }
+  NS_LOG_LOGIC ("window start=" << next << " end=" << m_windowEnd << " stop=" << m_windowStop);
+}
+
+void
+MultithreadedSimulatorImpl::RunPartition (uint32_t index)
+{
+  NS_LOG_FUNCTION (this << index);
+  g_partitionIndex = index;
+  Partition *self = m_partitions[index];
+  while (true)
+    {
+      // the outboxes are complete once every partition ends its window
+      Barrier (false);
+      // import in partition order, so that the uids of the imported
+      // events do not depend on thread timing.
+      for (uint32_t i = 0; i < m_partitions.size (); i++)
+        {
+          std::vector<RemoteEvent> &inbox = m_partitions[i]->outbox[index];
+          for (std::vector<RemoteEvent>::const_iterator j = inbox.begin (); j != inbox.end (); ++j)
+            {
+              Insert (self, j->timestamp, j->context, j->event);
+            }
+          inbox.clear ();
+        }
+      self->nextTs = self->events->IsEmpty () ? INFINITE_TS : self->events->PeekNext ().key.m_ts;
+      Barrier (true);
+
+      if (m_windowStop)
+        {
+          break;
+        }
+      uint64_t end = m_windowEnd;
+      while (!self->events->IsEmpty () && self->events->PeekNext ().key.m_ts < end)
+        {
+          Scheduler::Event ev = self->events->RemoveNext ();
+          NS_ASSERT (ev.key.m_ts >= self->currentTs);
+          self->unscheduledEvents--;
+
+          NS_LOG_LOGIC ("handle " << ev.key.m_ts);
+          self->currentTs = ev.key.m_ts;
+          self->currentContext = ev.key.m_context;
+          self->currentUid = ev.key.m_uid;
+          ev.impl->Invoke ();
+          ev.impl->Unref ();
+        }
+    }
+  g_partitionIndex = -1;
+}
+
+void
+MultithreadedSimulatorImpl::PartitionThread (std::pair<MultithreadedSimulatorImpl *, uint32_t> args)
+{
+  args.first->RunPartition (args.second);
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_stop = false;
+  Setup ();
+  Scatter ();
+
+  m_running = true;
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 1; i < m_partitions.size (); i++)
+    {
+      Ptr<SystemThread> thread =
+        Create<SystemThread> (MakeBoundCallback (&MultithreadedSimulatorImpl::PartitionThread,
+                                                 std::make_pair (this, i)));
+      thread->Start ();
+      threads.push_back (thread);
+    }
+  RunPartition (0);
+  for (uint32_t i = 0; i < threads.size (); i++)
+    {
+      threads[i]->Join ();
+    }
+  m_running = false;
+
+  Gather ();
+  Partition *first = m_partitions[0];
+  if (first->events->IsEmpty () || first->events->PeekNext ().key.m_ts > m_stopTs)
+    {
+      // the stop time was reached
+      m_stopTs = INFINITE_TS;
+    }
+
+  // If the simulator stopped naturally by lack of events, make a
+  // consistency test to check that we didn't lose any events along the way.
+  NS_ASSERT (!first->events->IsEmpty () || first->unscheduledEvents == 0);
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_stop = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &time)
+{
+  NS_LOG_FUNCTION (this << time.GetTimeStep ());
+  uint64_t ts = GetPartition ()->currentTs + time.GetTimeStep ();
+  uint64_t old = m_stopTs;
+  while (ts < old)
+    {
+      uint64_t seen = __sync_val_compare_and_swap (&m_stopTs, old, ts);
+      if (seen == old)
+        {
+          break;
+        }
+      old = seen;
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  return GetPartition ()->events->IsEmpty () || m_stop;
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &time, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << time.GetTimeStep () << event);
+  Partition *partition = GetPartition ();
+
+  Time tAbsolute = time + TimeStep (partition->currentTs);
+
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (partition->currentTs));
+  uint64_t ts = static_cast<uint64_t> (tAbsolute.GetTimeStep ());
+  uint32_t uid = Insert (partition, ts, partition->currentContext, event);
+  return EventId (event, ts, partition->currentContext, uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << time.GetTimeStep () << event);
+  Partition *partition = GetPartition ();
+  uint64_t ts = partition->currentTs + time.GetTimeStep ();
+  if (!m_running)
+    {
+      Insert (partition, ts, context, event);
+      return;
+    }
+  uint32_t current = g_partitionIndex;
+  uint32_t target = GetPartitionOf (context, current);
+  if (target == current)
+    {
+      Insert (partition, ts, context, event);
+      return;
+    }
+  NS_ABORT_MSG_IF ((uint64_t)time.GetTimeStep () < m_lookahead,
+                   "Event for context " << context << " scheduled from partition " << current
+                   << " to partition " << target << " with a delay of " << time
+                   << ", smaller than the lookahead " << TimeStep (m_lookahead));
+  RemoteEvent ev;
+  ev.timestamp = ts;
+  ev.context = context;
+  ev.event = event;
+  partition->outbox[target].push_back (ev);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << event);
+  Partition *partition = GetPartition ();
+  uint32_t uid = Insert (partition, partition->currentTs, partition->currentContext, event);
+  return EventId (event, partition->currentTs, partition->currentContext, uid);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << event);
+  EventId id (Ptr<EventImpl> (event, false), GetPartition ()->currentTs, 0xffffffff, 2);
+  CriticalSection cs (m_destroyEventsMutex);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  return TimeStep (GetPartition ()->currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetPartition ()->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection cs (m_destroyEventsMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *partition = GetPartition ();
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  partition->events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  partition->unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0
+          || id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection cs (m_destroyEventsMutex);
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  Partition *partition = GetPartition ();
+  if (id.PeekEventImpl () == 0
+      || id.GetTs () < partition->currentTs
+      || (id.GetTs () == partition->currentTs
+          && id.GetUid () <= partition->currentUid)
+      || id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (INFINITE_TS);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return GetPartition ()->currentContext;
+}
+
+} // namespace ns3
@@ -0,0 +1,225 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_MULTITHREADED_SIMULATOR_IMPL_H
+#define NS3_MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/object-factory.h"
+#include "ns3/nstime.h"
+#include "ns3/system-mutex.h"
+#include "ns3/ptr.h"
+
+#include <list>
+#include <vector>
+#include <utility>
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ * \ingroup mpi
+ *
+ * \brief Conservative parallel simulator running the partitions of a
+ * topology on threads of a single process.
+ *
+ * Nodes are assigned to partitions with their system id (see
+ * Node::GetSystemId), exactly as for DistributedSimulatorImpl, but all
+ * the partitions run in the same address space: one thread per
+ * partition, the main thread running partition 0. Events are assigned
+ * to the partition of the node given by their context; events without
+ * a node context run in the partition which scheduled them, or in
+ * partition 0 if they were scheduled before Run.
+ *
+ * Each partition has its own scheduler, created from the factory given
+ * to SetScheduler. The partitions advance in lock step through time
+ * windows: at the start of each window, all partitions agree on the
+ * smallest pending timestamp T, and each one then runs all its events
+ * older than T + lookahead without any synchronization. An event
+ * scheduled for another partition must be at least lookahead in the
+ * future, so it always falls in a later window: it is appended to a
+ * per-destination outbox which the receiving partition imports at the
+ * next window boundary.
+ *
+ * The arguments bound to such an event are handed over as they are,
+ * without copy or serialization, and the reference counts of ns-3
+ * objects are not atomic. An event for another partition may therefore
+ * only carry plain values, raw pointers to objects which live until the
+ * end of the simulation and are only used by the receiving partition
+ * (such as the devices held by their node), and Ptr to objects created
+ * for the event and no longer used by the sender. It must not carry a
+ * Ptr to an object which the receiving partition also holds.
+ * PointToPointChannel follows these rules: it binds a raw pointer to
+ * the receiving device and a Packet::DeepCopy of the packets, and does
+ * not fire its TxRxPointToPoint trace for these packets.
+ *
+ * The lookahead is the smallest Delay of the point-to-point channels
+ * which connect nodes of different partitions, unless the Lookahead
+ * attribute is set. Shared medium channels (CsmaChannel, wireless
+ * channels) keep state which is read by every attached device without
+ * delay, so they must be contained in one partition unless the
+ * Lookahead attribute is set, in which case the user is responsible for
+ * their safety. Scheduling an event in another partition with a delay
+ * smaller than the lookahead is a fatal error.
+ *
+ * Event uids are allocated with a stride equal to the number of
+ * partitions and the events imported from other partitions are
+ * inserted in a fixed order, so the results do not depend on the
+ * number of cores or on thread timing.
+ *
+ * Limitations:
+ *  - Simulator::Stop () and Simulator::Stop (time) called from an event
+ *    take effect at the end of the current window at the earliest: all
+ *    the partitions finish the window and then stop together.
+ *    Simulator::Stop (time) called before Run is exact.
+ *  - Simulator::Remove must be called from the partition which
+ *    scheduled the event. Simulator::Cancel can be used anywhere.
+ *  - Events cannot be scheduled from threads which do not run a
+ *    partition while the simulation runs.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  MultithreadedSimulatorImpl ();
+  ~MultithreadedSimulatorImpl ();
+
+  // virtual from SimulatorImpl
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &time);
+  virtual EventId Schedule (Time const &time, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  /**
+   * \returns The index of the partition run by the calling thread.
+   */
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * \returns The number of partitions of the last call to Run.
+   */
+  uint32_t GetPartitionCount (void) const;
+  /**
+   * \returns The lookahead used by the last call to Run.
+   */
+  Time GetLookahead (void) const;
+
+private:
+  virtual void DoDispose (void);
+
+  /** An event sent to another partition. */
+  struct RemoteEvent
+  {
+    uint64_t timestamp;  /**< Absolute time stamp. */
+    uint32_t context;    /**< Context of the event. */
+    EventImpl *event;    /**< The event. */
+  };
+  /** The state of one partition. */
+  struct Partition
+  {
+    Ptr<Scheduler> events;       /**< The pending events. */
+    uint32_t currentUid;         /**< Uid of the running event. */
+    uint64_t currentTs;          /**< Time stamp of the running event. */
+    uint32_t currentContext;     /**< Context of the running event. */
+    uint32_t nextUid;            /**< Next uid to allocate. */
+    int unscheduledEvents;       /**< Inserted but not yet run. */
+    uint64_t nextTs;             /**< Smallest pending time stamp, published at window start. */
+    /** Events sent to each partition during the current window. */
+    std::vector<std::vector<RemoteEvent> > outbox;
+  };
+
+  /**
+   * \returns The partition run by the calling thread, or the partition
+   * which holds all the events outside of Run.
+   */
+  Partition *GetPartition (void) const;
+  /**
+   * \param [in] context An event context.
+   * \param [in] current The partition of the caller.
+   * \returns The partition which must run events with this context.
+   */
+  uint32_t GetPartitionOf (uint32_t context, uint32_t current) const;
+  /**
+   * Insert an event in a partition, allocating its uid.
+   * \returns The uid of the event.
+   */
+  uint32_t Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event);
+  /** Build the partition map and compute the lookahead. */
+  void Setup (void);
+  /** Move all the events of all partitions to m_partitions[0]. */
+  void Gather (void);
+  /** Move the events of m_partitions[0] to their partition. */
+  void Scatter (void);
+  /** Run one partition until the end of the simulation. */
+  void RunPartition (uint32_t index);
+  /** Thread entry point of the partitions other than 0. */
+  static void PartitionThread (std::pair<MultithreadedSimulatorImpl *, uint32_t> args);
+  /**
+   * Wait until all the partition threads reach this point.
+   * \param [in] startWindow If true, the last thread to arrive calls
+   *            StartWindow before it releases the others.
+   */
+  void Barrier (bool startWindow);
+  /**
+   * Decide, once for all the partitions, whether the simulation stops
+   * and, if not, when the next window ends. Only called by the last
+   * thread to reach the barrier, while the others wait.
+   */
+  void StartWindow (void);
+
+  typedef std::list<EventId> DestroyEvents;
+  DestroyEvents m_destroyEvents;
+  mutable SystemMutex m_destroyEventsMutex; /**< Protects m_destroyEvents. */
+
+  ObjectFactory m_schedulerFactory;    /**< Creates the partition schedulers. */
+  /**
+   * The partitions. Outside of Run, only m_partitions[0] holds events
+   * and it is used by the main thread.
+   */
+  std::vector<Partition *> m_partitions;
+  /** Partition of each node, indexed by node id. */
+  std::vector<uint32_t> m_partitionOfNode;
+  bool m_running;                      /**< Set while Run executes. */
+  volatile bool m_stop;                /**< Set by Stop (). */
+  volatile uint64_t m_stopTs;          /**< Events after this time are not run. */
+  Time m_lookaheadAttribute;           /**< The Lookahead attribute. */
+  uint64_t m_lookahead;                /**< Lookahead, in time steps. */
+  uint32_t m_uidStride;                /**< Increment between the uids of a partition. */
+  bool m_windowStop;                   /**< Set by StartWindow if the partitions must stop. */
+  uint64_t m_windowEnd;                /**< Events before this time run in the current window. */
+
+  volatile uint32_t m_barrierCount;      /**< Threads waiting on the barrier. */
+  volatile uint32_t m_barrierGeneration; /**< Incremented to release the barrier. */
+};
+
+} // namespace ns3
+
+#endif /* NS3_MULTITHREADED_SIMULATOR_IMPL_H */
@@ -0,0 +1,314 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/boolean.h"
+#include "ns3/nstime.h"
+
+#include <algorithm>
+#include <vector>
+#include <utility>
+
+using namespace ns3;
+
+/**
+ * Nodes spread over several partitions pass tokens around a ring. Each
+ * node logs what it receives and checks the partition which runs it.
+ * The logs must hold the same events as with DefaultSimulatorImpl:
+ * events of a node with equal time stamps may be run in a different
+ * order, so the logs are sorted before the comparison.
+ */
+class MultithreadedSimulatorRingTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorRingTestCase (uint32_t partitions, Time stop);
+private:
+  virtual void DoRun (void);
+  /** Run the scenario with the given implementation and return the logs. */
+  std::vector<std::vector<std::pair<uint64_t, uint32_t> > > RunScenario (Ptr<SimulatorImpl> impl);
+  void Hop (uint32_t node, uint32_t hops);
+  void Tick (uint32_t node);
+
+  static const uint32_t NODES = 12;
+  uint32_t m_partitions;
+  Time m_stop;
+  std::vector<std::vector<std::pair<uint64_t, uint32_t> > > m_logs;
+  std::vector<uint32_t> m_systemIds;
+  bool m_wrongPartition;
+};
+
+MultithreadedSimulatorRingTestCase::MultithreadedSimulatorRingTestCase (uint32_t partitions, Time stop)
+  : TestCase ("Check event order across partitions"),
+    m_partitions (partitions),
+    m_stop (stop)
+{
+}
+
+void
+MultithreadedSimulatorRingTestCase::Hop (uint32_t node, uint32_t hops)
+{
+  m_logs[node].push_back (std::make_pair (Simulator::Now ().GetTimeStep (), hops));
+  if (Simulator::GetContext () != node || Simulator::GetSystemId () != m_systemIds[node])
+    {
+      m_wrongPartition = true;
+    }
+  if (hops == 0)
+    {
+      return;
+    }
+  uint32_t next = (node + 1 + hops % 3) % NODES;
+  Simulator::ScheduleWithContext (next, MilliSeconds (1) + MicroSeconds (7 * node + hops % 5),
+                                  &MultithreadedSimulatorRingTestCase::Hop, this, next, hops - 1);
+  Simulator::Schedule (MicroSeconds (3 + hops % 4), &MultithreadedSimulatorRingTestCase::Tick, this, node);
+}
+
+void
+MultithreadedSimulatorRingTestCase::Tick (uint32_t node)
+{
+  m_logs[node].push_back (std::make_pair (Simulator::Now ().GetTimeStep (), 0xffffffff));
+}
+
+std::vector<std::vector<std::pair<uint64_t, uint32_t> > >
+MultithreadedSimulatorRingTestCase::RunScenario (Ptr<SimulatorImpl> impl)
+{
+  Simulator::Destroy ();
+  Simulator::SetImplementation (impl);
+  m_logs.assign (NODES, std::vector<std::pair<uint64_t, uint32_t> > ());
+  m_systemIds.clear ();
+  m_wrongPartition = false;
+  NodeContainer nodes;
+  for (uint32_t i = 0; i < NODES; i++)
+    {
+      uint32_t systemId = i % m_partitions;
+      nodes.Create (1, systemId);
+      m_systemIds.push_back (DynamicCast<DefaultSimulatorImpl> (impl) ? 0 : systemId);
+    }
+  for (uint32_t i = 0; i < NODES; i++)
+    {
+      Simulator::ScheduleWithContext (nodes.Get (i)->GetId (), MicroSeconds (i),
+                                      &MultithreadedSimulatorRingTestCase::Hop, this, nodes.Get (i)->GetId (), 40);
+    }
+  if (!m_stop.IsZero ())
+    {
+      Simulator::Stop (m_stop);
+    }
+  Simulator::Run ();
+  if (!m_stop.IsZero ())
+    {
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (Simulator::Now (), m_stop, "Run went past the stop time");
+    }
+  Simulator::Destroy ();
+  for (uint32_t i = 0; i < NODES; i++)
+    {
+      std::sort (m_logs[i].begin (), m_logs[i].end ());
+    }
+  return m_logs;
+}
+
+void
+MultithreadedSimulatorRingTestCase::DoRun (void)
+{
+  std::vector<std::vector<std::pair<uint64_t, uint32_t> > > expected =
+    RunScenario (CreateObject<DefaultSimulatorImpl> ());
+
+  Ptr<MultithreadedSimulatorImpl> impl = CreateObject<MultithreadedSimulatorImpl> ();
+  impl->SetAttribute ("Lookahead", TimeValue (MilliSeconds (1)));
+  std::vector<std::vector<std::pair<uint64_t, uint32_t> > > logs = RunScenario (impl);
+  NS_TEST_ASSERT_MSG_EQ (impl->GetPartitionCount (), m_partitions, "wrong number of partitions");
+  NS_TEST_ASSERT_MSG_EQ (m_wrongPartition, false, "event run by the wrong partition");
+  for (uint32_t i = 0; i < NODES; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (logs[i].size (), expected[i].size (), "wrong number of events for node " << i);
+      for (uint32_t j = 0; j < logs[i].size (); j++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (logs[i][j].first, expected[i][j].first, "wrong time for node " << i);
+          NS_TEST_ASSERT_MSG_EQ (logs[i][j].second, expected[i][j].second, "wrong event for node " << i);
+        }
+    }
+  Simulator::SetImplementation (CreateObject<DefaultSimulatorImpl> ());
+}
+
+/**
+ * The lookahead is derived from the delay of the point-to-point
+ * channels between partitions.
+ */
+class MultithreadedSimulatorLookaheadTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorLookaheadTestCase ();
+private:
+  virtual void DoRun (void);
+  void Connect (Ptr<Node> a, Ptr<Node> b, Time delay);
+};
+
+MultithreadedSimulatorLookaheadTestCase::MultithreadedSimulatorLookaheadTestCase ()
+  : TestCase ("Check the lookahead derived from channel delays")
+{
+}
+
+void
+MultithreadedSimulatorLookaheadTestCase::Connect (Ptr<Node> a, Ptr<Node> b, Time delay)
+{
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (delay));
+  Ptr<Node> nodes[2] = { a, b };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAttribute ("PointToPointMode", BooleanValue (true));
+      device->SetChannel (channel);
+      nodes[i]->AddDevice (device);
+    }
+}
+
+void
+MultithreadedSimulatorLookaheadTestCase::DoRun (void)
+{
+  Simulator::Destroy ();
+  Ptr<MultithreadedSimulatorImpl> impl = CreateObject<MultithreadedSimulatorImpl> ();
+  Simulator::SetImplementation (impl);
+  NodeContainer nodes;
+  nodes.Create (2, 0);
+  nodes.Create (2, 1);
+  // links within a partition do not limit the lookahead
+  Connect (nodes.Get (0), nodes.Get (1), MicroSeconds (10));
+  Connect (nodes.Get (0), nodes.Get (2), MilliSeconds (5));
+  Connect (nodes.Get (1), nodes.Get (3), MilliSeconds (2));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (impl->GetPartitionCount (), 2, "wrong number of partitions");
+  NS_TEST_ASSERT_MSG_EQ (impl->GetLookahead (), MilliSeconds (2), "wrong lookahead");
+  Simulator::Destroy ();
+  Simulator::SetImplementation (CreateObject<DefaultSimulatorImpl> ());
+}
+
+/**
+ * An event of one partition calls Simulator::Stop () or
+ * Simulator::Stop (time) while the other partitions keep scheduling
+ * events forever. Every partition must stop at the same window
+ * boundary, and Run must return.
+ */
+class MultithreadedSimulatorStopTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorStopTestCase (Time delay);
+private:
+  virtual void DoRun (void);
+  void Tick (uint32_t node);
+  void Hop (uint32_t node);
+  void DoStop (void);
+
+  static const uint32_t NODES = 8;
+  Time m_delay;
+  std::vector<Time> m_lastTick;
+};
+
+MultithreadedSimulatorStopTestCase::MultithreadedSimulatorStopTestCase (Time delay)
+  : TestCase ("Check Simulator::Stop called from a partition"),
+    m_delay (delay)
+{
+}
+
+void
+MultithreadedSimulatorStopTestCase::Tick (uint32_t node)
+{
+  m_lastTick[node] = Simulator::Now ();
+  Simulator::Schedule (MicroSeconds (10), &MultithreadedSimulatorStopTestCase::Tick, this, node);
+}
+
+void
+MultithreadedSimulatorStopTestCase::Hop (uint32_t node)
+{
+  uint32_t next = (node + 1) % NODES;
+  Simulator::ScheduleWithContext (next, MilliSeconds (1) + MicroSeconds (node),
+                                  &MultithreadedSimulatorStopTestCase::Hop, this, next);
+}
+
+void
+MultithreadedSimulatorStopTestCase::DoStop (void)
+{
+  if (m_delay.IsZero ())
+    {
+      Simulator::Stop ();
+    }
+  else
+    {
+      Simulator::Stop (m_delay);
+    }
+}
+
+void
+MultithreadedSimulatorStopTestCase::DoRun (void)
+{
+  Simulator::Destroy ();
+  Ptr<MultithreadedSimulatorImpl> impl = CreateObject<MultithreadedSimulatorImpl> ();
+  impl->SetAttribute ("Lookahead", TimeValue (MilliSeconds (1)));
+  Simulator::SetImplementation (impl);
+  m_lastTick.assign (NODES, Time (0));
+  NodeContainer nodes;
+  for (uint32_t i = 0; i < NODES; i++)
+    {
+      nodes.Create (1, i % 4);
+    }
+  for (uint32_t i = 0; i < NODES; i++)
+    {
+      Simulator::ScheduleWithContext (i, MicroSeconds (i), &MultithreadedSimulatorStopTestCase::Tick, this, i);
+      Simulator::ScheduleWithContext (i, MicroSeconds (i), &MultithreadedSimulatorStopTestCase::Hop, this, i);
+    }
+  // node 2 runs in partition 2
+  Simulator::ScheduleWithContext (2, MilliSeconds (5), &MultithreadedSimulatorStopTestCase::DoStop, this);
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (impl->GetPartitionCount (), 4, "wrong number of partitions");
+
+  Time stop = MilliSeconds (5) + m_delay;
+  for (uint32_t i = 0; i < NODES; i++)
+    {
+      if (m_delay.IsZero ())
+        {
+          // the window which runs the stop event ends at most one
+          // lookahead after it
+          NS_TEST_EXPECT_MSG_GT_OR_EQ (m_lastTick[i], stop - MicroSeconds (10), "node " << i << " stopped early");
+          NS_TEST_EXPECT_MSG_LT (m_lastTick[i], stop + MilliSeconds (1), "node " << i << " did not stop");
+        }
+      else
+        {
+          NS_TEST_EXPECT_MSG_GT (m_lastTick[i], stop - MicroSeconds (10), "node " << i << " stopped early");
+          NS_TEST_EXPECT_MSG_LT_OR_EQ (m_lastTick[i], stop, "node " << i << " ran past the stop time");
+        }
+    }
+  Simulator::Destroy ();
+  Simulator::SetImplementation (CreateObject<DefaultSimulatorImpl> ());
+}
+
+static class MultithreadedSimulatorTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorTestSuite ()
+    : TestSuite ("multithreaded-simulator")
+  {
+    AddTestCase (new MultithreadedSimulatorRingTestCase (1, Time (0)), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorRingTestCase (3, Time (0)), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorRingTestCase (4, MicroSeconds (20000) + NanoSeconds (500)), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorLookaheadTestCase, TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorStopTestCase (Time (0)), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorStopTestCase (MilliSeconds (1)), TestCase::QUICK);
+  }
+} g_multithreadedSimulatorTestSuite;
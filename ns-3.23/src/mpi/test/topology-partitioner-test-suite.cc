@@ -0,0 +1,289 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/topology-partitioner.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/boolean.h"
+#include "ns3/nstime.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Base class of the partitioner tests: builds links out of
+ * SimpleChannel and SimpleNetDevice.
+ */
+class TopologyPartitionerTestCase : public TestCase
+{
+public:
+  TopologyPartitionerTestCase (std::string name);
+protected:
+  /** Connect nodes with a channel. */
+  void Connect (Ptr<Node> a, Ptr<Node> b, Time delay);
+  /** Connect nodes with a shared medium channel. */
+  void ConnectShared (NodeContainer nodes);
+  /** \returns The number of nodes in each partition. */
+  std::vector<uint32_t> Count (const std::vector<uint32_t> &assignment, uint32_t nPartitions);
+};
+
+TopologyPartitionerTestCase::TopologyPartitionerTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+TopologyPartitionerTestCase::Connect (Ptr<Node> a, Ptr<Node> b, Time delay)
+{
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (delay));
+  Ptr<Node> nodes[2] = { a, b };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAttribute ("PointToPointMode", BooleanValue (true));
+      device->SetChannel (channel);
+      nodes[i]->AddDevice (device);
+    }
+}
+
+void
+TopologyPartitionerTestCase::ConnectShared (NodeContainer nodes)
+{
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MilliSeconds (10)));
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetChannel (channel);
+      nodes.Get (i)->AddDevice (device);
+    }
+}
+
+std::vector<uint32_t>
+TopologyPartitionerTestCase::Count (const std::vector<uint32_t> &assignment, uint32_t nPartitions)
+{
+  std::vector<uint32_t> counts (nPartitions, 0);
+  for (uint32_t i = 0; i < assignment.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_LT (assignment[i], nPartitions, "invalid partition");
+      counts[assignment[i] % nPartitions]++;
+    }
+  return counts;
+}
+
+/**
+ * Two clusters of short links joined by two long links: the partitions
+ * must follow the clusters.
+ */
+class TopologyPartitionerClustersTestCase : public TopologyPartitionerTestCase
+{
+public:
+  TopologyPartitionerClustersTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TopologyPartitionerClustersTestCase::TopologyPartitionerClustersTestCase ()
+  : TopologyPartitionerTestCase ("Check that short links are not cut")
+{
+}
+
+void
+TopologyPartitionerClustersTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (16);
+  for (uint32_t c = 0; c < 2; c++)
+    {
+      for (uint32_t i = 0; i < 8; i++)
+        {
+          Connect (nodes.Get (c * 8 + i), nodes.Get (c * 8 + (i + 1) % 8), MicroSeconds (10 + i));
+          Connect (nodes.Get (c * 8 + i), nodes.Get (c * 8 + (i + 3) % 8), MicroSeconds (20));
+        }
+    }
+  Connect (nodes.Get (0), nodes.Get (8), MilliSeconds (5));
+  Connect (nodes.Get (7), nodes.Get (15), MilliSeconds (3));
+
+  TopologyPartitioner partitioner;
+  std::vector<uint32_t> assignment = partitioner.Partition (2);
+  NS_TEST_ASSERT_MSG_EQ (assignment.size (), 16, "wrong number of nodes");
+  for (uint32_t i = 1; i < 8; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (assignment[i], assignment[0], "first cluster split");
+      NS_TEST_ASSERT_MSG_EQ (assignment[8 + i], assignment[8], "second cluster split");
+    }
+  NS_TEST_ASSERT_MSG_NE (assignment[0], assignment[8], "clusters not separated");
+  NS_TEST_ASSERT_MSG_EQ (partitioner.GetLookahead (), MilliSeconds (3), "wrong lookahead");
+
+  TopologyPartitioner::Apply (assignment);
+  NS_TEST_ASSERT_MSG_EQ (nodes.Get (9)->GetSystemId (), assignment[9], "system id not applied");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * A ring of equal links split in four: the partitions must be balanced
+ * and the cut minimal.
+ */
+class TopologyPartitionerRingTestCase : public TopologyPartitionerTestCase
+{
+public:
+  TopologyPartitionerRingTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TopologyPartitionerRingTestCase::TopologyPartitionerRingTestCase ()
+  : TopologyPartitionerTestCase ("Check balance and cut on a ring")
+{
+}
+
+void
+TopologyPartitionerRingTestCase::DoRun (void)
+{
+  const uint32_t n = 64;
+  NodeContainer nodes;
+  nodes.Create (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Connect (nodes.Get (i), nodes.Get ((i + 1) % n), MilliSeconds (1));
+    }
+
+  TopologyPartitioner partitioner;
+  std::vector<uint32_t> assignment = partitioner.Partition (4);
+  std::vector<uint32_t> counts = Count (assignment, 4);
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (counts[i], n / 4, "partition " << i << " not balanced");
+    }
+  NS_TEST_ASSERT_MSG_EQ (partitioner.GetCutTraffic (), 4, "cut not minimal");
+  NS_TEST_ASSERT_MSG_EQ (partitioner.GetLookahead (), MilliSeconds (1), "wrong lookahead");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * The nodes of a shared medium channel stay together, and an assignment
+ * survives a round trip through a file.
+ */
+class TopologyPartitionerSharedTestCase : public TopologyPartitionerTestCase
+{
+public:
+  TopologyPartitionerSharedTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TopologyPartitionerSharedTestCase::TopologyPartitionerSharedTestCase ()
+  : TopologyPartitionerTestCase ("Check that shared channels are not cut")
+{
+}
+
+void
+TopologyPartitionerSharedTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (12);
+  for (uint32_t i = 0; i + 1 < 12; i++)
+    {
+      Connect (nodes.Get (i), nodes.Get (i + 1), MilliSeconds (1));
+    }
+  NodeContainer lan;
+  lan.Add (nodes.Get (2));
+  lan.Add (nodes.Get (6));
+  lan.Add (nodes.Get (10));
+  ConnectShared (lan);
+
+  TopologyPartitioner partitioner;
+  partitioner.SetImbalance (0.5);
+  std::vector<uint32_t> assignment = partitioner.Partition (3);
+  NS_TEST_ASSERT_MSG_EQ (assignment[6], assignment[2], "shared channel cut");
+  NS_TEST_ASSERT_MSG_EQ (assignment[10], assignment[2], "shared channel cut");
+  std::vector<uint32_t> counts = Count (assignment, 3);
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      NS_TEST_ASSERT_MSG_LT_OR_EQ (counts[i], 6, "partition " << i << " too large");
+    }
+
+  std::string filename = CreateTempDirFilename ("partition.txt");
+  TopologyPartitioner::Write (filename, assignment);
+  std::vector<uint32_t> read = TopologyPartitioner::Read (filename);
+  NS_TEST_ASSERT_MSG_EQ (read.size (), assignment.size (), "wrong size after round trip");
+  for (uint32_t i = 0; i < read.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (read[i], assignment[i], "wrong partition after round trip");
+    }
+
+  Simulator::Destroy ();
+}
+
+/**
+ * A star: coarsening can only merge the hub with one leaf per level, so
+ * it must stop early instead of running one level per leaf.
+ */
+class TopologyPartitionerStarTestCase : public TopologyPartitionerTestCase
+{
+public:
+  TopologyPartitionerStarTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TopologyPartitionerStarTestCase::TopologyPartitionerStarTestCase ()
+  : TopologyPartitionerTestCase ("Check balance on a star")
+{
+}
+
+void
+TopologyPartitionerStarTestCase::DoRun (void)
+{
+  const uint32_t n = 4000;
+  NodeContainer nodes;
+  nodes.Create (n + 1);
+  for (uint32_t i = 1; i <= n; i++)
+    {
+      Connect (nodes.Get (0), nodes.Get (i), MilliSeconds (1));
+    }
+
+  TopologyPartitioner partitioner;
+  std::vector<uint32_t> assignment = partitioner.Partition (4);
+  std::vector<uint32_t> counts = Count (assignment, 4);
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      NS_TEST_EXPECT_MSG_GT_OR_EQ (counts[i], n / 4 - n / 20, "partition " << i << " not balanced");
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (counts[i], n / 4 + n / 20, "partition " << i << " not balanced");
+    }
+
+  Simulator::Destroy ();
+}
+
+static class TopologyPartitionerTestSuite : public TestSuite
+{
+public:
+  TopologyPartitionerTestSuite ()
+    : TestSuite ("topology-partitioner")
+  {
+    AddTestCase (new TopologyPartitionerClustersTestCase, TestCase::QUICK);
+    AddTestCase (new TopologyPartitionerRingTestCase, TestCase::QUICK);
+    AddTestCase (new TopologyPartitionerSharedTestCase, TestCase::QUICK);
+    AddTestCase (new TopologyPartitionerStarTestCase, TestCase::QUICK);
+  }
+} g_topologyPartitionerTestSuite;
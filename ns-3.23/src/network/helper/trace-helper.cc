@@ -28,6 +28,8 @@
 #include "ns3/names.h"
 #include "ns3/net-device.h"
 #include "ns3/pcap-file-wrapper.h"
+#include "ns3/pcapng-file.h"
+#include "ns3/simulator.h"
 
 #include "trace-helper.h"
 
@@ -35,6 +37,9 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("TraceHelper");
 
+/// The pcapng file set by PcapHelper::SetMultiplexFile, if any
+static Ptr<PcapngFile> g_multiplexFile = 0;
+
 PcapHelper::PcapHelper ()
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -56,6 +61,11 @@ PcapHelper::CreateFile (
   NS_LOG_FUNCTION (filename << filemode << dataLinkType << snapLen << tzCorrection);
 
   Ptr<PcapFileWrapper> file = CreateObject<PcapFileWrapper> ();
+  if (g_multiplexFile != 0)
+    {
+      file->OpenInterface (g_multiplexFile, filename, dataLinkType, snapLen);
+      return file;
+    }
   file->Open (filename, filemode);
   NS_ABORT_MSG_IF (file->Fail (), "Unable to Open " << filename << " for mode " << filemode);
 
@@ -76,6 +86,28 @@ PcapHelper::CreateFile (
   return file;
 }
 
+void
+PcapHelper::SetMultiplexFile (std::string filename)
+{
+  NS_LOG_FUNCTION (filename);
+  g_multiplexFile = 0;
+  if (filename.empty ())
+    {
+      return;
+    }
+  g_multiplexFile = Create<PcapngFile> ();
+  g_multiplexFile->Open (filename);
+  NS_ABORT_MSG_IF (g_multiplexFile->Fail (), "Unable to Open " << filename);
+  Simulator::ScheduleDestroy (&PcapHelper::ReleaseMultiplexFile);
+}
+
+void
+PcapHelper::ReleaseMultiplexFile (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  g_multiplexFile = 0;
+}
+
 std::string
 PcapHelper::GetFilenameFromDevice (std::string prefix, Ptr<NetDevice> device, bool useObjectNames)
 {
@@ -110,7 +110,27 @@ public:
    */
   template <typename T> void HookDefaultSink (Ptr<T> object, std::string traceName, Ptr<PcapFileWrapper> file);
 
+  /**
+   * @brief Capture into a single pcapng file.
+   *
+   * The files created by CreateFile from now on are not created: each
+   * one becomes an interface of the given pcapng file instead, named
+   * after the file it replaces. The pcapng file is written by a
+   * background thread, and is complete once Simulator::Destroy has run
+   * and all the devices which capture into it have been destroyed.
+   *
+   * @param filename the name of the pcapng file, or an empty string to
+   * go back to one pcap file per capture
+   */
+  static void SetMultiplexFile (std::string filename);
+
 private:
+  /**
+   * Forget the pcapng file set by SetMultiplexFile, which is closed
+   * once its last interface is released.
+   */
+  static void ReleaseMultiplexFile (void);
+
   /**
    * The basic default trace sink.
    *
@@ -101,6 +101,31 @@ Application::DoInitialize (void)
   Object::DoInitialize ();
 }
 
+void
+Application::SaveCheckpoint (CheckpointWriter &writer) const
+{
+  NS_LOG_FUNCTION (this << &writer);
+  writer.WriteEvent (m_startEvent);
+  writer.WriteEvent (m_stopEvent);
+}
+
+void
+Application::RestoreCheckpoint (CheckpointReader &reader)
+{
+  NS_LOG_FUNCTION (this << &reader);
+  Time delay;
+  m_startEvent.Cancel ();
+  if (reader.ReadEvent (delay))
+    {
+      m_startEvent = Simulator::Schedule (delay, &Application::StartApplication, this);
+    }
+  m_stopEvent.Cancel ();
+  if (reader.ReadEvent (delay))
+    {
+      m_stopEvent = Simulator::Schedule (delay, &Application::StopApplication, this);
+    }
+}
+
 Ptr<Node> Application::GetNode () const
 {
   NS_LOG_FUNCTION (this);
@@ -24,6 +24,7 @@
 #include "ns3/event-id.h"
 #include "ns3/nstime.h"
 #include "ns3/object.h"
+#include "ns3/checkpoint.h"
 #include "ns3/ptr.h"
 #include "ns3/node.h"
 
@@ -57,7 +58,7 @@ class Node;
 * \brief The base class for all ns3 applications
 *
 */
-class Application : public Object
+class Application : public Object, public Checkpointable
 {
 public:
   /**
@@ -104,6 +105,19 @@ public:
    */
   void SetNode (Ptr<Node> node);
 
+  /**
+   * Save the start and stop events. Subclasses which have a state of
+   * their own must save it after calling this method.
+   * \param [in] writer Where to save the state.
+   */
+  virtual void SaveCheckpoint (CheckpointWriter &writer) const;
+  /**
+   * Schedule the start and stop events again. Subclasses which have a
+   * state of their own must restore it after calling this method.
+   * \param [in] reader Where to read the state.
+   */
+  virtual void RestoreCheckpoint (CheckpointReader &reader);
+
 private:
   /**
    * \brief Application specific startup code
@@ -20,6 +20,8 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include <algorithm>
+#include <new>
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
@@ -50,98 +52,46 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
-uint32_t Buffer::g_recommendedStart = 0;
+__thread uint32_t Buffer::g_recommendedStart = 0;
+uint64_t Buffer::g_materializedBytes = 0;
+uint32_t Buffer::g_minSegmentSize = 128;
 #ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use 
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy 
- * constructor orderings.
- */
-#define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
-
-Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
-{
-  NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
-    {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
-        {
-          Buffer::Deallocate (*i);
-        }
-      delete g_freeList;
-      g_freeList = DESTROYED;
-    }
-}
+namespace {
+/** The free list of the Buffer::Data blocks. */
+PacketFreeList g_freeList (1000);
+/** The free list of the Buffer::Segments objects. */
+PacketFreeList g_segmentsFreeList (1000);
+} // anonymous namespace
 
 void
 Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
-    {
-      Buffer::Deallocate (data);
-    }
-  else
-    {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
-    }
+  g_freeList.Free (data);
 }
 
 Buffer::Data *
 Buffer::Create (uint32_t dataSize)
 {
   NS_LOG_FUNCTION (dataSize);
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
+  if (dataSize == 0)
     {
-      g_freeList = new Buffer::FreeList ();
+      dataSize = 1;
     }
-  else if (IS_INITIALIZED (g_freeList))
-    {
-      while (!g_freeList->empty ()) 
-        {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
-        }
-    }
-  struct Buffer::Data *data = Buffer::Allocate (dataSize);
-  NS_ASSERT (data->m_count == 1);
+  void *p = g_freeList.Allocate (dataSize - 1 + sizeof (struct Buffer::Data));
+  struct Buffer::Data *data = static_cast<struct Buffer::Data *> (p);
+  data->m_size = PacketFreeList::GetCapacity (p) + 1 - sizeof (struct Buffer::Data);
+  data->m_count = 1;
   return data;
 }
+
+PacketPoolStats
+Buffer::GetPoolStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return g_freeList.GetStats ();
+}
 #else /* BUFFER_FREE_LIST */
 void
 Buffer::Recycle (struct Buffer::Data *data)
@@ -157,6 +107,14 @@ Buffer::Create (uint32_t size)
   NS_LOG_FUNCTION (size);
   return Allocate (size);
 }
+
+PacketPoolStats
+Buffer::GetPoolStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  PacketPoolStats stats = { 0, 0, 0, 0 };
+  return stats;
+}
 #endif /* BUFFER_FREE_LIST */
 
 struct Buffer::Data *
@@ -186,18 +144,21 @@ Buffer::Deallocate (struct Buffer::Data *data)
 }
 
 Buffer::Buffer ()
+  : m_segments (0)
 {
   NS_LOG_FUNCTION (this);
   Initialize (0);
 }
 
 Buffer::Buffer (uint32_t dataSize)
+  : m_segments (0)
 {
   NS_LOG_FUNCTION (this << dataSize);
   Initialize (dataSize);
 }
 
 Buffer::Buffer (uint32_t dataSize, bool initialize)
+  : m_segments (0)
 {
   NS_LOG_FUNCTION (this << dataSize << initialize);
   if (initialize == true)
@@ -276,6 +237,24 @@ Buffer::operator = (Buffer const&o)
   m_zeroAreaEnd = o.m_zeroAreaEnd;
   m_start = o.m_start;
   m_end = o.m_end;
+  if (m_segments != o.m_segments)
+    {
+      // o may be one of our segments: release them last.
+      Segments *segments = m_segments;
+      m_segments = o.m_segments;
+      if (m_segments != 0)
+        {
+          m_segments->m_count++;
+        }
+      if (segments != 0)
+        {
+          segments->m_count--;
+          if (segments->m_count == 0)
+            {
+              RecycleSegments (segments);
+            }
+        }
+    }
   NS_ASSERT (CheckInternalState ());
   return *this;
 }
@@ -285,6 +264,7 @@ Buffer::~Buffer ()
   NS_LOG_FUNCTION (this);
   NS_ASSERT (CheckInternalState ());
   g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
+  ReleaseSegments ();
   m_data->m_count--;
   if (m_data->m_count == 0) 
     {
@@ -311,6 +291,16 @@ Buffer::AddAtStart (uint32_t start)
   NS_LOG_FUNCTION (this << start);
   bool dirty;
   NS_ASSERT (CheckInternalState ());
+  bool rebased = false;
+  if (m_segments != 0 && m_start == m_end && m_segments->m_base != 0)
+    {
+      /* the new bytes are the first ones in front of the segments:
+       * make their offsets contiguous again.
+       */
+      DetachSegments ();
+      m_segments->m_base = 0;
+      rebased = true;
+    }
   bool isDirty = m_data->m_count > 1 && m_start > m_data->m_dirtyStart;
   if (m_start >= start && !isDirty)
     {
@@ -354,7 +344,7 @@ Buffer::AddAtStart (uint32_t start)
   m_maxZeroAreaStart = std::max (m_maxZeroAreaStart, m_zeroAreaStart);
   LOG_INTERNAL_STATE ("add start=" << start << ", ");
   NS_ASSERT (CheckInternalState ());
-  return dirty;
+  return dirty || rebased;
 }
 bool
 Buffer::AddAtEnd (uint32_t end)
@@ -362,6 +352,17 @@ Buffer::AddAtEnd (uint32_t end)
   NS_LOG_FUNCTION (this << end);
   bool dirty;
   NS_ASSERT (CheckInternalState ());
+  if (m_segments != 0)
+    {
+      /* the new bytes extend the last segment, typically for a
+       * trailer. The offsets of the buffer do not change.
+       */
+      DetachSegments ();
+      m_segments->m_buffers.back ().AddAtEnd (end);
+      m_segments->m_ends.back () += end;
+      m_segments->m_size += end;
+      return false;
+    }
   bool isDirty = m_data->m_count > 1 && m_end < m_data->m_dirtyEnd;
   if (GetInternalEnd () + end <= m_data->m_size && !isDirty)
     {
@@ -415,40 +416,109 @@ void
 Buffer::AddAtEnd (const Buffer &o)
 {
   NS_LOG_FUNCTION (this << &o);
-  if (m_data->m_count == 1 &&
-      m_end == m_zeroAreaEnd &&
-      m_end == m_data->m_dirtyEnd &&
-      o.m_start == o.m_zeroAreaStart &&
-      o.m_zeroAreaEnd - o.m_zeroAreaStart > 0)
-    {
-      /**
-       * This is an optimization which kicks in when
-       * we attempt to aggregate two buffers which contain
-       * adjacent zero areas.
+  if (&o == this)
+    {
+      Buffer copy = o;
+      AddAtEnd (copy);
+      return;
+    }
+  if (o.GetSize () == 0)
+    {
+      return;
+    }
+  if (m_segments != 0 || o.m_segments != 0 || o.GetSize () >= g_minSegmentSize)
+    {
+      /* Reference the content of o instead of copying it.
+       * Before: |**---***| + |+++---+++|[seg][seg]
+       * After:  |**---***|[+++---+++][seg][seg]
+       */
+      Buffer head = o;
+      head.ReleaseSegments ();
+      if (m_segments == 0)
+        {
+          m_segments = CreateSegments ();
+        }
+      else
+        {
+          DetachSegments ();
+        }
+      if (head.GetSize () != 0)
+        {
+          AppendSegment (head);
+        }
+      if (o.m_segments != 0)
+        {
+          for (std::vector<Buffer>::const_iterator i = o.m_segments->m_buffers.begin ();
+               i != o.m_segments->m_buffers.end (); i++)
+            {
+              AppendSegment (*i);
+            }
+        }
+      NS_ASSERT (CheckInternalState ());
+      return;
+    }
+  uint32_t zeroSize = m_zeroAreaEnd - m_zeroAreaStart;
+  uint32_t oZeroSize = o.m_zeroAreaEnd - o.m_zeroAreaStart;
+  bool adjacent = m_end == m_zeroAreaEnd && o.m_start == o.m_zeroAreaStart;
+  if (oZeroSize == 0 || (!adjacent && zeroSize >= oZeroSize))
+    {
+      /* Keep our zero area and append o as real data, only
+       * materializing its zero area, if any.
+       * Before: |**---***| + |+++000+++|
+       * After:  |**---***+++000+++|
        */
-      uint32_t zeroSize = o.m_zeroAreaEnd - o.m_zeroAreaStart;
-      m_zeroAreaEnd += zeroSize;
-      m_end = m_zeroAreaEnd;
-      m_data->m_dirtyEnd = m_zeroAreaEnd;
-      uint32_t endData = o.m_end - o.m_zeroAreaEnd;
-      AddAtEnd (endData);
+      uint32_t size = o.GetSize ();
+      if (o.m_data == m_data)
+        {
+          // o may be appended in place to the data it reads from:
+          // copy it out first.
+          Buffer copy (0);
+          copy.AddAtStart (size);
+          copy.Begin ().Write (o.Begin (), o.End ());
+          AddAtEnd (copy);
+          return;
+        }
+      AddAtEnd (size);
       Buffer::Iterator dst = End ();
-      dst.Prev (endData);
-      Buffer::Iterator src = o.End ();
-      src.Prev (endData);
-      dst.Write (src, o.End ());
+      dst.Prev (size);
+      dst.Write (o.Begin (), o.End ());
+      __sync_fetch_and_add (&g_materializedBytes, oZeroSize);
       NS_ASSERT (CheckInternalState ());
       return;
     }
 
-  Buffer dst = CreateFullCopy ();
-  Buffer src = o.CreateFullCopy ();
-
-  dst.AddAtEnd (src.GetSize ());
-  Buffer::Iterator destStart = dst.End ();
-  destStart.Prev (src.GetSize ());
-  destStart.Write (src.Begin (), src.End ());
-  *this = dst;
+  /* Keep the zero area of o, merged with ours if they are adjacent.
+   * Otherwise, our zero area is smaller and is materialized.
+   * Before: |**---| + |---++|    |**---***| + |+++------++|
+   * After:  |**------++|         |**000***+++------++|
+   */
+  Buffer::Iterator oZeroStart = o.Begin ();
+  oZeroStart.Next (o.m_zeroAreaStart - o.m_start);
+  Buffer::Iterator oZeroEnd = o.End ();
+  oZeroEnd.Prev (o.m_end - o.m_zeroAreaEnd);
+  uint32_t before;
+  uint32_t after = o.m_end - o.m_zeroAreaEnd;
+  Buffer tmp (adjacent ? zeroSize + oZeroSize : oZeroSize);
+  if (adjacent)
+    {
+      before = m_zeroAreaStart - m_start;
+      tmp.AddAtStart (before);
+      tmp.Begin ().Write (m_data->m_data + m_start, before);
+    }
+  else
+    {
+      before = GetSize () + o.m_zeroAreaStart - o.m_start;
+      tmp.AddAtStart (before);
+      Buffer::Iterator dst = tmp.Begin ();
+      dst.Write (Begin (), End ());
+      dst.Write (o.Begin (), oZeroStart);
+      __sync_fetch_and_add (&g_materializedBytes, zeroSize);
+    }
+  tmp.AddAtEnd (after);
+  Buffer::Iterator dst = tmp.End ();
+  dst.Prev (after);
+  dst.Write (oZeroEnd, o.End ());
+  *this = tmp;
   NS_ASSERT (CheckInternalState ());
 }
 
@@ -457,6 +527,30 @@ Buffer::RemoveAtStart (uint32_t start)
 {
   NS_LOG_FUNCTION (this << start);
   NS_ASSERT (CheckInternalState ());
+  if (m_segments != 0)
+    {
+      uint32_t headSize = m_end - m_start;
+      uint32_t tailStart = std::min (start - std::min (start, headSize), m_segments->m_size);
+      uint32_t end = m_end;
+      Segments *segments = m_segments;
+      m_segments = 0;
+      RemoveAtStart (std::min (start, headSize));
+      m_segments = segments;
+      /* removing part of the zero area moves m_end: keep the offsets
+       * of the segments where they were.
+       */
+      uint32_t base = m_segments->m_base + (end - m_end) + tailStart;
+      if (base != m_segments->m_base)
+        {
+          SliceSegments (tailStart, m_segments->m_size);
+        }
+      if (m_segments != 0)
+        {
+          m_segments->m_base = base;
+        }
+      NS_ASSERT (CheckInternalState ());
+      return;
+    }
   uint32_t newStart = m_start + start;
   if (newStart <= m_zeroAreaStart)
     {
@@ -502,6 +596,18 @@ Buffer::RemoveAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
   NS_ASSERT (CheckInternalState ());
+  if (m_segments != 0)
+    {
+      uint32_t tailSize = m_segments->m_size;
+      if (end < tailSize)
+        {
+          SliceSegments (0, tailSize - end);
+          NS_ASSERT (CheckInternalState ());
+          return;
+        }
+      ReleaseSegments ();
+      end -= tailSize;
+    }
   uint32_t newEnd = m_end - std::min (end, m_end - m_start);
   if (newEnd > m_zeroAreaEnd)
     {
@@ -550,8 +656,13 @@ Buffer::CreateFullCopy (void) const
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (CheckInternalState ());
+  if (m_segments != 0)
+    {
+      return Flatten ().CreateFullCopy ();
+    }
   if (m_zeroAreaEnd - m_zeroAreaStart != 0) 
     {
+      __sync_fetch_and_add (&g_materializedBytes, m_zeroAreaEnd - m_zeroAreaStart);
       Buffer tmp;
       tmp.AddAtStart (m_zeroAreaEnd - m_zeroAreaStart);
       tmp.Begin ().WriteU8 (0, m_zeroAreaEnd - m_zeroAreaStart);
@@ -574,6 +685,10 @@ uint32_t
 Buffer::GetSerializedSize (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_segments != 0)
+    {
+      return Flatten ().GetSerializedSize ();
+    }
   uint32_t dataStart = (m_zeroAreaStart - m_start + 3) & (~0x3);
   uint32_t dataEnd = (m_end - m_zeroAreaEnd + 3) & (~0x3);
 
@@ -594,6 +709,10 @@ uint32_t
 Buffer::Serialize (uint8_t* buffer, uint32_t maxSize) const
 {
   NS_LOG_FUNCTION (this << &buffer << maxSize);
+  if (m_segments != 0)
+    {
+      return Flatten ().Serialize (buffer, maxSize);
+    }
   uint32_t* p = reinterpret_cast<uint32_t *> (buffer);
   uint32_t size = 0;
 
@@ -672,6 +791,7 @@ Buffer::Deserialize (const uint8_t *buffer, uint32_t size)
   sizeCheck -= 4;
 
   // Create zero bytes
+  ReleaseSegments ();
   Initialize (zeroDataLength);
 
   // Add start data
@@ -704,16 +824,200 @@ Buffer::Deserialize (const uint8_t *buffer, uint32_t size)
   return (sizeCheck != 0) ? 0 : 1;
 }
 
+uint32_t
+Buffer::GetZeroAreaSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t size = m_zeroAreaEnd - m_zeroAreaStart;
+  if (m_segments != 0)
+    {
+      for (std::vector<Buffer>::const_iterator i = m_segments->m_buffers.begin ();
+           i != m_segments->m_buffers.end (); i++)
+        {
+          size += i->GetZeroAreaSize ();
+        }
+    }
+  return size;
+}
+
+uint64_t
+Buffer::GetMaterializedBytes (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return g_materializedBytes;
+}
+
+uint32_t
+Buffer::GetSegmentN (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_segments == 0 ? 0 : m_segments->m_buffers.size ();
+}
+
+void
+Buffer::SetMinSegmentSize (uint32_t size)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  g_minSegmentSize = size;
+}
+
+Buffer
+Buffer::Flatten (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_segments != 0);
+  Buffer tmp = *this;
+  tmp.ReleaseSegments ();
+  // a segment may share its data with tmp: copy through memory.
+  std::vector<uint8_t> tail (m_segments->m_size);
+  uint8_t *to = &tail[0];
+  for (std::vector<Buffer>::const_iterator i = m_segments->m_buffers.begin ();
+       i != m_segments->m_buffers.end (); i++)
+    {
+      to += i->CopyData (to, i->GetSize ());
+    }
+  tmp.AddAtEnd (tail.size ());
+  Buffer::Iterator i = tmp.End ();
+  i.Prev (tail.size ());
+  i.Write (&tail[0], tail.size ());
+  return tmp;
+}
+
+Buffer::Segments *
+Buffer::CreateSegments (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+#ifdef BUFFER_FREE_LIST
+  Segments *segments = new (g_segmentsFreeList.Allocate (sizeof (Segments))) Segments ();
+#else
+  Segments *segments = new Segments ();
+#endif
+  segments->m_buffers.reserve (4);
+  segments->m_ends.reserve (4);
+  segments->m_count = 1;
+  segments->m_base = 0;
+  segments->m_size = 0;
+  return segments;
+}
+
+void
+Buffer::RecycleSegments (struct Buffer::Segments *segments)
+{
+  NS_LOG_FUNCTION (segments);
+  NS_ASSERT (segments->m_count == 0);
+#ifdef BUFFER_FREE_LIST
+  segments->~Segments ();
+  g_segmentsFreeList.Free (segments);
+#else
+  delete segments;
+#endif
+}
+
+void
+Buffer::AppendSegment (const Buffer &b)
+{
+  NS_LOG_FUNCTION (this << &b);
+  NS_ASSERT (m_segments != 0 && m_segments->m_count == 1);
+  NS_ASSERT (b.m_segments == 0);
+  m_segments->m_buffers.push_back (b);
+  m_segments->m_size += b.GetSize ();
+  m_segments->m_ends.push_back (m_segments->m_size);
+}
+
+void
+Buffer::DetachSegments (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_segments->m_count > 1)
+    {
+      m_segments->m_count--;
+      Segments *segments = CreateSegments ();
+      segments->m_base = m_segments->m_base;
+      segments->m_size = m_segments->m_size;
+      segments->m_buffers = m_segments->m_buffers;
+      segments->m_ends = m_segments->m_ends;
+      m_segments = segments;
+    }
+}
+
+void
+Buffer::ReleaseSegments (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_segments == 0)
+    {
+      return;
+    }
+  m_segments->m_count--;
+  if (m_segments->m_count == 0)
+    {
+      RecycleSegments (m_segments);
+    }
+  m_segments = 0;
+}
+
+void
+Buffer::SliceSegments (uint32_t start, uint32_t end)
+{
+  NS_LOG_FUNCTION (this << start << end);
+  NS_ASSERT (start <= end && end <= m_segments->m_size);
+  if (start == end)
+    {
+      ReleaseSegments ();
+      return;
+    }
+  const std::vector<uint32_t> &ends = m_segments->m_ends;
+  uint32_t first = std::upper_bound (ends.begin (), ends.end (), start) - ends.begin ();
+  uint32_t last = std::lower_bound (ends.begin (), ends.end (), end) - ends.begin ();
+  Segments *segments = m_segments;
+  if (m_segments->m_count > 1)
+    {
+      // shared: only copy the segments which are kept.
+      m_segments->m_count--;
+      segments = CreateSegments ();
+      segments->m_base = m_segments->m_base;
+      segments->m_buffers.assign (m_segments->m_buffers.begin () + first,
+                                  m_segments->m_buffers.begin () + last + 1);
+      segments->m_ends.assign (m_segments->m_ends.begin () + first,
+                               m_segments->m_ends.begin () + last + 1);
+    }
+  else
+    {
+      segments->m_buffers.erase (segments->m_buffers.begin () + last + 1, segments->m_buffers.end ());
+      segments->m_buffers.erase (segments->m_buffers.begin (), segments->m_buffers.begin () + first);
+      segments->m_ends.erase (segments->m_ends.begin () + last + 1, segments->m_ends.end ());
+      segments->m_ends.erase (segments->m_ends.begin (), segments->m_ends.begin () + first);
+    }
+  m_segments = segments;
+  uint32_t firstStart = segments->m_ends[0] - segments->m_buffers[0].GetSize ();
+  segments->m_buffers.back ().RemoveAtEnd (segments->m_ends.back () - end);
+  segments->m_buffers.front ().RemoveAtStart (start - firstStart);
+  segments->m_ends.back () = end;
+  for (std::vector<uint32_t>::iterator i = segments->m_ends.begin (); i != segments->m_ends.end (); i++)
+    {
+      *i -= start;
+    }
+  segments->m_size = end - start;
+}
+
 int32_t 
 Buffer::GetCurrentStartOffset (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_segments != 0 && m_start == m_end)
+    {
+      return m_end + m_segments->m_base;
+    }
   return m_start;
 }
 int32_t 
 Buffer::GetCurrentEndOffset (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_segments != 0)
+    {
+      return m_end + m_segments->m_base + m_segments->m_size;
+    }
   return m_end;
 }
 
@@ -743,6 +1047,7 @@ void
 Buffer::CopyData (std::ostream *os, uint32_t size) const
 {
   NS_LOG_FUNCTION (this << &os << size);
+  uint32_t tailSize = size - std::min (size, m_end - m_start);
   if (size > 0)
     {
       uint32_t tmpsize = std::min (m_zeroAreaStart-m_start, size);
@@ -766,6 +1071,16 @@ Buffer::CopyData (std::ostream *os, uint32_t size) const
             }
         }
     }
+  if (m_segments != 0)
+    {
+      for (std::vector<Buffer>::const_iterator i = m_segments->m_buffers.begin ();
+           i != m_segments->m_buffers.end () && tailSize > 0; i++)
+        {
+          uint32_t tmpsize = std::min (i->GetSize (), tailSize);
+          i->CopyData (os, tmpsize);
+          tailSize -= tmpsize;
+        }
+    }
 }
 
 uint32_t 
@@ -795,10 +1110,21 @@ Buffer::CopyData (uint8_t *buffer, uint32_t size) const
             {
               tmpsize = std::min (m_end - m_zeroAreaEnd, size);
               memcpy (buffer, (const char*)(m_data->m_data + m_zeroAreaStart), tmpsize);
+              buffer += tmpsize;
               size -= tmpsize;
             }
         }
     }
+  if (m_segments != 0)
+    {
+      for (std::vector<Buffer>::const_iterator i = m_segments->m_buffers.begin ();
+           i != m_segments->m_buffers.end () && size > 0; i++)
+        {
+          uint32_t tmpsize = i->CopyData (buffer, size);
+          buffer += tmpsize;
+          size -= tmpsize;
+        }
+    }
   return originalSize - size;
 }
 
@@ -872,25 +1198,48 @@ Buffer::Iterator::Write (Iterator start, Iterator end)
   uint32_t size = end.m_current - start.m_current;
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + size),
                  GetWriteErrorMessage ());
+  if (end.m_current > start.m_tailStart || m_current + size > m_tailStart)
+    {
+      // segments on either side: copy through a small buffer.
+      uint8_t tmp[512];
+      while (size > 0)
+        {
+          uint32_t toCopy = std::min (size, static_cast<uint32_t> (sizeof (tmp)));
+          start.Read (tmp, toCopy);
+          Write (tmp, toCopy);
+          size -= toCopy;
+        }
+      return;
+    }
+  uint8_t *to;
+  if (m_current <= m_zeroStart)
+    {
+      to = &m_data[m_current];
+    }
+  else
+    {
+      to = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
+    }
   if (start.m_current <= start.m_zeroStart)
     {
       uint32_t toCopy = std::min (size, start.m_zeroStart - start.m_current);
-      memcpy (&m_data[m_current], &start.m_data[start.m_current], toCopy);
+      memcpy (to, &start.m_data[start.m_current], toCopy);
       start.m_current += toCopy;
       m_current += toCopy;
+      to += toCopy;
       size -= toCopy;
     }
   if (start.m_current <= start.m_zeroEnd)
     {
       uint32_t toCopy = std::min (size, start.m_zeroEnd - start.m_current);
-      memset (&m_data[m_current], 0, toCopy);
+      memset (to, 0, toCopy);
       start.m_current += toCopy;
       m_current += toCopy;
+      to += toCopy;
       size -= toCopy;
     }
   uint32_t toCopy = std::min (size, start.m_dataEnd - start.m_current);
   uint8_t *from = &start.m_data[start.m_current - (start.m_zeroEnd-start.m_zeroStart)];
-  uint8_t *to = &m_data[m_current];
   memcpy (to, from, toCopy);
   m_current += toCopy;
 }
@@ -984,6 +1333,11 @@ Buffer::Iterator::Write (uint8_t const*buffer, uint32_t size)
   NS_LOG_FUNCTION (this << &buffer << size);
   NS_ASSERT_MSG (CheckNoZero (m_current, size),
                  GetWriteErrorMessage ());
+  if (m_current + size > m_tailStart)
+    {
+      WriteTail (buffer, size);
+      return;
+    }
   uint8_t *to;
   if (m_current <= m_zeroStart)
     {
@@ -1152,12 +1506,104 @@ void
 Buffer::Iterator::Read (uint8_t *buffer, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &buffer << size);
+  if (m_current + size > m_tailStart)
+    {
+      ReadTail (buffer, size);
+      return;
+    }
   for (uint32_t i = 0; i < size; i++)
     {
       buffer[i] = ReadU8 ();
     }
 }
 
+void
+Buffer::Iterator::WriteTail (uint8_t const *buffer, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << &buffer << size);
+  if (m_current < m_tailStart)
+    {
+      uint32_t toWrite = m_tailStart - m_current;
+      Write (buffer, toWrite);
+      buffer += toWrite;
+      size -= toWrite;
+    }
+  NS_ASSERT_MSG (m_segments != 0 && m_current + size <= m_dataEnd,
+                 GetWriteErrorMessage ());
+  const std::vector<uint32_t> &ends = m_segments->m_ends;
+  uint32_t offset = m_current - m_tailStart;
+  uint32_t i = std::upper_bound (ends.begin (), ends.end (), offset) - ends.begin ();
+  while (size > 0)
+    {
+      uint32_t segmentStart = i == 0 ? 0 : ends[i - 1];
+      uint32_t toWrite = std::min (size, ends[i] - offset);
+      Buffer::Iterator j = m_segments->m_buffers[i].Begin ();
+      j.Next (offset - segmentStart);
+      j.Write (buffer, toWrite);
+      buffer += toWrite;
+      size -= toWrite;
+      offset += toWrite;
+      m_current += toWrite;
+      i++;
+    }
+}
+
+void
+Buffer::Iterator::ReadTail (uint8_t *buffer, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << &buffer << size);
+  if (m_current < m_tailStart)
+    {
+      uint32_t toRead = m_tailStart - m_current;
+      Read (buffer, toRead);
+      buffer += toRead;
+      size -= toRead;
+    }
+  NS_ASSERT_MSG (m_segments != 0 && m_current + size <= m_dataEnd,
+                 GetReadErrorMessage ());
+  const std::vector<uint32_t> &ends = m_segments->m_ends;
+  uint32_t offset = m_current - m_tailStart;
+  uint32_t i = std::upper_bound (ends.begin (), ends.end (), offset) - ends.begin ();
+  while (size > 0)
+    {
+      uint32_t segmentStart = i == 0 ? 0 : ends[i - 1];
+      uint32_t toRead = std::min (size, ends[i] - offset);
+      Buffer::Iterator j = m_segments->m_buffers[i].Begin ();
+      j.Next (offset - segmentStart);
+      j.Read (buffer, toRead);
+      buffer += toRead;
+      size -= toRead;
+      offset += toRead;
+      m_current += toRead;
+      i++;
+    }
+}
+
+uint8_t
+Buffer::Iterator::PeekTail (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (m_segments != 0 && m_current < m_dataEnd,
+                 GetReadErrorMessage ());
+  const std::vector<uint32_t> &ends = m_segments->m_ends;
+  uint32_t offset = m_current - m_tailStart;
+  uint32_t i = std::upper_bound (ends.begin (), ends.end (), offset) - ends.begin ();
+  const Buffer &b = m_segments->m_buffers[i];
+  uint32_t current = b.m_start + offset - (i == 0 ? 0 : ends[i - 1]);
+  if (current < b.m_zeroAreaStart)
+    {
+      return b.m_data->m_data[current];
+    }
+  else if (current < b.m_zeroAreaEnd)
+    {
+      return 0;
+    }
+  else
+    {
+      return b.m_data->m_data[current - (b.m_zeroAreaEnd - b.m_zeroAreaStart)];
+    }
+}
+
 uint16_t
 Buffer::Iterator::CalculateIpChecksum (uint16_t size)
 {
@@ -24,6 +24,7 @@
 #include <vector>
 #include <ostream>
 #include "ns3/assert.h"
+#include "packet-free-list.h"
 
 #define BUFFER_FREE_LIST 1
 
@@ -88,9 +89,21 @@ namespace ns3 {
  * \endverbatim
  *
  * A simple state invariant is that m_start <= m_zeroStart <= m_zeroEnd <= m_end
+ *
+ * The bytes described above may be followed by a list of "segments":
+ * other Buffer instances, shared by reference, whose content is
+ * logically appended to this one. AddAtEnd (const Buffer &) appends
+ * large buffers as segments instead of copying them and RemoveAtStart,
+ * RemoveAtEnd and CreateFragment slice the list of segments, so that
+ * aggregating, fragmenting and reassembling payloads costs a few
+ * pointer operations per segment. AddAtStart always works on the
+ * contiguous part in front of the segments, where headers are
+ * serialized. Iterators read and write across the segments through a
+ * slower path.
  */
 class Buffer 
 {
+  struct Segments;
 public:
   /**
    * \brief iterator in a Buffer instance
@@ -376,6 +389,18 @@ public:
      */
     uint32_t GetSize (void) const;
 
+    /**
+     * \param size number of bytes
+     * \returns a pointer to the next size bytes of the buffer if they are
+     *   stored contiguously, or zero if they reach the virtual zero area
+     *   or the segments of the buffer.
+     *
+     * The iterator is not moved. Most users should use Buffer::WriteSpan
+     * and Buffer::ReadSpan, which fall back to the Write and Read methods
+     * when the bytes are not contiguous.
+     */
+    inline uint8_t *GetSpan (uint32_t size) const;
+
 private:
     friend class Buffer;
     /**
@@ -432,6 +457,26 @@ private:
      * \warning this is the slow version, please use ReadNtohU32 (void)
      */
     uint32_t SlowReadNtohU32 (void);
+    /**
+     * \param buffer the bytes to write
+     * \param size the number of bytes to write
+     *
+     * Write data which reaches the segments of the buffer and advance
+     * the Iterator.
+     */
+    void WriteTail (uint8_t const *buffer, uint32_t size);
+    /**
+     * \param buffer the buffer to copy data into
+     * \param size the number of bytes to read
+     *
+     * Read data which reaches the segments of the buffer and advance
+     * the Iterator.
+     */
+    void ReadTail (uint8_t *buffer, uint32_t size);
+    /**
+     * \return the byte read in the segments of the buffer.
+     */
+    uint8_t PeekTail (void) const;
     /**
      * \brief Returns an appropriate message indicating a read error
      * \returns the error message
@@ -476,6 +521,211 @@ private:
      * to this pointer.
      */
     uint8_t *m_data;
+    /**
+     * offset in virtual bytes from the start of the data buffer to the
+     * start of the segments, that is, the end of the contiguous data.
+     */
+    uint32_t m_tailStart;
+    /**
+     * the segments of the buffer, if any.
+     */
+    Segments const *m_segments;
+  };
+
+  /**
+   * \brief Write a fixed number of bytes of a Buffer through a pointer.
+   *
+   * The bounds of the buffer are checked once, when the span is
+   * created, instead of once per field with the Iterator::Write
+   * methods, and the fields are then stored without any test.
+   * Headers can serialize themselves with:
+   * \code
+   * void
+   * MyHeader::Serialize (Buffer::Iterator start) const
+   * {
+   *   Buffer::WriteSpan span (start, 8);
+   *   span.WriteHtonU32 (m_sequence);
+   *   span.WriteHtonU32 (m_timestamp);
+   * }
+   * \endcode
+   *
+   * When the bytes are not stored contiguously, for example because
+   * they reach the segments of the buffer, they are written to a
+   * scratch area and copied through the iterator when the span is
+   * destroyed. The iterator is moved past the span when the span is
+   * destroyed, and all of its bytes must have been written by then.
+   */
+  class WriteSpan
+  {
+public:
+    /**
+     * \param i the iterator at the start of the span. It is moved
+     *   past the span when the span is destroyed.
+     * \param size the number of bytes of the span
+     */
+    inline WriteSpan (Iterator &i, uint32_t size);
+    /**
+     * Copy the bytes to the buffer if needed and move the iterator.
+     */
+    inline ~WriteSpan ();
+
+    /**
+     * \param data data to write
+     *
+     * Write one byte and move forward by one byte.
+     */
+    inline void WriteU8 (uint8_t data);
+    /**
+     * \param data data to write
+     * \param len number of times data must be written
+     */
+    inline void WriteU8 (uint8_t data, uint32_t len);
+    /**
+     * \param data data to write, in the byte order of the host, as
+     *   with Iterator::WriteU16.
+     */
+    inline void WriteU16 (uint16_t data);
+    /**
+     * \param data data to write, in network order
+     */
+    inline void WriteHtonU16 (uint16_t data);
+    /**
+     * \param data data to write, in network order
+     */
+    inline void WriteHtonU32 (uint32_t data);
+    /**
+     * \param data data to write, in network order
+     */
+    inline void WriteHtonU64 (uint64_t data);
+    /**
+     * \param data data to write, in least significant byte order
+     */
+    inline void WriteHtolsbU16 (uint16_t data);
+    /**
+     * \param data data to write, in least significant byte order
+     */
+    inline void WriteHtolsbU32 (uint32_t data);
+    /**
+     * \param data data to write, in least significant byte order
+     */
+    inline void WriteHtolsbU64 (uint64_t data);
+    /**
+     * \param buffer the bytes to copy
+     * \param size the number of bytes to copy
+     */
+    inline void Write (uint8_t const *buffer, uint32_t size);
+
+private:
+    /**
+     * Disable copy.
+     * \param o the span to copy
+     */
+    WriteSpan (const WriteSpan &o);
+    /**
+     * Disable assignment.
+     * \param o the span to copy
+     * \returns this span
+     */
+    WriteSpan &operator = (const WriteSpan &o);
+
+    /** The size of the scratch area kept in the span itself. */
+    static const uint32_t SCRATCH_SIZE = 64;
+
+    Iterator &m_iterator;             //!< the iterator to move
+    uint8_t *m_start;                 //!< the first byte of the span
+    uint8_t *m_current;               //!< the next byte to write
+    uint32_t m_size;                  //!< the size of the span
+    bool m_direct;                    //!< true if m_start points into the buffer
+    uint8_t m_scratch[SCRATCH_SIZE];  //!< the bytes of small non contiguous spans
+  };
+
+  /**
+   * \brief Read a fixed number of bytes of a Buffer through a pointer.
+   *
+   * This is the counterpart of WriteSpan for Header::Deserialize: the
+   * bounds are checked once, when the span is created, and the iterator
+   * is moved past the span right away. Bytes which are not stored
+   * contiguously, including virtual zero bytes, are first copied to a
+   * scratch area.
+   */
+  class ReadSpan
+  {
+public:
+    /**
+     * \param i the iterator at the start of the span. It is moved
+     *   past the span.
+     * \param size the number of bytes of the span
+     */
+    inline ReadSpan (Iterator &i, uint32_t size);
+    inline ~ReadSpan ();
+
+    /**
+     * \returns the next byte, without moving forward
+     */
+    inline uint8_t PeekU8 (void) const;
+    /**
+     * \returns the next byte
+     */
+    inline uint8_t ReadU8 (void);
+    /**
+     * \returns the next two bytes, in the byte order of the host, as
+     *   with Iterator::ReadU16.
+     */
+    inline uint16_t ReadU16 (void);
+    /**
+     * \returns the next two bytes, read in network order
+     */
+    inline uint16_t ReadNtohU16 (void);
+    /**
+     * \returns the next four bytes, read in network order
+     */
+    inline uint32_t ReadNtohU32 (void);
+    /**
+     * \returns the next eight bytes, read in network order
+     */
+    inline uint64_t ReadNtohU64 (void);
+    /**
+     * \returns the next two bytes, read in least significant byte order
+     */
+    inline uint16_t ReadLsbtohU16 (void);
+    /**
+     * \returns the next four bytes, read in least significant byte order
+     */
+    inline uint32_t ReadLsbtohU32 (void);
+    /**
+     * \returns the next eight bytes, read in least significant byte order
+     */
+    inline uint64_t ReadLsbtohU64 (void);
+    /**
+     * \param buffer where to copy the bytes
+     * \param size the number of bytes to copy
+     */
+    inline void Read (uint8_t *buffer, uint32_t size);
+    /**
+     * \param delta the number of bytes to skip
+     */
+    inline void Next (uint32_t delta);
+
+private:
+    /**
+     * Disable copy.
+     * \param o the span to copy
+     */
+    ReadSpan (const ReadSpan &o);
+    /**
+     * Disable assignment.
+     * \param o the span to copy
+     * \returns this span
+     */
+    ReadSpan &operator = (const ReadSpan &o);
+
+    /** The size of the scratch area kept in the span itself. */
+    static const uint32_t SCRATCH_SIZE = 64;
+
+    const uint8_t *m_current;         //!< the next byte to read
+    const uint8_t *m_end;             //!< the end of the span
+    uint8_t *m_heap;                  //!< the bytes of large non contiguous spans
+    uint8_t m_scratch[SCRATCH_SIZE];  //!< the bytes of small non contiguous spans
   };
 
   /**
@@ -523,6 +773,9 @@ private:
    * Add bytes at the end of the Buffer.
    * Any call to this method invalidates any Iterator
    * pointing to this Buffer.
+   *
+   * The virtual zero areas of the two buffers are merged when they
+   * are adjacent. Otherwise, only the smaller one is materialized.
    */
   void AddAtEnd (const Buffer &o);
   /**
@@ -598,6 +851,43 @@ private:
    */
   uint32_t Deserialize (const uint8_t* buffer, uint32_t size);
 
+  /**
+   * \returns the number of segments which follow the contiguous
+   * part of this buffer.
+   */
+  uint32_t GetSegmentN (void) const;
+  /**
+   * \param size the size from which AddAtEnd (const Buffer &)
+   * appends a buffer as a segment rather than by copy. The default
+   * is 128 bytes; std::numeric_limits<uint32_t>::max () disables
+   * segments.
+   *
+   * Once a buffer has segments, all the buffers appended to it are
+   * appended as segments.
+   */
+  static void SetMinSegmentSize (uint32_t size);
+
+  /**
+   * \returns the number of bytes of the "virtual zero area", which
+   * are part of the buffer but are not stored in memory, including
+   * the ones of its segments.
+   */
+  uint32_t GetZeroAreaSize (void) const;
+  /**
+   * \returns the number of bytes of "virtual zero area" turned into
+   * real zero bytes in memory since the start of the program.
+   *
+   * This happens when the buffer is accessed with PeekData, copied
+   * with CreateFullCopy, or when AddAtEnd appends a buffer whose zero
+   * area cannot be merged with the one of this buffer.
+   */
+  static uint64_t GetMaterializedBytes (void);
+  /**
+   * \returns the counters of the free list of the buffer data, summed
+   * over all the threads which created buffers.
+   */
+  static PacketPoolStats GetPoolStats (void);
+
   /**
    * \brief Returns the current buffer start offset
    * \return the offset
@@ -700,6 +990,40 @@ private:
     uint8_t m_data[1];
   };
 
+  /**
+   * \returns a copy of this buffer with the content of its segments
+   * copied in its contiguous part.
+   */
+  Buffer Flatten (void) const;
+  /**
+   * \param b the buffer to add at the end of the segments.
+   */
+  void AppendSegment (const Buffer &b);
+  /**
+   * \returns new segments, empty, with a reference count of one.
+   */
+  static Segments *CreateSegments (void);
+  /**
+   * \param segments segments which are not referenced anymore.
+   */
+  static void RecycleSegments (Segments *segments);
+  /**
+   * \brief Make sure the segments are not shared with another buffer.
+   */
+  void DetachSegments (void);
+  /**
+   * \brief Drop the reference to the segments.
+   */
+  void ReleaseSegments (void);
+  /**
+   * \param start the offset of the first byte to keep in the segments
+   * \param end the offset of the end of the bytes to keep
+   *
+   * Keep only [start, end) of the segments, copying them first
+   * if they are shared.
+   */
+  void SliceSegments (uint32_t start, uint32_t end);
+
   /**
    * \brief Transform a "Virtual byte buffer" into a "Real byte buffer"
    */
@@ -772,9 +1096,13 @@ private:
   /**
    * location in a newly-allocated buffer where you should start
    * writing data. i.e., m_start should be initialized to this 
-   * value.
+   * value. Every thread has its own.
    */
-  static uint32_t g_recommendedStart;
+  static __thread uint32_t g_recommendedStart;
+  /** Number of virtual zero bytes materialized so far. */
+  static uint64_t g_materializedBytes;
+  /** The size from which AddAtEnd appends buffers as segments. */
+  static uint32_t g_minSegmentSize;
 
   /**
    * offset to the start of the virtual zero area from the start
@@ -796,19 +1124,29 @@ private:
    * instance from the start of m_data->m_data
    */
   uint32_t m_end;
+  /**
+   * the segments which follow m_end, zero if there are none.
+   */
+  Segments *m_segments;
+};
 
-#ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  /// Local static destructor structure
-  struct LocalStaticDestructor 
-  {
-    ~LocalStaticDestructor ();
-  };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
-#endif
+/**
+ * The segments of a Buffer. They are shared by the copies of a Buffer
+ * and copied before being modified. A segment never has segments.
+ */
+struct Buffer::Segments
+{
+  uint32_t m_count; //!< the reference count
+  /**
+   * the virtual offset of the first byte of the segments minus the
+   * offset of the end of the contiguous data, used to keep the
+   * offsets returned by GetCurrentStartOffset stable when the
+   * contiguous data or the first segments are removed.
+   */
+  uint32_t m_base;
+  uint32_t m_size; //!< the total size of the segments
+  std::vector<Buffer> m_buffers; //!< the segments
+  std::vector<uint32_t> m_ends; //!< the end of each segment, from the start of the first one
 };
 
 } // namespace ns3
@@ -824,7 +1162,9 @@ Buffer::Iterator::Iterator ()
     m_dataStart (0),
     m_dataEnd (0),
     m_current (0),
-    m_data (0)
+    m_data (0),
+    m_tailStart (0),
+    m_segments (0)
 {
 }
 Buffer::Iterator::Iterator (Buffer const*buffer)
@@ -846,6 +1186,12 @@ Buffer::Iterator::Construct (const Buffer *buffer)
   m_dataStart = buffer->m_start;
   m_dataEnd = buffer->m_end;
   m_data = buffer->m_data->m_data;
+  m_tailStart = buffer->m_end;
+  m_segments = buffer->m_segments;
+  if (m_segments != 0)
+    {
+      m_dataEnd += m_segments->m_size;
+    }
 }
 
 void 
@@ -883,11 +1229,15 @@ Buffer::Iterator::WriteU8 (uint8_t data)
       m_data[m_current] = data;
       m_current++;
     }
-  else
+  else if (m_current < m_tailStart)
     {
       m_data[m_current - (m_zeroEnd-m_zeroStart)] = data;
       m_current++;
     }
+  else
+    {
+      WriteTail (&data, 1);
+    }
 }
 
 void 
@@ -895,7 +1245,14 @@ Buffer::Iterator::WriteU8 (uint8_t  data, uint32_t len)
 {
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + len),
                  GetWriteErrorMessage ());
-  if (m_current <= m_zeroStart)
+  if (m_current + len > m_tailStart)
+    {
+      for (uint32_t i = 0; i < len; i++)
+        {
+          WriteU8 (data);
+        }
+    }
+  else if (m_current <= m_zeroStart)
     {
       std::memset (&(m_data[m_current]), data, len);
       m_current += len;
@@ -913,6 +1270,14 @@ Buffer::Iterator::WriteHtonU16 (uint16_t data)
 {
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + 2),
                  GetWriteErrorMessage ());
+  if (m_current + 2 > m_tailStart)
+    {
+      uint8_t tmp[2];
+      tmp[0] = (data >> 8) & 0xff;
+      tmp[1] = (data >> 0) & 0xff;
+      WriteTail (tmp, 2);
+      return;
+    }
   uint8_t *buffer;
   if (m_current + 2 <= m_zeroStart)
     {
@@ -933,6 +1298,16 @@ Buffer::Iterator::WriteHtonU32 (uint32_t data)
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + 4),
                  GetWriteErrorMessage ());
 
+  if (m_current + 4 > m_tailStart)
+    {
+      uint8_t tmp[4];
+      tmp[0] = (data >> 24) & 0xff;
+      tmp[1] = (data >> 16) & 0xff;
+      tmp[2] = (data >> 8) & 0xff;
+      tmp[3] = (data >> 0) & 0xff;
+      WriteTail (tmp, 4);
+      return;
+    }
   uint8_t *buffer;
   if (m_current + 4 <= m_zeroStart)
     {
@@ -957,7 +1332,7 @@ Buffer::Iterator::ReadNtohU16 (void)
     {
       buffer = &m_data[m_current];
     }
-  else if (m_current >= m_zeroEnd)
+  else if (m_current >= m_zeroEnd && m_current + 2 <= m_tailStart)
     {
       buffer = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
     }
@@ -981,7 +1356,7 @@ Buffer::Iterator::ReadNtohU32 (void)
     {
       buffer = &m_data[m_current];
     }
-  else if (m_current >= m_zeroEnd)
+  else if (m_current >= m_zeroEnd && m_current + 4 <= m_tailStart)
     {
       buffer = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
     }
@@ -1017,11 +1392,15 @@ Buffer::Iterator::PeekU8 (void)
     {
       return 0;
     }
-  else
+  else if (m_current < m_tailStart)
     {
       uint8_t data = m_data[m_current - (m_zeroEnd-m_zeroStart)];
       return data;
     }
+  else
+    {
+      return PeekTail ();
+    }
 }
 
 uint8_t
@@ -1054,21 +1433,286 @@ Buffer::Iterator::Read (Buffer::Iterator start, uint32_t size)
 }
 
 
+uint8_t *
+Buffer::Iterator::GetSpan (uint32_t size) const
+{
+  if (m_current + size <= m_zeroStart)
+    {
+      return &m_data[m_current];
+    }
+  else if (m_current >= m_zeroEnd && m_current + size <= m_tailStart)
+    {
+      return &m_data[m_current - (m_zeroEnd - m_zeroStart)];
+    }
+  return 0;
+}
+
+Buffer::WriteSpan::WriteSpan (Iterator &i, uint32_t size)
+  : m_iterator (i),
+    m_size (size)
+{
+  NS_ASSERT_MSG (i.m_current >= i.m_dataStart && i.m_current + size <= i.m_dataEnd
+                 && i.CheckNoZero (i.m_current, i.m_current + size),
+                 i.GetWriteErrorMessage ());
+  m_start = i.GetSpan (size);
+  m_direct = m_start != 0;
+  if (!m_direct)
+    {
+      m_start = size <= SCRATCH_SIZE ? m_scratch : new uint8_t [size];
+    }
+  m_current = m_start;
+}
+
+Buffer::WriteSpan::~WriteSpan ()
+{
+  NS_ASSERT_MSG (m_current == m_start + m_size,
+                 "Only " << m_current - m_start << " bytes of a span of " << m_size << " were written");
+  if (m_direct)
+    {
+      m_iterator.Next (m_size);
+      return;
+    }
+  m_iterator.Write (m_start, m_size);
+  if (m_start != m_scratch)
+    {
+      delete [] m_start;
+    }
+}
+
+void
+Buffer::WriteSpan::WriteU8 (uint8_t data)
+{
+  NS_ASSERT (m_current + 1 <= m_start + m_size);
+  *m_current++ = data;
+}
+
+void
+Buffer::WriteSpan::WriteU8 (uint8_t data, uint32_t len)
+{
+  NS_ASSERT (m_current + len <= m_start + m_size);
+  std::memset (m_current, data, len);
+  m_current += len;
+}
+
+void
+Buffer::WriteSpan::WriteU16 (uint16_t data)
+{
+  NS_ASSERT (m_current + 2 <= m_start + m_size);
+  std::memcpy (m_current, &data, 2);
+  m_current += 2;
+}
+
+void
+Buffer::WriteSpan::WriteHtonU16 (uint16_t data)
+{
+  NS_ASSERT (m_current + 2 <= m_start + m_size);
+  m_current[0] = (data >> 8) & 0xff;
+  m_current[1] = (data >> 0) & 0xff;
+  m_current += 2;
+}
+
+void
+Buffer::WriteSpan::WriteHtonU32 (uint32_t data)
+{
+  NS_ASSERT (m_current + 4 <= m_start + m_size);
+  m_current[0] = (data >> 24) & 0xff;
+  m_current[1] = (data >> 16) & 0xff;
+  m_current[2] = (data >> 8) & 0xff;
+  m_current[3] = (data >> 0) & 0xff;
+  m_current += 4;
+}
+
+void
+Buffer::WriteSpan::WriteHtonU64 (uint64_t data)
+{
+  WriteHtonU32 (data >> 32);
+  WriteHtonU32 (data & 0xffffffff);
+}
+
+void
+Buffer::WriteSpan::WriteHtolsbU16 (uint16_t data)
+{
+  NS_ASSERT (m_current + 2 <= m_start + m_size);
+  m_current[0] = (data >> 0) & 0xff;
+  m_current[1] = (data >> 8) & 0xff;
+  m_current += 2;
+}
+
+void
+Buffer::WriteSpan::WriteHtolsbU32 (uint32_t data)
+{
+  NS_ASSERT (m_current + 4 <= m_start + m_size);
+  m_current[0] = (data >> 0) & 0xff;
+  m_current[1] = (data >> 8) & 0xff;
+  m_current[2] = (data >> 16) & 0xff;
+  m_current[3] = (data >> 24) & 0xff;
+  m_current += 4;
+}
+
+void
+Buffer::WriteSpan::WriteHtolsbU64 (uint64_t data)
+{
+  WriteHtolsbU32 (data & 0xffffffff);
+  WriteHtolsbU32 (data >> 32);
+}
+
+void
+Buffer::WriteSpan::Write (uint8_t const *buffer, uint32_t size)
+{
+  NS_ASSERT (m_current + size <= m_start + m_size);
+  std::memcpy (m_current, buffer, size);
+  m_current += size;
+}
+
+Buffer::ReadSpan::ReadSpan (Iterator &i, uint32_t size)
+  : m_heap (0)
+{
+  NS_ASSERT_MSG (i.m_current >= i.m_dataStart && i.m_current + size <= i.m_dataEnd,
+                 i.GetReadErrorMessage ());
+  m_current = i.GetSpan (size);
+  if (m_current != 0)
+    {
+      i.Next (size);
+    }
+  else
+    {
+      uint8_t *copy = m_scratch;
+      if (size > SCRATCH_SIZE)
+        {
+          copy = m_heap = new uint8_t [size];
+        }
+      i.Read (copy, size);
+      m_current = copy;
+    }
+  m_end = m_current + size;
+}
+
+Buffer::ReadSpan::~ReadSpan ()
+{
+  delete [] m_heap;
+}
+
+uint8_t
+Buffer::ReadSpan::PeekU8 (void) const
+{
+  NS_ASSERT (m_current + 1 <= m_end);
+  return *m_current;
+}
+
+uint8_t
+Buffer::ReadSpan::ReadU8 (void)
+{
+  NS_ASSERT (m_current + 1 <= m_end);
+  return *m_current++;
+}
+
+uint16_t
+Buffer::ReadSpan::ReadU16 (void)
+{
+  NS_ASSERT (m_current + 2 <= m_end);
+  uint16_t data;
+  std::memcpy (&data, m_current, 2);
+  m_current += 2;
+  return data;
+}
+
+uint16_t
+Buffer::ReadSpan::ReadNtohU16 (void)
+{
+  NS_ASSERT (m_current + 2 <= m_end);
+  uint16_t data = (m_current[0] << 8) | m_current[1];
+  m_current += 2;
+  return data;
+}
+
+uint32_t
+Buffer::ReadSpan::ReadNtohU32 (void)
+{
+  NS_ASSERT (m_current + 4 <= m_end);
+  uint32_t data = (static_cast<uint32_t> (m_current[0]) << 24)
+    | (static_cast<uint32_t> (m_current[1]) << 16)
+    | (static_cast<uint32_t> (m_current[2]) << 8)
+    | static_cast<uint32_t> (m_current[3]);
+  m_current += 4;
+  return data;
+}
+
+uint64_t
+Buffer::ReadSpan::ReadNtohU64 (void)
+{
+  uint64_t data = ReadNtohU32 ();
+  data <<= 32;
+  return data | ReadNtohU32 ();
+}
+
+uint16_t
+Buffer::ReadSpan::ReadLsbtohU16 (void)
+{
+  NS_ASSERT (m_current + 2 <= m_end);
+  uint16_t data = m_current[0] | (m_current[1] << 8);
+  m_current += 2;
+  return data;
+}
+
+uint32_t
+Buffer::ReadSpan::ReadLsbtohU32 (void)
+{
+  NS_ASSERT (m_current + 4 <= m_end);
+  uint32_t data = static_cast<uint32_t> (m_current[0])
+    | (static_cast<uint32_t> (m_current[1]) << 8)
+    | (static_cast<uint32_t> (m_current[2]) << 16)
+    | (static_cast<uint32_t> (m_current[3]) << 24);
+  m_current += 4;
+  return data;
+}
+
+uint64_t
+Buffer::ReadSpan::ReadLsbtohU64 (void)
+{
+  uint64_t data = ReadLsbtohU32 ();
+  return data | (static_cast<uint64_t> (ReadLsbtohU32 ()) << 32);
+}
+
+void
+Buffer::ReadSpan::Read (uint8_t *buffer, uint32_t size)
+{
+  NS_ASSERT (m_current + size <= m_end);
+  std::memcpy (buffer, m_current, size);
+  m_current += size;
+}
+
+void
+Buffer::ReadSpan::Next (uint32_t delta)
+{
+  NS_ASSERT (m_current + delta <= m_end);
+  m_current += delta;
+}
+
+
 Buffer::Buffer (Buffer const&o)
   : m_data (o.m_data),
     m_maxZeroAreaStart (o.m_zeroAreaStart),
     m_zeroAreaStart (o.m_zeroAreaStart),
     m_zeroAreaEnd (o.m_zeroAreaEnd),
     m_start (o.m_start),
-    m_end (o.m_end)
+    m_end (o.m_end),
+    m_segments (o.m_segments)
 {
   m_data->m_count++;
+  if (m_segments != 0)
+    {
+      m_segments->m_count++;
+    }
   NS_ASSERT (CheckInternalState ());
 }
 
 uint32_t 
 Buffer::GetSize (void) const
 {
+  if (m_segments != 0)
+    {
+      return m_end - m_start + m_segments->m_size;
+    }
   return m_end - m_start;
 }
 
@@ -22,6 +22,7 @@
 #include "ns3/log.h"
 #include "ns3/uinteger.h"
 #include "net-device.h"
+#include "packet.h"
 
 namespace ns3 {
 
@@ -43,4 +44,26 @@ NetDevice::~NetDevice ()
   NS_LOG_FUNCTION (this);
 }
 
+uint32_t
+NetDevice::SendBatch (const std::vector<Ptr<Packet> > &packets, const Address& dest, uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (this << packets.size () << dest << protocolNumber);
+  uint32_t sent = 0;
+  for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+    {
+      if (!Send (*i, dest, protocolNumber))
+        {
+          break;
+        }
+      sent++;
+    }
+  return sent;
+}
+
+void
+NetDevice::SetReceiveBatchCallback (ReceiveBatchCallback cb)
+{
+  NS_LOG_FUNCTION (this << &cb);
+}
+
 } // namespace ns3
@@ -22,6 +22,7 @@
 #define NET_DEVICE_H
 
 #include <string>
+#include <vector>
 #include <stdint.h>
 #include "ns3/callback.h"
 #include "ns3/object.h"
@@ -236,6 +237,22 @@ public:
    * \return whether the Send operation succeeded 
    */
   virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber) = 0;
+  /**
+   * \param packets packets sent from above down to Network Device
+   * \param dest mac address of the destination (already resolved)
+   * \param protocolNumber identifies the type of payload contained in
+   *        these packets.
+   *
+   *  Called from higher layer to send a burst of packets to the same
+   *  destination. Devices which support it transmit the burst as a
+   *  single train, with one event per burst rather than per packet on
+   *  the channel. The default implementation calls Send for each packet
+   *  and stops at the first failure.
+   *
+   * \return the number of packets, counted from the start of the burst,
+   *         which were accepted
+   */
+  virtual uint32_t SendBatch (const std::vector<Ptr<Packet> > &packets, const Address& dest, uint16_t protocolNumber);
   /**
    * \returns the node base class which contains this network
    *          interface.
@@ -302,6 +319,29 @@ public:
    */
   virtual void SetReceiveCallback (ReceiveCallback cb) = 0;
 
+  /**
+   * \param device a pointer to the net device which is calling this callback
+   * \param packets the packets received, in order
+   * \param protocol the 16 bit protocol number associated with these packets.
+   * \param sender the address of the sender
+   * \returns true if the callback could handle the packets successfully, false
+   *          otherwise.
+   */
+  typedef Callback< bool, Ptr<NetDevice>, const std::vector<Ptr<const Packet> > &, uint16_t,
+                    const Address & > ReceiveBatchCallback;
+
+  /**
+   * \param cb callback to invoke whenever a train of packets with the same
+   *        protocol and sender has been received and must be forwarded to
+   *        the higher layers.
+   *
+   * Devices which receive packet trains deliver them through this callback
+   * when it is set, and through the ReceiveCallback otherwise. The default
+   * implementation ignores the callback: all the packets are delivered
+   * through the ReceiveCallback.
+   */
+  virtual void SetReceiveBatchCallback (ReceiveBatchCallback cb);
+
 
   /**
    * \param device a pointer to the net device which is calling this callback
@@ -135,6 +135,11 @@ NodeListPriv::DoGet (void)
     {
       ptr = CreateObject<NodeListPriv> ();
       Config::RegisterRootNamespaceObject (ptr);
+      // NodeListPriv::Add, Node::AddDevice and Node::AddApplication
+      // invalidate the objects cached by Config.
+      Config::RegisterCachedContainer (NodeListPriv::GetTypeId (), "NodeList");
+      Config::RegisterCachedContainer (Node::GetTypeId (), "DeviceList");
+      Config::RegisterCachedContainer (Node::GetTypeId (), "ApplicationList");
       Simulator::ScheduleDestroy (&NodeListPriv::Delete);
     }
   return &ptr;
@@ -168,6 +173,7 @@ NodeListPriv::DoDispose (void)
       *i = 0;
     }
   m_nodes.erase (m_nodes.begin (), m_nodes.end ());
+  Config::InvalidateCache ();
   Object::DoDispose ();
 }
 
@@ -178,6 +184,7 @@ NodeListPriv::Add (Ptr<Node> node)
   NS_LOG_FUNCTION (this << node);
   uint32_t index = m_nodes.size ();
   m_nodes.push_back (node);
+  Config::InvalidateCache ();
   Simulator::ScheduleWithContext (index, TimeStep (0), &Node::Initialize, node);
   return index;
 
@@ -25,6 +25,7 @@
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/object-vector.h"
+#include "ns3/config.h"
 #include "ns3/uinteger.h"
 #include "ns3/log.h"
 #include "ns3/assert.h"
@@ -67,7 +68,7 @@ Node::GetTypeId (void)
                    MakeUintegerAccessor (&Node::m_id),
                    MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("SystemId", "The systemId of this node: a unique integer used for parallel simulations.",
-                   TypeId::ATTR_GET || TypeId::ATTR_SET,
+                   TypeId::ATTR_GET | TypeId::ATTR_SET,
                    UintegerValue (0),
                    MakeUintegerAccessor (&Node::m_sid),
                    MakeUintegerChecker<uint32_t> ())
@@ -123,9 +124,11 @@ Node::AddDevice (Ptr<NetDevice> device)
   NS_LOG_FUNCTION (this << device);
   uint32_t index = m_devices.size ();
   m_devices.push_back (device);
+  Config::InvalidateCache ();
   device->SetNode (this);
   device->SetIfIndex (index);
   device->SetReceiveCallback (MakeCallback (&Node::NonPromiscReceiveFromDevice, this));
+  device->SetReceiveBatchCallback (MakeCallback (&Node::ReceiveBatchFromDevice, this));
   Simulator::ScheduleWithContext (GetId (), Seconds (0.0), 
                                   &NetDevice::Initialize, device);
   NotifyDeviceAdded (device);
@@ -152,6 +155,7 @@ Node::AddApplication (Ptr<Application> application)
   NS_LOG_FUNCTION (this << application);
   uint32_t index = m_applications.size ();
   m_applications.push_back (application);
+  Config::InvalidateCache ();
   application->SetNode (this);
   Simulator::ScheduleWithContext (GetId (), Seconds (0.0), 
                                   &Application::Initialize, application);
@@ -194,6 +198,7 @@ Node::DoDispose ()
       *i = 0;
     }
   m_applications.clear ();
+  Config::InvalidateCache ();
   Object::DoDispose ();
 }
 void 
@@ -250,6 +255,17 @@ Node::RegisterProtocolHandler (ProtocolHandler handler,
   m_handlers.push_back (entry);
 }
 
+void
+Node::RegisterProtocolHandler (ProtocolHandler handler,
+                               BatchProtocolHandler batchHandler,
+                               uint16_t protocolType,
+                               Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (this << &handler << &batchHandler << protocolType << device);
+  RegisterProtocolHandler (handler, protocolType, device, false);
+  m_handlers.back ().batchHandler = batchHandler;
+}
+
 void
 Node::UnregisterProtocolHandler (ProtocolHandler handler)
 {
@@ -322,6 +338,42 @@ Node::ReceiveFromDevice (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16
     }
   return found;
 }
+
+bool
+Node::ReceiveBatchFromDevice (Ptr<NetDevice> device, const std::vector<Ptr<const Packet> > &packets,
+                              uint16_t protocol, const Address &from)
+{
+  NS_LOG_FUNCTION (this << device << packets.size () << protocol << &from);
+  NS_ASSERT_MSG (Simulator::GetContext () == GetId (), "Received packet with erroneous context ; " <<
+                 "make sure the channels in use are correctly updating events context " <<
+                 "when transfering events from one node to another.");
+  Address to = device->GetAddress ();
+  bool found = false;
+
+  for (ProtocolHandlerList::iterator i = m_handlers.begin ();
+       i != m_handlers.end (); i++)
+    {
+      if ((i->device == 0 || i->device == device)
+          && (i->protocol == 0 || i->protocol == protocol)
+          && !i->promiscuous)
+        {
+          if (!i->batchHandler.IsNull ())
+            {
+              i->batchHandler (device, packets, protocol, from, to, NetDevice::PacketType (0));
+            }
+          else
+            {
+              for (std::vector<Ptr<const Packet> >::const_iterator j = packets.begin ();
+                   j != packets.end (); ++j)
+                {
+                  i->handler (device, *j, protocol, from, to, NetDevice::PacketType (0));
+                }
+            }
+          found = true;
+        }
+    }
+  return found;
+}
 void 
 Node::RegisterDeviceAdditionListener (DeviceAdditionListener listener)
 {
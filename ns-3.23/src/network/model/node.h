@@ -163,6 +163,37 @@ public:
                                 uint16_t protocolType,
                                 Ptr<NetDevice> device,
                                 bool promiscuous=false);
+  /**
+   * A protocol handler for trains of packets
+   *
+   * \param device a pointer to the net device which received the packets
+   * \param packets the packets received, in order
+   * \param protocol the 16 bit protocol number associated with these packets.
+   * \param sender the address of the sender
+   * \param receiver the address of the receiver, that is, the value of
+   *                 device->GetAddress().
+   * \param packetType type of packets received; always zero since batch
+   *                   handlers are never promiscuous.
+   */
+  typedef Callback<void,Ptr<NetDevice>, const std::vector<Ptr<const Packet> > &,uint16_t,
+                   const Address &, const Address &, NetDevice::PacketType> BatchProtocolHandler;
+  /**
+   * Register a non-promiscuous protocol handler which can also receive
+   * the trains of packets delivered by devices which support
+   * NetDevice::SetReceiveBatchCallback. Handlers registered without a
+   * batch handler receive these trains one packet at a time.
+   *
+   * \param handler the handler of single packets
+   * \param batchHandler the handler of packet trains
+   * \param protocolType the type of protocol this handler is
+   *        interested in, or zero for all protocols.
+   * \param device the device attached to this handler, or zero
+   *        for all the devices of this node.
+   */
+  void RegisterProtocolHandler (ProtocolHandler handler,
+                                BatchProtocolHandler batchHandler,
+                                uint16_t protocolType,
+                                Ptr<NetDevice> device);
   /**
    * \param handler the handler to unregister
    *
@@ -249,6 +280,16 @@ private:
    */
   bool ReceiveFromDevice (Ptr<NetDevice> device, Ptr<const Packet>, uint16_t protocol,
                           const Address &from, const Address &to, NetDevice::PacketType packetType, bool promisc);
+  /**
+   * \brief Receive a train of packets from a device in non-promiscuous mode.
+   * \param device the device
+   * \param packets the packets
+   * \param protocol the protocol
+   * \param from the sender
+   * \returns true if the packets have been delivered to a protocol handler.
+   */
+  bool ReceiveBatchFromDevice (Ptr<NetDevice> device, const std::vector<Ptr<const Packet> > &packets,
+                               uint16_t protocol, const Address &from);
 
   /**
    * \brief Finish node's construction by setting the correct node ID.
@@ -261,6 +302,7 @@ private:
    */
   struct ProtocolHandlerEntry {
     ProtocolHandler handler; //!< the protocol handler
+    BatchProtocolHandler batchHandler; //!< the handler of packet trains, if any
     Ptr<NetDevice> device;   //!< the NetDevice
     uint16_t protocol;       //!< the protocol number
     bool promiscuous;        //!< true if it is a promiscuous handler
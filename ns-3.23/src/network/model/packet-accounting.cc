@@ -0,0 +1,548 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "packet-accounting.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/system-mutex.h"
+#include "ns3/core-config.h"
+#include "ns3/network-config.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <cxxabi.h>
+#ifdef HAVE_EXECINFO_H
+#include <execinfo.h>
+#endif
+#ifdef HAVE_DLADDR
+#include <dlfcn.h>
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PacketAccounting");
+
+bool PacketAccounting::m_enabled = false;
+uint32_t PacketAccounting::m_session = 0;
+
+namespace {
+
+/** Number of return addresses kept for each uid. */
+const int FRAMES = 6;
+
+/** The live objects of a uid. */
+struct Record
+{
+  const void *frames[FRAMES]; /**< Call stack of the first object. */
+  int depth;                  /**< Number of valid frames. */
+  Time created;               /**< Creation time of the first object. */
+  uint32_t objects;           /**< Number of live objects. */
+  uint64_t bytes;             /**< Total size of the live objects. */
+};
+
+/** Where a packet was created. */
+struct Location
+{
+  std::string module;   /**< The library. */
+  std::string function; /**< The function. */
+};
+
+/** The side table, by uid. */
+typedef std::map<uint64_t, Record> Table;
+
+/** \returns The side table. */
+Table &
+GetTable (void)
+{
+  static Table table;
+  return table;
+}
+
+/** \returns The mutex which protects the side table. */
+SystemMutex &
+GetMutex (void)
+{
+  static SystemMutex mutex;
+  return mutex;
+}
+
+/**
+ * \param mangled A mangled C++ name.
+ * \returns The demangled name, or mangled if it cannot be demangled.
+ */
+std::string
+Demangle (const char *mangled)
+{
+  int status;
+  char *demangled = abi::__cxa_demangle (mangled, 0, 0, &status);
+  if (status != 0 || demangled == 0)
+    {
+      return mangled;
+    }
+  std::string name = demangled;
+  std::free (demangled);
+  return name;
+}
+
+/**
+ * \param filename The path of a library or program.
+ * \returns The name of the ns-3 module, for the libraries of ns-3.
+ */
+std::string
+GetModuleName (std::string filename)
+{
+  std::string::size_type slash = filename.rfind ('/');
+  if (slash != std::string::npos)
+    {
+      filename = filename.substr (slash + 1);
+    }
+  if (filename.compare (0, 3, "lib") == 0)
+    {
+      filename = filename.substr (3);
+    }
+  std::string::size_type so = filename.find (".so");
+  if (so != std::string::npos)
+    {
+      filename = filename.substr (0, so);
+    }
+  // libns3.23-internet-debug.so is the internet module.
+  if (filename.compare (0, 3, "ns3") == 0)
+    {
+      std::string::size_type dash = filename.find ('-');
+      if (dash != std::string::npos)
+        {
+          filename = filename.substr (dash + 1);
+        }
+      static const char *profiles[] = { "-debug", "-release", "-optimized" };
+      for (uint32_t i = 0; i < sizeof (profiles) / sizeof (profiles[0]); i++)
+        {
+          std::string::size_type n = std::strlen (profiles[i]);
+          if (filename.size () > n
+              && filename.compare (filename.size () - n, n, profiles[i]) == 0)
+            {
+              filename = filename.substr (0, filename.size () - n);
+              break;
+            }
+        }
+    }
+  return filename;
+}
+
+/**
+ * \param address A return address.
+ * \returns The function and library which contain the address.
+ */
+Location
+Resolve (const void *address)
+{
+  Location location;
+#ifdef HAVE_DLADDR
+  Dl_info info;
+  if (dladdr (address, &info) != 0)
+    {
+      if (info.dli_fname != 0)
+        {
+          location.module = GetModuleName (info.dli_fname);
+        }
+      if (info.dli_sname != 0)
+        {
+          location.function = Demangle (info.dli_sname);
+        }
+    }
+#endif
+  if (location.function.empty ())
+    {
+      std::ostringstream oss;
+      oss << address;
+      location.function = oss.str ();
+    }
+  return location;
+}
+
+/**
+ * \param location The location of a frame.
+ * \returns true if the frame is one of the functions which create
+ *   packets on behalf of their caller.
+ */
+bool
+IsPacketInternal (const Location &location)
+{
+  const std::string &f = location.function;
+  return f.compare (0, 13, "ns3::Packet::") == 0
+    || f.compare (0, 23, "ns3::PacketAccounting::") == 0
+    || f.find ("ns3::Create<ns3::Packet") != std::string::npos;
+}
+
+/**
+ * Find, once per call stack frame, where the packets were created.
+ */
+class Resolver
+{
+public:
+  /**
+   * \param record The objects of a uid.
+   * \returns The first frame of the creation stack outside of Packet.
+   */
+  Location Get (const Record &record)
+  {
+    Location first;
+    for (int i = 0; i < record.depth; i++)
+      {
+        std::map<const void *, Location>::iterator j = m_cache.find (record.frames[i]);
+        if (j == m_cache.end ())
+          {
+            j = m_cache.insert (std::make_pair (record.frames[i], Resolve (record.frames[i]))).first;
+          }
+        if (!IsPacketInternal (j->second))
+          {
+            return j->second;
+          }
+        if (i == 0)
+          {
+            first = j->second;
+          }
+      }
+    if (first.function.empty ())
+      {
+        first.function = "unknown";
+      }
+    return first;
+  }
+
+private:
+  std::map<const void *, Location> m_cache; //!< Locations by address.
+};
+
+/**
+ * Order sites by decreasing size.
+ * \param a A site.
+ * \param b A site.
+ * \returns true if a must be reported before b.
+ */
+bool
+CompareSites (const PacketAccounting::Site &a, const PacketAccounting::Site &b)
+{
+  if (a.bytes != b.bytes)
+    {
+      return a.bytes > b.bytes;
+    }
+  if (a.module != b.module)
+    {
+      return a.module < b.module;
+    }
+  return a.function < b.function;
+}
+
+/**
+ * Group the live packets.
+ * \param byFunction Group by function, rather than by module.
+ * \returns The groups, by decreasing size.
+ */
+std::vector<PacketAccounting::Site>
+GetSites (bool byFunction)
+{
+  CriticalSection critical (GetMutex ());
+  Resolver resolver;
+  std::map<std::pair<std::string, std::string>, PacketAccounting::Site> sites;
+  for (Table::const_iterator i = GetTable ().begin (); i != GetTable ().end (); ++i)
+    {
+      Location location = resolver.Get (i->second);
+      if (!byFunction)
+        {
+          location.function = "";
+        }
+      std::pair<std::string, std::string> key = std::make_pair (location.module, location.function);
+      std::map<std::pair<std::string, std::string>, PacketAccounting::Site>::iterator j = sites.find (key);
+      if (j == sites.end ())
+        {
+          PacketAccounting::Site site;
+          site.module = location.module;
+          site.function = location.function;
+          site.packets = 0;
+          site.objects = 0;
+          site.bytes = 0;
+          site.oldest = i->second.created;
+          j = sites.insert (std::make_pair (key, site)).first;
+        }
+      j->second.packets++;
+      j->second.objects += i->second.objects;
+      j->second.bytes += i->second.bytes;
+      j->second.oldest = std::min (j->second.oldest, i->second.created);
+    }
+  std::vector<PacketAccounting::Site> result;
+  for (std::map<std::pair<std::string, std::string>, PacketAccounting::Site>::const_iterator i = sites.begin ();
+       i != sites.end (); ++i)
+    {
+      result.push_back (i->second);
+    }
+  std::sort (result.begin (), result.end (), &CompareSites);
+  return result;
+}
+
+/**
+ * Order live uids by creation time.
+ * \param a A uid and its record.
+ * \param b A uid and its record.
+ * \returns true if a was created before b.
+ */
+bool
+CompareAge (const Table::value_type *a, const Table::value_type *b)
+{
+  if (a->second.created != b->second.created)
+    {
+      return a->second.created < b->second.created;
+    }
+  return a->first < b->first;
+}
+
+} // anonymous namespace
+
+void
+PacketAccounting::Enable (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  CriticalSection critical (GetMutex ());
+  m_session++;
+  m_enabled = true;
+}
+
+void
+PacketAccounting::Disable (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  CriticalSection critical (GetMutex ());
+  m_enabled = false;
+  GetTable ().clear ();
+}
+
+void
+PacketAccounting::ReportAtDestroy (std::string const &filename)
+{
+  NS_LOG_FUNCTION (filename);
+  Simulator::ScheduleDestroy (&PacketAccounting::DoReportAtDestroy, filename);
+}
+
+void
+PacketAccounting::DoReportAtDestroy (std::string filename)
+{
+  NS_LOG_FUNCTION (filename);
+  if (filename.empty ())
+    {
+      Report (std::cerr);
+      return;
+    }
+  std::ofstream os (filename.c_str ());
+  if (!os.is_open ())
+    {
+      NS_LOG_ERROR ("Cannot open packet accounting report " << filename);
+      return;
+    }
+  Report (os);
+}
+
+uint32_t
+PacketAccounting::Add (uint64_t uid, uint32_t size)
+{
+  CriticalSection critical (GetMutex ());
+  Table::iterator i = GetTable ().find (uid);
+  if (i != GetTable ().end ())
+    {
+      i->second.objects++;
+      i->second.bytes += size;
+      return m_session;
+    }
+  Record record;
+#ifdef HAVE_EXECINFO_H
+  void *frames[FRAMES];
+  record.depth = backtrace (frames, FRAMES);
+  std::copy (frames, frames + record.depth, record.frames);
+#else
+  record.depth = 0;
+#endif
+  record.created = Simulator::Now ();
+  record.objects = 1;
+  record.bytes = size;
+  GetTable ().insert (std::make_pair (uid, record));
+  return m_session;
+}
+
+void
+PacketAccounting::Remove (uint32_t session, uint64_t uid, uint32_t size)
+{
+  CriticalSection critical (GetMutex ());
+  if (session != m_session || !m_enabled)
+    {
+      // Counted in a table which has been cleared since.
+      return;
+    }
+  Table::iterator i = GetTable ().find (uid);
+  if (i == GetTable ().end ())
+    {
+      return;
+    }
+  if (--i->second.objects == 0)
+    {
+      GetTable ().erase (i);
+      return;
+    }
+  i->second.bytes -= size;
+}
+
+void
+PacketAccounting::Resize (uint32_t session, uint64_t uid, int64_t delta)
+{
+  CriticalSection critical (GetMutex ());
+  if (session != m_session || !m_enabled)
+    {
+      return;
+    }
+  Table::iterator i = GetTable ().find (uid);
+  if (i != GetTable ().end ())
+    {
+      i->second.bytes += delta;
+    }
+}
+
+uint32_t
+PacketAccounting::GetNPackets (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  CriticalSection critical (GetMutex ());
+  return GetTable ().size ();
+}
+
+uint32_t
+PacketAccounting::GetNObjects (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  CriticalSection critical (GetMutex ());
+  uint32_t objects = 0;
+  for (Table::const_iterator i = GetTable ().begin (); i != GetTable ().end (); ++i)
+    {
+      objects += i->second.objects;
+    }
+  return objects;
+}
+
+uint64_t
+PacketAccounting::GetNBytes (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  CriticalSection critical (GetMutex ());
+  uint64_t bytes = 0;
+  for (Table::const_iterator i = GetTable ().begin (); i != GetTable ().end (); ++i)
+    {
+      bytes += i->second.bytes;
+    }
+  return bytes;
+}
+
+std::vector<PacketAccounting::Site>
+PacketAccounting::GetModules (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return GetSites (false);
+}
+
+std::vector<PacketAccounting::Site>
+PacketAccounting::GetFunctions (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return GetSites (true);
+}
+
+std::vector<PacketAccounting::Entry>
+PacketAccounting::GetOldest (uint32_t n)
+{
+  NS_LOG_FUNCTION (n);
+  CriticalSection critical (GetMutex ());
+  std::vector<const Table::value_type *> live;
+  for (Table::const_iterator i = GetTable ().begin (); i != GetTable ().end (); ++i)
+    {
+      live.push_back (&*i);
+    }
+  n = std::min<uint32_t> (n, live.size ());
+  std::partial_sort (live.begin (), live.begin () + n, live.end (), &CompareAge);
+
+  Resolver resolver;
+  std::vector<Entry> oldest;
+  for (uint32_t j = 0; j < n; j++)
+    {
+      Location location = resolver.Get (live[j]->second);
+      Entry entry;
+      entry.uid = live[j]->first;
+      entry.module = location.module;
+      entry.function = location.function;
+      entry.objects = live[j]->second.objects;
+      entry.bytes = live[j]->second.bytes;
+      entry.created = live[j]->second.created;
+      oldest.push_back (entry);
+    }
+  return oldest;
+}
+
+void
+PacketAccounting::Report (std::ostream &os, uint32_t lines)
+{
+  NS_LOG_FUNCTION (&os << lines);
+  os << "Live packets at " << Simulator::Now ().GetSeconds () << "s: "
+     << GetNPackets () << " uids, " << GetNObjects () << " objects, "
+     << GetNBytes () << " bytes" << std::endl;
+  if (GetNPackets () == 0)
+    {
+      return;
+    }
+  for (uint32_t part = 0; part < 2; part++)
+    {
+      bool byFunction = part == 1;
+      std::vector<Site> sites = GetSites (byFunction);
+      os << std::endl << "By creating " << (byFunction ? "function" : "module") << ":" << std::endl;
+      os << std::setw (14) << "bytes" << std::setw (10) << "uids"
+         << std::setw (10) << "objects" << std::setw (14) << "oldest (s)"
+         << "  " << (byFunction ? "function" : "module") << std::endl;
+      for (uint32_t j = 0; j < sites.size () && j < lines; j++)
+        {
+          const Site &s = sites[j];
+          os << std::setw (14) << s.bytes << std::setw (10) << s.packets
+             << std::setw (10) << s.objects << std::setw (14) << s.oldest.GetSeconds ()
+             << "  " << (byFunction ? s.function + " (" + s.module + ")" : s.module)
+             << std::endl;
+        }
+      if (sites.size () > lines)
+        {
+          os << "  (" << sites.size () - lines << " more)" << std::endl;
+        }
+    }
+  std::vector<Entry> oldest = GetOldest (lines);
+  os << std::endl << "Oldest packets:" << std::endl;
+  os << std::setw (14) << "uid" << std::setw (14) << "created (s)"
+     << std::setw (10) << "objects" << std::setw (10) << "bytes"
+     << "  function" << std::endl;
+  for (std::vector<Entry>::const_iterator i = oldest.begin (); i != oldest.end (); ++i)
+    {
+      os << std::setw (14) << i->uid << std::setw (14) << i->created.GetSeconds ()
+         << std::setw (10) << i->objects << std::setw (10) << i->bytes
+         << "  " << i->function << " (" << i->module << ")" << std::endl;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PACKET_ACCOUNTING_H
+#define PACKET_ACCOUNTING_H
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \ingroup packet
+ * \brief Account for the memory held by live packets.
+ *
+ * Once enabled, every Packet object is counted, against its uid, in a
+ * side table which also remembers where and when the first packet with
+ * this uid was created. Copies and fragments share the uid of their
+ * original, so they are counted with it: a packet which is still alive
+ * long after it should have been freed, because it is pinned in a queue
+ * or a reassembly buffer, shows up with its age and the function which
+ * created it.
+ *
+ * The creation site is the first function on the call stack outside of
+ * ns3::Packet, and the module is the library which contains this
+ * function. Both are only looked up when a report is made; they are
+ * unknown without backtrace and dladdr support.
+ *
+ * The table costs about a hundred bytes and a call stack capture per
+ * uid, so accounting is meant for debugging runs. Packets created
+ * before Enable are not counted, nor are their copies: each Packet
+ * object remembers whether it was counted, and by which call to Enable,
+ * so that it is only removed from the table it was added to. The table
+ * is protected by a mutex, so packets may be created and freed by the
+ * partitions of a multithreaded simulation.
+ */
+class PacketAccounting
+{
+public:
+  /** The packets created by a module or a function. */
+  struct Site
+  {
+    std::string module;   /**< The library of the creating function. */
+    std::string function; /**< The creating function, empty for a module. */
+    uint32_t packets;     /**< Number of live uids. */
+    uint32_t objects;     /**< Number of live Packet objects with these uids. */
+    uint64_t bytes;       /**< Total size of the live Packet objects. */
+    Time oldest;          /**< Creation time of the oldest live uid. */
+  };
+  /** A live packet. */
+  struct Entry
+  {
+    uint64_t uid;         /**< The uid of the packet. */
+    std::string module;   /**< The library of the creating function. */
+    std::string function; /**< The creating function. */
+    uint32_t objects;     /**< Number of live Packet objects with this uid. */
+    uint64_t bytes;       /**< Total size of these objects. */
+    Time created;         /**< Creation time of the first object. */
+  };
+
+  /**
+   * Start counting the packets created from now on.
+   */
+  static void Enable (void);
+  /**
+   * Stop counting packets and forget the packets counted so far.
+   */
+  static void Disable (void);
+  /** \returns true if packets are counted. */
+  inline static bool IsEnabled (void);
+  /**
+   * Print a report when Simulator::Destroy is called. Packets freed by
+   * objects destroyed before the report, such as the nodes if they were
+   * created before this call, are not reported.
+   *
+   * \param filename The file to print to, or an empty string to print
+   *   to std::cerr.
+   */
+  static void ReportAtDestroy (std::string const &filename = "");
+
+  /** \returns The number of live uids. */
+  static uint32_t GetNPackets (void);
+  /** \returns The number of live Packet objects. */
+  static uint32_t GetNObjects (void);
+  /** \returns The total size of the live Packet objects. */
+  static uint64_t GetNBytes (void);
+  /** \returns The live packets by creating module, by decreasing size. */
+  static std::vector<Site> GetModules (void);
+  /** \returns The live packets by creating function, by decreasing size. */
+  static std::vector<Site> GetFunctions (void);
+  /**
+   * \param n The largest number of packets to return.
+   * \returns The oldest live packets, oldest first.
+   */
+  static std::vector<Entry> GetOldest (uint32_t n);
+  /**
+   * Print the live packets by module and function, and the oldest ones.
+   * \param os The output stream.
+   * \param lines The largest number of lines of each part.
+   */
+  static void Report (std::ostream &os, uint32_t lines = 10);
+
+private:
+  friend class Packet;
+
+  /**
+   * Count a new Packet object.
+   * \param uid The uid of the packet.
+   * \param size The size of the packet.
+   * \returns The current accounting session, to be passed to Remove
+   *   and Resize.
+   */
+  static uint32_t Add (uint64_t uid, uint32_t size);
+  /**
+   * Forget a destroyed Packet object.
+   * \param session The session returned by Add for this object.
+   * \param uid The uid of the packet.
+   * \param size The size of the packet.
+   */
+  static void Remove (uint32_t session, uint64_t uid, uint32_t size);
+  /**
+   * Account for a change of size of a Packet object.
+   * \param session The session returned by Add for this object.
+   * \param uid The uid of the packet.
+   * \param delta The change of size.
+   */
+  static void Resize (uint32_t session, uint64_t uid, int64_t delta);
+  /**
+   * Print the report scheduled by ReportAtDestroy.
+   * \param filename The file to print to.
+   */
+  static void DoReportAtDestroy (std::string filename);
+
+  static bool m_enabled; //!< True if packets are counted.
+  static uint32_t m_session; //!< Number of calls to Enable.
+};
+
+bool
+PacketAccounting::IsEnabled (void)
+{
+  return m_enabled;
+}
+
+} // namespace ns3
+
+#endif /* PACKET_ACCOUNTING_H */
@@ -0,0 +1,322 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "packet-free-list.h"
+#include "ns3/core-config.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PacketFreeList");
+
+/**
+ * The header of a block. The user data follows it.
+ */
+struct PacketFreeList::Block
+{
+  Local *owner;      //!< The free list of the allocating thread, zero if none.
+  Block *next;       //!< The next block of a free list.
+  uint32_t capacity; //!< The size of the user data.
+  uint32_t padding;  //!< Keeps the user data 8-byte aligned.
+};
+
+/**
+ * The free list of a thread.
+ */
+struct PacketFreeList::Local
+{
+  Block *free;             //!< The blocks freed by the owning thread.
+  uint32_t nFree;          //!< The number of blocks in free.
+  uint32_t maxSize;        //!< The largest size the owning thread asked for.
+  Block * volatile remote; //!< The blocks freed by other threads.
+  PacketPoolStats stats;   //!< The counters of the owning thread.
+  Local *next;             //!< The next free list of the same PacketFreeList.
+  volatile uint32_t inUse; //!< Whether a live thread owns this free list.
+};
+
+namespace {
+
+/** The largest number of PacketFreeList objects. */
+const uint32_t MAX_FREE_LISTS = 8;
+/** The free lists of the calling thread, indexed by PacketFreeList. */
+__thread void *t_locals[MAX_FREE_LISTS];
+/** The number of indexes given to PacketFreeList objects. */
+uint32_t g_nFreeLists = 0;
+/** Protects g_nFreeLists. */
+volatile uint32_t g_indexLock = 0;
+
+#ifdef HAVE_PTHREAD_H
+/** The key whose destructor releases the free lists of exiting threads. */
+pthread_key_t g_exitKey;
+/** Creates g_exitKey. */
+pthread_once_t g_exitKeyOnce = PTHREAD_ONCE_INIT;
+#endif /* HAVE_PTHREAD_H */
+
+/**
+ * Lock a spinlock.
+ * \param lock The lock.
+ */
+void
+Lock (volatile uint32_t *lock)
+{
+  while (__sync_lock_test_and_set (lock, 1))
+    {
+    }
+}
+
+/**
+ * Unlock a spinlock.
+ * \param lock The lock.
+ */
+void
+Unlock (volatile uint32_t *lock)
+{
+  __sync_lock_release (lock);
+}
+
+} // anonymous namespace
+
+PacketFreeList::PacketFreeList (uint32_t maxBlocks)
+{
+  // The other members are zero-initialized: the free list may have been
+  // used by other static constructors already.
+  m_maxBlocks = maxBlocks;
+}
+
+PacketFreeList::~PacketFreeList ()
+{
+  m_destroyed = true;
+  Lock (&m_lock);
+  while (m_locals != 0)
+    {
+      Local *local = m_locals;
+      m_locals = local->next;
+      Block *blocks[2] = { local->free, local->remote };
+      for (uint32_t i = 0; i < 2; i++)
+        {
+          while (blocks[i] != 0)
+            {
+              Block *block = blocks[i];
+              blocks[i] = block->next;
+              delete [] reinterpret_cast<uint8_t *> (block);
+            }
+        }
+      delete local;
+    }
+  Unlock (&m_lock);
+}
+
+void *
+PacketFreeList::Allocate (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  Local *local = GetLocal ();
+  if (local != 0)
+    {
+      local->stats.allocations++;
+      if (size > local->maxSize)
+        {
+          local->maxSize = size;
+        }
+      if (local->free == 0 && local->remote != 0)
+        {
+          Drain (local);
+        }
+      while (local->free != 0)
+        {
+          Block *block = local->free;
+          local->free = block->next;
+          local->nFree--;
+          if (block->capacity >= size)
+            {
+              local->stats.reused++;
+              return block + 1;
+            }
+          delete [] reinterpret_cast<uint8_t *> (block);
+        }
+    }
+  Block *block = reinterpret_cast<Block *> (new uint8_t [sizeof (Block) + size]);
+  block->owner = local;
+  block->next = 0;
+  block->capacity = size;
+  return block + 1;
+}
+
+void
+PacketFreeList::Free (void *p)
+{
+  NS_LOG_FUNCTION (this << p);
+  Block *block = static_cast<Block *> (p) - 1;
+  Local *owner = block->owner;
+  if (owner == 0 || m_destroyed)
+    {
+      delete [] reinterpret_cast<uint8_t *> (block);
+      return;
+    }
+  if (m_index != 0 && owner == t_locals[m_index - 1])
+    {
+      Keep (owner, block);
+      return;
+    }
+  Block *head;
+  do
+    {
+      head = owner->remote;
+      block->next = head;
+    }
+  while (!__sync_bool_compare_and_swap (&owner->remote, head, block));
+}
+
+uint32_t
+PacketFreeList::GetCapacity (void const *p)
+{
+  return (static_cast<Block const *> (p) - 1)->capacity;
+}
+
+uint32_t
+PacketFreeList::GetMaxSize (void)
+{
+  NS_LOG_FUNCTION (this);
+  Local *local = GetLocal ();
+  return local == 0 ? 0 : local->maxSize;
+}
+
+PacketPoolStats
+PacketFreeList::GetStats (void)
+{
+  NS_LOG_FUNCTION (this);
+  PacketPoolStats stats = { 0, 0, 0, 0 };
+  Lock (&m_lock);
+  for (Local *local = m_locals; local != 0; local = local->next)
+    {
+      stats.allocations += local->stats.allocations;
+      stats.reused += local->stats.reused;
+      stats.remoteFrees += local->stats.remoteFrees;
+      stats.threads++;
+    }
+  Unlock (&m_lock);
+  return stats;
+}
+
+PacketFreeList::Local *
+PacketFreeList::GetLocal (void)
+{
+  if (m_destroyed)
+    {
+      return 0;
+    }
+  if (m_index == 0)
+    {
+      Lock (&g_indexLock);
+      if (m_index == 0)
+        {
+          NS_ASSERT_MSG (g_nFreeLists < MAX_FREE_LISTS, "Too many PacketFreeList objects");
+          g_nFreeLists++;
+          __sync_synchronize ();
+          m_index = g_nFreeLists;
+        }
+      Unlock (&g_indexLock);
+    }
+  Local *local = static_cast<Local *> (t_locals[m_index - 1]);
+  if (local == 0)
+    {
+      local = Adopt ();
+    }
+  return local;
+}
+
+PacketFreeList::Local *
+PacketFreeList::Adopt (void)
+{
+  NS_LOG_FUNCTION (this);
+  Lock (&m_lock);
+  Local *local = m_locals;
+  while (local != 0 && local->inUse)
+    {
+      local = local->next;
+    }
+  if (local == 0)
+    {
+      local = new Local ();
+      local->next = m_locals;
+      m_locals = local;
+    }
+  local->inUse = 1;
+  Unlock (&m_lock);
+  t_locals[m_index - 1] = local;
+#ifdef HAVE_PTHREAD_H
+  pthread_once (&g_exitKeyOnce, &PacketFreeList::CreateExitKey);
+  pthread_setspecific (g_exitKey, t_locals);
+#endif /* HAVE_PTHREAD_H */
+  return local;
+}
+
+void
+PacketFreeList::Keep (Local *local, Block *block)
+{
+  if (block->capacity < local->maxSize || local->nFree >= m_maxBlocks)
+    {
+      delete [] reinterpret_cast<uint8_t *> (block);
+      return;
+    }
+  block->next = local->free;
+  local->free = block;
+  local->nFree++;
+}
+
+void
+PacketFreeList::Drain (Local *local)
+{
+  NS_LOG_FUNCTION (this << local);
+  Block *blocks = __sync_lock_test_and_set (&local->remote, static_cast<Block *> (0));
+  while (blocks != 0)
+    {
+      Block *block = blocks;
+      blocks = block->next;
+      local->stats.remoteFrees++;
+      Keep (local, block);
+    }
+}
+
+void
+PacketFreeList::CreateExitKey (void)
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_key_create (&g_exitKey, &PacketFreeList::ReleaseLocals);
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+PacketFreeList::ReleaseLocals (void *locals)
+{
+  void **table = static_cast<void **> (locals);
+  __sync_synchronize ();
+  for (uint32_t i = 0; i < MAX_FREE_LISTS; i++)
+    {
+      if (table[i] != 0)
+        {
+          static_cast<Local *> (table[i])->inUse = 0;
+          table[i] = 0;
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PACKET_FREE_LIST_H
+#define PACKET_FREE_LIST_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ * Counters of a PacketFreeList, summed over all the threads which used it.
+ */
+struct PacketPoolStats
+{
+  uint64_t allocations; /**< Number of blocks allocated. */
+  uint64_t reused;      /**< Number of allocations served by a free list. */
+  uint64_t remoteFrees; /**< Number of blocks freed by another thread than their allocating thread. */
+  uint32_t threads;     /**< Number of per-thread free lists. */
+};
+
+/**
+ * \ingroup packet
+ * \brief Free lists of the variable-sized blocks which store packets.
+ *
+ * Every thread has its own free list, so blocks are allocated and freed
+ * without locking. A block freed by another thread than the one which
+ * allocated it is pushed on a lock-free stack of its allocating thread,
+ * which moves it to its free list when its free list runs out: threads
+ * which hand packets over to each other keep reusing the same blocks.
+ *
+ * As the free lists of ns3::Buffer and ns3::PacketMetadata always did,
+ * each thread keeps a bounded number of blocks, and only those which are
+ * at least as large as the largest block it was asked for.
+ *
+ * The free list of a thread which exits is adopted by the next thread
+ * which needs one. Instances must have static storage duration: they
+ * may be used before their constructor and after their destructor have
+ * run, in which case blocks are simply allocated and freed with new and
+ * delete.
+ */
+class PacketFreeList
+{
+public:
+  /**
+   * \param maxBlocks The largest number of free blocks kept per thread.
+   */
+  PacketFreeList (uint32_t maxBlocks);
+  /** Free all the cached blocks. */
+  ~PacketFreeList ();
+
+  /**
+   * \param size The number of bytes needed.
+   * \returns A block of at least size bytes, aligned for any integer type.
+   */
+  void *Allocate (uint32_t size);
+  /**
+   * \param p A block returned by Allocate, from any thread.
+   */
+  void Free (void *p);
+  /**
+   * \param p A block returned by Allocate.
+   * \returns The size of the block, which may be larger than requested.
+   */
+  static uint32_t GetCapacity (void const *p);
+  /**
+   * \returns The largest size the calling thread asked for.
+   */
+  uint32_t GetMaxSize (void);
+  /**
+   * \returns The counters of this free list.
+   */
+  PacketPoolStats GetStats (void);
+
+private:
+  struct Block;
+  struct Local;
+
+  /**
+   * \returns The free list of the calling thread, or zero once this
+   *   object has been destroyed.
+   */
+  Local *GetLocal (void);
+  /**
+   * Give the calling thread a free list.
+   * \returns The free list.
+   */
+  Local *Adopt (void);
+  /**
+   * Keep a block in a free list if it is worth keeping, or delete it.
+   * \param local The free list.
+   * \param block The block.
+   */
+  void Keep (Local *local, Block *block);
+  /**
+   * Move the blocks freed by other threads to a free list.
+   * \param local The free list.
+   */
+  void Drain (Local *local);
+  /**
+   * Create the thread-specific key whose destructor calls ReleaseLocals.
+   */
+  static void CreateExitKey (void);
+  /**
+   * Release the free lists of an exiting thread.
+   * \param locals The table of free lists of the thread.
+   */
+  static void ReleaseLocals (void *locals);
+
+  uint32_t m_maxBlocks;     //!< The largest number of free blocks per thread.
+  uint32_t m_index;         //!< The index of this object in the per-thread tables, plus one.
+  Local *m_locals;          //!< The free lists of all the threads.
+  volatile uint32_t m_lock; //!< Protects m_locals.
+  bool m_destroyed;         //!< Set once the destructor has run.
+};
+
+} // namespace ns3
+
+#endif /* PACKET_FREE_LIST_H */
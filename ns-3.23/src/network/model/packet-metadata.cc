@@ -34,19 +34,15 @@ NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
 bool PacketMetadata::m_metadataSkipped = false;
-uint32_t PacketMetadata::m_maxSize = 0;
-uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+__thread uint16_t PacketMetadata::m_chunkUid = 0;
+bool PacketMetadata::m_lazy = false;
 
-PacketMetadata::DataFreeList::~DataFreeList ()
-{
-  NS_LOG_FUNCTION (this);
-  for (iterator i = begin (); i != end (); i++)
-    {
-      PacketMetadata::Deallocate (*i);
-    }
-  PacketMetadata::m_enable = false;
-}
+namespace {
+/** The free list of the metadata storage. */
+PacketFreeList g_freeList (1000);
+/** The free list of the recorded operations. */
+PacketFreeList g_opFreeList (10000);
+} // anonymous namespace
 
 void 
 PacketMetadata::Enable (void)
@@ -70,6 +66,29 @@ PacketMetadata::EnableChecking (void)
   m_enableChecking = true;
 }
 
+void
+PacketMetadata::SetLazy (bool lazy)
+{
+  NS_LOG_FUNCTION (lazy);
+  if (lazy)
+    {
+      Enable ();
+    }
+  m_lazy = lazy;
+}
+
+PacketMetadata::PacketMetadata (uint64_t uid)
+  : m_data (PacketMetadata::Create (10)),
+    m_log (0),
+    m_head (0xffff),
+    m_tail (0xffff),
+    m_used (0),
+    m_packetUid (uid)
+{
+  NS_LOG_FUNCTION (this << uid);
+  memset (m_data->m_data, 0xff, 4);
+}
+
 void
 PacketMetadata::ReserveCopy (uint32_t size)
 {
@@ -96,6 +115,16 @@ PacketMetadata::ReserveCopy (uint32_t size)
     }
 }
 void
+PacketMetadata::Unshare (void)
+{
+  NS_LOG_FUNCTION (this);
+  DropLog ();
+  if (m_data != 0)
+    {
+      ReserveCopy (0);
+    }
+}
+void
 PacketMetadata::Reserve (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
@@ -133,6 +162,11 @@ bool
 PacketMetadata::IsStateOk (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_data == 0)
+    {
+      // a lazy metadata whose items are not reconstructed.
+      return true;
+    }
   bool ok = m_used <= m_data->m_size;
   ok &= IsPointerOk (m_head);
   ok &= IsPointerOk (m_tail);
@@ -571,75 +605,197 @@ struct PacketMetadata::Data *
 PacketMetadata::Create (uint32_t size)
 {
   NS_LOG_FUNCTION (size);
-  NS_LOG_LOGIC ("create size="<<size<<", max="<<m_maxSize);
-  if (size > m_maxSize)
-    {
-      m_maxSize = size;
-    }
-  while (!m_freeList.empty ()) 
+  if (size < PACKET_METADATA_DATA_M_DATA_SIZE)
+    {
+      size = PACKET_METADATA_DATA_M_DATA_SIZE;
+    }
+  // allocate as much as the largest metadata of this thread, so that
+  // the storage is not reallocated as the metadata grows.
+  uint32_t n = std::max<uint32_t> (sizeof (struct Data) + size - PACKET_METADATA_DATA_M_DATA_SIZE,
+                                   g_freeList.GetMaxSize ());
+  void *p = g_freeList.Allocate (n);
+  struct PacketMetadata::Data *data = static_cast<struct PacketMetadata::Data *> (p);
+  data->m_size = PacketFreeList::GetCapacity (p) - sizeof (struct Data) + PACKET_METADATA_DATA_M_DATA_SIZE;
+  NS_LOG_LOGIC ("create size="<<size<<", got="<<data->m_size);
+  data->m_count = 1;
+  data->m_dirtyEnd = 0;
+  return data;
+}
+
+void
+PacketMetadata::Recycle (struct PacketMetadata::Data *data)
+{
+  NS_LOG_FUNCTION (data);
+  NS_ASSERT (data->m_count == 0);
+  g_freeList.Free (data);
+}
+
+PacketPoolStats
+PacketMetadata::GetPoolStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return g_freeList.GetStats ();
+}
+
+void
+PacketMetadata::CreateLog (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  struct Op *op = CreateOp ();
+  op->type = CREATE;
+  op->chunkUid = 0;
+  if (size > 0)
+    {
+      op->chunkUid = m_chunkUid++;
+    }
+  op->typeUid = 0;
+  op->size = size;
+  op->packetUid = m_packetUid;
+  op->prev = 0;
+  op->other = 0;
+  m_log = op;
+}
+
+struct PacketMetadata::Op *
+PacketMetadata::Record (uint8_t type, uint32_t typeUid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << static_cast<uint32_t> (type) << typeUid << size);
+  NS_ASSERT (m_log != 0);
+  if (m_data != 0)
     {
-      struct PacketMetadata::Data *data = m_freeList.back ();
-      m_freeList.pop_back ();
-      if (data->m_size >= size) 
+      m_data->m_count--;
+      if (m_data->m_count == 0) 
         {
-          NS_LOG_LOGIC ("create found size="<<data->m_size);
-          data->m_count = 1;
-          return data;
+          PacketMetadata::Recycle (m_data);
         }
-      PacketMetadata::Deallocate (data);
-      NS_LOG_LOGIC ("create dealloc size="<<data->m_size);
-    }
-  NS_LOG_LOGIC ("create alloc size="<<m_maxSize);
-  return PacketMetadata::Allocate (m_maxSize);
+      m_data = 0;
+      m_head = 0xffff;
+      m_tail = 0xffff;
+      m_used = 0;
+    }
+  struct Op *op = CreateOp ();
+  op->type = type;
+  op->chunkUid = 0;
+  op->typeUid = typeUid;
+  op->size = size;
+  op->packetUid = 0;
+  // the reference held by this metadata moves to the new operation.
+  op->prev = m_log;
+  op->other = 0;
+  m_log = op;
+  return op;
 }
 
 void
-PacketMetadata::Recycle (struct PacketMetadata::Data *data)
+PacketMetadata::Materialize (void) const
 {
-  NS_LOG_FUNCTION (data);
-  if (!m_enable)
+  NS_LOG_FUNCTION (this);
+  if (m_log == 0 || m_data != 0)
     {
-      PacketMetadata::Deallocate (data);
       return;
-    } 
-  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
-  NS_ASSERT (data->m_count == 0);
-  if (m_freeList.size () > 1000 ||
-      data->m_size < m_maxSize) 
-    {
-      PacketMetadata::Deallocate (data);
-    } 
-  else 
+    }
+  PacketMetadata metadata = Replay (m_log);
+  PacketMetadata *self = const_cast<PacketMetadata *> (this);
+  self->m_data = metadata.m_data;
+  self->m_data->m_count++;
+  self->m_head = metadata.m_head;
+  self->m_tail = metadata.m_tail;
+  self->m_used = metadata.m_used;
+}
+
+void
+PacketMetadata::DropLog (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_log == 0)
     {
-      m_freeList.push_back (data);
+      return;
     }
+  Materialize ();
+  ReleaseLog (m_log);
+  m_log = 0;
 }
 
-struct PacketMetadata::Data *
-PacketMetadata::Allocate (uint32_t n)
+PacketMetadata
+PacketMetadata::Replay (const struct Op *log)
 {
-  NS_LOG_FUNCTION (n);
-  uint32_t size = sizeof (struct Data);
-  if (n <= PACKET_METADATA_DATA_M_DATA_SIZE)
+  NS_LOG_FUNCTION (log);
+  std::vector<const struct Op *> ops;
+  for (const struct Op *op = log; op != 0; op = op->prev)
     {
-      n = PACKET_METADATA_DATA_M_DATA_SIZE;
+      ops.push_back (op);
     }
-  size += n - PACKET_METADATA_DATA_M_DATA_SIZE;
-  uint8_t *buf = new uint8_t [size];
-  struct PacketMetadata::Data *data = (struct PacketMetadata::Data *)buf;
-  data->m_size = n;
-  data->m_count = 1;
-  data->m_dirtyEnd = 0;
-  return data;
+  const struct Op *root = ops.back ();
+  NS_ASSERT (root->type == CREATE);
+  PacketMetadata metadata (root->packetUid);
+  if (root->size > 0)
+    {
+      metadata.DoAddHeader (0, root->size, root->chunkUid);
+    }
+  for (uint32_t i = ops.size () - 1; i-- > 0; )
+    {
+      const struct Op *op = ops[i];
+      switch (op->type)
+        {
+        case ADD_HEADER:
+          metadata.DoAddHeader (op->typeUid, op->size, op->chunkUid);
+          break;
+        case REMOVE_HEADER:
+          metadata.DoRemoveHeader (op->typeUid, op->size);
+          break;
+        case ADD_TRAILER:
+          metadata.DoAddTrailer (op->typeUid, op->size, op->chunkUid);
+          break;
+        case REMOVE_TRAILER:
+          metadata.DoRemoveTrailer (op->typeUid, op->size);
+          break;
+        case ADD_AT_END:
+          metadata.AddAtEnd (Replay (op->other));
+          break;
+        case REMOVE_AT_START:
+          metadata.RemoveAtStart (op->size);
+          break;
+        case REMOVE_AT_END:
+          metadata.RemoveAtEnd (op->size);
+          break;
+        default:
+          NS_ASSERT_MSG (false, "unexpected operation " << static_cast<uint32_t> (op->type));
+          break;
+        }
+    }
+  return metadata;
 }
-void 
-PacketMetadata::Deallocate (struct PacketMetadata::Data *data)
+
+struct PacketMetadata::Op *
+PacketMetadata::CreateOp (void)
 {
-  NS_LOG_FUNCTION (data);
-  uint8_t *buf = (uint8_t *)data;
-  delete [] buf;
+  NS_LOG_FUNCTION_NOARGS ();
+  struct Op *op = static_cast<struct Op *> (g_opFreeList.Allocate (sizeof (struct Op)));
+  op->count = 1;
+  return op;
 }
 
+void
+PacketMetadata::ReleaseLog (struct Op *op)
+{
+  NS_LOG_FUNCTION (op);
+  while (op != 0)
+    {
+      NS_ASSERT (op->count > 0);
+      op->count--;
+      if (op->count > 0)
+        {
+          return;
+        }
+      struct Op *prev = op->prev;
+      if (op->other != 0)
+        {
+          ReleaseLog (op->other);
+        }
+      g_opFreeList.Free (op);
+      op = prev;
+    }
+}
 
 PacketMetadata 
 PacketMetadata::CreateFragment (uint32_t start, uint32_t end) const
@@ -655,15 +811,21 @@ void
 PacketMetadata::AddHeader (const Header &header, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &header << size);
-  NS_ASSERT (IsStateOk ());
   uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
-  DoAddHeader (uid, size);
+  if (m_log != 0)
+    {
+      struct Op *op = Record (ADD_HEADER, uid, size);
+      op->chunkUid = m_chunkUid++;
+      return;
+    }
+  NS_ASSERT (IsStateOk ());
+  DoAddHeader (uid, size, m_chunkUid++);
   NS_ASSERT (IsStateOk ());
 }
 void
-PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
+PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size, uint16_t chunkUid)
 {
-  NS_LOG_FUNCTION (this << uid << size);
+  NS_LOG_FUNCTION (this << uid << size << chunkUid);
   if (!m_enable)
     {
       m_metadataSkipped = true;
@@ -675,8 +837,7 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
   item.prev = 0xffff;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = chunkUid;
   uint16_t written = AddSmall (&item);
   UpdateHead (written);
 }
@@ -685,6 +846,17 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
 {
   uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &header << size);
+  if (m_log != 0)
+    {
+      Record (REMOVE_HEADER, uid, size);
+      return;
+    }
+  DoRemoveHeader (uid, size);
+}
+void
+PacketMetadata::DoRemoveHeader (uint32_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << uid << size);
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
     {
@@ -733,6 +905,18 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
 {
   uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &trailer << size);
+  if (m_log != 0)
+    {
+      struct Op *op = Record (ADD_TRAILER, uid, size);
+      op->chunkUid = m_chunkUid++;
+      return;
+    }
+  DoAddTrailer (uid, size, m_chunkUid++);
+}
+void
+PacketMetadata::DoAddTrailer (uint32_t uid, uint32_t size, uint16_t chunkUid)
+{
+  NS_LOG_FUNCTION (this << uid << size << chunkUid);
   NS_ASSERT (IsStateOk ());
   if (!m_enable)
     {
@@ -744,8 +928,7 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
   item.prev = m_tail;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = chunkUid;
   uint16_t written = AddSmall (&item);
   UpdateTail (written);
   NS_ASSERT (IsStateOk ());
@@ -755,6 +938,17 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
 {
   uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &trailer << size);
+  if (m_log != 0)
+    {
+      Record (REMOVE_TRAILER, uid, size);
+      return;
+    }
+  DoRemoveTrailer (uid, size);
+}
+void
+PacketMetadata::DoRemoveTrailer (uint32_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << uid << size);
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
     {
@@ -802,6 +996,16 @@ void
 PacketMetadata::AddAtEnd (PacketMetadata const&o)
 {
   NS_LOG_FUNCTION (this << &o);
+  if (m_log != 0 && o.m_log != 0)
+    {
+      struct Op *op = Record (ADD_AT_END, 0, 0);
+      op->other = o.m_log;
+      op->other->count++;
+      return;
+    }
+  // the items of both sides are needed if only one of them is lazy.
+  DropLog ();
+  o.Materialize ();
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
     {
@@ -890,6 +1094,14 @@ void
 PacketMetadata::RemoveAtStart (uint32_t start)
 {
   NS_LOG_FUNCTION (this << start);
+  if (m_log != 0)
+    {
+      if (start > 0)
+        {
+          Record (REMOVE_AT_START, 0, start);
+        }
+      return;
+    }
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
     {
@@ -922,7 +1134,7 @@ PacketMetadata::RemoveAtStart (uint32_t start)
       else
         {
           // fragment the list item.
-          PacketMetadata fragment (m_packetUid, 0);
+          PacketMetadata fragment (m_packetUid);
           extraItem.fragmentStart += leftToRemove;
           leftToRemove = 0;
           uint16_t written = fragment.AddBig (0xffff, fragment.m_tail,
@@ -953,6 +1165,14 @@ void
 PacketMetadata::RemoveAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
+  if (m_log != 0)
+    {
+      if (end > 0)
+        {
+          Record (REMOVE_AT_END, 0, end);
+        }
+      return;
+    }
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
     {
@@ -986,7 +1206,7 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
       else
         {
           // fragment the list item.
-          PacketMetadata fragment (m_packetUid, 0);
+          PacketMetadata fragment (m_packetUid);
           NS_ASSERT (extraItem.fragmentEnd > leftToRemove);
           extraItem.fragmentEnd -= leftToRemove;
           leftToRemove = 0;
@@ -1047,6 +1267,7 @@ PacketMetadata::ItemIterator
 PacketMetadata::BeginItem (Buffer buffer) const
 {
   NS_LOG_FUNCTION (this << &buffer);
+  Materialize ();
   return ItemIterator (this, buffer);
 }
 PacketMetadata::ItemIterator::ItemIterator (const PacketMetadata *metadata, Buffer buffer)
@@ -1151,6 +1372,7 @@ PacketMetadata::GetSerializedSize (void) const
       return totalSize;
     }
 
+  Materialize ();
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t current = m_head;
@@ -1183,6 +1405,7 @@ uint32_t
 PacketMetadata::Serialize (uint8_t* buffer, uint32_t maxSize) const
 {
   NS_LOG_FUNCTION (this << &buffer << maxSize);
+  Materialize ();
   uint8_t* start = buffer;
 
   buffer = AddToRawU64 (m_packetUid, start, buffer, maxSize);
@@ -1284,6 +1507,7 @@ uint32_t
 PacketMetadata::Deserialize (const uint8_t* buffer, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &buffer << size);
+  DropLog ();
   const uint8_t* start = buffer;
   uint32_t desSize = size - 4;
 
@@ -27,6 +27,7 @@
 #include "ns3/assert.h"
 #include "ns3/type-id.h"
 #include "buffer.h"
+#include "packet-free-list.h"
 
 namespace ns3 {
 
@@ -74,6 +75,17 @@ class Trailer;
  * integers, and some others as variable-size 32-bit integers.
  * The variable-size 32 bit integers are stored using the uleb128
  * encoding.
+ *
+ * When SetLazy is enabled, the metadata created from then on does not
+ * maintain this list: each operation is only appended to a log of
+ * PacketMetadata::Op records. The records are reference-counted and
+ * shared by the copies of a packet, and AddAtEnd refers to the log of
+ * the other packet instead of copying it, so that each operation costs
+ * a constant amount of work. The list of items is reconstructed by
+ * replaying the log when it is actually needed, that is, by BeginItem
+ * and by the serialization methods, and kept until the next operation.
+ * With EnableChecking, the removal of unexpected headers and trailers
+ * is then only detected by this reconstruction.
  */
 class PacketMetadata 
 {
@@ -159,6 +171,19 @@ private:
    * \brief Enable the packet metadata checking
    */
   static void EnableChecking (void);
+  /**
+   * \brief Record the operations and reconstruct the items on demand
+   *
+   * \param lazy true to enable, and false to disable, the lazy
+   *        recording of operations for the metadata created from now
+   *        on. Enabling it also enables the packet metadata.
+   */
+  static void SetLazy (bool lazy);
+  /**
+   * \returns the counters of the free list of the metadata storage,
+   * summed over all the threads which created metadata.
+   */
+  static PacketPoolStats GetPoolStats (void);
 
   /**
    * \brief Constructor
@@ -269,6 +294,11 @@ private:
    *  \return 1 on success, 0 on failure
    */
   uint32_t Deserialize (const uint8_t* buffer, uint32_t size);
+  /**
+   * \brief Copy the storage of the metadata, so that it is not
+   * shared with any other packet.
+   */
+  void Unshare (void);
 
 private:
   /**
@@ -492,18 +522,54 @@ private:
   };
 
   /**
-   * \brief Class to hold all the metadata
+   * \brief The operations recorded by a lazy metadata
    */
-  class DataFreeList : public std::vector<struct Data *>
+  enum OpType
   {
-public:
-    ~DataFreeList ();
+    CREATE,         //!< the constructor
+    ADD_HEADER,     //!< AddHeader
+    REMOVE_HEADER,  //!< RemoveHeader
+    ADD_TRAILER,    //!< AddTrailer
+    REMOVE_TRAILER, //!< RemoveTrailer
+    ADD_AT_END,     //!< AddAtEnd
+    REMOVE_AT_START, //!< RemoveAtStart
+    REMOVE_AT_END   //!< RemoveAtEnd
+  };
+
+  /**
+   * \brief An operation of the log of a lazy metadata
+   *
+   * The log is a list linked from the last operation to the CREATE
+   * operation through the prev field; logs with a common history
+   * share their first operations.
+   */
+  struct Op {
+    /** number of operations and metadata which reference this one */
+    uint32_t count;
+    /** the OpType of the operation */
+    uint8_t type;
+    /** chunk uid of the added header, trailer or payload */
+    uint16_t chunkUid;
+    /** type uid of the header or trailer, as in SmallItem::typeUid */
+    uint32_t typeUid;
+    /** size of the header, trailer or payload, or size removed */
+    uint32_t size;
+    /** uid of the packet, for a CREATE operation */
+    uint64_t packetUid;
+    /** the previous operation, zero for a CREATE operation */
+    struct Op *prev;
+    /** the last operation of the appended metadata, for ADD_AT_END */
+    struct Op *other;
   };
 
-  friend DataFreeList::~DataFreeList ();
   friend class ItemIterator;
 
-  PacketMetadata ();
+  /**
+   * \brief Constructor of an empty metadata which does not record
+   *        its operations, regardless of SetLazy.
+   * \param uid packet uid
+   */
+  explicit PacketMetadata (uint64_t uid);
 
   /**
    * \brief Add a SmallItem
@@ -613,8 +679,69 @@ public:
    * \brief Add an header
    * \param uid header's uid to add
    * \param size header serialized size
+   * \param chunkUid the uid of this header instance
+   */
+  void DoAddHeader (uint32_t uid, uint32_t size, uint16_t chunkUid);
+  /**
+   * \brief Remove an header
+   * \param uid header's uid to remove
+   * \param size header serialized size
+   */
+  void DoRemoveHeader (uint32_t uid, uint32_t size);
+  /**
+   * \brief Add a trailer
+   * \param uid trailer's uid to add
+   * \param size trailer serialized size
+   * \param chunkUid the uid of this trailer instance
+   */
+  void DoAddTrailer (uint32_t uid, uint32_t size, uint16_t chunkUid);
+  /**
+   * \brief Remove a trailer
+   * \param uid trailer's uid to remove
+   * \param size trailer serialized size
+   */
+  void DoRemoveTrailer (uint32_t uid, uint32_t size);
+
+  /**
+   * \brief Start the log of a lazy metadata
+   * \param size size of the initial payload
+   */
+  void CreateLog (uint32_t size);
+  /**
+   * \brief Append an operation to the log and drop the items
+   *        reconstructed from the previous operations
+   * \param type the OpType of the operation
+   * \param typeUid the type uid of the header or trailer, if any
+   * \param size the size of the operation
+   * \returns the new operation
+   */
+  struct Op *Record (uint8_t type, uint32_t typeUid, uint32_t size);
+  /**
+   * \brief Reconstruct the items of a lazy metadata, if needed
+   */
+  void Materialize (void) const;
+  /**
+   * \brief Reconstruct the items and stop recording the operations
+   */
+  void DropLog (void);
+  /**
+   * \brief Replay a log
+   * \param log the last operation of the log
+   * \returns a metadata which does not record its operations, with
+   *          the items resulting from the operations of the log
+   */
+  static PacketMetadata Replay (const struct Op *log);
+  /**
+   * \brief Allocate an operation
+   * \returns an operation with a count of one
    */
-  void DoAddHeader (uint32_t uid, uint32_t size);
+  static struct Op *CreateOp (void);
+  /**
+   * \brief Drop a reference to a log, and recycle the operations
+   *        which are not referenced anymore
+   * \param op the last operation of the log
+   */
+  static void ReleaseLog (struct Op *op);
   /**
    * \brief Check if the metadata state is ok
    * \returns true if the internal state is ok
@@ -644,19 +771,8 @@ public:
    * \returns a pointer to the created buffer storage
    */
   static struct PacketMetadata::Data *Create (uint32_t size);
-  /**
-   * \brief Allocate a buffer data storage
-   * \param n the storage size to create
-   * \returns a pointer to the allocated buffer storage
-   */
-  static struct PacketMetadata::Data *Allocate (uint32_t n);
-  /**
-   * \brief Deallocate the buffer memory
-   * \param data the buffer data storage
-   */
-  static void Deallocate (struct PacketMetadata::Data *data);
 
-  static DataFreeList m_freeList; //!< the metadata data storage
+  static bool m_lazy; //!< Record the operations of the new metadata
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
 
@@ -667,10 +783,10 @@ public:
    */
   static bool m_metadataSkipped;
 
-  static uint32_t m_maxSize; //!< maximum metadata size
-  static uint16_t m_chunkUid; //!< Chunk Uid
+  static __thread uint16_t m_chunkUid; //!< Chunk Uid, counted per thread
 
-  struct Data *m_data; //!< Metadata storage
+  struct Data *m_data; //!< Metadata storage, zero if not reconstructed yet
+  struct Op *m_log; //!< last recorded operation, zero if not lazy
   /*
      head -(next)-> tail
        ^             |
@@ -687,28 +803,42 @@ public:
 namespace ns3 {
 
 PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
-  : m_data (PacketMetadata::Create (10)),
+  : m_data (0),
+    m_log (0),
     m_head (0xffff),
     m_tail (0xffff),
     m_used (0),
     m_packetUid (uid)
 {
+  if (m_lazy)
+    {
+      CreateLog (size);
+      return;
+    }
+  m_data = PacketMetadata::Create (10);
   memset (m_data->m_data, 0xff, 4);
   if (size > 0)
     {
-      DoAddHeader (0, size);
+      DoAddHeader (0, size, m_chunkUid++);
     }
 }
 PacketMetadata::PacketMetadata (PacketMetadata const &o)
   : m_data (o.m_data),
+    m_log (o.m_log),
     m_head (o.m_head),
     m_tail (o.m_tail),
     m_used (o.m_used),
     m_packetUid (o.m_packetUid)
 {
-  NS_ASSERT (m_data != 0);
-  NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
-  m_data->m_count++;
+  if (m_data != 0)
+    {
+      NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
+      m_data->m_count++;
+    }
+  if (m_log != 0)
+    {
+      m_log->count++;
+    }
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -716,15 +846,31 @@ PacketMetadata::operator = (PacketMetadata const& o)
   if (m_data != o.m_data) 
     {
       // not self assignment
-      NS_ASSERT (m_data != 0);
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (m_data != 0)
         {
-          PacketMetadata::Recycle (m_data);
+          m_data->m_count--;
+          if (m_data->m_count == 0) 
+            {
+              PacketMetadata::Recycle (m_data);
+            }
         }
       m_data = o.m_data;
-      NS_ASSERT (m_data != 0);
-      m_data->m_count++;
+      if (m_data != 0)
+        {
+          m_data->m_count++;
+        }
+    }
+  if (m_log != o.m_log)
+    {
+      if (o.m_log != 0)
+        {
+          o.m_log->count++;
+        }
+      if (m_log != 0)
+        {
+          PacketMetadata::ReleaseLog (m_log);
+        }
+      m_log = o.m_log;
     }
   m_head = o.m_head;
   m_tail = o.m_tail;
@@ -734,11 +880,17 @@ PacketMetadata::operator = (PacketMetadata const& o)
 }
 PacketMetadata::~PacketMetadata ()
 {
-  NS_ASSERT (m_data != 0);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (m_data != 0)
+    {
+      m_data->m_count--;
+      if (m_data->m_count == 0) 
+        {
+          PacketMetadata::Recycle (m_data);
+        }
+    }
+  if (m_log != 0)
     {
-      PacketMetadata::Recycle (m_data);
+      PacketMetadata::ReleaseLog (m_log);
     }
 }
 
@@ -20,269 +20,249 @@
 
 /**
 \file   packet-tag-list.cc
-\brief  Implements a linked list of Packet tags, including copy-on-write semantics.
+\brief  Implements the list of Packet tags, stored inline in the packet.
 */
 
 #include "packet-tag-list.h"
+#include "packet-free-list.h"
 #include "tag-buffer.h"
 #include "tag.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
 #include <cstring>
+#include <new>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
-bool
-PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
-{
-  TypeId tid = tag.GetInstanceTypeId ();
-  NS_LOG_FUNCTION (this << tid);
-  NS_LOG_INFO     ("looking for " << tid);
+/** The free list of the spilled tags. */
+static PacketFreeList g_spillFreeList (1000);
 
-  // trivial case when list is empty
-  if (m_next == 0)
-    {
-      return false;
-    }
+uint32_t
+PacketTagList::GetMaskBit (TypeId tid)
+{
+  return 1U << (tid.GetUid () & 31);
+}
 
-  bool found = false;
+struct PacketTagList::Spill *
+PacketTagList::CreateSpill (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  void *p = g_spillFreeList.Allocate (sizeof (struct Spill));
+  struct Spill *spill = new (p) struct Spill ();
+  spill->count = 1;
+  return spill;
+}
 
-  struct TagData ** prevNext = &m_next; // previous node's next pointer
-  struct TagData  * cur      =  m_next; // cursor to current node
-  struct TagData  * it = 0;             // utility
+void
+PacketTagList::RecycleSpill (struct Spill *spill)
+{
+  NS_LOG_FUNCTION (spill);
+  NS_ASSERT (spill->count == 0);
+  spill->~Spill ();
+  g_spillFreeList.Free (spill);
+}
 
-  // Search from the head of the list until we find tid or a merge
-  while (cur != 0)
+struct PacketTagList::Spill *
+PacketTagList::DetachSpill (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_spill->count > 1)
     {
-      if (cur->count > 1)
-        {
-          // found merge
-          NS_LOG_INFO ("found initial merge before tid");
-          break;
-        }
-      else if (cur->tid == tid)
-        {
-          NS_LOG_INFO ("found tid before initial merge, calling writer");
-          found = (this->*Writer)(tag, true, cur, prevNext);
-          break;
-        }
-      else
-        {
-          // no merge or tid found yet, move on
-          prevNext = &cur->next;
-          cur      =  cur->next;
-        }
-    }  // while !found && !cow
+      // copy before dropping our reference: the other lists may
+      // release theirs meanwhile.
+      struct Spill *spill = CreateSpill ();
+      spill->tags = m_spill->tags;
+      ReleaseSpill ();
+      m_spill = spill;
+    }
+  return m_spill;
+}
 
-  // did we find it or run out of tags?
-  if (cur == 0 || found)
+void
+PacketTagList::Unshare (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_spill != 0)
     {
-      NS_LOG_INFO ("returning after header with found: " << found);
-      return found;
+      DetachSpill ();
     }
+}
 
-  // From here on out, we have to copy the list
-  // until we find tid, then link past it
-
-  // Before we do all that work, let's make sure tid really exists
-  for (it = cur; it != 0; it = it->next)
+void
+PacketTagList::ReleaseSpill (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_spill == 0)
     {
-      if (it->tid == tid)
-        {
-          break;
-        }
+      return;
     }
-  if (it == 0)
+  if (__sync_sub_and_fetch (&m_spill->count, 1) == 0)
     {
-      // got to end of list without finding tid
-      NS_LOG_INFO ("tid not found after first merge");
-      return found;
+      RecycleSpill (m_spill);
     }
+  m_spill = 0;
+}
 
-  // At this point cur is a merge, but untested for tid
-  NS_ASSERT (cur != 0);
-  NS_ASSERT (cur->count > 1);
-
-  /*
-     Walk the remainder of the list, copying, until we find tid
-     As we put a copy of the cur node onto our list,
-     we move the merge point down the list.
-
-     Starting position                  End position
-       T1 is a merge                     T1.count decremented
-                                         T2 is a merge
-                                         T1' is a copy of T1
-
-          other                             other
-               \                                 \
-      Prev  ->  T1  ->  T2  -> ...                T1  ->  T2  -> ...
-           /   /                                         /|
-      pNext cur                         Prev  ->  T1' --/ |
-                                                     /    |
-                                                pNext   cur
-
-     When we reach tid, we link past it, decrement count, and we're done.
-  */
-
-  // Should normally check for null cur pointer,
-  // but since we know tid exists, we'll skip this test
-  while ( /* cur && */ cur->tid != tid)
+struct PacketTagList::TagData *
+PacketTagList::Find (TypeId tid)
+{
+  NS_LOG_FUNCTION (this << tid);
+  if ((m_mask & GetMaskBit (tid)) == 0)
     {
-      NS_ASSERT (cur != 0);
-      NS_ASSERT (cur->count > 1);
-      cur->count--;                       // unmerge cur
-      struct TagData * copy = new struct TagData ();
-      copy->tid = cur->tid;
-      copy->count = 1;
-      memcpy (copy->data, cur->data, TagData::MAX_SIZE);
-      copy->next = cur->next;             // merge into tail
-      copy->next->count++;                // mark new merge
-      *prevNext = copy;                   // point prior list at copy
-      prevNext = &copy->next;             // advance
-      cur      =  copy->next;
+      return 0;
     }
-  // Sanity check:
-  NS_ASSERT (cur != 0);                 // cur should be non-zero
-  NS_ASSERT (cur->tid == tid);          // cur->tid should be tid
-  NS_ASSERT (cur->count > 1);           // cur should be a merge
-
-  // link around tid, removing it from our list
-  found = (this->*Writer)(tag, false, cur, prevNext);
-  return found;
-
+  for (uint32_t i = 0; i < m_inlineN; i++)
+    {
+      if (m_inline[i].tid == tid)
+        {
+          return &m_inline[i];
+        }
+    }
+  if (m_spill != 0)
+    {
+      for (uint32_t i = 0; i < m_spill->tags.size (); i++)
+        {
+          if (m_spill->tags[i].tid == tid)
+            {
+              return &DetachSpill ()->tags[i];
+            }
+        }
+    }
+  return 0;
 }
 
 bool
 PacketTagList::Remove (Tag & tag)
 {
-  return COWTraverse (tag, &PacketTagList::RemoveWriter);
-}
-
-// COWWriter implementing Remove
-bool
-PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
-                             struct PacketTagList::TagData  * cur,
-                             struct PacketTagList::TagData ** prevNext)
-{
-  NS_LOG_FUNCTION_NOARGS ();
-
-  // found tid
-  bool found = true;
-  tag.Deserialize (TagBuffer (cur->data,
-                              cur->data + TagData::MAX_SIZE));
-  *prevNext = cur->next;            // link around cur
-
-  if (preMerge)
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  struct TagData *cur = Find (tid);
+  if (cur == 0)
     {
-      // found tid before first merge, so delete cur
-      delete cur;
+      return false;
+    }
+  tag.Deserialize (TagBuffer (cur->data, cur->data + TagData::MAX_SIZE));
+  if (cur >= m_inline && cur < m_inline + m_inlineN)
+    {
+      m_inlineN--;
+      *cur = m_inline[m_inlineN];
     }
   else
     {
-      // cur is always a merge at this point
-      // unmerge cur, since we linked around it already
-      cur->count--;
-      if (cur->next != 0)
+      *cur = m_spill->tags.back ();
+      m_spill->tags.pop_back ();
+      if (m_spill->tags.empty ())
         {
-          // there's a next, so make it a merge
-          cur->next->count++;
+          ReleaseSpill ();
         }
     }
-  return found;
+  if (GetN () == 0)
+    {
+      m_mask = 0;
+    }
+  return true;
 }
 
 bool
 PacketTagList::Replace (Tag & tag)
 {
-  bool found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
-  if (!found)
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  struct TagData *cur = Find (tid);
+  if (cur == 0)
     {
       Add (tag);
+      return false;
     }
-  return found;
+  NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
+  tag.Serialize (TagBuffer (cur->data, cur->data + tag.GetSerializedSize ()));
+  return true;
 }
 
-// COWWriter implementing Replace
-bool
-PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
-                              struct PacketTagList::TagData  * cur,
-                              struct PacketTagList::TagData ** prevNext)
+void 
+PacketTagList::Add (const Tag &tag) const
 {
-  NS_LOG_FUNCTION_NOARGS ();
-
-  // found tid
-  bool found = true;
-  if (preMerge)
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+#ifdef NS3_ASSERT_ENABLE
+  // ensure this id was not yet added
+  for (uint32_t i = 0; i < GetN (); i++)
     {
-      // found tid before first merge, so just rewrite
-      tag.Serialize (TagBuffer (cur->data,
-                                cur->data + tag.GetSerializedSize ()));
+      NS_ASSERT (Get (i)->tid != tid);
     }
-  else
+#endif /* NS3_ASSERT_ENABLE */
+  PacketTagList *self = const_cast<PacketTagList *> (this);
+  struct TagData *head;
+  if (m_inlineN < INLINE_SIZE)
     {
-      // cur is always a merge at this point
-      // need to copy, replace, and link past cur
-      cur->count--;                     // unmerge cur
-      struct TagData * copy = new struct TagData ();
-      copy->tid = tag.GetInstanceTypeId ();
-      copy->count = 1;
-      tag.Serialize (TagBuffer (copy->data,
-                                copy->data + tag.GetSerializedSize ()));
-      copy->next = cur->next;           // merge into tail
-      if (copy->next != 0)
-        {
-          copy->next->count++;          // mark new merge
-        }
-      *prevNext = copy;                 // point prior list at copy
+      head = &self->m_inline[self->m_inlineN];
+      self->m_inlineN++;
     }
-  return found;
-}
-
-void 
-PacketTagList::Add (const Tag &tag) const
-{
-  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
-  // ensure this id was not yet added
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  else
     {
-      NS_ASSERT (cur->tid != tag.GetInstanceTypeId ());
+      struct Spill *spill = m_spill == 0 ? CreateSpill () : self->DetachSpill ();
+      self->m_spill = spill;
+      spill->tags.push_back (TagData ());
+      head = &spill->tags.back ();
     }
-  struct TagData * head = new struct TagData ();
-  head->count = 1;
-  head->next = 0;
-  head->tid = tag.GetInstanceTypeId ();
-  head->next = m_next;
+  head->tid = tid;
   NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
   tag.Serialize (TagBuffer (head->data, head->data + tag.GetSerializedSize ()));
-
-  const_cast<PacketTagList *> (this)->m_next = head;
+  self->m_mask |= GetMaskBit (tid);
 }
 
 bool
 PacketTagList::Peek (Tag &tag) const
 {
-  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  NS_LOG_FUNCTION (this << tid);
+  if ((m_mask & GetMaskBit (tid)) == 0)
+    {
+      return false;
+    }
+  const struct TagData *cur = 0;
+  for (uint32_t i = 0; i < m_inlineN && cur == 0; i++)
     {
-      if (cur->tid == tid) 
+      if (m_inline[i].tid == tid)
         {
-          /* found tag */
-          tag.Deserialize (TagBuffer (cur->data, cur->data + TagData::MAX_SIZE));
-          return true;
+          cur = &m_inline[i];
         }
     }
-  /* no tag found */
-  return false;
+  for (uint32_t i = 0; m_spill != 0 && i < m_spill->tags.size () && cur == 0; i++)
+    {
+      if (m_spill->tags[i].tid == tid)
+        {
+          cur = &m_spill->tags[i];
+        }
+    }
+  if (cur == 0)
+    {
+      /* no tag found */
+      return false;
+    }
+  /* found tag */
+  tag.Deserialize (TagBuffer (const_cast<uint8_t *> (cur->data),
+                              const_cast<uint8_t *> (cur->data) + TagData::MAX_SIZE));
+  return true;
+}
+
+uint32_t
+PacketTagList::GetN (void) const
+{
+  return m_inlineN + (m_spill == 0 ? 0 : m_spill->tags.size ());
 }
 
 const struct PacketTagList::TagData *
-PacketTagList::Head (void) const
+PacketTagList::Get (uint32_t i) const
 {
-  return m_next;
+  NS_ASSERT (i < GetN ());
+  if (i < m_inlineN)
+    {
+      return &m_inline[i];
+    }
+  return &m_spill->tags[i - m_inlineN];
 }
 
 } /* namespace ns3 */
-
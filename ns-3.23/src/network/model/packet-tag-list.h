@@ -22,11 +22,12 @@
 
 /**
 \file   packet-tag-list.h
-\brief  Defines a linked list of Packet tags, including copy-on-write semantics.
+\brief  Defines the list of Packet tags, stored inline in the packet.
 */
 
 #include <stdint.h>
 #include <ostream>
+#include <vector>
 #include "ns3/type-id.h"
 
 namespace ns3 {
@@ -43,96 +44,33 @@ class Tag;
  *
  * \internal
  *
- * The implementation of this class is a bit tricky.  Refer to this
- * diagram in the discussion that follows.
+ * Tags are stored in serialized form, see TagData.
  *
- * \dot
- *    digraph {
- *        rankdir = "LR";
- *        clusterrank = local;
- *        node [ shape = record, fontname="FreeSans", fontsize="10" ];
- *        oth  [ label="<l> Other branch | <n> next | <c> ..." ];
- *        PTL1 [ label="<l> PacketTagList A | <n> m_next" , shape=Mrecord];
- *        PTL2 [ label="<l> PacketTagList B | <n> m_next" , shape=Mrecord];
- *        oth:n  -> T7:l ;
- *        PTL2:n -> T6:l ;
- *        PTL1:n -> T5:l ;
- *        T1   [ label="<l> T1  | <n> next | <c> count = 1" ];
- *        T2   [ label="<l> T2  | <n> next | <c> count = 1" ];
- *        T3   [ label="<l> T3  | <n> next | <c> count = 2" ];
- *        T4   [ label="<l> T4  | <n> next | <c> count = 1" ];
- *        T5   [ label="<l> T5  | <n> next | <c> count = 2" ];
- *        T6   [ label="<l> T6  | <n> next | <c> count = 1" ];
- *        T7   [ label="<l> T7  | <n> next | <c> count = 1" ];
- *        NULL [ label="0", shape = ellipse ];
- *        subgraph cluster_list {
- *          penwidth = 0;
- *          T6:n -> T5:l ;
- *          T5:n -> T4:l ;
- *          T4:n -> T3:l ;
- *          T7:n -> T3:l ;
- *          T3:n -> T2:l ;
- *          T2:n -> T1:l ;
- *          T1:n -> NULL ;
- *        };
- *      };
- * \enddot
+ *   - The first #INLINE_SIZE tags are stored in an array inside the
+ *     PacketTagList, hence inside the Packet: adding them to a packet
+ *     does not allocate memory, and copying a packet copies them.
  *
- *   - Tags are stored in serialized form in a tree of TagData
- *     structures. (<tt>T1-T7</tt> in the diagram)
+ *   - The tags past #INLINE_SIZE "spill" into a block shared by the
+ *     copies of the list and copied on write. The blocks are recycled
+ *     through a free list.
  *
- *   - Each TagData points (\c next pointers in the diagram)
- *     toward the root of the tree, which is a null pointer.
+ *   - Each tag type is identified by the 16-bit uid interned by TypeId.
+ *     The list keeps a mask with one bit per uid modulo 32, so that
+ *     looking for a tag which is not in the list, the most common case,
+ *     takes constant time. The bits of removed tags are only cleared
+ *     when the list becomes empty.
  *
- *   - \c count is the number of incoming pointers to this
- *     TagData.  Branch points, where branches merge or join, have
- *     <tt>count \> 1</tt> (\c T3, \c T5); successive links along
- *     a branch have <tt>count = 1</tt> (\c T1, \c T2, \c T4, \c T6, \c T7).
- *
- *   - Each PacketTagList points to a specific TagData,
- *     which is the most recent Tag added to the packet. (<tt>T5-T7</tt>)
- *
- *   - Conceptually, therefore, each Packet has a PacketTagList which
- *     points to a singly-linked list of TagData.
- *
- * \par <b> Copy-on-write </b> is implemented as follows:
- *
- *   - #Add prepends the new tag to the list (growing that branch of the tree,
- *     as \c T6). This is a constant time operation, and does not affect
- *     any other #PacketTagList's, hence this is a \c const function.
- *
- *   - Copy constructor (PacketTagList(const PacketTagList & o))
- *     and assignment (#operator=(const PacketTagList & o)
- *     simply join the tree at the same place as the original
- *     PacketTagList \c o, incrementing the \c count.
- *     For assignment, the old branch is deleted, up to
- *     the first branch point, which has its \c count decremented.
- *     (PacketTagList \c B started as a copy of PacketTagList \c A,
- *     before \c T6 was added to \c B).
- *
- *   - #Remove and #Replace are a little tricky, depending on where the
- *     target tag is found relative to the first branch point:
- *     - \e Target before <em> the first branch point: </em> \n
- *       The target is just dealt with in place (linked around and deleted,
- *       in the case of #Remove; rewritten in the case of #Replace).
- *     - \e Target at or after <em> the first branch point: </em> \n
- *       The portion of the list between the first branch and the target is
- *       shared. This portion is copied before the #Remove or #Replace is
- *       performed.
+ * The order of the tags in the list is not specified.
  *
  * \par <b> Memory Management: </b>
  * \n
  * Packet tags must serialize to a finite maximum size, see TagData
- *
- * This documentation entitles the original author to a free beer.
  */
 class PacketTagList 
 {
 public:
   /**
-   * Tree node for sharing serialized tags.
-   *
-   * See PacketTagList for a discussion of the data structure.
+   * A tag in serialized form.
    *
    * See TagData::TagData_e for a discussion of the size limit on
    * tag serialization.
@@ -146,15 +84,9 @@ public:
      * in this constant.
      *
      * \internal
-     * Ideally, TagData would be 32 bytes in size, so they require
-     * no padding on 64-bit architectures.  (The architecture
-     * affects the size because of the \c #next pointer.)
-     * This would leave 18 bytes for \c #data.  However,
-     * ns3:Ipv6PacketInfoTag needs 19 bytes!  The current
+     * ns3:Ipv6PacketInfoTag needs 19 bytes. The current
      * implementation allows 20 bytes, which gives TagData
-     * a size of 30 bytes on 32-byte machines (which gets
-     * padded with 2 bytes), and 34 bytes on 64-bit machines, which
-     * gets padded to 40 bytes.
+     * a size of 22 bytes.
      */
     enum TagData_e
     {
@@ -162,11 +94,17 @@ public:
   };
 
     uint8_t data[MAX_SIZE];   /**< Serialization buffer */
-    struct TagData * next;   /**< Pointer to next in list */
     TypeId tid;               /**< Type of the tag serialized into #data */
-    uint32_t count;           /**< Number of incoming links */
   };  /* struct TagData */
 
+  /**
+   * \brief Number of tags stored inline
+   */
+  enum InlineSize_e
+  {
+    INLINE_SIZE = 4           /**< Size of #m_inline */
+  };
+
   /**
    * Create a new PacketTagList.
    */
@@ -176,8 +114,7 @@ public:
    *
    * \param [in] o The PacketTagList to copy.
    *
-   * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * This copies the inline tags and shares the spilled ones.
    */
   inline PacketTagList (PacketTagList const &o);
   /**
@@ -186,25 +123,22 @@ public:
    * \param [in] o The PacketTagList to copy.
    * \returns the copied object
    *
-   * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * This copies the inline tags and shares the spilled ones.
    */
   inline PacketTagList &operator = (PacketTagList const &o);
   /**
    * Destructor
-   *
-   * #RemoveAll's the tags up to the first merge.
    */
   inline ~PacketTagList ();
 
   /**
-   * Add a tag to the head of this branch.
+   * Add a tag to the list.
    *
    * \param [in] tag The tag to add
    */
   void Add (Tag const&tag) const;
   /**
-   * Remove (the first instance of) tag from the list.
+   * Remove tag from the list.
    *
    * \param [in,out] tag The tag type to remove.  If found,
    *          \pname{tag} is set to the value of the tag found.
@@ -230,67 +164,67 @@ public:
    */
   bool Peek (Tag &tag) const;
   /**
-   * Remove all tags from this list (up to the first merge).
+   * Remove all tags from this list.
    */
   inline void RemoveAll (void);
   /**
-   * \returns pointer to head of tag list
+   * \returns the number of tags in the list.
+   */
+  uint32_t GetN (void) const;
+  /**
+   * \param [in] i The index of a tag, smaller than GetN.
+   * \returns the tag.
+   */
+  const struct PacketTagList::TagData *Get (uint32_t i) const;
+  /**
+   * Copy the spilled tags if they are shared with another list, so
+   * that this list shares no storage with any other one.
    */
-  const struct PacketTagList::TagData *Head (void) const;
+  void Unshare (void);
 
 private:
   /**
-   * Typedef of method function pointer for copy-on-write operations
-   *
-   * \param [in] tag The tag type to operate on.
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *             false otherwise.
-   * \param [in] cur Pointer to the tag.
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True if operation successful, false otherwise
+   * The tags which do not fit in #m_inline, shared by the copies of
+   * a list and copied before being modified.
    */
-  typedef bool (PacketTagList::*COWWriter)
-    (Tag       & tag, bool         preMerge,
-    struct TagData * cur, struct TagData ** prevNext);
+  struct Spill
+  {
+    volatile uint32_t count;     /**< Number of lists sharing these tags, updated atomically */
+    std::vector<TagData> tags;   /**< The tags */
+  };
+
   /**
-   * Traverse the list implementing copy-on-write, using \pname{Writer}.
-   *
-   * \param [in] tag The tag type to operate on.
-   * \param [in] Writer The copy-on-write function to use.
-   * \returns True if \pname{tag} found, false otherwise.
+   * \param [in] tid The type of a tag.
+   * \returns the bit of #m_mask for this type.
    */
-  bool COWTraverse   (Tag & tag, PacketTagList::COWWriter Writer);
+  static uint32_t GetMaskBit (TypeId tid);
   /**
-   * Copy-on-write implementing Remove.
-   *
-   * \param [in] tag The target tag type to remove.
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *             false otherwise.
-   * \param [in] cur Pointer to the tag.
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True, since tag will definitely be removed.
+   * \param [in] tid The type of a tag.
+   * \returns the tag of this type, or zero if there is none. Spilled
+   *          tags are copied first so that the tag can be modified.
    */
-  bool RemoveWriter  (Tag       & tag, bool         preMerge,
-                      struct TagData * cur, struct TagData ** prevNext);
+  struct TagData *Find (TypeId tid);
   /**
-   * Copy-on-write implementing Replace
-   *
-   * \param [in] tag The target tag type to replace
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *          false otherwise.
-   * \param [in] cur Pointer to the tag
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True, since tag value will definitely be replaced.
+   * \returns a copy of the spilled tags which is not shared.
    */
-  bool ReplaceWriter (Tag & tag, bool preMerge, struct TagData * cur, struct TagData ** prevNext);
-
+  struct Spill *DetachSpill (void);
+  /**
+   * \returns new spilled tags, empty, with a count of one.
+   */
+  static struct Spill *CreateSpill (void);
+  /**
+   * \param [in] spill Spilled tags which are not used anymore.
+   */
+  static void RecycleSpill (struct Spill *spill);
   /**
-   * Pointer to first \ref TagData on the list
+   * Drop the reference to the spilled tags.
    */
-  struct TagData *m_next;
+  void ReleaseSpill (void);
+
+  struct TagData m_inline[INLINE_SIZE]; //!< the first tags
+  uint8_t m_inlineN;                    //!< the number of tags in #m_inline
+  uint32_t m_mask;                      //!< at least the bits of the types in the list
+  struct Spill *m_spill;                //!< the other tags, if any
 };
 
 } // namespace ns3
@@ -302,16 +236,24 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_inlineN (0),
+    m_mask (0),
+    m_spill (0)
 {
 }
 
 PacketTagList::PacketTagList (PacketTagList const &o)
-  : m_next (o.m_next)
+  : m_inlineN (o.m_inlineN),
+    m_mask (o.m_mask),
+    m_spill (o.m_spill)
 {
-  if (m_next != 0)
+  for (uint32_t i = 0; i < m_inlineN; i++)
+    {
+      m_inline[i] = o.m_inline[i];
+    }
+  if (m_spill != 0)
     {
-      m_next->count++;
+      __sync_fetch_and_add (&m_spill->count, 1);
     }
 }
 
@@ -319,46 +261,48 @@ PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (this == &o) 
     {
       return *this;
     }
-  RemoveAll ();
-  m_next = o.m_next;
-  if (m_next != 0) 
+  m_inlineN = o.m_inlineN;
+  m_mask = o.m_mask;
+  for (uint32_t i = 0; i < m_inlineN; i++)
     {
-      m_next->count++;
+      m_inline[i] = o.m_inline[i];
+    }
+  if (m_spill != o.m_spill)
+    {
+      if (m_spill != 0)
+        {
+          ReleaseSpill ();
+        }
+      m_spill = o.m_spill;
+      if (m_spill != 0)
+        {
+          __sync_fetch_and_add (&m_spill->count, 1);
+        }
     }
   return *this;
 }
 
 PacketTagList::~PacketTagList ()
 {
-  RemoveAll ();
+  if (m_spill != 0)
+    {
+      ReleaseSpill ();
+    }
 }
 
 void
 PacketTagList::RemoveAll (void)
 {
-  struct TagData *prev = 0;
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
-    {
-      cur->count--;
-      if (cur->count > 0) 
-        {
-          break;
-        }
-      if (prev != 0) 
-        {
-	  delete prev;
-        }
-      prev = cur;
-    }
-  if (prev != 0) 
+  if (m_spill != 0)
     {
-      delete prev;
+      ReleaseSpill ();
     }
-  m_next = 0;
+  m_inlineN = 0;
+  m_mask = 0;
 }
 
 } // namespace ns3
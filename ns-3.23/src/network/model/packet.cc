@@ -18,6 +18,7 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "packet.h"
+#include "packet-accounting.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
@@ -28,7 +29,38 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Packet");
 
-uint32_t Packet::m_globalUid = 0;
+namespace {
+
+/**
+ * \ingroup packet
+ * The uid counter of a system id. Each counter fills a cache line, so
+ * that the partitions of a multithreaded simulation do not share one.
+ */
+struct UidCounter
+{
+  uint32_t next;       //!< The lower 32 bits of the next uid.
+  uint8_t padding[60]; //!< Pads the counter to a cache line.
+};
+
+/** The number of uid counters; system ids share them modulo this number. */
+const uint32_t N_UID_COUNTERS = 256;
+/** The uid counters. */
+UidCounter g_uidCounters[N_UID_COUNTERS];
+
+} // anonymous namespace
+
+uint64_t
+Packet::AllocateUid (void)
+{
+  /* The upper 32 bits of the packet id in metadata is for the system
+   * id. For simulations which are neither distributed nor multithreaded,
+   * this is simply zero. The lower 32 bits count the packets created by
+   * this system id.
+   */
+  uint32_t systemId = Simulator::GetSystemId ();
+  UidCounter &counter = g_uidCounters[systemId % N_UID_COUNTERS];
+  return static_cast<uint64_t> (systemId) << 32 | counter.next++;
+}
 
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
@@ -81,21 +113,22 @@ ByteTagIterator::ByteTagIterator (ByteTagList::Iterator i)
 }
 
 
-PacketTagIterator::PacketTagIterator (const struct PacketTagList::TagData *head)
-  : m_current (head)
+PacketTagIterator::PacketTagIterator (const PacketTagList *list)
+  : m_list (list),
+    m_current (0)
 {
 }
 bool
 PacketTagIterator::HasNext (void) const
 {
-  return m_current != 0;
+  return m_current < m_list->GetN ();
 }
 PacketTagIterator::Item
 PacketTagIterator::Next (void)
 {
   NS_ASSERT (HasNext ());
-  const struct PacketTagList::TagData *prev = m_current;
-  m_current = m_current->next;
+  const struct PacketTagList::TagData *prev = m_list->Get (m_current);
+  m_current++;
   return PacketTagIterator::Item (prev);
 }
 
@@ -127,30 +160,72 @@ Packet::Copy (void) const
   return Ptr<Packet> (new Packet (*this), false);
 }
 
+Ptr<Packet>
+Packet::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  Buffer buffer;
+  buffer.AddAtStart (m_buffer.GetSize ());
+  buffer.Begin ().Write (m_buffer.Begin (), m_buffer.End ());
+  // the byte tags are stored with the offsets of the buffer, which
+  // are not the same in the copy.
+  int32_t delta = buffer.GetCurrentStartOffset () - m_buffer.GetCurrentStartOffset ();
+  ByteTagList byteTagList;
+  ByteTagList::Iterator i = m_byteTagList.Begin (m_buffer.GetCurrentStartOffset (),
+                                                 m_buffer.GetCurrentEndOffset ());
+  while (i.HasNext ())
+    {
+      ByteTagList::Iterator::Item item = i.Next ();
+      TagBuffer tag = byteTagList.Add (item.tid, item.size, item.start + delta, item.end + delta);
+      tag.CopyFrom (item.buf);
+    }
+  PacketTagList packetTagList = m_packetTagList;
+  packetTagList.Unshare ();
+  PacketMetadata metadata = m_metadata;
+  metadata.Unshare ();
+  Ptr<Packet> copy = Ptr<Packet> (new Packet (buffer, byteTagList, packetTagList, metadata), false);
+  if (m_nixVector)
+    {
+      copy->m_nixVector = m_nixVector->Copy ();
+    }
+  return copy;
+}
+
 Packet::Packet ()
   : m_buffer (),
     m_byteTagList (),
     m_packetTagList (),
-    /* The upper 32 bits of the packet id in 
-     * metadata is for the system id. For non-
-     * distributed simulations, this is simply 
-     * zero.  The lower 32 bits are for the 
-     * global UID
-     */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, 0),
-    m_nixVector (0)
+    m_metadata (AllocateUid (), 0),
+    m_nixVector (0),
+    m_accounting (0)
 {
-  m_globalUid++;
+  if (PacketAccounting::IsEnabled ())
+    {
+      m_accounting = PacketAccounting::Add (GetUid (), GetSize ());
+    }
 }
 
 Packet::Packet (const Packet &o)
   : m_buffer (o.m_buffer),
     m_byteTagList (o.m_byteTagList),
     m_packetTagList (o.m_packetTagList),
-    m_metadata (o.m_metadata)
+    m_metadata (o.m_metadata),
+    m_accounting (0)
 {
   o.m_nixVector ? m_nixVector = o.m_nixVector->Copy ()
     : m_nixVector = 0;
+  if (PacketAccounting::IsEnabled ())
+    {
+      m_accounting = PacketAccounting::Add (GetUid (), GetSize ());
+    }
+}
+
+Packet::~Packet ()
+{
+  if (m_accounting != 0)
+    {
+      PacketAccounting::Remove (m_accounting, GetUid (), GetSize ());
+    }
 }
 
 Packet &
@@ -160,6 +235,15 @@ Packet::operator = (const Packet &o)
     {
       return *this;
     }
+  if (m_accounting != 0)
+    {
+      PacketAccounting::Remove (m_accounting, GetUid (), GetSize ());
+      m_accounting = 0;
+    }
+  if (PacketAccounting::IsEnabled ())
+    {
+      m_accounting = PacketAccounting::Add (o.GetUid (), o.GetSize ());
+    }
   m_buffer = o.m_buffer;
   m_byteTagList = o.m_byteTagList;
   m_packetTagList = o.m_packetTagList;
@@ -173,45 +257,46 @@ Packet::Packet (uint32_t size)
   : m_buffer (size),
     m_byteTagList (),
     m_packetTagList (),
-    /* The upper 32 bits of the packet id in 
-     * metadata is for the system id. For non-
-     * distributed simulations, this is simply 
-     * zero.  The lower 32 bits are for the 
-     * global UID
-     */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
-    m_nixVector (0)
+    m_metadata (AllocateUid (), size),
+    m_nixVector (0),
+    m_accounting (0)
 {
-  m_globalUid++;
+  if (PacketAccounting::IsEnabled ())
+    {
+      m_accounting = PacketAccounting::Add (GetUid (), GetSize ());
+    }
 }
 Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
   : m_buffer (0, false),
     m_byteTagList (),
     m_packetTagList (),
     m_metadata (0,0),
-    m_nixVector (0)
+    m_nixVector (0),
+    m_accounting (0)
 {
   NS_ASSERT (magic);
   Deserialize (buffer, size);
+  if (PacketAccounting::IsEnabled ())
+    {
+      m_accounting = PacketAccounting::Add (GetUid (), GetSize ());
+    }
 }
 
 Packet::Packet (uint8_t const*buffer, uint32_t size)
   : m_buffer (),
     m_byteTagList (),
     m_packetTagList (),
-    /* The upper 32 bits of the packet id in 
-     * metadata is for the system id. For non-
-     * distributed simulations, this is simply 
-     * zero.  The lower 32 bits are for the 
-     * global UID
-     */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
-    m_nixVector (0)
-{
-  m_globalUid++;
+    m_metadata (AllocateUid (), size),
+    m_nixVector (0),
+    m_accounting (0)
+{
   m_buffer.AddAtStart (size);
   Buffer::Iterator i = m_buffer.Begin ();
   i.Write (buffer, size);
+  if (PacketAccounting::IsEnabled ())
+    {
+      m_accounting = PacketAccounting::Add (GetUid (), GetSize ());
+    }
 }
 
 Packet::Packet (const Buffer &buffer,  const ByteTagList &byteTagList, 
@@ -220,8 +305,13 @@ Packet::Packet (const Buffer &buffer,  const ByteTagList &byteTagList,
     m_byteTagList (byteTagList),
     m_packetTagList (packetTagList),
     m_metadata (metadata),
-    m_nixVector (0)
+    m_nixVector (0),
+    m_accounting (0)
 {
+  if (PacketAccounting::IsEnabled ())
+    {
+      m_accounting = PacketAccounting::Add (GetUid (), GetSize ());
+    }
 }
 
 Ptr<Packet>
@@ -263,6 +353,10 @@ Packet::AddHeader (const Header &header)
     }
   header.Serialize (m_buffer.Begin ());
   m_metadata.AddHeader (header, size);
+  if (m_accounting != 0)
+    {
+      PacketAccounting::Resize (m_accounting, GetUid (), size);
+    }
 }
 uint32_t
 Packet::RemoveHeader (Header &header)
@@ -271,6 +365,10 @@ Packet::RemoveHeader (Header &header)
   NS_LOG_FUNCTION (this << header.GetInstanceTypeId ().GetName () << deserialized);
   m_buffer.RemoveAtStart (deserialized);
   m_metadata.RemoveHeader (header, deserialized);
+  if (m_accounting != 0)
+    {
+      PacketAccounting::Resize (m_accounting, GetUid (), -static_cast<int64_t> (deserialized));
+    }
   return deserialized;
 }
 uint32_t
@@ -295,6 +393,10 @@ Packet::AddTrailer (const Trailer &trailer)
   Buffer::Iterator end = m_buffer.End ();
   trailer.Serialize (end);
   m_metadata.AddTrailer (trailer, size);
+  if (m_accounting != 0)
+    {
+      PacketAccounting::Resize (m_accounting, GetUid (), size);
+    }
 }
 uint32_t
 Packet::RemoveTrailer (Trailer &trailer)
@@ -303,6 +405,10 @@ Packet::RemoveTrailer (Trailer &trailer)
   NS_LOG_FUNCTION (this << trailer.GetInstanceTypeId ().GetName () << deserialized);
   m_buffer.RemoveAtEnd (deserialized);
   m_metadata.RemoveTrailer (trailer, deserialized);
+  if (m_accounting != 0)
+    {
+      PacketAccounting::Resize (m_accounting, GetUid (), -static_cast<int64_t> (deserialized));
+    }
   return deserialized;
 }
 uint32_t
@@ -328,6 +434,10 @@ Packet::AddAtEnd (Ptr<const Packet> packet)
                    appendPrependOffset);
   m_byteTagList.Add (copy);
   m_metadata.AddAtEnd (packet->m_metadata);
+  if (m_accounting != 0)
+    {
+      PacketAccounting::Resize (m_accounting, GetUid (), packet->GetSize ());
+    }
 }
 void
 Packet::AddPaddingAtEnd (uint32_t size)
@@ -341,6 +451,10 @@ Packet::AddPaddingAtEnd (uint32_t size)
                               m_buffer.GetCurrentEndOffset () - size);
     }
   m_metadata.AddPaddingAtEnd (size);
+  if (m_accounting != 0)
+    {
+      PacketAccounting::Resize (m_accounting, GetUid (), size);
+    }
 }
 void 
 Packet::RemoveAtEnd (uint32_t size)
@@ -348,6 +462,10 @@ Packet::RemoveAtEnd (uint32_t size)
   NS_LOG_FUNCTION (this << size);
   m_buffer.RemoveAtEnd (size);
   m_metadata.RemoveAtEnd (size);
+  if (m_accounting != 0)
+    {
+      PacketAccounting::Resize (m_accounting, GetUid (), -static_cast<int64_t> (size));
+    }
 }
 void 
 Packet::RemoveAtStart (uint32_t size)
@@ -355,6 +473,10 @@ Packet::RemoveAtStart (uint32_t size)
   NS_LOG_FUNCTION (this << size);
   m_buffer.RemoveAtStart (size);
   m_metadata.RemoveAtStart (size);
+  if (m_accounting != 0)
+    {
+      PacketAccounting::Resize (m_accounting, GetUid (), -static_cast<int64_t> (size));
+    }
 }
 
 void 
@@ -364,6 +486,13 @@ Packet::RemoveAllByteTags (void)
   m_byteTagList.RemoveAll ();
 }
 
+uint32_t
+Packet::GetVirtualSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_buffer.GetZeroAreaSize ();
+}
+
 uint32_t 
 Packet::CopyData (uint8_t *buffer, uint32_t size) const
 {
@@ -550,6 +679,13 @@ Packet::EnablePrinting (void)
   PacketMetadata::Enable ();
 }
 
+void
+Packet::EnableLazyPrinting (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  PacketMetadata::SetLazy (true);
+}
+
 void
 Packet::EnableChecking (void)
 {
@@ -809,6 +945,17 @@ Packet::AddByteTag (const Tag &tag) const
                                 m_buffer.GetCurrentEndOffset ());
   tag.Serialize (buffer);
 }
+void
+Packet::AddByteTag (const Tag &tag, uint32_t start, uint32_t end) const
+{
+  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ().GetName () << tag.GetSerializedSize () << start << end);
+  NS_ASSERT_MSG (start <= end && end <= GetSize (), "Byte tag range outside of the packet");
+  ByteTagList *list = const_cast<ByteTagList *> (&m_byteTagList);
+  TagBuffer buffer = list->Add (tag.GetInstanceTypeId (), tag.GetSerializedSize (),
+                                m_buffer.GetCurrentStartOffset () + start,
+                                m_buffer.GetCurrentStartOffset () + end);
+  tag.Serialize (buffer);
+}
 ByteTagIterator 
 Packet::GetByteTagIterator (void) const
 {
@@ -893,7 +1040,7 @@ Packet::PrintPacketTags (std::ostream &os) const
 PacketTagIterator 
 Packet::GetPacketTagIterator (void) const
 {
-  return PacketTagIterator (m_packetTagList.Head ());
+  return PacketTagIterator (&m_packetTagList);
 }
 
 std::ostream& operator<< (std::ostream& os, const Packet &packet)
@@ -168,10 +168,11 @@ private:
   friend class Packet;
   /**
    * Constructor
-   * \param head head of the items
+   * \param list the tags of the packet
    */
-  PacketTagIterator (const struct PacketTagList::TagData *head);
-  const struct PacketTagList::TagData *m_current;  //!< actual position over the set of tags in a packet
+  PacketTagIterator (const PacketTagList *list);
+  const PacketTagList *m_list;  //!< the set of tags in a packet
+  uint32_t m_current;           //!< actual position over the set of tags in a packet
 };
 
 /**
@@ -237,6 +238,12 @@ public:
    * \param o object to copy
    */
   Packet (const Packet &o);
+  /**
+   * \brief Destructor
+   *
+   * Packets are counted by PacketAccounting when it is enabled.
+   */
+  ~Packet ();
   /**
    * \brief Basic assignment
    * \param o object to copy
@@ -247,9 +254,13 @@ public:
    * \brief Create a packet with a zero-filled payload.
    *
    * The memory necessary for the payload is not allocated:
-   * it will be allocated at any later point if you attempt
-   * to fragment this packet or to access the zero-filled
-   * bytes. The packet is allocated with a new uid (as 
+   * fragmenting the packet, adding headers and trailers, and
+   * concatenating it with other such packets only keep track of
+   * offsets. CopyData writes the zero bytes on demand (for pcap
+   * files or emulated devices, for example), and the payload is
+   * only allocated if PeekData is called or if it ends up between
+   * two other zero-filled payloads in the same packet (see
+   * GetVirtualSize). The packet is allocated with a new uid (as 
    * returned by getUid).
    * 
    * \param size the size of the zero-filled payload
@@ -297,6 +308,11 @@ public:
    * \returns the size in bytes of the packet
    */
   inline uint32_t GetSize (void) const;
+  /**
+   * \returns the number of bytes of the zero-filled payload of this
+   * packet which are not stored in memory.
+   */
+  uint32_t GetVirtualSize (void) const;
   /**
    * \brief Add header to this packet.
    *
@@ -423,6 +439,19 @@ public:
    */
   Ptr<Packet> Copy (void) const;
 
+  /**
+   * \brief performs a copy of the packet which shares no storage
+   * with the original packet.
+   *
+   * \returns the copy of the packet.
+   *
+   * Unlike Copy, the buffer, tags and metadata are copied, so the
+   * copy can be used by another thread than the original packet.
+   * Byte tags which lie outside of the bytes of the packet are not
+   * copied.
+   */
+  Ptr<Packet> DeepCopy (void) const;
+
   /**
    * \brief Returns the packet's Uid.
    *
@@ -489,6 +518,15 @@ public:
    * simulation setup and before any packet is created.
    */
   static void EnablePrinting (void);
+  /**
+   * \brief Enable printing packets metadata, reconstructed on demand.
+   *
+   * Like EnablePrinting, but the packets only record a log of the
+   * operations on their headers and trailers, which is replayed when
+   * they are printed or serialized: this is much cheaper when only
+   * a few of the packets are printed. See PacketMetadata::SetLazy.
+   */
+  static void EnableLazyPrinting (void);
   /**
    * \brief Enable packets metadata checking.
    *
@@ -541,6 +579,17 @@ public:
    * packet).
    */
   void AddByteTag (const Tag &tag) const;
+  /**
+   * \brief Tag the bytes of a range of this packet with a new byte tag.
+   *
+   * \param tag the new tag to add to this packet
+   * \param start the offset of the first byte tagged
+   * \param end the offset of the byte after the last byte tagged
+   *
+   * This is the counterpart of ByteTagIterator::Item::GetStart and
+   * GetEnd, for example to restore the tags of a saved packet.
+   */
+  void AddByteTag (const Tag &tag, uint32_t start, uint32_t end) const;
   /**
    * \brief Retiurns an iterator over the set of byte tags included in this packet
    *
@@ -700,8 +749,23 @@ private:
 
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
+  /**
+   * The accounting session which counted this object, or zero if it
+   * was created while PacketAccounting was disabled.
+   */
+  uint32_t m_accounting;
 
-  static uint32_t m_globalUid; //!< Global counter of packets Uid
+  /**
+   * \returns a new uid, from the range of the system id of the caller.
+   *
+   * Every system id, i.e., every MPI rank or every partition of a
+   * multithreaded simulation, counts its packets separately, so
+   * partitions running on different threads create packets without
+   * synchronizing, and the uids of each partition do not depend on the
+   * scheduling of the threads. Up to 256 partitions may create packets
+   * concurrently.
+   */
+  static uint64_t AllocateUid (void);
 };
 
 /**
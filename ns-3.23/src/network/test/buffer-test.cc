@@ -3,6 +3,11 @@
 #include "ns3/double.h"
 #include "ns3/test.h"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
 using namespace ns3;
 
 //-----------------------------------------------------------------------------
@@ -342,6 +347,426 @@ BufferTest::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
 //-----------------------------------------------------------------------------
+class BufferZeroAreaTest : public TestCase {
+private:
+  /**
+   * Check the content of a buffer without materializing it.
+   * \param b The buffer.
+   * \param expected The expected bytes.
+   * \param zeroSize The expected size of its zero area.
+   * \param line The line of the caller.
+   */
+  void Check (const Buffer &b, const std::vector<uint8_t> &expected, uint32_t zeroSize, int line);
+  /**
+   * Create a buffer made of some bytes, a zero area and some bytes.
+   */
+  static Buffer Make (uint8_t head, uint32_t zeroSize, uint8_t tail);
+public:
+  virtual void DoRun (void);
+  BufferZeroAreaTest ();
+};
+
+BufferZeroAreaTest::BufferZeroAreaTest ()
+  : TestCase ("Buffer zero area is kept virtual") {
+}
+
+Buffer
+BufferZeroAreaTest::Make (uint8_t head, uint32_t zeroSize, uint8_t tail)
+{
+  Buffer b (zeroSize);
+  if (head != 0)
+    {
+      b.AddAtStart (1);
+      b.Begin ().WriteU8 (head);
+    }
+  if (tail != 0)
+    {
+      b.AddAtEnd (1);
+      Buffer::Iterator i = b.End ();
+      i.Prev ();
+      i.WriteU8 (tail);
+    }
+  return b;
+}
+
+void
+BufferZeroAreaTest::Check (const Buffer &b, const std::vector<uint8_t> &expected, uint32_t zeroSize, int line)
+{
+  NS_TEST_EXPECT_MSG_EQ_INTERNAL (b.GetSize (), expected.size (), "wrong size", __FILE__, line);
+  NS_TEST_EXPECT_MSG_EQ_INTERNAL (b.GetZeroAreaSize (), zeroSize, "wrong zero area", __FILE__, line);
+  std::vector<uint8_t> got (b.GetSize ());
+  b.CopyData (&got[0], got.size ());
+  NS_TEST_EXPECT_MSG_EQ_INTERNAL ((got == expected), true, "wrong content", __FILE__, line);
+}
+
+void
+BufferZeroAreaTest::DoRun (void)
+{
+  std::vector<uint8_t> expected;
+  uint64_t materialized = Buffer::GetMaterializedBytes ();
+
+  // fragments of a zero payload are reassembled by offsets
+  Buffer whole = Make (0x11, 1000, 0);
+  Buffer frag0 = whole.CreateFragment (0, 401);
+  Buffer frag1 = whole.CreateFragment (401, 300);
+  Buffer frag2 = whole.CreateFragment (701, 300);
+  frag0.AddAtEnd (frag1);
+  frag0.AddAtEnd (frag2);
+  expected.assign (1001, 0);
+  expected[0] = 0x11;
+  Check (frag0, expected, 1000, __LINE__);
+  Check (whole, expected, 1000, __LINE__);
+
+  // trailing bytes of the appended buffer are kept
+  Buffer a = Make (0x22, 50, 0);
+  a.AddAtEnd (Make (0, 70, 0x33));
+  expected.assign (122, 0);
+  expected[0] = 0x22;
+  expected[121] = 0x33;
+  Check (a, expected, 120, __LINE__);
+
+  // real bytes are appended without touching the zero area
+  Buffer data = Make (0x44, 0, 0x55);
+  a.AddAtEnd (data);
+  expected.push_back (0x44);
+  expected.push_back (0x55);
+  Check (a, expected, 120, __LINE__);
+  NS_TEST_EXPECT_MSG_EQ (Buffer::GetMaterializedBytes (), materialized, "zero bytes were materialized");
+
+  // separated zero areas: only the smaller one is materialized
+  Buffer small = Make (0, 10, 0x66);
+  small.AddAtEnd (Make (0x77, 100, 0x88));
+  expected.assign (10, 0);
+  expected.push_back (0x66);
+  expected.push_back (0x77);
+  expected.resize (expected.size () + 100, 0);
+  expected.push_back (0x88);
+  Check (small, expected, 100, __LINE__);
+  NS_TEST_EXPECT_MSG_EQ (Buffer::GetMaterializedBytes () - materialized, 10, "wrong materialized size");
+  materialized = Buffer::GetMaterializedBytes ();
+
+  Buffer large = Make (0x77, 100, 0x88);
+  large.AddAtEnd (Make (0, 10, 0x66));
+  expected.assign (1, 0x77);
+  expected.resize (101, 0);
+  expected.push_back (0x88);
+  expected.resize (112, 0);
+  expected.push_back (0x66);
+  Check (large, expected, 100, __LINE__);
+  NS_TEST_EXPECT_MSG_EQ (Buffer::GetMaterializedBytes () - materialized, 10, "wrong materialized size");
+
+  // a buffer appended to itself
+  Buffer self = Make (0x99, 5, 0);
+  self.AddAtEnd (self);
+  expected.assign (6, 0);
+  expected[0] = 0x99;
+  expected.push_back (0x99);
+  expected.resize (12, 0);
+  Check (self, expected, 5, __LINE__);
+
+  // a copy which shares our data, appended in place
+  Buffer shared;
+  shared.AddAtStart (100);
+  shared.Begin ().WriteU8 (0xdd, 100);
+  shared.RemoveAtEnd (81);
+  Buffer two;
+  two.AddAtStart (2);
+  two.Begin ().WriteU8 (0xee, 2);
+  shared.AddAtEnd (two);
+  shared.AddAtEnd (Buffer (shared));
+  expected.assign (19, 0xdd);
+  expected.resize (21, 0xee);
+  expected.resize (42, 0xee);
+  std::fill (expected.begin () + 21, expected.begin () + 40, 0xdd);
+  Check (shared, expected, 0, __LINE__);
+
+  // shared data is not overwritten by an append
+  Buffer base = Make (0xaa, 20, 0);
+  Buffer copy = base;
+  base.AddAtEnd (Make (0, 20, 0xbb));
+  copy.AddAtEnd (Make (0xcc, 0, 0));
+  expected.assign (1, 0xaa);
+  expected.resize (21, 0);
+  expected.push_back (0xcc);
+  Check (copy, expected, 20, __LINE__);
+  expected.assign (1, 0xaa);
+  expected.resize (41, 0);
+  expected.push_back (0xbb);
+  Check (base, expected, 40, __LINE__);
+}
+//-----------------------------------------------------------------------------
+class BufferSegmentTest : public TestCase {
+private:
+  /**
+   * Check the content of a buffer read with CopyData and with an iterator.
+   * \param b The buffer.
+   * \param expected The expected bytes.
+   * \param line The line of the caller.
+   */
+  void Check (const Buffer &b, const std::vector<uint8_t> &expected, int line);
+  /**
+   * Create a buffer of real bytes.
+   * \param size The size of the buffer.
+   * \param seed The value of its first byte, incremented for each byte.
+   */
+  static Buffer Make (uint32_t size, uint8_t seed);
+public:
+  virtual void DoRun (void);
+  BufferSegmentTest ();
+};
+
+BufferSegmentTest::BufferSegmentTest ()
+  : TestCase ("Buffer segments are shared and sliced") {
+}
+
+Buffer
+BufferSegmentTest::Make (uint32_t size, uint8_t seed)
+{
+  Buffer b;
+  b.AddAtStart (size);
+  Buffer::Iterator i = b.Begin ();
+  for (uint32_t j = 0; j < size; j++)
+    {
+      i.WriteU8 (seed + j);
+    }
+  return b;
+}
+
+void
+BufferSegmentTest::Check (const Buffer &b, const std::vector<uint8_t> &expected, int line)
+{
+  NS_TEST_EXPECT_MSG_EQ_INTERNAL (b.GetSize (), expected.size (), "wrong size", __FILE__, line);
+  NS_TEST_EXPECT_MSG_EQ_INTERNAL (static_cast<uint32_t> (b.GetCurrentEndOffset () - b.GetCurrentStartOffset ()), b.GetSize (),
+                                  "wrong offsets", __FILE__, line);
+  std::vector<uint8_t> got (b.GetSize ());
+  b.CopyData (&got[0], got.size ());
+  NS_TEST_EXPECT_MSG_EQ_INTERNAL ((got == expected), true, "wrong content", __FILE__, line);
+  std::vector<uint8_t> read (b.GetSize ());
+  b.Begin ().Read (&read[0], read.size ());
+  NS_TEST_EXPECT_MSG_EQ_INTERNAL ((read == expected), true, "wrong iterator content", __FILE__, line);
+}
+
+void
+BufferSegmentTest::DoRun (void)
+{
+  std::vector<uint8_t> expected;
+  Buffer a = Make (200, 0);
+  Buffer b = Make (300, 100);
+  std::vector<uint8_t> bBytes (300);
+  b.CopyData (&bBytes[0], 300);
+
+  // large buffers are appended by reference
+  Buffer c = a;
+  c.AddAtEnd (b);
+  NS_TEST_EXPECT_MSG_EQ (c.GetSegmentN (), 1, "buffer not appended as a segment");
+  for (uint32_t j = 0; j < 200; j++)
+    {
+      expected.push_back (j);
+    }
+  expected.insert (expected.end (), bBytes.begin (), bBytes.end ());
+  Check (c, expected, __LINE__);
+
+  // reads across the end of the contiguous data
+  Buffer::Iterator i = c.Begin ();
+  i.Next (198);
+  NS_TEST_EXPECT_MSG_EQ (i.ReadNtohU32 (), 0xc6c76465, "wrong read across segments");
+  i.Prev (4);
+  NS_TEST_EXPECT_MSG_EQ (i.ReadNtohU16 (), 0xc6c7, "wrong read before segments");
+  NS_TEST_EXPECT_MSG_EQ (i.ReadNtohU16 (), 0x6465, "wrong read in segments");
+
+  // headers go in front of the segments
+  c.AddAtStart (4);
+  c.Begin ().WriteHtonU32 (0xdeadbeef);
+  expected.insert (expected.begin (), 4, 0);
+  expected[0] = 0xde;
+  expected[1] = 0xad;
+  expected[2] = 0xbe;
+  expected[3] = 0xef;
+  Check (c, expected, __LINE__);
+
+  // trailers extend the last segment without touching its other users
+  c.AddAtEnd (4);
+  i = c.End ();
+  i.Prev (4);
+  i.WriteHtonU32 (0x01020304);
+  expected.push_back (1);
+  expected.push_back (2);
+  expected.push_back (3);
+  expected.push_back (4);
+  Check (c, expected, __LINE__);
+  Check (b, bBytes, __LINE__);
+
+  // fragments slice the segments
+  Buffer frag = c.CreateFragment (150, 200);
+  Check (frag, std::vector<uint8_t> (expected.begin () + 150, expected.begin () + 350), __LINE__);
+  NS_TEST_EXPECT_MSG_EQ (frag.GetSegmentN (), 1, "wrong number of segments");
+
+  // removing the contiguous data keeps the offsets of the segments
+  int32_t end = c.GetCurrentEndOffset ();
+  c.RemoveAtStart (250);
+  expected.erase (expected.begin (), expected.begin () + 250);
+  Check (c, expected, __LINE__);
+  NS_TEST_EXPECT_MSG_EQ (c.GetCurrentEndOffset (), end, "the offsets of the segments moved");
+  NS_TEST_EXPECT_MSG_EQ (c.AddAtStart (2), true, "the offsets were not renumbered");
+  c.Begin ().WriteU8 (0x55, 2);
+  expected.insert (expected.begin (), 2, 0x55);
+  Check (c, expected, __LINE__);
+
+  // aggregation and reassembly
+  Buffer aggregate;
+  expected.clear ();
+  for (uint32_t j = 0; j < 10; j++)
+    {
+      aggregate.AddAtEnd (b);
+      expected.insert (expected.end (), bBytes.begin (), bBytes.end ());
+    }
+  NS_TEST_EXPECT_MSG_EQ (aggregate.GetSegmentN (), 10, "wrong number of segments");
+  Check (aggregate, expected, __LINE__);
+  aggregate.RemoveAtStart (1000);
+  aggregate.RemoveAtEnd (450);
+  expected.erase (expected.begin (), expected.begin () + 1000);
+  expected.erase (expected.end () - 450, expected.end ());
+  NS_TEST_EXPECT_MSG_EQ (aggregate.GetSegmentN (), 6, "wrong number of segments");
+  Check (aggregate, expected, __LINE__);
+  Buffer reassembled;
+  for (uint32_t j = 0; j < aggregate.GetSize (); j += 400)
+    {
+      uint32_t size = std::min<uint32_t> (400, aggregate.GetSize () - j);
+      reassembled.AddAtEnd (aggregate.CreateFragment (j, size));
+    }
+  Check (reassembled, expected, __LINE__);
+
+  // the flat copies
+  Buffer copy = reassembled.CreateFullCopy ();
+  NS_TEST_EXPECT_MSG_EQ (copy.GetSegmentN (), 0, "copy has segments");
+  Check (copy, expected, __LINE__);
+  std::vector<uint8_t> serialized (reassembled.GetSerializedSize ());
+  NS_TEST_EXPECT_MSG_EQ (reassembled.Serialize (&serialized[0], serialized.size ()), 1, "serialization failed");
+  Buffer deserialized;
+  // the size includes the length prefix written by Packet::Serialize.
+  deserialized.Deserialize (&serialized[0], serialized.size () + 4);
+  Check (deserialized, expected, __LINE__);
+  NS_TEST_EXPECT_MSG_EQ (std::memcmp (reassembled.PeekData (), &expected[0], expected.size ()), 0,
+                         "wrong flat content");
+
+  // segments can be disabled
+  Buffer::SetMinSegmentSize (std::numeric_limits<uint32_t>::max ());
+  Buffer flat = a;
+  flat.AddAtEnd (b);
+  NS_TEST_EXPECT_MSG_EQ (flat.GetSegmentN (), 0, "buffer appended as a segment");
+  Buffer::SetMinSegmentSize (128);
+}
+//-----------------------------------------------------------------------------
+class BufferSpanTest : public TestCase {
+public:
+  virtual void DoRun (void);
+  BufferSpanTest ();
+};
+
+BufferSpanTest::BufferSpanTest ()
+  : TestCase ("Buffer spans match the iterator") {
+}
+
+void
+BufferSpanTest::DoRun (void)
+{
+  // contiguous bytes are written in place, in the iterator formats
+  Buffer a;
+  a.AddAtStart (32);
+  Buffer::Iterator i = a.Begin ();
+  {
+    Buffer::WriteSpan span (i, 28);
+    span.WriteU8 (0x01);
+    span.WriteHtonU16 (0x0203);
+    span.WriteHtonU32 (0x04050607);
+    span.WriteHtonU64 (0x08090a0b0c0d0e0fULL);
+    span.WriteHtolsbU16 (0x1110);
+    span.WriteHtolsbU32 (0x15141312);
+    span.WriteU16 (0x1234);
+    uint8_t bytes[] = { 0x16, 0x17, 0x18 };
+    span.Write (bytes, 3);
+    span.WriteU8 (0x19, 2);
+  }
+  NS_TEST_EXPECT_MSG_EQ (i.GetDistanceFrom (a.Begin ()), 28, "iterator not moved past the span");
+  i.WriteU8 (0x20);
+  i = a.Begin ();
+  NS_TEST_EXPECT_MSG_EQ (i.ReadU8 (), 0x01, "wrong byte");
+  NS_TEST_EXPECT_MSG_EQ (i.ReadNtohU16 (), 0x0203, "wrong network order");
+  NS_TEST_EXPECT_MSG_EQ (i.ReadNtohU32 (), 0x04050607, "wrong network order");
+  NS_TEST_EXPECT_MSG_EQ (i.ReadNtohU64 (), 0x08090a0b0c0d0e0fULL, "wrong network order");
+  NS_TEST_EXPECT_MSG_EQ (i.ReadLsbtohU16 (), 0x1110, "wrong lsb order");
+  NS_TEST_EXPECT_MSG_EQ (i.ReadLsbtohU32 (), 0x15141312, "wrong lsb order");
+  NS_TEST_EXPECT_MSG_EQ (i.ReadU16 (), 0x1234, "wrong host order");
+
+  i = a.Begin ();
+  {
+    Buffer::ReadSpan span (i, 32);
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)span.PeekU8 (), 0x01, "wrong byte");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)span.ReadU8 (), 0x01, "wrong byte");
+    NS_TEST_EXPECT_MSG_EQ (span.ReadNtohU16 (), 0x0203, "wrong network order");
+    NS_TEST_EXPECT_MSG_EQ (span.ReadNtohU32 (), 0x04050607, "wrong network order");
+    NS_TEST_EXPECT_MSG_EQ (span.ReadNtohU64 (), 0x08090a0b0c0d0e0fULL, "wrong network order");
+    NS_TEST_EXPECT_MSG_EQ (span.ReadLsbtohU16 (), 0x1110, "wrong lsb order");
+    NS_TEST_EXPECT_MSG_EQ (span.ReadLsbtohU32 (), 0x15141312, "wrong lsb order");
+    NS_TEST_EXPECT_MSG_EQ (span.ReadU16 (), 0x1234, "wrong host order");
+    span.Next (1);
+    uint8_t bytes[5];
+    span.Read (bytes, 5);
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)bytes[0], 0x17, "wrong bytes");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)bytes[4], 0x20, "wrong bytes");
+  }
+  NS_TEST_EXPECT_MSG_EQ (i.IsEnd (), true, "iterator not moved past the span");
+
+  // virtual zero bytes are read through a copy
+  Buffer zero (100);
+  zero.AddAtStart (2);
+  zero.Begin ().WriteHtonU16 (0xabcd);
+  i = zero.Begin ();
+  {
+    Buffer::ReadSpan span (i, 6);
+    NS_TEST_EXPECT_MSG_EQ (span.ReadNtohU16 (), 0xabcd, "wrong bytes before the zero area");
+    NS_TEST_EXPECT_MSG_EQ (span.ReadNtohU32 (), 0, "wrong bytes in the zero area");
+  }
+  NS_TEST_EXPECT_MSG_EQ (i.GetDistanceFrom (zero.Begin ()), 6, "iterator not moved past the span");
+
+  // spans which reach the segments go through the iterator
+  Buffer front;
+  front.AddAtStart (200);
+  Buffer back;
+  back.AddAtStart (300);
+  back.Begin ().WriteU8 (0, 300);
+  front.AddAtEnd (back);
+  NS_TEST_ASSERT_MSG_EQ (front.GetSegmentN (), 1, "buffer not appended as a segment");
+  i = front.Begin ();
+  {
+    Buffer::WriteSpan span (i, 200);
+    for (uint32_t j = 0; j < 50; j++)
+      {
+        span.WriteHtonU32 (j);
+      }
+  }
+  i.Next (96);
+  {
+    Buffer::WriteSpan span (i, 4);
+    span.WriteHtonU32 (0xdeadbeef);
+  }
+  i = front.Begin ();
+  i.Next (296);
+  NS_TEST_EXPECT_MSG_EQ (i.ReadNtohU32 (), 0xdeadbeef, "wrong write across segments");
+  i = front.Begin ();
+  i.Next (100);
+  {
+    Buffer::ReadSpan span (i, 200);
+    for (uint32_t j = 25; j < 50; j++)
+      {
+        NS_TEST_EXPECT_MSG_EQ (span.ReadNtohU32 (), j, "wrong read across segments");
+      }
+    span.Next (96);
+    NS_TEST_EXPECT_MSG_EQ (span.ReadNtohU32 (), 0xdeadbeef, "wrong read across segments");
+  }
+  NS_TEST_EXPECT_MSG_EQ (back.Begin ().ReadNtohU32 (), 0, "the segment was modified in place");
+}
+//-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
 {
 public:
@@ -352,6 +777,9 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferZeroAreaTest, TestCase::QUICK);
+  AddTestCase (new BufferSegmentTest, TestCase::QUICK);
+  AddTestCase (new BufferSpanTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite;
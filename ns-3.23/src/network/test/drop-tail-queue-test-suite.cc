@@ -19,6 +19,8 @@
 #include "ns3/test.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/uinteger.h"
+#include "ns3/checkpoint.h"
+#include "ns3/socket.h"
 
 using namespace ns3;
 
@@ -77,6 +79,68 @@ DropTailQueueTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ ((p == 0), true, "There are really no packets in there");
 }
 
+class DropTailQueueCheckpointTestCase : public TestCase
+{
+public:
+  DropTailQueueCheckpointTestCase ();
+  virtual void DoRun (void);
+};
+
+DropTailQueueCheckpointTestCase::DropTailQueueCheckpointTestCase ()
+  : TestCase ("Check that the packets of a drop tail queue are checkpointed")
+{
+}
+
+void
+DropTailQueueCheckpointTestCase::DoRun (void)
+{
+  Ptr<DropTailQueue> queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (2));
+  uint8_t data[3] = { 1, 2, 3 };
+  Ptr<Packet> tagged = Create<Packet> (data, 3);
+  SocketIpTtlTag ttl;
+  ttl.SetTtl (17);
+  tagged->AddPacketTag (ttl);
+  SocketIpTosTag tos;
+  tos.SetTos (42);
+  tagged->AddByteTag (tos, 1, 3);
+  queue->Enqueue (tagged);
+  queue->Enqueue (Create<Packet> (100));
+  queue->Enqueue (Create<Packet> (10)); // dropped
+
+  CheckpointWriter writer;
+  queue->SaveCheckpoint (writer);
+
+  Ptr<DropTailQueue> restored = CreateObject<DropTailQueue> ();
+  restored->Enqueue (Create<Packet> (5));
+  CheckpointReader reader (&writer.GetData ()[0], writer.GetData ().size ());
+  restored->RestoreCheckpoint (reader);
+  NS_TEST_EXPECT_MSG_EQ (reader.GetRemaining (), 0, "state not fully read");
+  NS_TEST_EXPECT_MSG_EQ (restored->GetNPackets (), 2, "wrong number of packets");
+  NS_TEST_EXPECT_MSG_EQ (restored->GetNBytes (), 103, "wrong number of bytes");
+  NS_TEST_EXPECT_MSG_EQ (restored->GetTotalReceivedPackets (), 2, "wrong received packets");
+  NS_TEST_EXPECT_MSG_EQ (restored->GetTotalDroppedPackets (), 1, "wrong dropped packets");
+  Ptr<Packet> p = restored->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 3, "wrong first packet");
+  uint8_t copy[3];
+  p->CopyData (copy, 3);
+  NS_TEST_EXPECT_MSG_EQ (copy[2], 3, "wrong content of the first packet");
+  SocketIpTtlTag restoredTtl;
+  NS_TEST_EXPECT_MSG_EQ (p->PeekPacketTag (restoredTtl), true, "packet tag not restored");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)restoredTtl.GetTtl (), 17, "wrong packet tag");
+  ByteTagIterator i = p->GetByteTagIterator ();
+  NS_TEST_ASSERT_MSG_EQ (i.HasNext (), true, "byte tag not restored");
+  ByteTagIterator::Item item = i.Next ();
+  NS_TEST_EXPECT_MSG_EQ (item.GetTypeId (), SocketIpTosTag::GetTypeId (), "wrong byte tag");
+  NS_TEST_EXPECT_MSG_EQ (item.GetStart (), 1, "wrong start of the byte tag");
+  NS_TEST_EXPECT_MSG_EQ (item.GetEnd (), 3, "wrong end of the byte tag");
+  SocketIpTosTag restoredTos;
+  item.GetTag (restoredTos);
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)restoredTos.GetTos (), 42, "wrong byte tag");
+  NS_TEST_EXPECT_MSG_EQ (i.HasNext (), false, "too many byte tags");
+  NS_TEST_EXPECT_MSG_EQ (restored->Dequeue ()->GetSize (), 100, "wrong second packet");
+}
+
 static class DropTailQueueTestSuite : public TestSuite
 {
 public:
@@ -84,5 +148,6 @@ public:
     : TestSuite ("drop-tail-queue", UNIT)
   {
     AddTestCase (new DropTailQueueTestCase (), TestCase::QUICK);
+    AddTestCase (new DropTailQueueCheckpointTestCase (), TestCase::QUICK);
   }
 } g_dropTailQueueTestSuite;
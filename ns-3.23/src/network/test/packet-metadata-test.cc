@@ -252,16 +252,22 @@ HistoryTrailer<N>::Deserialize (Buffer::Iterator start)
 
 class PacketMetadataTest : public TestCase {
 public:
-  PacketMetadataTest ();
+  /**
+   * \param lazy true to record the operations and reconstruct the
+   *        metadata on demand
+   */
+  PacketMetadataTest (bool lazy);
   virtual ~PacketMetadataTest ();
   void CheckHistory (Ptr<Packet> p, const char *file, int line, uint32_t n, ...);
   virtual void DoRun (void);
 private:
   Ptr<Packet> DoAddHeader (Ptr<Packet> p);
+  bool m_lazy;
 };
 
-PacketMetadataTest::PacketMetadataTest ()
-  : TestCase ("Packet metadata")
+PacketMetadataTest::PacketMetadataTest (bool lazy)
+  : TestCase (lazy ? "Lazy packet metadata" : "Packet metadata"),
+    m_lazy (lazy)
 {
 }
 
@@ -399,6 +405,7 @@ void
 PacketMetadataTest::DoRun (void)
 {
   PacketMetadata::Enable ();
+  PacketMetadata::SetLazy (m_lazy);
 
   Ptr<Packet> p = Create<Packet> (0);
   Ptr<Packet> p1 = Create<Packet> (0);
@@ -821,6 +828,8 @@ PacketMetadataTest::DoRun (void)
                                  p3->GetSize ());
   delete [] buf;
   NS_TEST_EXPECT_MSG_EQ (msg, std::string ("hello world"), "Could not find original data in received packet");
+
+  PacketMetadata::SetLazy (false);
 }
 //-----------------------------------------------------------------------------
 class PacketMetadataTestSuite : public TestSuite
@@ -832,7 +841,8 @@ public:
 PacketMetadataTestSuite::PacketMetadataTestSuite ()
   : TestSuite ("packet-metadata", UNIT)
 {
-  AddTestCase (new PacketMetadataTest, TestCase::QUICK);
+  AddTestCase (new PacketMetadataTest (false), TestCase::QUICK);
+  AddTestCase (new PacketMetadataTest (true), TestCase::QUICK);
 }
 
 PacketMetadataTestSuite g_packetMetadataTest;
@@ -19,7 +19,11 @@
  */
 #include "ns3/packet.h"
 #include "ns3/packet-tag-list.h"
+#include "ns3/packet-accounting.h"
+#include "ns3/core-config.h"
+#include "ns3/network-config.h"
 #include "ns3/test.h"
+#include "ns3/system-thread.h"
 #include "ns3/unused.h"
 #include <limits>     // std:numeric_limits
 #include <string>
@@ -27,6 +31,7 @@
 #include <iostream>
 #include <iomanip>
 #include <ctime>
+#include <vector>
 
 using namespace ns3;
 
@@ -334,6 +339,17 @@ PacketTest::DoRun (void)
          E (1, 10, 100), E (2, 10, 100), E (4, 10, 100),
          E (1, 100, 1000), E (2, 100, 1000), E (5, 100, 1000));
 
+  // the byte tags stay in place when the removed bytes reach the
+  // appended buffers, and a header is added in front of them.
+  frag0->RemoveAtStart (50);
+  CHECK (frag0, 6,
+         E (1, 0, 50), E (2, 0, 50), E (4, 0, 50),
+         E (1, 50, 950), E (2, 50, 950), E (5, 50, 950));
+  frag0->AddHeader (ATestHeader<10> ());
+  CHECK (frag0, 6,
+         E (1, 10, 60), E (2, 10, 60), E (4, 10, 60),
+         E (1, 60, 960), E (2, 60, 960), E (5, 60, 960));
+
 
   // force caching a buffer of the right size.
   frag0 = Create<Packet> (1000);
@@ -451,6 +467,35 @@ PacketTest::DoRun (void)
     CHECK (tmp, 1, E (20, 1, 1001));
 #endif
   }
+
+  {
+    // DeepCopy copies the bytes, the byte tags, the packet tags, the
+    // spilled ones included, and the metadata.
+    Ptr<Packet> tmp = Create<Packet> (reinterpret_cast<const uint8_t*> ("hello"), 5);
+    tmp->AddByteTag (ATestTag<20> ());
+    tmp->AddHeader (ATestHeader<10> ());
+    tmp->AddPacketTag (ATestTag<1> ());
+    tmp->AddPacketTag (ATestTag<2> ());
+    tmp->AddPacketTag (ATestTag<3> ());
+    tmp->AddPacketTag (ATestTag<4> ());
+    tmp->AddPacketTag (ATestTag<5> ());
+    Ptr<Packet> copy = tmp->DeepCopy ();
+    NS_TEST_EXPECT_MSG_EQ (copy->GetUid (), tmp->GetUid (), "DeepCopy changed the uid");
+    NS_TEST_EXPECT_MSG_EQ (copy->GetSize (), 15, "DeepCopy changed the size");
+    CHECK (copy, 1, E (20, 10, 15));
+    ATestTag<5> spilled;
+    NS_TEST_EXPECT_MSG_EQ (copy->PeekPacketTag (spilled), true, "spilled packet tag not copied");
+    ATestHeader<10> h;
+    copy->RemoveHeader (h);
+    uint8_t buf[5];
+    copy->CopyData (buf, 5);
+    NS_TEST_EXPECT_MSG_EQ (std::string (reinterpret_cast<const char *> (buf), 5), "hello", "wrong bytes");
+    CHECK (copy, 1, E (20, 0, 5));
+    copy->RemovePacketTag (spilled);
+    NS_TEST_EXPECT_MSG_EQ (tmp->PeekPacketTag (spilled), true, "the copy shares the packet tags");
+    CHECK (tmp, 1, E (20, 10, 15));
+    NS_TEST_EXPECT_MSG_EQ (tmp->GetSize (), 15, "the copy shares the buffer");
+  }
 }
 //--------------------------------------
 class PacketTagListTest : public TestCase
@@ -594,6 +639,7 @@ PacketTagListTest::DoRun (void)
               << std::endl;;
     ATestTag<10> t10;
     NS_TEST_EXPECT_MSG_EQ (ref.Peek (t10), false, "missing tag");
+    NS_TEST_EXPECT_MSG_EQ (ref.GetN (), 7, "wrong number of tags");
   }
 
   { // Copy ctor, assignment
@@ -716,6 +762,151 @@ PacketTagListTest::DoRun (void)
     
 }
 
+//-----------------------------------------------------------------------------
+class PacketAccountingTest : public TestCase
+{
+public:
+  PacketAccountingTest ();
+private:
+  void DoRun (void);
+};
+
+PacketAccountingTest::PacketAccountingTest ()
+  : TestCase ("PacketAccounting: live packets and their creation sites")
+{
+}
+
+void
+PacketAccountingTest::DoRun (void)
+{
+  Ptr<Packet> before = Create<Packet> (1000);
+  Ptr<Packet> early = before->Copy ();
+  PacketAccounting::Enable ();
+  Ptr<Packet> a = Create<Packet> (100);
+  Ptr<Packet> b = a->Copy ();
+  Ptr<Packet> c = Create<Packet> (10);
+  NS_TEST_EXPECT_MSG_EQ (PacketAccounting::GetNPackets (), 2, "copies share the uid of their original");
+  NS_TEST_EXPECT_MSG_EQ (PacketAccounting::GetNObjects (), 3, "every object is counted");
+  NS_TEST_EXPECT_MSG_EQ (PacketAccounting::GetNBytes (), 210, "wrong total size");
+
+  a->AddHeader (ATestHeader<2> ());
+  b->RemoveAtStart (50);
+  Ptr<Packet> fragment = c->CreateFragment (0, 4);
+  NS_TEST_EXPECT_MSG_EQ (PacketAccounting::GetNBytes (), 166, "size changes are not accounted");
+  Ptr<Packet> d = before->Copy ();
+  early = 0;
+  NS_TEST_EXPECT_MSG_EQ (PacketAccounting::GetNObjects (), 5, "a copy made before Enable removed a counted one");
+  before = 0;
+  d = 0;
+  NS_TEST_EXPECT_MSG_EQ (PacketAccounting::GetNObjects (), 4, "packets created before Enable are counted");
+
+  std::vector<PacketAccounting::Entry> oldest = PacketAccounting::GetOldest (10);
+  NS_TEST_ASSERT_MSG_EQ (oldest.size (), 2, "wrong number of live packets");
+  NS_TEST_EXPECT_MSG_EQ (oldest[0].uid, a->GetUid (), "packets are not sorted by age");
+  NS_TEST_EXPECT_MSG_EQ (oldest[0].objects, 2, "wrong number of objects");
+  NS_TEST_EXPECT_MSG_EQ (oldest[0].bytes, 152, "wrong size");
+  NS_TEST_EXPECT_MSG_EQ (oldest[1].bytes, 14, "wrong size");
+#if defined (HAVE_DLADDR) && defined (HAVE_EXECINFO_H)
+  NS_TEST_EXPECT_MSG_NE (oldest[0].function.find ("PacketAccountingTest::DoRun"), std::string::npos,
+                         "wrong creation site " << oldest[0].function);
+  std::vector<PacketAccounting::Site> modules = PacketAccounting::GetModules ();
+  NS_TEST_ASSERT_MSG_EQ (modules.size (), 1, "all the packets come from the test module");
+  NS_TEST_EXPECT_MSG_NE (modules[0].module.find ("network"), std::string::npos,
+                         "wrong module " << modules[0].module);
+  NS_TEST_EXPECT_MSG_EQ (modules[0].packets, 2, "wrong number of packets");
+  NS_TEST_EXPECT_MSG_EQ (modules[0].bytes, 166, "wrong module size");
+#endif
+  std::ostringstream report;
+  PacketAccounting::Report (report);
+  NS_TEST_EXPECT_MSG_NE (report.str ().find ("2 uids, 4 objects, 166 bytes"), std::string::npos,
+                         "wrong report " << report.str ());
+
+  a = 0;
+  b = 0;
+  NS_TEST_EXPECT_MSG_EQ (PacketAccounting::GetNPackets (), 1, "freed packets are still counted");
+  NS_TEST_EXPECT_MSG_EQ (PacketAccounting::GetNBytes (), 14, "wrong total size");
+  PacketAccounting::Disable ();
+  NS_TEST_EXPECT_MSG_EQ (PacketAccounting::GetNPackets (), 0, "Disable keeps the packets");
+
+  PacketAccounting::Enable ();
+  Ptr<Packet> e = c->Copy ();
+  c = 0;
+  fragment = 0;
+  NS_TEST_EXPECT_MSG_EQ (PacketAccounting::GetNObjects (), 1, "packets counted before Disable are removed");
+  PacketAccounting::Disable ();
+}
+
+//-----------------------------------------------------------------------------
+class PacketPoolTest : public TestCase
+{
+public:
+  PacketPoolTest ();
+private:
+  void DoRun (void);
+  /** Free the packets of m_packets. */
+  void FreePackets (void);
+
+  std::vector<Ptr<Packet> > m_packets; //!< Packets created by the test thread.
+};
+
+PacketPoolTest::PacketPoolTest ()
+  : TestCase ("Packet pools: uids, free list reuse and cross-thread frees")
+{
+}
+
+void
+PacketPoolTest::FreePackets (void)
+{
+  m_packets.clear ();
+}
+
+void
+PacketPoolTest::DoRun (void)
+{
+  Ptr<Packet> a = Create<Packet> (100);
+  Ptr<Packet> b = Create<Packet> (100);
+  NS_TEST_EXPECT_MSG_EQ (b->GetUid (), a->GetUid () + 1, "uids of a system id are not consecutive");
+
+  PacketPoolStats before = Buffer::GetPoolStats ();
+  PacketPoolStats metadataBefore = PacketMetadata::GetPoolStats ();
+  a = 0;
+  b = Create<Packet> (100);
+  PacketPoolStats after = Buffer::GetPoolStats ();
+  PacketPoolStats metadataAfter = PacketMetadata::GetPoolStats ();
+  NS_TEST_EXPECT_MSG_EQ (after.allocations, before.allocations + 1, "wrong number of allocations");
+  NS_TEST_EXPECT_MSG_EQ (metadataAfter.allocations, metadataBefore.allocations + 1, "wrong number of allocations");
+  // metadata storage is allocated with the largest size seen, so it is
+  // always kept when freed; small buffers are not.
+  NS_TEST_EXPECT_MSG_EQ (metadataAfter.reused, metadataBefore.reused + 1, "a freed metadata storage was not reused");
+
+#ifdef HAVE_PTHREAD_H
+  // Empty the free lists of this thread, then free its packets from
+  // another thread: their storage must come back to this thread.
+  const uint32_t n = 2000;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      m_packets.push_back (Create<Packet> (100));
+    }
+  before = Buffer::GetPoolStats ();
+  metadataBefore = PacketMetadata::GetPoolStats ();
+  Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&PacketPoolTest::FreePackets, this));
+  thread->Start ();
+  thread->Join ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      m_packets.push_back (Create<Packet> (100));
+    }
+  after = Buffer::GetPoolStats ();
+  metadataAfter = PacketMetadata::GetPoolStats ();
+  NS_TEST_EXPECT_MSG_EQ (after.remoteFrees, before.remoteFrees + n, "buffers freed by another thread were lost");
+  NS_TEST_EXPECT_MSG_EQ (metadataAfter.remoteFrees, metadataBefore.remoteFrees + n,
+                         "metadata freed by another thread was lost");
+  NS_TEST_EXPECT_MSG_GT (metadataAfter.reused, metadataBefore.reused,
+                         "metadata freed by another thread was not reused");
+  m_packets.clear ();
+#endif /* HAVE_PTHREAD_H */
+}
+
 //-----------------------------------------------------------------------------
 class PacketTestSuite : public TestSuite
 {
@@ -728,6 +919,8 @@ PacketTestSuite::PacketTestSuite ()
 {
   AddTestCase (new PacketTest, TestCase::QUICK);
   AddTestCase (new PacketTagListTest, TestCase::QUICK);
+  AddTestCase (new PacketAccountingTest, TestCase::QUICK);
+  AddTestCase (new PacketPoolTest, TestCase::QUICK);
 }
 
 static PacketTestSuite g_packetTestSuite;
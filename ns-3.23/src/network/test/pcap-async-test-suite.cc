@@ -0,0 +1,345 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ns3/network-config.h"
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/pcap-file.h"
+#include "ns3/pcap-file-wrapper.h"
+#include "ns3/pcapng-file.h"
+#include "ns3/output-stream-wrapper.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif /* HAVE_ZLIB */
+
+using namespace ns3;
+
+/**
+ * \param filename The name of a file.
+ * \returns The content of the file.
+ */
+static std::vector<uint8_t>
+ReadFile (std::string filename)
+{
+  std::ifstream file (filename.c_str (), std::ios::in | std::ios::binary);
+  return std::vector<uint8_t> (std::istreambuf_iterator<char> (file),
+                               std::istreambuf_iterator<char> ());
+}
+
+/**
+ * \param size The size of the packet.
+ * \param seed The first byte of the packet.
+ * \returns A packet filled with a known pattern.
+ */
+static Ptr<Packet>
+MakePacket (uint32_t size, uint8_t seed)
+{
+  std::vector<uint8_t> data (size + 1);
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      data[i] = seed + i;
+    }
+  return Create<Packet> (&data[0], size);
+}
+
+/**
+ * Check that an asynchronous pcap file is identical to the same file
+ * written synchronously, with blocks small enough that many records
+ * straddle two blocks or need a block of their own.
+ */
+class AsyncPcapFileTestCase : public TestCase
+{
+public:
+  AsyncPcapFileTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Write the test packets.
+   * \param filename The name of the file.
+   * \param blockSize The asynchronous block size, or zero.
+   */
+  void WriteFile (std::string filename, uint32_t blockSize);
+};
+
+AsyncPcapFileTestCase::AsyncPcapFileTestCase ()
+  : TestCase ("Check that asynchronous pcap files match synchronous ones")
+{
+}
+
+void
+AsyncPcapFileTestCase::WriteFile (std::string filename, uint32_t blockSize)
+{
+  PcapFile f;
+  f.SetAsynchronous (blockSize);
+  f.Open (filename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << filename << ") returns error");
+  f.Init (1, 100);
+  for (uint32_t i = 0; i < 200; ++i)
+    {
+      Ptr<Packet> p = MakePacket ((i * 37) % 300, i);
+      f.Write (i, i * 10, p);
+      uint8_t data[20];
+      std::memset (data, i, sizeof (data));
+      f.Write (i, i * 10 + 1, data, sizeof (data));
+    }
+  NS_TEST_EXPECT_MSG_EQ (f.Fail (), false, "Write must not fail");
+  f.Close ();
+}
+
+void
+AsyncPcapFileTestCase::DoRun (void)
+{
+  std::string syncName = CreateTempDirFilename ("sync.pcap");
+  std::string asyncName = CreateTempDirFilename ("async.pcap");
+  WriteFile (syncName, 0);
+  WriteFile (asyncName, 64);
+
+  std::vector<uint8_t> expected = ReadFile (syncName);
+  std::vector<uint8_t> actual = ReadFile (asyncName);
+  NS_TEST_ASSERT_MSG_GT (expected.size (), 24, "The synchronous file is empty");
+  NS_TEST_EXPECT_MSG_EQ (actual.size (), expected.size (), "The files differ in size");
+  NS_TEST_EXPECT_MSG_EQ ((actual == expected), true, "The files differ");
+}
+
+/**
+ * Check the blocks of a pcapng file which captures two interfaces.
+ */
+class PcapngFileTestCase : public TestCase
+{
+public:
+  PcapngFileTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param offset The offset of a 32 bit word in the file.
+   * \returns The word.
+   */
+  uint32_t Get32 (uint32_t offset) const;
+
+  std::vector<uint8_t> m_data; //!< Content of the file.
+};
+
+PcapngFileTestCase::PcapngFileTestCase ()
+  : TestCase ("Check that devices are multiplexed into one pcapng file")
+{
+}
+
+uint32_t
+PcapngFileTestCase::Get32 (uint32_t offset) const
+{
+  uint32_t value;
+  std::memcpy (&value, &m_data[offset], 4);
+  return value;
+}
+
+void
+PcapngFileTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("multiplex.pcapng");
+  {
+    Ptr<PcapngFile> file = Create<PcapngFile> ();
+    file->Open (filename, 128);
+    NS_TEST_ASSERT_MSG_EQ (file->Fail (), false, "Open (" << filename << ") returns error");
+    Ptr<PcapFileWrapper> first = CreateObject<PcapFileWrapper> ();
+    first->OpenInterface (file, "first.pcap", 9);
+    Ptr<PcapFileWrapper> second = CreateObject<PcapFileWrapper> ();
+    second->OpenInterface (file, "second-device.pcap", 1, 50);
+    NS_TEST_EXPECT_MSG_EQ (second->GetSnapLen (), 50, "Wrong snapshot length");
+    NS_TEST_EXPECT_MSG_EQ (second->GetDataLinkType (), 1, "Wrong data link type");
+    for (uint32_t i = 0; i < 100; ++i)
+      {
+        first->Write (NanoSeconds (i), MakePacket (i, i));
+        second->Write (Seconds (5) + NanoSeconds (i), MakePacket (i, i));
+      }
+    // The file is complete once both interfaces and the file are released.
+  }
+
+  m_data = ReadFile (filename);
+  NS_TEST_ASSERT_MSG_GT (m_data.size (), 28, "The file is empty");
+
+  // Section Header Block
+  NS_TEST_ASSERT_MSG_EQ (Get32 (0), 0x0a0d0d0a, "Bad section header block type");
+  NS_TEST_ASSERT_MSG_EQ (Get32 (4), 28, "Bad section header block length");
+  NS_TEST_ASSERT_MSG_EQ (Get32 (8), 0x1a2b3c4d, "Bad byte order magic");
+
+  uint32_t offset = 28;
+  uint32_t nInterfaces = 0;
+  uint32_t nPackets[2] = { 0, 0 };
+  while (offset < m_data.size ())
+    {
+      NS_TEST_ASSERT_MSG_LT_OR_EQ (offset + 12, m_data.size (), "Truncated block");
+      uint32_t type = Get32 (offset);
+      uint32_t length = Get32 (offset + 4);
+      NS_TEST_ASSERT_MSG_EQ (length % 4, 0, "Unaligned block");
+      NS_TEST_ASSERT_MSG_LT_OR_EQ (offset + length, m_data.size (), "Truncated block");
+      NS_TEST_ASSERT_MSG_EQ (Get32 (offset + length - 4), length, "Bad trailing block length");
+      if (type == 1)
+        {
+          // Interface Description Block: link type, snaplen and name.
+          NS_TEST_ASSERT_MSG_EQ (nPackets[0] + nPackets[1], 0, "Interface described after packets");
+          uint16_t linkType;
+          std::memcpy (&linkType, &m_data[offset + 8], 2);
+          NS_TEST_EXPECT_MSG_EQ (linkType, (nInterfaces == 0 ? 9 : 1), "Bad link type");
+          NS_TEST_EXPECT_MSG_EQ (Get32 (offset + 12), (nInterfaces == 0 ? 65535 : 50), "Bad snaplen");
+          std::string name = nInterfaces == 0 ? "first.pcap" : "second-device.pcap";
+          uint16_t code, size;
+          std::memcpy (&code, &m_data[offset + 16], 2);
+          std::memcpy (&size, &m_data[offset + 18], 2);
+          NS_TEST_EXPECT_MSG_EQ (code, 2, "Missing interface name");
+          NS_TEST_EXPECT_MSG_EQ (std::string ((const char *)&m_data[offset + 20], size), name, "Bad interface name");
+          nInterfaces++;
+        }
+      else
+        {
+          // Enhanced Packet Block
+          NS_TEST_ASSERT_MSG_EQ (type, 6, "Unexpected block type");
+          uint32_t interface = Get32 (offset + 8);
+          NS_TEST_ASSERT_MSG_LT (interface, nInterfaces, "Packet of an unknown interface");
+          uint32_t i = nPackets[interface];
+          uint64_t ts = (uint64_t (Get32 (offset + 12)) << 32) | Get32 (offset + 16);
+          NS_TEST_EXPECT_MSG_EQ (ts, (interface == 0 ? i : 5000000000ULL + i), "Bad timestamp");
+          uint32_t inclLen = Get32 (offset + 20);
+          NS_TEST_EXPECT_MSG_EQ (Get32 (offset + 24), i, "Bad original length");
+          NS_TEST_EXPECT_MSG_EQ (inclLen, (interface == 1 && i > 50 ? 50 : i), "Bad captured length");
+          for (uint32_t j = 0; j < inclLen; ++j)
+            {
+              NS_TEST_ASSERT_MSG_EQ ((uint32_t)m_data[offset + 28 + j], (uint8_t)(i + j), "Bad packet data");
+            }
+          nPackets[interface]++;
+        }
+      offset += length;
+    }
+  NS_TEST_EXPECT_MSG_EQ (nInterfaces, 2, "Wrong number of interfaces");
+  NS_TEST_EXPECT_MSG_EQ (nPackets[0], 100, "Missing packets on the first interface");
+  NS_TEST_EXPECT_MSG_EQ (nPackets[1], 100, "Missing packets on the second interface");
+}
+
+#ifdef HAVE_ZLIB
+/**
+ * Check that traces named with a ".gz" extension are compressed.
+ */
+class GzipTraceTestCase : public TestCase
+{
+public:
+  GzipTraceTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param filename The name of a gzip file.
+   * \returns The decompressed content of the file.
+   */
+  std::vector<uint8_t> Decompress (std::string filename);
+};
+
+GzipTraceTestCase::GzipTraceTestCase ()
+  : TestCase ("Check that ascii and pcap traces can be gzip compressed")
+{
+}
+
+std::vector<uint8_t>
+GzipTraceTestCase::Decompress (std::string filename)
+{
+  std::vector<uint8_t> data;
+  gzFile file = gzopen (filename.c_str (), "rb");
+  if (file == 0)
+    {
+      return data;
+    }
+  uint8_t chunk[4096];
+  int n;
+  while ((n = gzread (file, chunk, sizeof (chunk))) > 0)
+    {
+      data.insert (data.end (), chunk, chunk + n);
+    }
+  gzclose (file);
+  return data;
+}
+
+void
+GzipTraceTestCase::DoRun (void)
+{
+  // An ascii trace, written with std::endl as the trace sinks do, then
+  // appended to.
+  std::string asciiName = CreateTempDirFilename ("trace.tr.gz");
+  std::string expected;
+  for (uint32_t pass = 0; pass < 2; ++pass)
+    {
+      Ptr<OutputStreamWrapper> stream =
+        Create<OutputStreamWrapper> (asciiName, pass == 0 ? std::ios::out : std::ios::app);
+      for (uint32_t i = 0; i < 50000; ++i)
+        {
+          *stream->GetStream () << "+ " << pass << " " << i << " ns3::PppHeader (Point-to-Point Protocol: IP (0x0021))" << std::endl;
+          std::ostringstream line;
+          line << "+ " << pass << " " << i << " ns3::PppHeader (Point-to-Point Protocol: IP (0x0021))" << std::endl;
+          expected += line.str ();
+        }
+    }
+  std::vector<uint8_t> ascii = Decompress (asciiName);
+  NS_TEST_EXPECT_MSG_EQ ((std::string (ascii.begin (), ascii.end ()) == expected), true,
+                         "Bad decompressed ascii trace");
+  NS_TEST_EXPECT_MSG_LT (ReadFile (asciiName).size (), expected.size () / 5,
+                         "The ascii trace is not compressed");
+
+  // A pcap file, which must match an uncompressed one.
+  std::string pcapName = CreateTempDirFilename ("trace.pcap");
+  std::string gzipName = CreateTempDirFilename ("trace.pcap.gz");
+  for (uint32_t pass = 0; pass < 2; ++pass)
+    {
+      Ptr<PcapFileWrapper> file = CreateObject<PcapFileWrapper> ();
+      file->Open (pass == 0 ? pcapName : gzipName, std::ios::out);
+      NS_TEST_ASSERT_MSG_EQ (file->Fail (), false, "Open returns error");
+      file->Init (1);
+      for (uint32_t i = 0; i < 1000; ++i)
+        {
+          file->Write (MilliSeconds (i), MakePacket (i % 1500, i));
+        }
+      file->Close ();
+      NS_TEST_EXPECT_MSG_EQ (file->Fail (), false, "Close returns error");
+    }
+  NS_TEST_EXPECT_MSG_EQ ((Decompress (gzipName) == ReadFile (pcapName)), true,
+                         "Bad decompressed pcap file");
+}
+#endif /* HAVE_ZLIB */
+
+class PcapAsyncTestSuite : public TestSuite
+{
+public:
+  PcapAsyncTestSuite ();
+};
+
+PcapAsyncTestSuite::PcapAsyncTestSuite ()
+  : TestSuite ("pcap-async", UNIT)
+{
+  AddTestCase (new AsyncPcapFileTestCase, TestCase::QUICK);
+  AddTestCase (new PcapngFileTestCase, TestCase::QUICK);
+#ifdef HAVE_ZLIB
+  AddTestCase (new GzipTraceTestCase, TestCase::QUICK);
+#endif /* HAVE_ZLIB */
+}
+
+static PcapAsyncTestSuite pcapAsyncTestSuite;
@@ -109,6 +109,46 @@ void ReadFrom (Buffer::Iterator &i, Mac16Address &ad)
   ad.CopyFrom (mac);
 }
 
+void WriteTo (Buffer::WriteSpan &span, Ipv4Address ad)
+{
+  NS_LOG_FUNCTION (&span << &ad);
+  span.WriteHtonU32 (ad.Get ());
+}
+void WriteTo (Buffer::WriteSpan &span, Ipv6Address ad)
+{
+  NS_LOG_FUNCTION (&span << &ad);
+  uint8_t buf[16];
+  ad.GetBytes (buf);
+  span.Write (buf, 16);
+}
+void WriteTo (Buffer::WriteSpan &span, Mac48Address ad)
+{
+  NS_LOG_FUNCTION (&span << &ad);
+  uint8_t mac[6];
+  ad.CopyTo (mac);
+  span.Write (mac, 6);
+}
+
+void ReadFrom (Buffer::ReadSpan &span, Ipv4Address &ad)
+{
+  NS_LOG_FUNCTION (&span << &ad);
+  ad.Set (span.ReadNtohU32 ());
+}
+void ReadFrom (Buffer::ReadSpan &span, Ipv6Address &ad)
+{
+  NS_LOG_FUNCTION (&span << &ad);
+  uint8_t ipv6[16];
+  span.Read (ipv6, 16);
+  ad.Set (ipv6);
+}
+void ReadFrom (Buffer::ReadSpan &span, Mac48Address &ad)
+{
+  NS_LOG_FUNCTION (&span << &ad);
+  uint8_t mac[6];
+  span.Read (mac, 6);
+  ad.CopyFrom (mac);
+}
+
 namespace addressUtils {
 
 bool IsMulticast (const Address &ad)
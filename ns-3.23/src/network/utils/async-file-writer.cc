@@ -0,0 +1,694 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "ns3/core-config.h"
+#include "ns3/network-config.h"
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/callback.h"
+#include "ns3/mpsc-queue.h"
+#include "ns3/system-condition.h"
+#include "ns3/system-mutex.h"
+#include "ns3/system-thread.h"
+#endif /* HAVE_PTHREAD_H */
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif /* HAVE_ZLIB */
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif /* HAVE_ZSTD */
+#include "async-file-writer.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AsyncFileWriter");
+
+/**
+ * A compressed stream. Only used by the thread which writes the file.
+ */
+class AsyncFileWriter::Compressor
+{
+public:
+  /**
+   * \param compression The compression format, which must be supported.
+   */
+  Compressor (Compression compression);
+  ~Compressor ();
+  /**
+   * Compress bytes.
+   * \param data The bytes.
+   * \param size The number of bytes.
+   * \param out Where to write the compressed bytes.
+   */
+  void Write (const uint8_t *data, uint32_t size, std::ostream &out);
+  /**
+   * Write the end of the compressed stream.
+   * \param out Where to write the compressed bytes.
+   */
+  void Finish (std::ostream &out);
+
+private:
+  /**
+   * Set the bytes to compress.
+   * \param data The bytes.
+   * \param size The number of bytes.
+   */
+  void SetInput (const uint8_t *data, uint32_t size);
+  /**
+   * Run the compressor on the pending input.
+   * \param finish True to end the stream.
+   * \param out Where to write the compressed bytes.
+   */
+  void Run (bool finish, std::ostream &out);
+
+  Compression m_compression;  //!< The compression format.
+  std::vector<char> m_output; //!< Compressed bytes.
+#ifdef HAVE_ZLIB
+  z_stream m_zlib;            //!< The gzip stream.
+#endif /* HAVE_ZLIB */
+#ifdef HAVE_ZSTD
+  ZSTD_CCtx *m_zstd;          //!< The zstd stream.
+  ZSTD_inBuffer m_zstdInput;  //!< The pending zstd input.
+#endif /* HAVE_ZSTD */
+};
+
+AsyncFileWriter::Compressor::Compressor (Compression compression)
+  : m_compression (compression),
+    m_output (1 << 16)
+{
+  NS_LOG_FUNCTION (this << compression);
+#ifdef HAVE_ZLIB
+  if (m_compression == GZIP)
+    {
+      std::memset (&m_zlib, 0, sizeof (m_zlib));
+      // The window bits plus 16 ask for a gzip header. The point is to
+      // save disk bandwidth at a low CPU cost, hence the fastest level.
+      int status = deflateInit2 (&m_zlib, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8,
+                                 Z_DEFAULT_STRATEGY);
+      NS_ABORT_MSG_IF (status != Z_OK, "deflateInit2 failed: " << status);
+    }
+#endif /* HAVE_ZLIB */
+#ifdef HAVE_ZSTD
+  if (m_compression == ZSTD)
+    {
+      m_zstd = ZSTD_createCCtx ();
+      NS_ABORT_MSG_IF (m_zstd == 0, "ZSTD_createCCtx failed");
+      ZSTD_CCtx_setParameter (m_zstd, ZSTD_c_compressionLevel, 1);
+      m_output.resize (ZSTD_CStreamOutSize ());
+    }
+#endif /* HAVE_ZSTD */
+}
+
+AsyncFileWriter::Compressor::~Compressor ()
+{
+  NS_LOG_FUNCTION (this);
+#ifdef HAVE_ZLIB
+  if (m_compression == GZIP)
+    {
+      deflateEnd (&m_zlib);
+    }
+#endif /* HAVE_ZLIB */
+#ifdef HAVE_ZSTD
+  if (m_compression == ZSTD)
+    {
+      ZSTD_freeCCtx (m_zstd);
+    }
+#endif /* HAVE_ZSTD */
+}
+
+void
+AsyncFileWriter::Compressor::Write (const uint8_t *data, uint32_t size, std::ostream &out)
+{
+  SetInput (data, size);
+  Run (false, out);
+}
+
+void
+AsyncFileWriter::Compressor::Finish (std::ostream &out)
+{
+  SetInput (0, 0);
+  Run (true, out);
+}
+
+void
+AsyncFileWriter::Compressor::SetInput (const uint8_t *data, uint32_t size)
+{
+#ifdef HAVE_ZLIB
+  if (m_compression == GZIP)
+    {
+      m_zlib.next_in = const_cast<Bytef *> (data);
+      m_zlib.avail_in = size;
+    }
+#endif /* HAVE_ZLIB */
+#ifdef HAVE_ZSTD
+  if (m_compression == ZSTD)
+    {
+      m_zstdInput.src = data;
+      m_zstdInput.size = size;
+      m_zstdInput.pos = 0;
+    }
+#endif /* HAVE_ZSTD */
+}
+
+void
+AsyncFileWriter::Compressor::Run (bool finish, std::ostream &out)
+{
+#ifdef HAVE_ZLIB
+  if (m_compression == GZIP)
+    {
+      int status;
+      do
+        {
+          m_zlib.next_out = reinterpret_cast<Bytef *> (&m_output[0]);
+          m_zlib.avail_out = m_output.size ();
+          status = deflate (&m_zlib, finish ? Z_FINISH : Z_NO_FLUSH);
+          NS_ABORT_MSG_IF (status == Z_STREAM_ERROR, "deflate failed");
+          out.write (&m_output[0], m_output.size () - m_zlib.avail_out);
+        }
+      while (m_zlib.avail_out == 0 || (finish && status != Z_STREAM_END));
+    }
+#endif /* HAVE_ZLIB */
+#ifdef HAVE_ZSTD
+  if (m_compression == ZSTD)
+    {
+      size_t remaining;
+      do
+        {
+          ZSTD_outBuffer output = { &m_output[0], m_output.size (), 0 };
+          remaining = ZSTD_compressStream2 (m_zstd, &output, &m_zstdInput,
+                                            finish ? ZSTD_e_end : ZSTD_e_continue);
+          NS_ABORT_MSG_IF (ZSTD_isError (remaining), "ZSTD_compressStream2 failed: "
+                           << ZSTD_getErrorName (remaining));
+          out.write (&m_output[0], output.pos);
+        }
+      while (m_zstdInput.pos < m_zstdInput.size || (finish && remaining != 0));
+    }
+#endif /* HAVE_ZSTD */
+}
+
+#ifdef HAVE_PTHREAD_H
+
+/**
+ * The writer thread shared by all the open files.
+ *
+ * Blocks go through a lock-free queue. The thread sleeps on a condition
+ * when the queue is empty; it also wakes up every millisecond so that
+ * a lost wakeup can only delay a write, never stall it.
+ */
+class AsyncFileWriter::WriterThread
+{
+public:
+  /** Register an open file, starting the thread if needed. */
+  static void Acquire (void);
+  /** Unregister a closed file, stopping the thread after the last one. */
+  static void Release (void);
+  /**
+   * Queue a block, waiting for room if the queue is full.
+   * \param file The file to write to.
+   * \param data The block.
+   * \param size The number of bytes to write.
+   */
+  static void Push (AsyncFileWriter *file, uint8_t *data, uint32_t size);
+  /** Wait until a block has been written, or for at most WAIT_NS. */
+  static void WaitWritten (void);
+
+private:
+  /** A queued block. */
+  struct Block
+  {
+    AsyncFileWriter *file; //!< The file to write to.
+    uint8_t *data;         //!< The block.
+    uint32_t size;         //!< The number of bytes to write.
+  };
+  /** The thread body. */
+  static void Run (void);
+  /** \returns The lock which protects the start and stop of the thread. */
+  static SystemMutex &GetLock (void);
+
+  static const uint32_t QUEUE_SIZE = 1024;   //!< Maximum number of queued blocks.
+  static const uint64_t WAIT_NS = 1000000;   //!< Longest sleep of the waiting threads.
+
+  static uint32_t m_users;                   //!< Number of open files.
+  static Ptr<SystemThread> m_thread;         //!< The writer thread.
+  static MpscQueue<Block> *m_queue;          //!< The queued blocks.
+  static SystemCondition *m_wakeup;          //!< Set when a block is queued.
+  static SystemCondition *m_written;         //!< Set when a block is written.
+  static volatile bool m_stop;               //!< Tells the thread to exit.
+};
+
+uint32_t AsyncFileWriter::WriterThread::m_users = 0;
+Ptr<SystemThread> AsyncFileWriter::WriterThread::m_thread = 0;
+MpscQueue<AsyncFileWriter::WriterThread::Block> *AsyncFileWriter::WriterThread::m_queue = 0;
+SystemCondition *AsyncFileWriter::WriterThread::m_wakeup = 0;
+SystemCondition *AsyncFileWriter::WriterThread::m_written = 0;
+volatile bool AsyncFileWriter::WriterThread::m_stop = false;
+
+SystemMutex &
+AsyncFileWriter::WriterThread::GetLock (void)
+{
+  // Never deleted, so that files closed by static destructors still
+  // find it.
+  static SystemMutex *lock = new SystemMutex ();
+  return *lock;
+}
+
+void
+AsyncFileWriter::WriterThread::Acquire (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  CriticalSection cs (GetLock ());
+  if (m_users++ != 0)
+    {
+      return;
+    }
+  if (m_queue == 0)
+    {
+      m_queue = new MpscQueue<Block> (QUEUE_SIZE);
+      m_wakeup = new SystemCondition ();
+      m_written = new SystemCondition ();
+    }
+  m_stop = false;
+  m_thread = Create<SystemThread> (MakeCallback (&AsyncFileWriter::WriterThread::Run));
+  m_thread->Start ();
+}
+
+void
+AsyncFileWriter::WriterThread::Release (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  CriticalSection cs (GetLock ());
+  NS_ASSERT (m_users > 0);
+  if (--m_users != 0)
+    {
+      return;
+    }
+  m_stop = true;
+  m_wakeup->SetCondition (true);
+  m_wakeup->Signal ();
+  m_thread->Join ();
+  m_thread = 0;
+}
+
+void
+AsyncFileWriter::WriterThread::Push (AsyncFileWriter *file, uint8_t *data, uint32_t size)
+{
+  Block block;
+  block.file = file;
+  block.data = data;
+  block.size = size;
+  while (__sync_fetch_and_add (&file->m_pending, 0) > MAX_PENDING
+         || !m_queue->Push (block))
+    {
+      // The writer is more than MAX_PENDING blocks behind on this file,
+      // or QUEUE_SIZE blocks behind overall: wait for it.
+      m_wakeup->SetCondition (true);
+      m_wakeup->Signal ();
+      WaitWritten ();
+    }
+  m_wakeup->SetCondition (true);
+  m_wakeup->Signal ();
+}
+
+void
+AsyncFileWriter::WriterThread::WaitWritten (void)
+{
+  m_written->SetCondition (false);
+  m_written->TimedWait (WAIT_NS);
+}
+
+void
+AsyncFileWriter::WriterThread::Run (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  Block block;
+  for (;;)
+    {
+      // Clear the wakeup before looking at the queue: a block pushed
+      // after the last Pop sets it again and TimedWait returns at once.
+      m_wakeup->SetCondition (false);
+      while (m_queue->Pop (block))
+        {
+          block.file->DoWrite (block.data, block.size);
+          m_written->SetCondition (true);
+          m_written->Broadcast ();
+        }
+      if (m_stop)
+        {
+          break;
+        }
+      m_wakeup->TimedWait (WAIT_NS);
+    }
+}
+
+#endif /* HAVE_PTHREAD_H */
+
+AsyncFileWriter::AsyncFileWriter ()
+  : m_compressor (0),
+    m_fail (false),
+    m_pending (0),
+    m_open (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+AsyncFileWriter::~AsyncFileWriter ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+AsyncFileWriter::Compression
+AsyncFileWriter::GetCompression (std::string const &filename)
+{
+  NS_LOG_FUNCTION (filename);
+  std::string::size_type dot = filename.rfind ('.');
+  std::string extension = dot == std::string::npos ? "" : filename.substr (dot);
+  if (extension == ".gz")
+    {
+      return GZIP;
+    }
+  if (extension == ".zst")
+    {
+      return ZSTD;
+    }
+  return NONE;
+}
+
+bool
+AsyncFileWriter::IsSupported (Compression compression)
+{
+  NS_LOG_FUNCTION (compression);
+  switch (compression)
+    {
+    case NONE:
+      return true;
+    case GZIP:
+#ifdef HAVE_ZLIB
+      return true;
+#else /* HAVE_ZLIB */
+      return false;
+#endif /* HAVE_ZLIB */
+    case ZSTD:
+#ifdef HAVE_ZSTD
+      return true;
+#else /* HAVE_ZSTD */
+      return false;
+#endif /* HAVE_ZSTD */
+    }
+  return false;
+}
+
+void
+AsyncFileWriter::Open (std::string const &filename, std::ios::openmode mode)
+{
+  NS_LOG_FUNCTION (this << filename << mode);
+  NS_ASSERT (!m_open);
+  Compression compression = GetCompression (filename);
+  NS_ABORT_MSG_UNLESS (IsSupported (compression),
+                       "Cannot compress " << filename << ": ns-3 was built without "
+                       << (compression == GZIP ? "zlib" : "zstd"));
+  mode = (mode & std::ios::app) ? std::ios::app : std::ios::trunc;
+  m_file.open (filename.c_str (), std::ios::out | std::ios::binary | mode);
+  m_fail = m_file.fail ();
+  if (m_fail)
+    {
+      return;
+    }
+  if (compression != NONE)
+    {
+      m_compressor = new Compressor (compression);
+    }
+  m_open = true;
+#ifdef HAVE_PTHREAD_H
+  WriterThread::Acquire ();
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+AsyncFileWriter::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_open)
+    {
+      return;
+    }
+  Drain ();
+#ifdef HAVE_PTHREAD_H
+  WriterThread::Release ();
+#endif /* HAVE_PTHREAD_H */
+  // The writer thread is done with this file.
+  if (m_compressor != 0)
+    {
+      m_compressor->Finish (m_file);
+      delete m_compressor;
+      m_compressor = 0;
+    }
+  m_file.close ();
+  m_fail = m_fail || m_file.fail ();
+  m_open = false;
+}
+
+bool
+AsyncFileWriter::Fail (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_fail;
+}
+
+void
+AsyncFileWriter::Submit (uint8_t *data, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << &data << size);
+  if (!m_open)
+    {
+      m_fail = true;
+      delete [] data;
+      return;
+    }
+#ifdef HAVE_PTHREAD_H
+  __sync_fetch_and_add (&m_pending, 1);
+  WriterThread::Push (this, data, size);
+#else /* HAVE_PTHREAD_H */
+  DoWrite (data, size);
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+AsyncFileWriter::Drain (void)
+{
+  NS_LOG_FUNCTION (this);
+#ifdef HAVE_PTHREAD_H
+  while (__sync_fetch_and_add (&m_pending, 0) != 0)
+    {
+      WriterThread::WaitWritten ();
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+AsyncFileWriter::DoWrite (uint8_t *data, uint32_t size)
+{
+  if (m_compressor != 0)
+    {
+      m_compressor->Write (data, size, m_file);
+    }
+  else
+    {
+      m_file.write ((const char *)data, size);
+    }
+  if (m_file.fail ())
+    {
+      m_fail = true;
+    }
+  delete [] data;
+#ifdef HAVE_PTHREAD_H
+  __sync_fetch_and_sub (&m_pending, 1);
+#endif /* HAVE_PTHREAD_H */
+}
+
+
+AsyncWriteBuffer::AsyncWriteBuffer ()
+  : m_writer (0),
+    m_blockSize (0),
+    m_block (0),
+    m_capacity (0),
+    m_used (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+AsyncWriteBuffer::~AsyncWriteBuffer ()
+{
+  NS_LOG_FUNCTION (this);
+  Flush ();
+}
+
+void
+AsyncWriteBuffer::SetWriter (Ptr<AsyncFileWriter> writer, uint32_t blockSize)
+{
+  NS_LOG_FUNCTION (this << writer << blockSize);
+  Flush ();
+  m_writer = writer;
+  m_blockSize = blockSize;
+}
+
+Ptr<AsyncFileWriter>
+AsyncWriteBuffer::GetWriter (void) const
+{
+  return m_writer;
+}
+
+uint8_t *
+AsyncWriteBuffer::Reserve (uint32_t size)
+{
+  NS_ASSERT (m_writer != 0);
+  if (m_block != 0 && m_capacity - m_used >= size)
+    {
+      uint8_t *start = m_block + m_used;
+      m_used += size;
+      return start;
+    }
+  Flush ();
+  m_capacity = std::max (size, m_blockSize);
+  m_block = new uint8_t [m_capacity];
+  m_used = size;
+  return m_block;
+}
+
+void
+AsyncWriteBuffer::Write (const void *data, uint32_t size)
+{
+  std::memcpy (Reserve (size), data, size);
+}
+
+void
+AsyncWriteBuffer::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_block == 0)
+    {
+      return;
+    }
+  if (m_used != 0 && m_writer != 0)
+    {
+      m_writer->Submit (m_block, m_used);
+    }
+  else
+    {
+      delete [] m_block;
+    }
+  m_block = 0;
+  m_capacity = 0;
+  m_used = 0;
+}
+
+
+AsyncStreamBuf::AsyncStreamBuf (Ptr<AsyncFileWriter> writer, uint32_t blockSize)
+  : m_writer (writer),
+    m_blockSize (blockSize),
+    m_block (0)
+{
+  NS_LOG_FUNCTION (this << writer << blockSize);
+}
+
+AsyncStreamBuf::~AsyncStreamBuf ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+void
+AsyncStreamBuf::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  SubmitBlock ();
+  m_writer = 0;
+}
+
+void
+AsyncStreamBuf::SubmitBlock (void)
+{
+  if (m_block == 0)
+    {
+      return;
+    }
+  uint32_t used = pptr () - pbase ();
+  if (used != 0 && m_writer != 0)
+    {
+      m_writer->Submit (m_block, used);
+    }
+  else
+    {
+      delete [] m_block;
+    }
+  m_block = 0;
+  setp (0, 0);
+}
+
+AsyncStreamBuf::int_type
+AsyncStreamBuf::overflow (int_type c)
+{
+  if (m_writer == 0)
+    {
+      return traits_type::eof ();
+    }
+  SubmitBlock ();
+  m_block = new uint8_t [m_blockSize];
+  char *start = reinterpret_cast<char *> (m_block);
+  setp (start, start + m_blockSize);
+  if (!traits_type::eq_int_type (c, traits_type::eof ()))
+    {
+      *pptr () = traits_type::to_char_type (c);
+      pbump (1);
+    }
+  return traits_type::not_eof (c);
+}
+
+int
+AsyncStreamBuf::sync (void)
+{
+  return 0;
+}
+
+
+AsyncOutputStream::AsyncOutputStream (std::string const &filename, std::ios::openmode mode,
+                                      uint32_t blockSize)
+  : std::ostream (0),
+    m_writer (Create<AsyncFileWriter> ()),
+    m_buffer (m_writer, blockSize)
+{
+  NS_LOG_FUNCTION (this << filename << mode << blockSize);
+  rdbuf (&m_buffer);
+  m_writer->Open (filename, mode);
+  if (m_writer->Fail ())
+    {
+      setstate (std::ios::failbit);
+    }
+}
+
+AsyncOutputStream::~AsyncOutputStream ()
+{
+  NS_LOG_FUNCTION (this);
+  m_buffer.Close ();
+  m_writer->Close ();
+}
+
+} // namespace ns3
@@ -0,0 +1,277 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ASYNC_FILE_WRITER_H
+#define ASYNC_FILE_WRITER_H
+
+#include <string>
+#include <fstream>
+#include <ostream>
+#include <streambuf>
+#include <stdint.h>
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+namespace ns3 {
+
+/**
+ * \brief A file written by a background thread.
+ *
+ * Blocks of bytes handed to Submit are queued and written to the file,
+ * in submission order, by a writer thread shared by all the open
+ * AsyncFileWriter objects. The thread is started when the first file
+ * is opened and stopped when the last one is closed. Submit is
+ * lock-free and can be called from any thread, so the simulation
+ * thread (or threads) only pays for filling the blocks.
+ *
+ * Without threading support, the blocks are written synchronously by
+ * Submit.
+ *
+ * Files whose name ends with ".gz" or ".zst" are compressed, with gzip
+ * or zstd, by the writer thread. At most MAX_PENDING blocks of a file
+ * can wait for the writer, so a file which is written faster than it
+ * can be compressed and stored slows down its producer instead of
+ * using more memory.
+ *
+ * Most users should not use this class directly: see AsyncWriteBuffer,
+ * which fills blocks of a fixed size, and the "Asynchronous" attribute
+ * of ns3::PcapFileWrapper.
+ */
+class AsyncFileWriter : public SimpleRefCount<AsyncFileWriter>
+{
+public:
+  /** The compression formats. */
+  enum Compression
+  {
+    NONE, //!< No compression
+    GZIP, //!< gzip, for file names ending with ".gz"
+    ZSTD  //!< zstd, for file names ending with ".zst"
+  };
+
+  static const uint32_t MAX_PENDING = 8; /**< Maximum number of blocks of a file waiting for the writer */
+
+  AsyncFileWriter ();
+  ~AsyncFileWriter ();
+
+  /**
+   * \param filename The name of a file.
+   * \returns The compression of the file, chosen from its extension.
+   */
+  static Compression GetCompression (std::string const &filename);
+  /**
+   * \param compression A compression format.
+   * \returns true if ns-3 was built with the library of this format.
+   */
+  static bool IsSupported (Compression compression);
+
+  /**
+   * Open a binary file for writing. The file is truncated unless the
+   * mode has std::ios::app, and compressed if its name ends with ".gz"
+   * or ".zst": appending to a compressed file adds a new gzip member or
+   * zstd frame, which the usual tools read as a continuation.
+   *
+   * \param filename The name of the file.
+   * \param mode The access mode of the file.
+   */
+  void Open (std::string const &filename, std::ios::openmode mode = std::ios::out);
+  /**
+   * Wait until all the submitted blocks have been written and close
+   * the file.
+   */
+  void Close (void);
+  /**
+   * \returns true if the file could not be opened, or if writing a
+   *   block failed.
+   */
+  bool Fail (void) const;
+  /**
+   * Queue a block to be written. Can be called from any thread; blocks
+   * submitted by the same thread are written in order.
+   *
+   * \param data The block, allocated with new uint8_t[]. The writer
+   *   thread deletes it once written.
+   * \param size The number of bytes to write.
+   */
+  void Submit (uint8_t *data, uint32_t size);
+  /**
+   * Wait until all the blocks submitted so far have been written.
+   */
+  void Drain (void);
+
+private:
+  class WriterThread;
+  class Compressor;
+
+  /**
+   * Write a block to the file and delete it. Called by the writer thread.
+   * \param data The block.
+   * \param size The number of bytes to write.
+   */
+  void DoWrite (uint8_t *data, uint32_t size);
+
+  std::ofstream m_file;       //!< The output file.
+  Compressor *m_compressor;   //!< The compressor of the file, if any.
+  volatile bool m_fail;       //!< Set when a write failed.
+  volatile uint32_t m_pending; //!< Number of submitted blocks not yet written.
+  bool m_open;                //!< True between Open and Close.
+};
+
+/**
+ * \brief Fills blocks of an AsyncFileWriter.
+ *
+ * Bytes are appended to a block of a fixed size which is submitted to
+ * the writer once full, so the writer thread only ever sees large
+ * writes. Each AsyncWriteBuffer must be filled by one thread at a
+ * time; several buffers can feed the same AsyncFileWriter from
+ * different threads, in which case the file receives their blocks
+ * interleaved and each record should be written with a single
+ * Reserve, which never splits its bytes across two blocks.
+ */
+class AsyncWriteBuffer
+{
+public:
+  static const uint32_t BLOCK_SIZE_DEFAULT = 1 << 20; /**< Default size of the write blocks */
+
+  AsyncWriteBuffer ();
+  /**
+   * Submit the last block, if any.
+   */
+  ~AsyncWriteBuffer ();
+
+  /**
+   * \param writer The file to fill, or zero to detach the buffer.
+   * \param blockSize The size of the blocks.
+   */
+  void SetWriter (Ptr<AsyncFileWriter> writer, uint32_t blockSize);
+  /**
+   * \returns The file filled by this buffer.
+   */
+  Ptr<AsyncFileWriter> GetWriter (void) const;
+  /**
+   * Append size bytes to the buffer. The current block is submitted
+   * first if it has no room for them, and larger requests get a block
+   * of their own.
+   *
+   * \param size The number of bytes.
+   * \returns Where to write the bytes. The pointer is only valid until
+   *   the next call to Reserve or Flush.
+   */
+  uint8_t *Reserve (uint32_t size);
+  /**
+   * Append a copy of some bytes to the buffer.
+   *
+   * \param data The bytes.
+   * \param size The number of bytes.
+   */
+  void Write (const void *data, uint32_t size);
+  /**
+   * Submit the current block.
+   */
+  void Flush (void);
+
+private:
+  /**
+   * Disable copy: a block has one owner.
+   * \param o The buffer to copy.
+   */
+  AsyncWriteBuffer (const AsyncWriteBuffer &o);
+  /**
+   * Disable assignment.
+   * \param o The buffer to copy.
+   * \returns This buffer.
+   */
+  AsyncWriteBuffer &operator = (const AsyncWriteBuffer &o);
+
+  Ptr<AsyncFileWriter> m_writer; //!< The file.
+  uint32_t m_blockSize;          //!< Size of the blocks.
+  uint8_t *m_block;              //!< The block being filled.
+  uint32_t m_capacity;           //!< Size of m_block.
+  uint32_t m_used;               //!< Number of bytes filled in m_block.
+};
+
+/**
+ * \brief A stream buffer which fills blocks of an AsyncFileWriter.
+ *
+ * Flushing the stream does not submit anything, so that the usual
+ * std::endl at the end of each trace line costs nothing: the blocks are
+ * submitted once full, and the last one by Close.
+ */
+class AsyncStreamBuf : public std::streambuf
+{
+public:
+  /**
+   * \param writer The file to fill.
+   * \param blockSize The size of the blocks.
+   */
+  AsyncStreamBuf (Ptr<AsyncFileWriter> writer, uint32_t blockSize);
+  /**
+   * Submit the last block, if any.
+   */
+  ~AsyncStreamBuf ();
+  /**
+   * Submit the last block and detach from the file.
+   */
+  void Close (void);
+
+protected:
+  /**
+   * Submit the full block and start a new one.
+   * \param c The character which did not fit, or EOF.
+   * \returns EOF on failure.
+   */
+  virtual int_type overflow (int_type c);
+  /**
+   * Do nothing: the bytes are only submitted by full blocks.
+   * \returns 0.
+   */
+  virtual int sync (void);
+
+private:
+  /** Submit the current block, if any. */
+  void SubmitBlock (void);
+
+  Ptr<AsyncFileWriter> m_writer; //!< The file.
+  uint32_t m_blockSize;          //!< Size of the blocks.
+  uint8_t *m_block;              //!< The block being filled.
+};
+
+/**
+ * \brief A std::ostream written, and possibly compressed, by the
+ * AsyncFileWriter thread.
+ *
+ * See AsyncStreamBuf: the file is only complete once the stream is
+ * destroyed.
+ */
+class AsyncOutputStream : public std::ostream
+{
+public:
+  /**
+   * \param filename The name of the file, see AsyncFileWriter::Open.
+   * \param mode The access mode of the file.
+   * \param blockSize The size of the write blocks.
+   */
+  AsyncOutputStream (std::string const &filename, std::ios::openmode mode = std::ios::out,
+                     uint32_t blockSize = AsyncWriteBuffer::BLOCK_SIZE_DEFAULT);
+  ~AsyncOutputStream ();
+
+private:
+  Ptr<AsyncFileWriter> m_writer; //!< The file.
+  AsyncStreamBuf m_buffer;       //!< The stream buffer.
+};
+
+} // namespace ns3
+
+#endif /* ASYNC_FILE_WRITER_H */
@@ -19,14 +19,156 @@
 #include "ns3/log.h"
 #include "ns3/enum.h"
 #include "ns3/uinteger.h"
+#include "ns3/tag.h"
 #include "drop-tail-queue.h"
 
+#include <vector>
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("DropTailQueue");
 
 NS_OBJECT_ENSURE_REGISTERED (DropTailQueue);
 
+namespace {
+
+/**
+ * \param [in] tid The type of a tag.
+ * \returns true if tags of this type can be restored, which requires
+ *   a constructor.
+ */
+bool
+CanSaveTag (TypeId tid)
+{
+  if (tid.GetConstructor ().IsNull ())
+    {
+      NS_LOG_WARN ("Tag " << tid.GetName () << " has no constructor and is not saved");
+      return false;
+    }
+  return true;
+}
+
+/**
+ * Save a tag as its type name and serialized bytes.
+ * \param [in] item The tag, a PacketTagIterator::Item or a
+ *   ByteTagIterator::Item whose type passes CanSaveTag.
+ * \param [out] writer Where to save it.
+ */
+template <typename T>
+void
+SaveTag (const T &item, CheckpointWriter &writer)
+{
+  Tag *tag = dynamic_cast<Tag *> (item.GetTypeId ().GetConstructor () ());
+  NS_ASSERT (tag != 0);
+  item.GetTag (*tag);
+  // one more byte, so that the buffer is never empty.
+  std::vector<uint8_t> buffer (tag->GetSerializedSize () + 1);
+  tag->Serialize (TagBuffer (&buffer[0], &buffer[0] + buffer.size () - 1));
+  delete tag;
+  writer.WriteString (item.GetTypeId ().GetName ());
+  writer.WriteU32 (buffer.size () - 1);
+  writer.WriteBytes (&buffer[0], buffer.size () - 1);
+}
+
+/**
+ * Restore a tag saved by SaveTag.
+ * \param [in] reader Where to read it.
+ * \returns The tag, to delete after use.
+ */
+Tag *
+RestoreTag (CheckpointReader &reader)
+{
+  TypeId tid = TypeId::LookupByName (reader.ReadString ());
+  std::vector<uint8_t> buffer (reader.ReadU32 () + 1);
+  reader.ReadBytes (&buffer[0], buffer.size () - 1);
+  Tag *tag = dynamic_cast<Tag *> (tid.GetConstructor () ());
+  NS_ASSERT (tag != 0);
+  tag->Deserialize (TagBuffer (&buffer[0], &buffer[0] + buffer.size () - 1));
+  return tag;
+}
+
+/**
+ * Save a packet with its packet tags and byte tags, which
+ * Packet::Serialize does not include.
+ * \param [in] p The packet.
+ * \param [out] writer Where to save it.
+ */
+void
+SavePacket (Ptr<const Packet> p, CheckpointWriter &writer)
+{
+  uint32_t size = p->GetSerializedSize ();
+  std::vector<uint8_t> buffer (size);
+  p->Serialize (&buffer[0], size);
+  writer.WriteU32 (size);
+  writer.WriteBytes (&buffer[0], size);
+
+  std::vector<PacketTagIterator::Item> packetTags;
+  PacketTagIterator i = p->GetPacketTagIterator ();
+  while (i.HasNext ())
+    {
+      PacketTagIterator::Item item = i.Next ();
+      if (CanSaveTag (item.GetTypeId ()))
+        {
+          packetTags.push_back (item);
+        }
+    }
+  writer.WriteU32 (packetTags.size ());
+  for (uint32_t k = 0; k < packetTags.size (); k++)
+    {
+      SaveTag (packetTags[k], writer);
+    }
+
+  std::vector<ByteTagIterator::Item> byteTags;
+  ByteTagIterator j = p->GetByteTagIterator ();
+  while (j.HasNext ())
+    {
+      ByteTagIterator::Item item = j.Next ();
+      if (CanSaveTag (item.GetTypeId ()))
+        {
+          byteTags.push_back (item);
+        }
+    }
+  writer.WriteU32 (byteTags.size ());
+  for (uint32_t k = 0; k < byteTags.size (); k++)
+    {
+      writer.WriteU32 (byteTags[k].GetStart ());
+      writer.WriteU32 (byteTags[k].GetEnd ());
+      SaveTag (byteTags[k], writer);
+    }
+}
+
+/**
+ * Restore a packet saved by SavePacket.
+ * \param [in] reader Where to read it.
+ * \returns The packet.
+ */
+Ptr<Packet>
+RestorePacket (CheckpointReader &reader)
+{
+  std::vector<uint8_t> buffer (reader.ReadU32 ());
+  reader.ReadBytes (&buffer[0], buffer.size ());
+  Ptr<Packet> p = Create<Packet> (&buffer[0], buffer.size (), true);
+  uint32_t n = reader.ReadU32 ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Tag *tag = RestoreTag (reader);
+      p->AddPacketTag (*tag);
+      delete tag;
+    }
+  n = reader.ReadU32 ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t start = reader.ReadU32 ();
+      uint32_t end = reader.ReadU32 ();
+      Tag *tag = RestoreTag (reader);
+      p->AddByteTag (*tag, start, end);
+      delete tag;
+    }
+  return p;
+}
+
+} // anonymous namespace
+
 TypeId DropTailQueue::GetTypeId (void) 
 {
   static TypeId tid = TypeId ("ns3::DropTailQueue")
@@ -151,5 +293,38 @@ DropTailQueue::DoPeek (void) const
   return p;
 }
 
+void
+DropTailQueue::SaveCheckpoint (CheckpointWriter &writer) const
+{
+  NS_LOG_FUNCTION (this << &writer);
+  Queue::SaveCheckpoint (writer);
+  std::queue<Ptr<Packet> > packets = m_packets;
+  writer.WriteU32 (packets.size ());
+  for (; !packets.empty (); packets.pop ())
+    {
+      SavePacket (packets.front (), writer);
+    }
+}
+
+void
+DropTailQueue::RestoreCheckpoint (CheckpointReader &reader)
+{
+  NS_LOG_FUNCTION (this << &reader);
+  Queue::RestoreCheckpoint (reader);
+  m_packets = std::queue<Ptr<Packet> > ();
+  m_bytesInQueue = 0;
+  m_nPackets = 0;
+  m_nBytes = 0;
+  uint32_t n = reader.ReadU32 ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = RestorePacket (reader);
+      m_packets.push (p);
+      m_bytesInQueue += p->GetSize ();
+      m_nPackets++;
+      m_nBytes += p->GetSize ();
+    }
+}
+
 } // namespace ns3
 
@@ -63,6 +63,10 @@ public:
    */
   DropTailQueue::QueueMode GetMode (void);
 
+  // Inherited
+  virtual void SaveCheckpoint (CheckpointWriter &writer) const;
+  virtual void RestoreCheckpoint (CheckpointReader &reader);
+
 private:
   virtual bool DoEnqueue (Ptr<Packet> p);
   virtual Ptr<Packet> DoDequeue (void);
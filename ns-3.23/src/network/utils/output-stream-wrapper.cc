@@ -20,6 +20,7 @@
 #include "ns3/log.h"
 #include "ns3/fatal-impl.h"
 #include "ns3/abort.h"
+#include "async-file-writer.h"
 #include <fstream>
 
 namespace ns3 {
@@ -30,6 +31,14 @@ OutputStreamWrapper::OutputStreamWrapper (std::string filename, std::ios::openmo
   : m_destroyable (true)
 {
   NS_LOG_FUNCTION (this << filename << filemode);
+  if (AsyncFileWriter::GetCompression (filename) != AsyncFileWriter::NONE)
+    {
+      m_ostream = new AsyncOutputStream (filename, filemode);
+      FatalImpl::RegisterStream (m_ostream);
+      NS_ABORT_MSG_UNLESS (m_ostream->good (), "AsciiTraceHelper::CreateFileStream():  " <<
+                           "Unable to Open " << filename << " for mode " << filemode);
+      return;
+    }
   std::ofstream* os = new std::ofstream ();
   os->open (filename.c_str (), filemode);
   m_ostream = os;
@@ -64,6 +64,11 @@ namespace ns3 {
  * \endverbatim
  *
  *
+ * A file whose name ends with ".gz" or ".zst" is written through an
+ * AsyncOutputStream: the text is compressed, with gzip or zstd, by a
+ * background thread, and the file is complete once the wrapper is
+ * destroyed.
+ *
  * This class uses a basic ns-3 reference counting base class but is not 
  * an ns3::Object with attributes, TypeId, or aggregation.
  */
@@ -18,6 +18,7 @@
 
 #include "ns3/log.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/buffer.h"
 #include "ns3/header.h"
 #include "pcap-file-wrapper.h"
@@ -40,12 +41,25 @@ PcapFileWrapper::GetTypeId (void)
                    UintegerValue (PcapFile::SNAPLEN_DEFAULT),
                    MakeUintegerAccessor (&PcapFileWrapper::m_snapLen),
                    MakeUintegerChecker<uint32_t> (0, PcapFile::SNAPLEN_DEFAULT))
+    .AddAttribute ("Asynchronous",
+                   "Write the packets from a background thread, through large buffers. "
+                   "The file is complete once it is closed.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PcapFileWrapper::m_async),
+                   MakeBooleanChecker ())
+    .AddAttribute ("WriteBufferSize",
+                   "Size of the write buffers of asynchronous files",
+                   UintegerValue (AsyncWriteBuffer::BLOCK_SIZE_DEFAULT),
+                   MakeUintegerAccessor (&PcapFileWrapper::m_writeBufferSize),
+                   MakeUintegerChecker<uint32_t> (1))
   ;
   return tid;
 }
 
 
 PcapFileWrapper::PcapFileWrapper ()
+  : m_pcapng (0),
+    m_interface (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -61,6 +75,10 @@ bool
 PcapFileWrapper::Fail (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_pcapng != 0)
+    {
+      return m_pcapng->Fail ();
+    }
   return m_file.Fail ();
 }
 bool 
@@ -80,6 +98,7 @@ void
 PcapFileWrapper::Close (void)
 {
   NS_LOG_FUNCTION (this);
+  m_pcapng = 0;
   m_file.Close ();
 }
 
@@ -87,9 +106,24 @@ void
 PcapFileWrapper::Open (std::string const &filename, std::ios::openmode mode)
 {
   NS_LOG_FUNCTION (this << filename << mode);
+  bool compressed = AsyncFileWriter::GetCompression (filename) != AsyncFileWriter::NONE;
+  m_file.SetAsynchronous ((m_async || compressed) ? m_writeBufferSize : 0);
   m_file.Open (filename, mode);
 }
 
+void
+PcapFileWrapper::OpenInterface (Ptr<PcapngFile> file, std::string const &name,
+                                uint32_t dataLinkType, uint32_t snapLen)
+{
+  NS_LOG_FUNCTION (this << file << name << dataLinkType << snapLen);
+  if (snapLen == std::numeric_limits<uint32_t>::max ())
+    {
+      snapLen = m_snapLen;
+    }
+  m_pcapng = file;
+  m_interface = file->AddInterface (name, dataLinkType, snapLen);
+}
+
 void
 PcapFileWrapper::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t tzCorrection)
 {
@@ -113,6 +147,11 @@ void
 PcapFileWrapper::Write (Time t, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << t << p);
+  if (m_pcapng != 0)
+    {
+      m_pcapng->Write (m_interface, t.GetNanoSeconds (), p);
+      return;
+    }
   uint64_t current = t.GetMicroSeconds ();
   uint64_t s = current / 1000000;
   uint64_t us = current % 1000000;
@@ -124,6 +163,11 @@ void
 PcapFileWrapper::Write (Time t, Header &header, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << t << &header << p);
+  if (m_pcapng != 0)
+    {
+      m_pcapng->Write (m_interface, t.GetNanoSeconds (), header, p);
+      return;
+    }
   uint64_t current = t.GetMicroSeconds ();
   uint64_t s = current / 1000000;
   uint64_t us = current % 1000000;
@@ -135,6 +179,11 @@ void
 PcapFileWrapper::Write (Time t, uint8_t const *buffer, uint32_t length)
 {
   NS_LOG_FUNCTION (this << t << &buffer << length);
+  if (m_pcapng != 0)
+    {
+      m_pcapng->Write (m_interface, t.GetNanoSeconds (), buffer, length);
+      return;
+    }
   uint64_t current = t.GetMicroSeconds ();
   uint64_t s = current / 1000000;
   uint64_t us = current % 1000000;
@@ -181,6 +230,10 @@ uint32_t
 PcapFileWrapper::GetSnapLen (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_pcapng != 0)
+    {
+      return m_pcapng->GetSnapLen (m_interface);
+    }
   return m_file.GetSnapLen ();
 }
 
@@ -188,6 +241,10 @@ uint32_t
 PcapFileWrapper::GetDataLinkType (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_pcapng != 0)
+    {
+      return m_pcapng->GetDataLinkType (m_interface);
+    }
   return m_file.GetDataLinkType ();
 }
 
@@ -27,6 +27,7 @@
 #include "ns3/object.h"
 #include "ns3/nstime.h"
 #include "pcap-file.h"
+#include "pcapng-file.h"
 
 namespace ns3 {
 
@@ -35,6 +36,14 @@ namespace ns3 {
  * ns-3 interface to the low-level public methods of PcapFile.  Users are
  * encouraged to use this object instead of class ns3::PcapFile in ns-3
  * public APIs.
+ *
+ * With the "Asynchronous" attribute set, files opened for writing are
+ * written by a background thread through large buffers (see
+ * PcapFile::SetAsynchronous). This is always the case for files named
+ * with a ".gz" or ".zst" extension, which the background thread
+ * compresses. A wrapper can also stand for one
+ * interface of a pcapng file shared by several captures: see
+ * OpenInterface.
  */
 class PcapFileWrapper : public Object
 {
@@ -82,6 +91,19 @@ public:
    */
   void Close (void);
 
+  /**
+   * Write the packets of this wrapper to a new interface of a pcapng
+   * file instead of a pcap file of its own. This replaces Open and Init.
+   *
+   * \param file The pcapng file, which must be open.
+   * \param name The name of the interface.
+   * \param dataLinkType The data link type, as in Init.
+   * \param snapLen The maximum number of bytes captured per packet.
+   * Defaults to the "CaptureSize" attribute.
+   */
+  void OpenInterface (Ptr<PcapngFile> file, std::string const &name, uint32_t dataLinkType,
+                      uint32_t snapLen = std::numeric_limits<uint32_t>::max ());
+
   /**
    * Initialize the pcap file associated with this wrapper.  This file must have
    * been previously opened with write permissions.
@@ -215,6 +237,10 @@ public:
 private:
   PcapFile m_file; //!< Pcap file
   uint32_t m_snapLen; //!< max length of saved packets
+  bool m_async; //!< write through a background thread
+  uint32_t m_writeBufferSize; //!< size of the asynchronous write blocks
+  Ptr<PcapngFile> m_pcapng; //!< shared pcapng file, if any
+  uint32_t m_interface; //!< interface of this wrapper in m_pcapng
 };
 
 } // namespace ns3
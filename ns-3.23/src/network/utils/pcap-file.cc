@@ -48,7 +48,8 @@ const uint16_t VERSION_MINOR = 4;             /**< Minor version of supported pc
 
 PcapFile::PcapFile ()
   : m_file (),
-    m_swapMode (false)
+    m_swapMode (false),
+    m_asyncBlockSize (0)
 {
   NS_LOG_FUNCTION (this);
   FatalImpl::RegisterStream (&m_file);
@@ -66,6 +67,10 @@ bool
 PcapFile::Fail (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_buffer.GetWriter () != 0)
+    {
+      return m_buffer.GetWriter ()->Fail ();
+    }
   return m_file.fail ();
 }
 bool 
@@ -86,9 +91,24 @@ void
 PcapFile::Close (void)
 {
   NS_LOG_FUNCTION (this);
+  Ptr<AsyncFileWriter> writer = m_buffer.GetWriter ();
+  if (writer != 0)
+    {
+      // Keep the writer attached, so that Fail reports write errors.
+      m_buffer.Flush ();
+      writer->Close ();
+      return;
+    }
   m_file.close ();
 }
 
+void
+PcapFile::SetAsynchronous (uint32_t blockSize)
+{
+  NS_LOG_FUNCTION (this << blockSize);
+  m_asyncBlockSize = blockSize;
+}
+
 uint32_t
 PcapFile::GetMagic (void)
 {
@@ -197,7 +217,10 @@ PcapFile::WriteFileHeader (void)
   // If we're initializing the file, we need to write the pcap file header
   // at the start of the file.
   //
-  m_file.seekp (0, std::ios::beg);
+  if (m_buffer.GetWriter () == 0)
+    {
+      m_file.seekp (0, std::ios::beg);
+    }
  
   //
   // We have the ability to write out the pcap file header in a foreign endian
@@ -225,13 +248,13 @@ PcapFile::WriteFileHeader (void)
   // Watch out for memory alignment differences between machines, so write
   // them all individually.
   //
-  m_file.write ((const char *)&headerOut->m_magicNumber, sizeof(headerOut->m_magicNumber));
-  m_file.write ((const char *)&headerOut->m_versionMajor, sizeof(headerOut->m_versionMajor));
-  m_file.write ((const char *)&headerOut->m_versionMinor, sizeof(headerOut->m_versionMinor));
-  m_file.write ((const char *)&headerOut->m_zone, sizeof(headerOut->m_zone));
-  m_file.write ((const char *)&headerOut->m_sigFigs, sizeof(headerOut->m_sigFigs));
-  m_file.write ((const char *)&headerOut->m_snapLen, sizeof(headerOut->m_snapLen));
-  m_file.write ((const char *)&headerOut->m_type, sizeof(headerOut->m_type));
+  WriteBytes (&headerOut->m_magicNumber, sizeof(headerOut->m_magicNumber));
+  WriteBytes (&headerOut->m_versionMajor, sizeof(headerOut->m_versionMajor));
+  WriteBytes (&headerOut->m_versionMinor, sizeof(headerOut->m_versionMinor));
+  WriteBytes (&headerOut->m_zone, sizeof(headerOut->m_zone));
+  WriteBytes (&headerOut->m_sigFigs, sizeof(headerOut->m_sigFigs));
+  WriteBytes (&headerOut->m_snapLen, sizeof(headerOut->m_snapLen));
+  WriteBytes (&headerOut->m_type, sizeof(headerOut->m_type));
 }
 
 void
@@ -317,6 +340,17 @@ PcapFile::Open (std::string const &filename, std::ios::openmode mode)
   //
   mode |= std::ios::binary;
 
+  m_buffer.SetWriter (0, 0);
+  // Compressed files are always written asynchronously.
+  bool compressed = AsyncFileWriter::GetCompression (filename) != AsyncFileWriter::NONE;
+  if ((m_asyncBlockSize != 0 || compressed) && (mode & std::ios::in) == 0)
+    {
+      Ptr<AsyncFileWriter> writer = Create<AsyncFileWriter> ();
+      writer->Open (filename);
+      m_buffer.SetWriter (writer, m_asyncBlockSize != 0 ? m_asyncBlockSize
+                          : AsyncWriteBuffer::BLOCK_SIZE_DEFAULT);
+      return;
+    }
   m_file.open (filename.c_str (), mode);
   if (mode & std::ios::in)
     {
@@ -393,19 +427,32 @@ PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
   // Watch out for memory alignment differences between machines, so write
   // them all individually.
   //
-  m_file.write ((const char *)&header.m_tsSec, sizeof(header.m_tsSec));
-  m_file.write ((const char *)&header.m_tsUsec, sizeof(header.m_tsUsec));
-  m_file.write ((const char *)&header.m_inclLen, sizeof(header.m_inclLen));
-  m_file.write ((const char *)&header.m_origLen, sizeof(header.m_origLen));
+  WriteBytes (&header.m_tsSec, sizeof(header.m_tsSec));
+  WriteBytes (&header.m_tsUsec, sizeof(header.m_tsUsec));
+  WriteBytes (&header.m_inclLen, sizeof(header.m_inclLen));
+  WriteBytes (&header.m_origLen, sizeof(header.m_origLen));
   return inclLen;
 }
 
+void
+PcapFile::WriteBytes (const void *data, uint32_t size)
+{
+  if (m_buffer.GetWriter () != 0)
+    {
+      m_buffer.Write (data, size);
+    }
+  else
+    {
+      m_file.write ((const char *)data, size);
+    }
+}
+
 void
 PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, uint8_t const * const data, uint32_t totalLen)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << &data << totalLen);
   uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalLen);
-  m_file.write ((const char *)data, inclLen);
+  WriteBytes (data, inclLen);
 }
 
 void 
@@ -413,6 +460,12 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << p);
   uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, p->GetSize ());
+  if (m_buffer.GetWriter () != 0)
+    {
+      // Only the captured bytes are copied out of the packet.
+      p->CopyData (m_buffer.Reserve (inclLen), inclLen);
+      return;
+    }
   p->CopyData (&m_file, inclLen);
 }
 
@@ -428,8 +481,14 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, Header &header, Ptr<const Pack
   headerBuffer.AddAtStart (headerSize);
   header.Serialize (headerBuffer.Begin ());
   uint32_t toCopy = std::min (headerSize, inclLen);
-  headerBuffer.CopyData (&m_file, toCopy);
   inclLen -= toCopy;
+  if (m_buffer.GetWriter () != 0)
+    {
+      headerBuffer.CopyData (m_buffer.Reserve (toCopy), toCopy);
+      p->CopyData (m_buffer.Reserve (inclLen), inclLen);
+      return;
+    }
+  headerBuffer.CopyData (&m_file, toCopy);
   p->CopyData (&m_file, inclLen);
 }
 
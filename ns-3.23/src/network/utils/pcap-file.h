@@ -25,6 +25,7 @@
 #include <fstream>
 #include <stdint.h>
 #include "ns3/ptr.h"
+#include "async-file-writer.h"
 
 namespace ns3 {
 
@@ -85,6 +86,22 @@ public:
    */
   void Close (void);
 
+  /**
+   * Write the file through a background thread. Records are appended
+   * to blocks of blockSize bytes in memory, and each full block is
+   * handed to the AsyncFileWriter thread, so Write never waits for the
+   * disk. Must be called before Open and only applies to files opened
+   * with std::ios::out; the file is complete once Close returns.
+   *
+   * Files whose name ends with ".gz" or ".zst" are always written
+   * this way, and compressed by the background thread (see
+   * AsyncFileWriter).
+   *
+   * \param blockSize The size of the write blocks, or zero to write
+   *   synchronously (the default).
+   */
+  void SetAsynchronous (uint32_t blockSize);
+
   /**
    * Initialize the pcap file associated with this object.  This file must have
    * been previously opened with write permissions.
@@ -343,6 +360,12 @@ private:
    * \returns the length of the packet to write in the Pcap file
    */
   uint32_t WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen);
+  /**
+   * \brief Write bytes to the file or to the asynchronous buffer
+   * \param data The bytes
+   * \param size The number of bytes
+   */
+  void WriteBytes (const void *data, uint32_t size);
 
   /**
    * \brief Read and verify a Pcap file header
@@ -353,6 +376,8 @@ private:
   std::fstream   m_file;        //!< file stream
   PcapFileHeader m_fileHeader;  //!< file header
   bool m_swapMode;              //!< swap mode
+  uint32_t m_asyncBlockSize;    //!< block size of asynchronous writes, or zero
+  AsyncWriteBuffer m_buffer;    //!< asynchronous write buffer
 };
 
 } // namespace ns3
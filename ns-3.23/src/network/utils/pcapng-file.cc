@@ -0,0 +1,271 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ns3/header.h"
+#include "ns3/buffer.h"
+#include "pcapng-file.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PcapngFile");
+
+//
+// Block types and options of the pcapng format. All the fields are
+// written in the byte order of the host, which readers detect from the
+// byte order magic of the section header.
+//
+const uint32_t SECTION_HEADER_BLOCK = 0x0a0d0d0a;   /**< Section Header Block type */
+const uint32_t INTERFACE_DESCRIPTION_BLOCK = 1;     /**< Interface Description Block type */
+const uint32_t ENHANCED_PACKET_BLOCK = 6;           /**< Enhanced Packet Block type */
+const uint32_t BYTE_ORDER_MAGIC = 0x1a2b3c4d;       /**< Byte order magic of the section header */
+const uint16_t VERSION_MAJOR = 1;                   /**< Major version of the pcapng format */
+const uint16_t VERSION_MINOR = 0;                   /**< Minor version of the pcapng format */
+const uint16_t OPT_ENDOFOPT = 0;                    /**< End of the options */
+const uint16_t IF_NAME = 2;                         /**< Interface name option */
+const uint16_t IF_TSRESOL = 9;                      /**< Timestamp resolution option */
+const uint8_t TSRESOL_NS = 9;                       /**< Timestamps in units of 10^-9 s */
+
+/**
+ * \param size A number of bytes.
+ * \returns The number of padding bytes which align size to 32 bits.
+ */
+static uint32_t
+PadLength (uint32_t size)
+{
+  return (4 - (size % 4)) % 4;
+}
+
+/**
+ * Append bytes to a block body.
+ * \param body The block body.
+ * \param data The bytes.
+ * \param size The number of bytes.
+ */
+static void
+Append (std::vector<uint8_t> &body, const void *data, uint32_t size)
+{
+  const uint8_t *bytes = static_cast<const uint8_t *> (data);
+  body.insert (body.end (), bytes, bytes + size);
+}
+
+/**
+ * Append an option to a block body.
+ * \param body The block body.
+ * \param code The option code.
+ * \param data The option value.
+ * \param size The size of the value.
+ */
+static void
+AppendOption (std::vector<uint8_t> &body, uint16_t code, const void *data, uint16_t size)
+{
+  Append (body, &code, sizeof (code));
+  Append (body, &size, sizeof (size));
+  Append (body, data, size);
+  body.resize (body.size () + PadLength (size), 0);
+}
+
+PcapngFile::PcapngFile ()
+  : m_writer (0),
+    m_blockSize (AsyncWriteBuffer::BLOCK_SIZE_DEFAULT)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PcapngFile::~PcapngFile ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+void
+PcapngFile::Open (std::string const &filename, uint32_t blockSize)
+{
+  NS_LOG_FUNCTION (this << filename << blockSize);
+  NS_ASSERT (m_writer == 0);
+  m_writer = Create<AsyncFileWriter> ();
+  m_writer->Open (filename);
+  m_blockSize = blockSize;
+
+  std::vector<uint8_t> body;
+  Append (body, &BYTE_ORDER_MAGIC, sizeof (BYTE_ORDER_MAGIC));
+  Append (body, &VERSION_MAJOR, sizeof (VERSION_MAJOR));
+  Append (body, &VERSION_MINOR, sizeof (VERSION_MINOR));
+  // The length of the section is not known in advance.
+  int64_t sectionLength = -1;
+  Append (body, &sectionLength, sizeof (sectionLength));
+  WriteBlock (SECTION_HEADER_BLOCK, body);
+}
+
+void
+PcapngFile::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_writer == 0)
+    {
+      return;
+    }
+  for (std::vector<Interface>::iterator i = m_interfaces.begin (); i != m_interfaces.end (); ++i)
+    {
+      delete i->buffer;
+    }
+  m_interfaces.clear ();
+  m_writer->Close ();
+  // Keep the writer to report failures.
+}
+
+bool
+PcapngFile::Fail (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_writer == 0 || m_writer->Fail ();
+}
+
+uint32_t
+PcapngFile::AddInterface (std::string const &name, uint32_t dataLinkType, uint32_t snapLen)
+{
+  NS_LOG_FUNCTION (this << name << dataLinkType << snapLen);
+  NS_ASSERT (m_writer != 0);
+
+  std::vector<uint8_t> body;
+  uint16_t linkType = dataLinkType;
+  uint16_t reserved = 0;
+  Append (body, &linkType, sizeof (linkType));
+  Append (body, &reserved, sizeof (reserved));
+  Append (body, &snapLen, sizeof (snapLen));
+  if (!name.empty ())
+    {
+      AppendOption (body, IF_NAME, name.data (), std::min<size_t> (name.size (), 0xffff));
+    }
+  AppendOption (body, IF_TSRESOL, &TSRESOL_NS, sizeof (TSRESOL_NS));
+  AppendOption (body, OPT_ENDOFOPT, 0, 0);
+  // The description goes through the writer before any packet of the
+  // interface can be submitted, so readers always know the interface
+  // by the time they see its packets.
+  WriteBlock (INTERFACE_DESCRIPTION_BLOCK, body);
+
+  Interface interface;
+  interface.dataLinkType = dataLinkType;
+  interface.snapLen = snapLen;
+  interface.buffer = new AsyncWriteBuffer ();
+  interface.buffer->SetWriter (m_writer, m_blockSize);
+  m_interfaces.push_back (interface);
+  return m_interfaces.size () - 1;
+}
+
+uint32_t
+PcapngFile::GetNInterfaces (void) const
+{
+  return m_interfaces.size ();
+}
+
+uint32_t
+PcapngFile::GetDataLinkType (uint32_t interface) const
+{
+  NS_ASSERT (interface < m_interfaces.size ());
+  return m_interfaces[interface].dataLinkType;
+}
+
+uint32_t
+PcapngFile::GetSnapLen (uint32_t interface) const
+{
+  NS_ASSERT (interface < m_interfaces.size ());
+  return m_interfaces[interface].snapLen;
+}
+
+void
+PcapngFile::WriteBlock (uint32_t type, std::vector<uint8_t> const &body)
+{
+  NS_ASSERT (body.size () % 4 == 0);
+  uint32_t totalLen = body.size () + 12;
+  uint8_t *block = new uint8_t [totalLen];
+  std::memcpy (block, &type, 4);
+  std::memcpy (block + 4, &totalLen, 4);
+  if (!body.empty ())
+    {
+      std::memcpy (block + 8, &body[0], body.size ());
+    }
+  std::memcpy (block + 8 + body.size (), &totalLen, 4);
+  m_writer->Submit (block, totalLen);
+}
+
+uint8_t *
+PcapngFile::StartPacket (uint32_t interface, uint64_t ts, uint32_t totalLen, uint32_t &inclLen)
+{
+  NS_ASSERT (interface < m_interfaces.size ());
+  uint32_t snapLen = m_interfaces[interface].snapLen;
+  inclLen = (snapLen != 0 && totalLen > snapLen) ? snapLen : totalLen;
+  uint32_t pad = PadLength (inclLen);
+  uint32_t blockLen = 32 + inclLen + pad;
+
+  uint32_t header[7];
+  header[0] = ENHANCED_PACKET_BLOCK;
+  header[1] = blockLen;
+  header[2] = interface;
+  header[3] = ts >> 32;
+  header[4] = ts & 0xffffffff;
+  header[5] = inclLen;
+  header[6] = totalLen;
+
+  // The whole block is reserved at once: the blocks of an interface
+  // reach the file between the blocks of other interfaces, so a record
+  // must never straddle two of them.
+  uint8_t *block = m_interfaces[interface].buffer->Reserve (blockLen);
+  std::memcpy (block, header, sizeof (header));
+  std::memset (block + 28 + inclLen, 0, pad);
+  std::memcpy (block + blockLen - 4, &blockLen, 4);
+  return block + 28;
+}
+
+void
+PcapngFile::Write (uint32_t interface, uint64_t ts, uint8_t const *data, uint32_t totalLen)
+{
+  NS_LOG_FUNCTION (this << interface << ts << &data << totalLen);
+  uint32_t inclLen;
+  uint8_t *start = StartPacket (interface, ts, totalLen, inclLen);
+  std::memcpy (start, data, inclLen);
+}
+
+void
+PcapngFile::Write (uint32_t interface, uint64_t ts, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << interface << ts << p);
+  uint32_t inclLen;
+  uint8_t *start = StartPacket (interface, ts, p->GetSize (), inclLen);
+  p->CopyData (start, inclLen);
+}
+
+void
+PcapngFile::Write (uint32_t interface, uint64_t ts, Header &header, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << interface << ts << &header << p);
+  uint32_t headerSize = header.GetSerializedSize ();
+  uint32_t inclLen;
+  uint8_t *start = StartPacket (interface, ts, headerSize + p->GetSize (), inclLen);
+
+  Buffer headerBuffer;
+  headerBuffer.AddAtStart (headerSize);
+  header.Serialize (headerBuffer.Begin ());
+  uint32_t fromHeader = std::min (headerSize, inclLen);
+  headerBuffer.CopyData (start, fromHeader);
+  p->CopyData (start + fromHeader, inclLen - fromHeader);
+}
+
+} // namespace ns3
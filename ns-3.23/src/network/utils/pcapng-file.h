@@ -0,0 +1,159 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PCAPNG_FILE_H
+#define PCAPNG_FILE_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+#include "async-file-writer.h"
+
+namespace ns3 {
+
+class Packet;
+class Header;
+
+/**
+ * \brief A pcapng file which captures several interfaces.
+ *
+ * The file holds one section. Each captured device is an interface of
+ * the section, described by an Interface Description Block which gives
+ * its data link type, its snapshot length and its name, and each packet
+ * is an Enhanced Packet Block which carries the identifier of its
+ * interface and a timestamp in nanoseconds.
+ *
+ * The file is written through an AsyncFileWriter, and every interface
+ * has its own AsyncWriteBuffer. Packets of an interface are therefore
+ * written in order, but packets of different interfaces are only
+ * interleaved block by block: readers which need a single timeline
+ * must sort the packets by timestamp. In exchange, interfaces can be
+ * written by different threads without any locking, as long as each
+ * interface is only written by one thread at a time.
+ *
+ * AddInterface must not be called while packets are written.
+ */
+class PcapngFile : public SimpleRefCount<PcapngFile>
+{
+public:
+  PcapngFile ();
+  ~PcapngFile ();
+
+  /**
+   * Create, or truncate, a pcapng file and write its Section Header Block.
+   *
+   * \param filename The name of the file.
+   * \param blockSize The size of the write blocks of each interface.
+   */
+  void Open (std::string const &filename, uint32_t blockSize = AsyncWriteBuffer::BLOCK_SIZE_DEFAULT);
+  /**
+   * Write the buffered packets of all the interfaces and close the file.
+   */
+  void Close (void);
+  /**
+   * \returns true if the file could not be opened or written.
+   */
+  bool Fail (void) const;
+
+  /**
+   * Add an interface to the section.
+   *
+   * \param name The name of the interface, for example the name of the
+   *   pcap file it replaces.
+   * \param dataLinkType The data link type of the packets, as in PcapFile::Init.
+   * \param snapLen The maximum number of bytes captured per packet.
+   * \returns The identifier of the interface, which counts from zero.
+   */
+  uint32_t AddInterface (std::string const &name, uint32_t dataLinkType, uint32_t snapLen);
+  /**
+   * \returns The number of interfaces.
+   */
+  uint32_t GetNInterfaces (void) const;
+  /**
+   * \param interface The identifier of an interface.
+   * \returns The data link type of the interface.
+   */
+  uint32_t GetDataLinkType (uint32_t interface) const;
+  /**
+   * \param interface The identifier of an interface.
+   * \returns The snapshot length of the interface.
+   */
+  uint32_t GetSnapLen (uint32_t interface) const;
+
+  /**
+   * \brief Write a packet.
+   *
+   * \param interface The identifier of the capturing interface.
+   * \param ts The timestamp, in nanoseconds.
+   * \param data The packet bytes.
+   * \param totalLen The size of the packet.
+   */
+  void Write (uint32_t interface, uint64_t ts, uint8_t const *data, uint32_t totalLen);
+  /**
+   * \brief Write a packet.
+   *
+   * Only the bytes within the snapshot length are copied out of the packet.
+   *
+   * \param interface The identifier of the capturing interface.
+   * \param ts The timestamp, in nanoseconds.
+   * \param p The packet.
+   */
+  void Write (uint32_t interface, uint64_t ts, Ptr<const Packet> p);
+  /**
+   * \brief Write a packet.
+   *
+   * \param interface The identifier of the capturing interface.
+   * \param ts The timestamp, in nanoseconds.
+   * \param header A header to write in front of the packet.
+   * \param p The packet.
+   */
+  void Write (uint32_t interface, uint64_t ts, Header &header, Ptr<const Packet> p);
+
+private:
+  /** An interface of the section. */
+  struct Interface
+  {
+    uint32_t dataLinkType;    //!< Data link type.
+    uint32_t snapLen;         //!< Snapshot length.
+    AsyncWriteBuffer *buffer; //!< The buffer of the interface.
+  };
+
+  /**
+   * Submit a complete block which is not written by an interface.
+   * \param type The block type.
+   * \param body The block body, padded to 32 bits.
+   */
+  void WriteBlock (uint32_t type, std::vector<uint8_t> const &body);
+  /**
+   * Reserve and fill all of an Enhanced Packet Block but its data.
+   * \param interface The identifier of the capturing interface.
+   * \param ts The timestamp, in nanoseconds.
+   * \param totalLen The size of the packet.
+   * \param [out] inclLen The number of packet bytes to write.
+   * \returns Where to write the packet bytes.
+   */
+  uint8_t *StartPacket (uint32_t interface, uint64_t ts, uint32_t totalLen, uint32_t &inclLen);
+
+  Ptr<AsyncFileWriter> m_writer;       //!< The file.
+  uint32_t m_blockSize;                //!< Size of the write blocks.
+  std::vector<Interface> m_interfaces; //!< The interfaces.
+};
+
+} // namespace ns3
+
+#endif /* PCAPNG_FILE_H */
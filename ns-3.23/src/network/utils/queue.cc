@@ -191,6 +191,26 @@ Queue::ResetStatistics (void)
   m_nTotalDroppedPackets = 0;
 }
 
+void
+Queue::SaveCheckpoint (CheckpointWriter &writer) const
+{
+  NS_LOG_FUNCTION (this << &writer);
+  writer.WriteU32 (m_nTotalReceivedBytes);
+  writer.WriteU32 (m_nTotalReceivedPackets);
+  writer.WriteU32 (m_nTotalDroppedBytes);
+  writer.WriteU32 (m_nTotalDroppedPackets);
+}
+
+void
+Queue::RestoreCheckpoint (CheckpointReader &reader)
+{
+  NS_LOG_FUNCTION (this << &reader);
+  m_nTotalReceivedBytes = reader.ReadU32 ();
+  m_nTotalReceivedPackets = reader.ReadU32 ();
+  m_nTotalDroppedBytes = reader.ReadU32 ();
+  m_nTotalDroppedPackets = reader.ReadU32 ();
+}
+
 void
 Queue::Drop (Ptr<Packet> p)
 {
@@ -28,6 +28,7 @@
 #include <list>
 #include "ns3/packet.h"
 #include "ns3/object.h"
+#include "ns3/checkpoint.h"
 #include "ns3/traced-callback.h"
 
 namespace ns3 {
@@ -42,7 +43,7 @@ namespace ns3 {
  * 
  * This class defines the base APIs for packet queues in the ns-3 system
  */
-class Queue : public Object
+class Queue : public Object, public Checkpointable
 {
 public:
   /**
@@ -119,6 +120,19 @@ public:
    */
   void ResetStatistics (void);
 
+  /**
+   * Save the statistics of the queue. Subclasses must save their
+   * packets after calling this method.
+   * \param [in] writer Where to save the state.
+   */
+  virtual void SaveCheckpoint (CheckpointWriter &writer) const;
+  /**
+   * Restore the statistics of the queue. Subclasses must restore
+   * their packets after calling this method.
+   * \param [in] reader Where to read the state.
+   */
+  virtual void RestoreCheckpoint (CheckpointReader &reader);
+
   /**
    * \brief Enumeration of the modes supported in the class.
    *
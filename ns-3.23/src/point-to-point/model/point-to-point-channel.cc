@@ -20,6 +20,7 @@
 #include "point-to-point-net-device.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/packet.h"
+#include "ns3/node.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 
@@ -80,6 +81,29 @@ PointToPointChannel::Attach (Ptr<PointToPointNetDevice> device)
       m_link[1].m_dst = m_link[0].m_src;
       m_link[0].m_state = IDLE;
       m_link[1].m_state = IDLE;
+      UpdateWires ();
+    }
+}
+
+void
+PointToPointChannel::UpdateWires (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_nDevices < N_DEVICES)
+    {
+      return;
+    }
+  for (uint32_t wire = 0; wire < N_DEVICES; ++wire)
+    {
+      Link &link = m_link[wire];
+      Ptr<Node> srcNode = link.m_src->GetNode ();
+      Ptr<Node> dstNode = link.m_dst->GetNode ();
+      link.m_nodesKnown = srcNode != 0 && dstNode != 0;
+      if (link.m_nodesKnown)
+        {
+          link.m_dstContext = dstNode->GetId ();
+          link.m_crossPartition = srcNode->GetSystemId () != dstNode->GetSystemId ();
+        }
     }
 }
 
@@ -96,13 +120,67 @@ PointToPointChannel::TransmitStart (
   NS_ASSERT (m_link[1].m_state != INITIALIZING);
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
+  const Link &link = m_link[wire];
+  NS_ASSERT_MSG (link.m_nodesKnown, "Both devices must be added to a node");
 
-  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
+  if (link.m_crossPartition)
+    {
+      // The receiving device belongs to another partition, which may run
+      // on another thread: hand it a copy of the packet and a raw pointer,
+      // without touching its reference count.
+      Simulator::ScheduleWithContext (link.m_dstContext,
+                                      txTime + m_delay, &PointToPointNetDevice::Receive,
+                                      PeekPointer (link.m_dst), p->DeepCopy ());
+      return true;
+    }
+
+  Simulator::ScheduleWithContext (link.m_dstContext,
                                   txTime + m_delay, &PointToPointNetDevice::Receive,
-                                  m_link[wire].m_dst, p);
+                                  link.m_dst, p);
 
   // Call the tx anim callback on the net device
-  m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
+  m_txrxPointToPoint (p, src, link.m_dst, txTime, txTime + m_delay);
+  return true;
+}
+
+bool
+PointToPointChannel::TransmitStartBatch (
+  const std::vector<Ptr<Packet> > &packets,
+  Ptr<PointToPointNetDevice> src,
+  Time txTime)
+{
+  NS_LOG_FUNCTION (this << packets.size () << src);
+
+  NS_ASSERT (m_link[0].m_state != INITIALIZING);
+  NS_ASSERT (m_link[1].m_state != INITIALIZING);
+
+  uint32_t wire = src == m_link[0].m_src ? 0 : 1;
+  const Link &link = m_link[wire];
+  NS_ASSERT_MSG (link.m_nodesKnown, "Both devices must be added to a node");
+
+  if (link.m_crossPartition)
+    {
+      // See TransmitStart
+      std::vector<Ptr<Packet> > received;
+      received.reserve (packets.size ());
+      for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+        {
+          received.push_back ((*i)->DeepCopy ());
+        }
+      Simulator::ScheduleWithContext (link.m_dstContext,
+                                      txTime + m_delay, &PointToPointNetDevice::ReceiveBatch,
+                                      PeekPointer (link.m_dst), received);
+      return true;
+    }
+
+  Simulator::ScheduleWithContext (link.m_dstContext,
+                                  txTime + m_delay, &PointToPointNetDevice::ReceiveBatch,
+                                  link.m_dst, packets);
+
+  for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+    {
+      m_txrxPointToPoint (*i, src, link.m_dst, txTime, txTime + m_delay);
+    }
   return true;
 }
 
@@ -20,6 +20,7 @@
 #define POINT_TO_POINT_CHANNEL_H
 
 #include <list>
+#include <vector>
 #include "ns3/channel.h"
 #include "ns3/ptr.h"
 #include "ns3/nstime.h"
@@ -80,6 +81,20 @@ public:
    */
   virtual bool TransmitStart (Ptr<Packet> p, Ptr<PointToPointNetDevice> src, Time txTime);
 
+  /**
+   * \brief Transmit a train of packets over this channel
+   *
+   * The whole train is received by the other end in a single event, when
+   * its last packet has arrived.
+   *
+   * \param packets Packets to transmit, in order
+   * \param src Source PointToPointNetDevice
+   * \param txTime Time to transmit the whole train
+   * \returns true if successful (currently always true)
+   */
+  virtual bool TransmitStartBatch (const std::vector<Ptr<Packet> > &packets,
+                                   Ptr<PointToPointNetDevice> src, Time txTime);
+
   /**
    * \brief Get number of devices on this channel
    * \returns number of devices on this channel
@@ -147,6 +162,19 @@ private:
   /** Each point to point link has exactly two net devices. */
   static const int N_DEVICES = 2;
 
+  friend class PointToPointNetDevice;
+
+  /**
+   * \brief Record the receiving context and partition of each wire
+   *
+   * Called when the second device is attached and whenever an attached
+   * device is added to a node, before the simulation runs, so that
+   * TransmitStart never has to look at the node of the receiving device,
+   * which may belong to another partition running on another thread
+   * (see MultithreadedSimulatorImpl).
+   */
+  void UpdateWires (void);
+
   Time          m_delay;    //!< Propagation delay
   int32_t       m_nDevices; //!< Devices of this channel
 
@@ -157,6 +185,10 @@ private:
    * net device, receiving net device, transmission time and 
    * packet receipt time.
    *
+   * Not fired for the packets sent to a node of another partition
+   * (see MultithreadedSimulatorImpl), since the receiving device is
+   * owned by another thread.
+   *
    * \see class CallBackTraceSource
    */
   TracedCallback<Ptr<const Packet>, // Packet being transmitted
@@ -190,11 +222,15 @@ public:
     /** \brief Create the link, it will be in INITIALIZING state
      *
      */
-    Link() : m_state (INITIALIZING), m_src (0), m_dst (0) {}
+    Link() : m_state (INITIALIZING), m_src (0), m_dst (0),
+             m_nodesKnown (false), m_dstContext (0), m_crossPartition (false) {}
 
     WireState                  m_state; //!< State of the link
     Ptr<PointToPointNetDevice> m_src;   //!< First NetDevice
     Ptr<PointToPointNetDevice> m_dst;   //!< Second NetDevice
+    bool     m_nodesKnown;     //!< Both devices have been added to a node
+    uint32_t m_dstContext;     //!< Id of the node of m_dst
+    bool     m_crossPartition; //!< The two nodes have different system ids
   };
 
   Link    m_link[N_DEVICES]; //!< Link model
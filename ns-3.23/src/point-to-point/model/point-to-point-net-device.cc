@@ -214,6 +214,8 @@ PointToPointNetDevice::DoDispose ()
   m_channel = 0;
   m_receiveErrorModel = 0;
   m_currentPkt = 0;
+  m_currentTrain.clear ();
+  m_txTrains.clear ();
   NetDevice::DoDispose ();
 }
 
@@ -275,26 +277,122 @@ PointToPointNetDevice::TransmitComplete (void)
   NS_ASSERT_MSG (m_txMachineState == BUSY, "Must be BUSY if transmitting");
   m_txMachineState = READY;
 
-  NS_ASSERT_MSG (m_currentPkt != 0, "PointToPointNetDevice::TransmitComplete(): m_currentPkt zero");
+  if (m_currentTrain.empty ())
+    {
+      NS_ASSERT_MSG (m_currentPkt != 0, "PointToPointNetDevice::TransmitComplete(): m_currentPkt zero");
 
-  m_phyTxEndTrace (m_currentPkt);
-  m_currentPkt = 0;
+      m_phyTxEndTrace (m_currentPkt);
+      m_currentPkt = 0;
+    }
+  else
+    {
+      for (std::vector<Ptr<Packet> >::const_iterator i = m_currentTrain.begin ();
+           i != m_currentTrain.end (); ++i)
+        {
+          m_phyTxEndTrace (*i);
+        }
+      m_currentTrain.clear ();
+    }
+
+  TransmitNext ();
+}
+
+bool
+PointToPointNetDevice::TransmitStartBatch (const std::vector<Ptr<Packet> > &packets)
+{
+  NS_LOG_FUNCTION (this << packets.size ());
 
-  Ptr<Packet> p = m_queue->Dequeue ();
-  if (p == 0)
+  NS_ASSERT_MSG (m_txMachineState == READY, "Must be READY to transmit");
+  m_txMachineState = BUSY;
+  m_currentTrain = packets;
+
+  //
+  // The train ends with its last packet; the interframe gap after it is
+  // only waited for by the transmitter.
+  //
+  Time txTime = Seconds (0);
+  for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
     {
+      m_phyTxBeginTrace (*i);
+      if (i != packets.begin ())
+        {
+          txTime += m_tInterframeGap;
+        }
+      txTime += m_bps.CalculateBytesTxTime ((*i)->GetSize ());
+    }
+  Time txCompleteTime = txTime + m_tInterframeGap;
+
+  NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << txCompleteTime.GetSeconds () << "sec");
+  Simulator::Schedule (txCompleteTime, &PointToPointNetDevice::TransmitComplete, this);
+
+  bool result = m_channel->TransmitStartBatch (packets, this, txTime);
+  if (result == false)
+    {
+      for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+        {
+          m_phyTxDropTrace (*i);
+        }
+    }
+  return result;
+}
+
+void
+PointToPointNetDevice::TransmitNext (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t n = 1;
+  if (!m_txTrains.empty ())
+    {
+      n = m_txTrains.front ();
+      m_txTrains.pop_front ();
+    }
+
+  if (n == 1)
+    {
+      Ptr<Packet> p = m_queue->Dequeue ();
+      if (p == 0)
+        {
+          //
+          // No packet was on the queue, so we just exit.  The queue may
+          // have dropped packets of the trains we knew about.
+          //
+          m_txTrains.clear ();
+          return;
+        }
+
       //
-      // No packet was on the queue, so we just exit.
+      // Got another packet off of the queue, so start the transmit process agin.
       //
+      m_snifferTrace (p);
+      m_promiscSnifferTrace (p);
+      TransmitStart (p);
       return;
     }
 
-  //
-  // Got another packet off of the queue, so start the transmit process agin.
-  //
-  m_snifferTrace (p);
-  m_promiscSnifferTrace (p);
-  TransmitStart (p);
+  std::vector<Ptr<Packet> > train;
+  train.reserve (n);
+  while (train.size () < n)
+    {
+      Ptr<Packet> p = m_queue->Dequeue ();
+      if (p == 0)
+        {
+          m_txTrains.clear ();
+          break;
+        }
+      m_snifferTrace (p);
+      m_promiscSnifferTrace (p);
+      train.push_back (p);
+    }
+
+  if (train.size () == 1)
+    {
+      TransmitStart (train.front ());
+    }
+  else if (!train.empty ())
+    {
+      TransmitStartBatch (train);
+    }
 }
 
 bool
@@ -335,6 +433,59 @@ PointToPointNetDevice::Receive (Ptr<Packet> packet)
   NS_LOG_FUNCTION (this << packet);
   uint16_t protocol = 0;
 
+  if (DoReceive (packet, protocol))
+    {
+      m_rxCallback (this, packet, protocol, GetRemote ());
+    }
+}
+
+void
+PointToPointNetDevice::ReceiveBatch (std::vector<Ptr<Packet> > packets)
+{
+  NS_LOG_FUNCTION (this << packets.size ());
+
+  if (m_rxBatchCallback.IsNull ())
+    {
+      for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+        {
+          Receive (*i);
+        }
+      return;
+    }
+
+  //
+  // Forward the runs of packets of the same protocol up the stack
+  // together, once the whole train went through the receive path.
+  //
+  Address remote = GetRemote ();
+  std::vector<Ptr<const Packet> > run;
+  uint16_t runProtocol = 0;
+  for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+    {
+      uint16_t protocol = 0;
+      if (!DoReceive (*i, protocol))
+        {
+          continue;
+        }
+      if (!run.empty () && protocol != runProtocol)
+        {
+          m_rxBatchCallback (this, run, runProtocol, remote);
+          run.clear ();
+        }
+      run.push_back (*i);
+      runProtocol = protocol;
+    }
+  if (!run.empty ())
+    {
+      m_rxBatchCallback (this, run, runProtocol, remote);
+    }
+}
+
+bool
+PointToPointNetDevice::DoReceive (Ptr<Packet> packet, uint16_t &protocol)
+{
+  NS_LOG_FUNCTION (this << packet);
+
   if (m_receiveErrorModel && m_receiveErrorModel->IsCorrupt (packet) ) 
     {
       // 
@@ -375,8 +526,9 @@ PointToPointNetDevice::Receive (Ptr<Packet> packet)
         }
 
       m_macRxTrace (originalPacket);
-      m_rxCallback (this, packet, protocol, GetRemote ());
+      return true;
     }
+  return false;
 }
 
 Ptr<Queue>
@@ -547,6 +699,10 @@ PointToPointNetDevice::Send (
           m_promiscSnifferTrace (packet);
           return TransmitStart (packet);
         }
+      if (!m_txTrains.empty ())
+        {
+          m_txTrains.push_back (1);
+        }
       return true;
     }
 
@@ -555,6 +711,55 @@ PointToPointNetDevice::Send (
   return false;
 }
 
+uint32_t
+PointToPointNetDevice::SendBatch (const std::vector<Ptr<Packet> > &packets,
+                                  const Address &dest,
+                                  uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (this << packets.size () << dest << protocolNumber);
+
+  if (IsLinkUp () == false)
+    {
+      for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+        {
+          m_macTxDropTrace (*i);
+        }
+      return 0;
+    }
+
+  if (m_txTrains.empty ())
+    {
+      //
+      // The packets already queued by Send go out one by one.
+      //
+      m_txTrains.assign (m_queue->GetNPackets (), 1);
+    }
+
+  uint32_t sent = 0;
+  for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+    {
+      Ptr<Packet> packet = *i;
+      AddHeader (packet, protocolNumber);
+      m_macTxTrace (packet);
+      if (!m_queue->Enqueue (packet))
+        {
+          m_macTxDropTrace (packet);
+          break;
+        }
+      sent++;
+    }
+
+  if (sent > 0)
+    {
+      m_txTrains.push_back (sent);
+      if (m_txMachineState == READY)
+        {
+          TransmitNext ();
+        }
+    }
+  return sent;
+}
+
 bool
 PointToPointNetDevice::SendFrom (Ptr<Packet> packet, 
                                  const Address &source, 
@@ -576,6 +781,10 @@ PointToPointNetDevice::SetNode (Ptr<Node> node)
 {
   NS_LOG_FUNCTION (this);
   m_node = node;
+  if (m_channel != 0)
+    {
+      m_channel->UpdateWires ();
+    }
 }
 
 bool
@@ -591,6 +800,12 @@ PointToPointNetDevice::SetReceiveCallback (NetDevice::ReceiveCallback cb)
   m_rxCallback = cb;
 }
 
+void
+PointToPointNetDevice::SetReceiveBatchCallback (NetDevice::ReceiveBatchCallback cb)
+{
+  m_rxBatchCallback = cb;
+}
+
 void
 PointToPointNetDevice::SetPromiscReceiveCallback (NetDevice::PromiscReceiveCallback cb)
 {
@@ -20,6 +20,8 @@
 #define POINT_TO_POINT_NET_DEVICE_H
 
 #include <cstring>
+#include <deque>
+#include <vector>
 #include "ns3/address.h"
 #include "ns3/node.h"
 #include "ns3/net-device.h"
@@ -149,6 +151,17 @@ public:
    */
   void Receive (Ptr<Packet> p);
 
+  /**
+   * Receive a train of packets from a connected PointToPointChannel.
+   *
+   * The packets go through the same receive path as with Receive, but
+   * consecutive packets of the same protocol are forwarded up the stack
+   * together when a ReceiveBatchCallback is set.
+   *
+   * \param packets The received packets, in order.
+   */
+  void ReceiveBatch (std::vector<Ptr<Packet> > packets);
+
   // The remaining methods are documented in ns3::NetDevice*
 
   virtual void SetIfIndex (const uint32_t index);
@@ -182,6 +195,23 @@ public:
 
   virtual bool Send (Ptr<Packet> packet, const Address &dest, uint16_t protocolNumber);
   virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber);
+  /**
+   * Send a burst of packets.
+   *
+   * The packets are queued like with Send. When the transmitter reaches
+   * them, they are sent back to back as a single train: the transmission
+   * of the whole train is one event on this device, and its reception is
+   * one event on the peer device, when the last packet of the train has
+   * arrived. The first packets of a train are therefore received later
+   * than if they had been sent one by one.
+   *
+   * \param packets The packets to send.
+   * \param dest The destination address.
+   * \param protocolNumber The protocol of the packets.
+   * \returns The number of packets, counted from the first one, which
+   *          were queued.
+   */
+  virtual uint32_t SendBatch (const std::vector<Ptr<Packet> > &packets, const Address &dest, uint16_t protocolNumber);
 
   virtual Ptr<Node> GetNode (void) const;
   virtual void SetNode (Ptr<Node> node);
@@ -189,6 +219,7 @@ public:
   virtual bool NeedsArp (void) const;
 
   virtual void SetReceiveCallback (NetDevice::ReceiveCallback cb);
+  virtual void SetReceiveBatchCallback (NetDevice::ReceiveBatchCallback cb);
 
   virtual Address GetMulticast (Ipv6Address addr) const;
 
@@ -272,6 +303,34 @@ private:
    */
   bool TransmitStart (Ptr<Packet> p);
 
+  /**
+   * Start sending a train of packets down the wire.
+   *
+   * The packets are sent back to back, separated by the interframe gap,
+   * and TransmitComplete is only called at the end of the train.
+   *
+   * \see PointToPointChannel::TransmitStartBatch ()
+   * \param packets the packets to send
+   * \returns true if success, false on failure
+   */
+  bool TransmitStartBatch (const std::vector<Ptr<Packet> > &packets);
+
+  /**
+   * Dequeue the next packet, or the next train of packets queued by
+   * SendBatch, and start sending it.
+   */
+  void TransmitNext (void);
+
+  /**
+   * Run a received packet through the error model, the receive traces
+   * and the promiscuous callback, and remove its header.
+   *
+   * \param packet the received packet
+   * \param [out] protocol the protocol of the packet
+   * \returns true if the packet must be forwarded up the stack
+   */
+  bool DoReceive (Ptr<Packet> packet, uint16_t &protocol);
+
   /**
    * Stop Sending a Packet Down the Wire and Begin the Interframe Gap.
    *
@@ -442,6 +501,7 @@ private:
   Ptr<Node> m_node;         //!< Node owning this NetDevice
   Mac48Address m_address;   //!< Mac48Address of this NetDevice
   NetDevice::ReceiveCallback m_rxCallback;   //!< Receive callback
+  NetDevice::ReceiveBatchCallback m_rxBatchCallback; //!< Receive callback for trains
   NetDevice::PromiscReceiveCallback m_promiscCallback;  //!< Receive callback
                                                         //   (promisc data)
   uint32_t m_ifIndex; //!< Index of the interface
@@ -461,6 +521,14 @@ private:
   uint32_t m_mtu;
 
   Ptr<Packet> m_currentPkt; //!< Current packet processed
+  std::vector<Ptr<Packet> > m_currentTrain; //!< Current train processed, if any
+
+  /**
+   * The sizes of the trains waiting in the queue, in order. It is only
+   * used while trains are queued, and then counts single packets as
+   * trains of one packet.
+   */
+  std::deque<uint32_t> m_txTrains;
 
   /**
    * \brief PPP to Ethernet protocol number mapping
@@ -76,4 +76,18 @@ PointToPointRemoteChannel::TransmitStart (
   return true;
 }
 
+bool
+PointToPointRemoteChannel::TransmitStartBatch (
+  const std::vector<Ptr<Packet> > &packets,
+  Ptr<PointToPointNetDevice> src,
+  Time txTime)
+{
+  NS_LOG_FUNCTION (this << packets.size () << src);
+  for (std::vector<Ptr<Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+    {
+      TransmitStart (*i, src, txTime);
+    }
+  return true;
+}
+
 } // namespace ns3
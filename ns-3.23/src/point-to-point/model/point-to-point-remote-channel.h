@@ -68,6 +68,20 @@ public:
    */
   virtual bool TransmitStart (Ptr<Packet> p, Ptr<PointToPointNetDevice> src,
                               Time txTime);
+
+  /**
+   * \brief Transmit a train of packets
+   *
+   * Each packet is sent on its own, and they all arrive with the end of
+   * the train.
+   *
+   * \param packets Packets to transmit
+   * \param src Source PointToPointNetDevice
+   * \param txTime Time to transmit the whole train
+   * \returns true if successful (currently always true)
+   */
+  virtual bool TransmitStartBatch (const std::vector<Ptr<Packet> > &packets,
+                                   Ptr<PointToPointNetDevice> src, Time txTime);
 };
 
 } // namespace ns3
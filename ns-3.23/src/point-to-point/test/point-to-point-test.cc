@@ -3,6 +3,11 @@
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/data-rate.h"
+#include "ns3/nstime.h"
+#include "ns3/node.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/default-simulator-impl.h"
 
 using namespace ns3;
 
@@ -73,6 +78,350 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Test the transmission of packet trains
+ *
+ * It sends a burst of packets, a single packet and a second burst, and
+ * checks that the bursts are received as trains, when their last packet
+ * has arrived, while the single packet is received on its own.
+ */
+class PointToPointBatchTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointBatchTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send the packets to the device specified
+   *
+   * \param device NetDevice to send to
+   */
+  void SendPackets (Ptr<PointToPointNetDevice> device);
+  /**
+   * \brief Receive a single packet
+   * \param device the receiving device
+   * \param packet the packet
+   * \param protocol the protocol
+   * \param from the sender
+   * \param to the receiver
+   * \param packetType the packet type
+   */
+  void ReceiveOne (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                   const Address &from, const Address &to, NetDevice::PacketType packetType);
+  /**
+   * \brief Receive a train of packets
+   * \param device the receiving device
+   * \param packets the packets
+   * \param protocol the protocol
+   * \param from the sender
+   * \param to the receiver
+   * \param packetType the packet type
+   */
+  void ReceiveBatch (Ptr<NetDevice> device, const std::vector<Ptr<const Packet> > &packets, uint16_t protocol,
+                     const Address &from, const Address &to, NetDevice::PacketType packetType);
+
+  std::vector<uint32_t> m_sizes; //!< Sizes of the received packets, in order
+  std::vector<double> m_times;   //!< Reception times of the single packets and of the trains
+  uint32_t m_singles;            //!< Number of single packets received
+  uint32_t m_batches;            //!< Number of trains received
+};
+
+PointToPointBatchTest::PointToPointBatchTest ()
+  : TestCase ("PointToPoint packet trains"),
+    m_singles (0),
+    m_batches (0)
+{
+}
+
+void
+PointToPointBatchTest::SendPackets (Ptr<PointToPointNetDevice> device)
+{
+  std::vector<Ptr<Packet> > burst;
+  burst.push_back (Create<Packet> (100));
+  burst.push_back (Create<Packet> (200));
+  burst.push_back (Create<Packet> (300));
+  uint32_t sent = device->SendBatch (burst, device->GetBroadcast (), 0x800);
+  NS_TEST_EXPECT_MSG_EQ (sent, 3, "The first burst should be accepted");
+
+  device->Send (Create<Packet> (50), device->GetBroadcast (), 0x800);
+
+  burst.clear ();
+  burst.push_back (Create<Packet> (10));
+  burst.push_back (Create<Packet> (20));
+  sent = device->SendBatch (burst, device->GetBroadcast (), 0x800);
+  NS_TEST_EXPECT_MSG_EQ (sent, 2, "The second burst should be accepted");
+}
+
+void
+PointToPointBatchTest::ReceiveOne (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                                   const Address &from, const Address &to, NetDevice::PacketType packetType)
+{
+  m_singles++;
+  m_sizes.push_back (packet->GetSize ());
+  m_times.push_back (Simulator::Now ().GetSeconds ());
+}
+
+void
+PointToPointBatchTest::ReceiveBatch (Ptr<NetDevice> device, const std::vector<Ptr<const Packet> > &packets, uint16_t protocol,
+                                     const Address &from, const Address &to, NetDevice::PacketType packetType)
+{
+  m_batches++;
+  for (std::vector<Ptr<const Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+    {
+      m_sizes.push_back ((*i)->GetSize ());
+    }
+  m_times.push_back (Simulator::Now ().GetSeconds ());
+  NS_TEST_EXPECT_MSG_EQ (protocol, 0x800, "Wrong protocol");
+}
+
+void
+PointToPointBatchTest::DoRun (void)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MilliSeconds (1)));
+
+  // one byte per microsecond
+  devA->SetDataRate (DataRate ("8Mbps"));
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue> ());
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  b->RegisterProtocolHandler (MakeCallback (&PointToPointBatchTest::ReceiveOne, this),
+                              MakeCallback (&PointToPointBatchTest::ReceiveBatch, this),
+                              0x800, devB);
+
+  Simulator::Schedule (Seconds (1.0), &PointToPointBatchTest::SendPackets, this, devA);
+
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_batches, 2, "The bursts should be received as trains");
+  NS_TEST_ASSERT_MSG_EQ (m_singles, 1, "The single packet should be received on its own");
+  NS_TEST_ASSERT_MSG_EQ (m_sizes.size (), 6, "Wrong number of packets");
+  uint32_t sizes[] = { 100, 200, 300, 50, 10, 20 };
+  for (uint32_t i = 0; i < 6; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_sizes[i], sizes[i], "Packet " << i << " out of order");
+    }
+
+  // each packet carries a two byte PPP header, and transmission times
+  // are truncated to the nanosecond
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_times[0], 1.001606, 1e-8, "First train received at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_times[1], 1.001658, 1e-8, "Single packet received at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_times[2], 1.001692, 1e-8, "Second train received at the wrong time");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test the transmission of packets between partitions
+ *
+ * Two nodes in different partitions of a MultithreadedSimulatorImpl
+ * send each other a burst, a single packet and a second burst at the
+ * same time, so that both partitions send and receive concurrently.
+ * Each node must receive the packets of the other one, in order and at
+ * the same times as in a sequential run, and the TxRxPointToPoint trace
+ * must not be fired for them.
+ */
+class PointToPointCrossPartitionTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointCrossPartitionTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send the packets to the device specified
+   *
+   * \param device NetDevice to send to
+   * \param node the index of the sending node
+   */
+  void SendPackets (PointToPointNetDevice *device, uint32_t node);
+  /**
+   * \brief Receive a single packet
+   * \param device the receiving device
+   * \param packet the packet
+   * \param protocol the protocol
+   * \param from the sender
+   * \param to the receiver
+   * \param packetType the packet type
+   */
+  void ReceiveOne (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                   const Address &from, const Address &to, NetDevice::PacketType packetType);
+  /**
+   * \brief Receive a train of packets
+   * \param device the receiving device
+   * \param packets the packets
+   * \param protocol the protocol
+   * \param from the sender
+   * \param to the receiver
+   * \param packetType the packet type
+   */
+  void ReceiveBatch (Ptr<NetDevice> device, const std::vector<Ptr<const Packet> > &packets, uint16_t protocol,
+                     const Address &from, const Address &to, NetDevice::PacketType packetType);
+  /**
+   * \brief Count the TxRxPointToPoint trace events
+   * \param packet the packet
+   * \param txDevice the transmitting device
+   * \param rxDevice the receiving device
+   * \param duration the transmission time
+   * \param lastBitTime the last bit receive time
+   */
+  void TxRx (Ptr<const Packet> packet, Ptr<NetDevice> txDevice, Ptr<NetDevice> rxDevice,
+             Time duration, Time lastBitTime);
+
+  // each partition only writes to the entries of its own node
+  std::vector<uint32_t> m_sizes[2]; //!< Sizes of the packets received by each node, in order
+  std::vector<double> m_times[2];   //!< Reception times of the single packets and of the trains
+  uint32_t m_sent[2];               //!< Number of packets accepted by the device of each node
+  uint32_t m_singles[2];            //!< Number of single packets received by each node
+  uint32_t m_batches[2];            //!< Number of trains received by each node
+  uint32_t m_txrx;                  //!< Number of TxRxPointToPoint trace events
+};
+
+PointToPointCrossPartitionTest::PointToPointCrossPartitionTest ()
+  : TestCase ("PointToPoint traffic between partitions"),
+    m_txrx (0)
+{
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      m_sent[i] = 0;
+      m_singles[i] = 0;
+      m_batches[i] = 0;
+    }
+}
+
+void
+PointToPointCrossPartitionTest::SendPackets (PointToPointNetDevice *device, uint32_t node)
+{
+  // the sizes tell the two senders apart
+  uint32_t base = node * 1000;
+  std::vector<Ptr<Packet> > burst;
+  burst.push_back (Create<Packet> (base + 100));
+  burst.push_back (Create<Packet> (base + 200));
+  burst.push_back (Create<Packet> (base + 300));
+  m_sent[node] += device->SendBatch (burst, device->GetBroadcast (), 0x800);
+
+  if (device->Send (Create<Packet> (base + 50), device->GetBroadcast (), 0x800))
+    {
+      m_sent[node]++;
+    }
+
+  burst.clear ();
+  burst.push_back (Create<Packet> (base + 10));
+  burst.push_back (Create<Packet> (base + 20));
+  m_sent[node] += device->SendBatch (burst, device->GetBroadcast (), 0x800);
+}
+
+void
+PointToPointCrossPartitionTest::ReceiveOne (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                                            const Address &from, const Address &to, NetDevice::PacketType packetType)
+{
+  uint32_t node = device->GetNode ()->GetSystemId ();
+  m_singles[node]++;
+  m_sizes[node].push_back (packet->GetSize ());
+  m_times[node].push_back (Simulator::Now ().GetSeconds ());
+}
+
+void
+PointToPointCrossPartitionTest::ReceiveBatch (Ptr<NetDevice> device, const std::vector<Ptr<const Packet> > &packets, uint16_t protocol,
+                                              const Address &from, const Address &to, NetDevice::PacketType packetType)
+{
+  uint32_t node = device->GetNode ()->GetSystemId ();
+  m_batches[node]++;
+  for (std::vector<Ptr<const Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+    {
+      m_sizes[node].push_back ((*i)->GetSize ());
+    }
+  m_times[node].push_back (Simulator::Now ().GetSeconds ());
+}
+
+void
+PointToPointCrossPartitionTest::TxRx (Ptr<const Packet> packet, Ptr<NetDevice> txDevice, Ptr<NetDevice> rxDevice,
+                                      Time duration, Time lastBitTime)
+{
+  m_txrx++;
+}
+
+void
+PointToPointCrossPartitionTest::DoRun (void)
+{
+  Ptr<MultithreadedSimulatorImpl> impl = CreateObject<MultithreadedSimulatorImpl> ();
+  Simulator::Destroy ();
+  Simulator::SetImplementation (impl);
+
+  Ptr<Node> nodes[2];
+  Ptr<PointToPointNetDevice> devices[2];
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MilliSeconds (1)));
+  channel->TraceConnectWithoutContext ("TxRxPointToPoint",
+                                       MakeCallback (&PointToPointCrossPartitionTest::TxRx, this));
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      nodes[i] = CreateObject<Node> (i);
+      devices[i] = CreateObject<PointToPointNetDevice> ();
+      // one byte per microsecond
+      devices[i]->SetDataRate (DataRate ("8Mbps"));
+      devices[i]->SetAddress (Mac48Address::Allocate ());
+      devices[i]->SetQueue (CreateObject<DropTailQueue> ());
+      nodes[i]->AddDevice (devices[i]);
+      devices[i]->Attach (channel);
+      nodes[i]->RegisterProtocolHandler (MakeCallback (&PointToPointCrossPartitionTest::ReceiveOne, this),
+                                         MakeCallback (&PointToPointCrossPartitionTest::ReceiveBatch, this),
+                                         0x800, devices[i]);
+      Simulator::ScheduleWithContext (nodes[i]->GetId (), Seconds (1.0),
+                                      &PointToPointCrossPartitionTest::SendPackets, this,
+                                      PeekPointer (devices[i]), i);
+    }
+
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (impl->GetPartitionCount (), 2, "The nodes should run in two partitions");
+  NS_TEST_EXPECT_MSG_EQ (m_txrx, 0, "The trace should not be fired between partitions");
+  for (uint32_t node = 0; node < 2; ++node)
+    {
+      uint32_t base = (1 - node) * 1000;
+      NS_TEST_ASSERT_MSG_EQ (m_sent[1 - node], 6, "Node " << 1 - node << " should send all its packets");
+      NS_TEST_ASSERT_MSG_EQ (m_batches[node], 2, "Node " << node << " should receive the bursts as trains");
+      NS_TEST_ASSERT_MSG_EQ (m_singles[node], 1, "Node " << node << " should receive the single packet on its own");
+      NS_TEST_ASSERT_MSG_EQ (m_sizes[node].size (), 6, "Node " << node << " received a wrong number of packets");
+      uint32_t sizes[] = { 100, 200, 300, 50, 10, 20 };
+      for (uint32_t i = 0; i < 6; ++i)
+        {
+          NS_TEST_EXPECT_MSG_EQ (m_sizes[node][i], base + sizes[i], "Packet " << i << " of node " << node << " out of order");
+        }
+      NS_TEST_EXPECT_MSG_EQ_TOL (m_times[node][0], 1.001606 + base * 3e-6, 1e-8, "First train received at the wrong time");
+      NS_TEST_EXPECT_MSG_EQ_TOL (m_times[node][1], 1.001658 + base * 4e-6, 1e-8, "Single packet received at the wrong time");
+      NS_TEST_EXPECT_MSG_EQ_TOL (m_times[node][2], 1.001692 + base * 6e-6, 1e-8, "Second train received at the wrong time");
+    }
+
+  Simulator::Destroy ();
+  Simulator::SetImplementation (CreateObject<DefaultSimulatorImpl> ());
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -89,6 +438,8 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointBatchTest, TestCase::QUICK);
+  AddTestCase (new PointToPointCrossPartitionTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
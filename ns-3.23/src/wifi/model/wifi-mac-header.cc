@@ -1078,28 +1078,29 @@ WifiMacHeader::GetSerializedSize (void) const
 void
 WifiMacHeader::Serialize (Buffer::Iterator i) const
 {
-  i.WriteHtolsbU16 (GetFrameControl ());
-  i.WriteHtolsbU16 (m_duration);
-  WriteTo (i, m_addr1);
+  Buffer::WriteSpan span (i, GetSize ());
+  span.WriteHtolsbU16 (GetFrameControl ());
+  span.WriteHtolsbU16 (m_duration);
+  WriteTo (span, m_addr1);
   switch (m_ctrlType)
     {
     case TYPE_MGT:
-      WriteTo (i, m_addr2);
-      WriteTo (i, m_addr3);
-      i.WriteHtolsbU16 (GetSequenceControl ());
+      WriteTo (span, m_addr2);
+      WriteTo (span, m_addr3);
+      span.WriteHtolsbU16 (GetSequenceControl ());
       break;
     case TYPE_CTL:
       switch (m_ctrlSubtype)
         {
         case SUBTYPE_CTL_RTS:
-          WriteTo (i, m_addr2);
+          WriteTo (span, m_addr2);
           break;
         case SUBTYPE_CTL_CTS:
         case SUBTYPE_CTL_ACK:
           break;
         case SUBTYPE_CTL_BACKREQ:
         case SUBTYPE_CTL_BACKRESP:
-          WriteTo (i, m_addr2);
+          WriteTo (span, m_addr2);
           break;
         default:
           //NOTREACHED
@@ -1109,16 +1110,16 @@ WifiMacHeader::Serialize (Buffer::Iterator i) const
       break;
     case TYPE_DATA:
       {
-        WriteTo (i, m_addr2);
-        WriteTo (i, m_addr3);
-        i.WriteHtolsbU16 (GetSequenceControl ());
+        WriteTo (span, m_addr2);
+        WriteTo (span, m_addr3);
+        span.WriteHtolsbU16 (GetSequenceControl ());
         if (m_ctrlToDs && m_ctrlFromDs)
           {
-            WriteTo (i, m_addr4);
+            WriteTo (span, m_addr4);
           }
         if (m_ctrlSubtype & 0x08)
           {
-            i.WriteHtolsbU16 (GetQosControl ());
+            span.WriteHtolsbU16 (GetQosControl ());
           }
       } break;
     default:
@@ -1133,45 +1134,54 @@ WifiMacHeader::Deserialize (Buffer::Iterator start)
   Buffer::Iterator i = start;
   uint16_t frame_control = i.ReadLsbtohU16 ();
   SetFrameControl (frame_control);
-  m_duration = i.ReadLsbtohU16 ();
-  ReadFrom (i, m_addr1);
+  uint32_t size = GetSize ();
+  if (size == 0
+      || (m_ctrlType == TYPE_CTL && m_ctrlSubtype == SUBTYPE_CTL_CTLWRAPPER))
+    {
+      // Only the first address of the frames Serialize does not
+      // support is read.
+      size = 2 + 2 + 6;
+    }
+  Buffer::ReadSpan span (i, size - 2);
+  m_duration = span.ReadLsbtohU16 ();
+  ReadFrom (span, m_addr1);
   switch (m_ctrlType)
     {
     case TYPE_MGT:
-      ReadFrom (i, m_addr2);
-      ReadFrom (i, m_addr3);
-      SetSequenceControl (i.ReadLsbtohU16 ());
+      ReadFrom (span, m_addr2);
+      ReadFrom (span, m_addr3);
+      SetSequenceControl (span.ReadLsbtohU16 ());
       break;
     case TYPE_CTL:
       switch (m_ctrlSubtype)
         {
         case SUBTYPE_CTL_RTS:
-          ReadFrom (i, m_addr2);
+          ReadFrom (span, m_addr2);
           break;
         case SUBTYPE_CTL_CTS:
         case SUBTYPE_CTL_ACK:
           break;
         case SUBTYPE_CTL_BACKREQ:
         case SUBTYPE_CTL_BACKRESP:
-          ReadFrom (i, m_addr2);
+          ReadFrom (span, m_addr2);
           break;
         }
       break;
     case TYPE_DATA:
-      ReadFrom (i, m_addr2);
-      ReadFrom (i, m_addr3);
-      SetSequenceControl (i.ReadLsbtohU16 ());
+      ReadFrom (span, m_addr2);
+      ReadFrom (span, m_addr3);
+      SetSequenceControl (span.ReadLsbtohU16 ());
       if (m_ctrlToDs && m_ctrlFromDs)
         {
-          ReadFrom (i, m_addr4);
+          ReadFrom (span, m_addr4);
         }
       if (m_ctrlSubtype & 0x08)
         {
-          SetQosControl (i.ReadLsbtohU16 ());
+          SetQosControl (span.ReadLsbtohU16 ());
         }
       break;
     }
-  return i.GetDistanceFrom (start);
+  return size;
 }
 
 } // namespace ns3
@@ -20,7 +20,10 @@
 #include "ns3/system-wall-clock-ms.h"
 #include "ns3/packet.h"
 #include "ns3/packet-metadata.h"
+#include "ns3/buffer.h"
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <stdlib.h> // for exit ()
@@ -241,6 +244,75 @@ benchC (uint32_t n)
   }
 }
 
+static void
+benchE (uint32_t n)
+{
+  BenchHeader<14> subframe;
+  BenchHeader<26> mac;
+  uint8_t payload[1400] = { 0 };
+
+  for (uint32_t i = 0; i < n; i++) {
+    Ptr<Packet> aggregate = Create<Packet> ();
+    for (uint32_t j = 0; j < 8; j++) {
+      Ptr<Packet> msdu = Create<Packet> (payload, sizeof (payload));
+      msdu->AddHeader (subframe);
+      aggregate->AddAtEnd (msdu);
+    }
+    aggregate->AddHeader (mac);
+    aggregate->RemoveHeader (mac);
+    uint32_t size = sizeof (payload) + subframe.GetSerializedSize ();
+    for (uint32_t j = 0; j < 8; j++) {
+      Ptr<Packet> msdu = aggregate->CreateFragment (j * size, size);
+      msdu->RemoveHeader (subframe);
+    }
+  }
+}
+
+static void
+benchF (uint32_t n)
+{
+  BenchHeader<20> ipv4;
+  uint8_t payload[9000] = { 0 };
+
+  for (uint32_t i = 0; i < n; i++) {
+    Ptr<Packet> p = Create<Packet> (payload, sizeof (payload));
+    Ptr<Packet> reassembled = Create<Packet> ();
+    for (uint32_t offset = 0; offset < sizeof (payload); offset += 1480) {
+      uint32_t size = std::min<uint32_t> (1480, sizeof (payload) - offset);
+      Ptr<Packet> fragment = p->CreateFragment (offset, size);
+      fragment->AddHeader (ipv4);
+      fragment->RemoveHeader (ipv4);
+      reassembled->AddAtEnd (fragment);
+    }
+  }
+}
+
+static void
+benchG (uint32_t n)
+{
+  BenchTag<16> tag1;
+  BenchTag<17> tag2;
+  BenchTag<18> tag3;
+  BenchTag<19> tag4;
+  BenchTag<20> tag5;
+  BenchTag<21> missing;
+
+  for (uint32_t i = 0; i < n; i++) {
+    Ptr<Packet> p = Create<Packet> (1000);
+    p->AddPacketTag (tag1);
+    p->AddPacketTag (tag2);
+    p->AddPacketTag (tag3);
+    p->AddPacketTag (tag4);
+    for (uint32_t j = 0; j < 4; j++) {
+      Ptr<Packet> o = p->Copy ();
+      o->PeekPacketTag (missing);
+      o->PeekPacketTag (tag3);
+      o->ReplacePacketTag (tag2);
+      o->AddPacketTag (tag5);
+      o->RemovePacketTag (tag1);
+    }
+  }
+}
 
 static void
 runBench (void (*bench) (uint32_t), uint32_t n, char const *name)
@@ -273,6 +345,14 @@ int main (int argc, char *argv[])
         {
           Packet::EnablePrinting ();
         }
+      if (strncmp ("--enable-lazy-printing", argv[0], strlen ("--enable-lazy-printing")) == 0)
+        {
+          Packet::EnableLazyPrinting ();
+        }
+      if (strncmp ("--disable-segments", argv[0], strlen ("--disable-segments")) == 0)
+        {
+          Buffer::SetMinSegmentSize (std::numeric_limits<uint32_t>::max ());
+        }
       argc--;
       argv++;
   }
@@ -289,6 +369,9 @@ int main (int argc, char *argv[])
   runBench (&benchB, n, "Just add headers");
   runBench (&benchC, n, "Remove by func call");
   runBench (&benchD, n, "Intermixed add/remove headers and tags");
+  runBench (&benchE, n, "Aggregate and deaggregate 8 payloads");
+  runBench (&benchF, n, "Fragment and reassemble a 9000 byte payload");
+  runBench (&benchG, n, "Copy and update packet tags");
 
   return 0;
 }
@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Measures the cost of the trace points which devices hit for every
+ * packet, such as MacTx and PhyRxDrop: with no sink connected, with the
+ * source compiled out with NullTracedCallback, and with one or more
+ * sinks connected with or without a context.
+ */
+
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/traced-callback.h"
+#include "ns3/packet.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string.h>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+/**
+ * A device with a MacTx and a PhyRxDrop trace source, the second of
+ * which is compiled out.
+ */
+class BenchDevice
+{
+public:
+  /**
+   * Hit the trace points of a packet n times.
+   * \param [in] packet The packet to trace.
+   * \param [in] n The number of times.
+   */
+  void Send (Ptr<const Packet> packet, uint32_t n);
+  /**
+   * Hit the compiled out trace point of a packet n times.
+   * \param [in] packet The packet to trace.
+   * \param [in] n The number of times.
+   */
+  void Drop (Ptr<const Packet> packet, uint32_t n);
+
+  /** The MacTx trace source. */
+  TracedCallback<Ptr<const Packet> > m_macTxTrace;
+  /** The PhyRxDrop trace source, compiled out. */
+  NullTracedCallback<Ptr<const Packet> > m_phyRxDropTrace;
+};
+
+void
+BenchDevice::Send (Ptr<const Packet> packet, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      m_macTxTrace (packet);
+    }
+}
+
+void
+BenchDevice::Drop (Ptr<const Packet> packet, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      m_phyRxDropTrace (packet);
+    }
+}
+
+static uint32_t g_sinkCalls = 0;
+
+static void
+Sink (Ptr<const Packet> packet)
+{
+  g_sinkCalls++;
+}
+
+static void
+ContextSink (std::string context, Ptr<const Packet> packet)
+{
+  g_sinkCalls++;
+}
+
+static void
+benchNoSink (uint32_t n)
+{
+  BenchDevice device;
+  device.Send (Create<Packet> (1000), n);
+}
+
+static void
+benchNullSource (uint32_t n)
+{
+  BenchDevice device;
+  device.m_phyRxDropTrace.ConnectWithoutContext (MakeCallback (&Sink));
+  device.Drop (Create<Packet> (1000), n);
+}
+
+static void
+benchOneSink (uint32_t n)
+{
+  BenchDevice device;
+  device.m_macTxTrace.ConnectWithoutContext (MakeCallback (&Sink));
+  device.Send (Create<Packet> (1000), n);
+}
+
+static void
+benchOneContextSink (uint32_t n)
+{
+  BenchDevice device;
+  device.m_macTxTrace.Connect (MakeCallback (&ContextSink),
+                               "/NodeList/0/DeviceList/0/$ns3::BenchDevice/MacTx");
+  device.Send (Create<Packet> (1000), n);
+}
+
+static void
+benchFourSinks (uint32_t n)
+{
+  BenchDevice device;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      device.m_macTxTrace.ConnectWithoutContext (MakeCallback (&Sink));
+    }
+  device.Send (Create<Packet> (1000), n);
+}
+
+static void
+runBench (void (*bench) (uint32_t), uint32_t n, char const *name)
+{
+  SystemWallClockMs time;
+  time.Start ();
+  (*bench) (n);
+  uint64_t deltaMs = time.End ();
+  double ps = n;
+  ps *= 1000;
+  ps /= deltaMs;
+  std::cout << ps << " traces/s"
+            << " (" << deltaMs << " ms elapsed)\t"
+            << name
+            << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  while (argc > 0) {
+      if (strncmp ("--n=", argv[0],strlen ("--n=")) == 0)
+        {
+          char const *nAscii = argv[0] + strlen ("--n=");
+          std::istringstream iss;
+          iss.str (nAscii);
+          iss >> n;
+        }
+      argc--;
+      argv++;
+  }
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of traces must be specified " <<
+        "by command-line argument --n=(number of traces)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-traced-callback with n=" << n << std::endl;
+
+  runBench (&benchNoSink, n, "No sink connected");
+  runBench (&benchNullSource, n, "Source compiled out with NullTracedCallback");
+  runBench (&benchOneSink, n, "One sink without context");
+  runBench (&benchOneContextSink, n, "One sink with context");
+  runBench (&benchFourSinks, n, "Four sinks without context");
+  std::cout << g_sinkCalls << " sink calls" << std::endl;
+
+  return 0;
+}